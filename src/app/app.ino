@@ -3,6 +3,8 @@
 #include "log_manager.h"
 #include "config_manager.h"
 #include "rtc_state.h"
+#include "refresh_policy.h"
+#include "photo_overlay.h"
 #include "device_telemetry.h"
 #include "input_manager.h"
 #include "display_power.h"
@@ -553,6 +555,10 @@ void setup() {
     strlcpy(config.device_name, default_name.c_str(), CONFIG_DEVICE_NAME_MAX_LEN);
   }
   rtc_image_state_init();
+  refresh_policy_apply_config(&config);
+  it8951_set_panel_levels(config.panel_levels);
+  it8951_set_photo_orientation(config.photo_orientation);
+  photo_overlay_apply_config(&config);
 
   const uint16_t long_press_ms = config.long_press_ms > 0 ? config.long_press_ms : kDefaultLongPressMs;
   const bool long_press = (long_press_ms > 0) ? input_manager_check_long_press(long_press_ms) : false;
@@ -106,21 +106,21 @@ static bool http_get_string_with_retry(
     return false;
 }
 
-static void parse_list_xml(const String &xml, std::vector<String> &names, String &next_marker) {
+static bool parse_list_xml(const String &xml, NameList &names, String &next_marker) {
     names.clear();
     next_marker = "";
 
-    size_t pos = 0;
+    const char *pos = xml.c_str();
     while (true) {
-        const int start = xml.indexOf("<Name>", pos);
-        if (start < 0) break;
-        const int end = xml.indexOf("</Name>", start);
-        if (end < 0) break;
-        const int content_start = start + 6;
-        if (end > content_start) {
-            names.push_back(xml.substring(content_start, end));
+        const char *start = strstr(pos, "<Name>");
+        if (!start) break;
+        const char *content_start = start + 6;
+        const char *end = strstr(content_start, "</Name>");
+        if (!end) break;
+        if (end > content_start && !names.push_back(content_start, (size_t)(end - content_start))) {
+            return false;
         }
-        pos = static_cast<size_t>(end + 7);
+        pos = end + 7;
     }
 
     const int marker_start = xml.indexOf("<NextMarker>");
@@ -133,6 +133,76 @@ static void parse_list_xml(const String &xml, std::vector<String> &names, String
             }
         }
     }
+    return true;
+}
+
+// Body bytes read from the connection per sink write (stack buffer).
+static constexpr size_t kDownloadChunkBytes = 1024;
+
+struct BufferSink {
+    const String *blob_name;
+    size_t max_bytes;  // 0 = unbounded
+    uint8_t *buffer;
+    size_t size;
+    size_t used;
+};
+
+static bool buffer_sink_begin(uint32_t total_bytes, void *user) {
+    BufferSink *b = static_cast<BufferSink*>(user);
+    if (b->max_bytes > 0 && total_bytes > b->max_bytes) {
+        LOGW("Azure", "Refusing large download (%lu>%lu): %s",
+             (unsigned long)total_bytes,
+             (unsigned long)b->max_bytes,
+             b->blob_name->c_str());
+        return false;
+    }
+    uint8_t *buffer = (uint8_t *)heap_caps_malloc(total_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buffer) {
+        buffer = (uint8_t *)heap_caps_malloc(total_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!buffer) {
+        LOGE("Azure", "Alloc failed (%lu bytes)", (unsigned long)total_bytes);
+        return false;
+    }
+    b->buffer = buffer;
+    b->size = total_bytes;
+    b->used = 0;
+    return true;
+}
+
+static bool buffer_sink_write(const uint8_t *data, size_t len, void *user) {
+    BufferSink *b = static_cast<BufferSink*>(user);
+    if (b->used + len > b->size) return false;
+    memcpy(b->buffer + b->used, data, len);
+    b->used += len;
+    return true;
+}
+
+static bool download_to_buffer(
+    const AzureSasUrlParts &sas,
+    const String &blob_name,
+    size_t max_bytes,
+    uint8_t **out_buf,
+    size_t *out_size,
+    uint32_t timeout_ms,
+    uint8_t retries,
+    uint32_t retry_delay_ms,
+    int *out_http_code
+) {
+    if (out_buf) *out_buf = nullptr;
+    if (out_size) *out_size = 0;
+
+    BufferSink b = {&blob_name, max_bytes, nullptr, 0, 0};
+    const AzureBlobSink sink = {buffer_sink_begin, buffer_sink_write, &b};
+    if (!azure_blob_download_to_sink(sas, blob_name, sink, timeout_ms, retries, retry_delay_ms, out_http_code) ||
+        b.used != b.size) {
+        if (b.buffer) heap_caps_free(b.buffer);
+        return false;
+    }
+
+    if (out_buf) *out_buf = b.buffer;
+    if (out_size) *out_size = b.size;
+    return true;
 }
 
 } // namespace
@@ -205,7 +275,7 @@ bool azure_blob_list_page(
     const String &prefix,
     const String &marker,
     uint16_t max_results,
-    std::vector<String> &out_names,
+    NameList &out_names,
     String &out_next_marker,
     uint32_t timeout_ms,
     uint8_t retries,
@@ -218,7 +288,10 @@ bool azure_blob_list_page(
         return false;
     }
 
-    parse_list_xml(body, out_names, out_next_marker);
+    if (!parse_list_xml(body, out_names, out_next_marker)) {
+        LOGE("Azure", "List out of memory (prefix=%s, %u names)", prefix.c_str(), (unsigned)out_names.size());
+        return false;
+    }
     return true;
 }
 
@@ -253,85 +326,7 @@ bool azure_blob_download_to_buffer_ex(
     uint32_t retry_delay_ms,
     int *out_http_code
 ) {
-    if (out_buf) *out_buf = nullptr;
-    if (out_size) *out_size = 0;
-    if (out_http_code) *out_http_code = 0;
-
-    const String url = azure_blob_build_blob_url(sas, blob_name);
-
-    for (uint8_t attempt = 1; attempt <= retries; attempt++) {
-        HTTPClient http;
-        WiFiClient plain;
-        WiFiClientSecure tls;
-        if (!http_begin(http, plain, tls, sas, url, timeout_ms)) {
-            if (out_http_code) *out_http_code = 0;
-            LOGW("Azure", "Download begin failed (attempt %u/%u)", attempt, retries);
-        } else {
-            http.addHeader("x-ms-version", kAzureMsVersion);
-            const int code = http.GET();
-            if (out_http_code) *out_http_code = code;
-            if (code == HTTP_CODE_OK) {
-                WiFiClient *stream = http.getStreamPtr();
-                int remaining = http.getSize();
-                if (remaining <= 0) {
-                    http.end();
-                    LOGW("Azure", "Missing content-length for %s", blob_name.c_str());
-                    return false;
-                }
-
-                const size_t total_size = static_cast<size_t>(remaining);
-                uint8_t *buffer = (uint8_t *)heap_caps_malloc(total_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                if (!buffer) {
-                    buffer = (uint8_t *)heap_caps_malloc(total_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-                }
-                if (!buffer) {
-                    http.end();
-                    LOGE("Azure", "Alloc failed (%lu bytes)", (unsigned long)total_size);
-                    return false;
-                }
-
-                uint8_t buf[1024];
-                size_t total = 0;
-                bool ok = true;
-
-                while (http.connected() && remaining > 0) {
-                    const size_t available = stream->available();
-                    if (available) {
-                        const size_t to_read = available > sizeof(buf) ? sizeof(buf) : available;
-                        const int read = stream->readBytes(buf, to_read);
-                        if (read <= 0) break;
-                        if (total + static_cast<size_t>(read) > total_size) {
-                            ok = false;
-                            break;
-                        }
-                        memcpy(buffer + total, buf, static_cast<size_t>(read));
-                        total += static_cast<size_t>(read);
-                        remaining -= read;
-                    } else {
-                        delay(1);
-                    }
-                }
-
-                http.end();
-
-                if (!ok || remaining != 0 || total != total_size) {
-                    LOGW("Azure", "Download incomplete (%lu/%lu)", (unsigned long)total, (unsigned long)total_size);
-                    heap_caps_free(buffer);
-                    return false;
-                }
-
-                if (out_buf) *out_buf = buffer;
-                if (out_size) *out_size = total_size;
-                return true;
-            }
-
-            LOGW("Azure", "Download failed (%d) attempt %u/%u", code, attempt, retries);
-        }
-        http.end();
-        delay(retry_delay_ms * attempt);
-    }
-
-    return false;
+    return download_to_buffer(sas, blob_name, 0, out_buf, out_size, timeout_ms, retries, retry_delay_ms, out_http_code);
 }
 
 bool azure_blob_download_to_buffer_bounded(
@@ -345,9 +340,20 @@ bool azure_blob_download_to_buffer_bounded(
     uint32_t retry_delay_ms,
     int *out_http_code
 ) {
-    if (out_buf) *out_buf = nullptr;
-    if (out_size) *out_size = 0;
+    return download_to_buffer(sas, blob_name, max_bytes, out_buf, out_size, timeout_ms, retries, retry_delay_ms, out_http_code);
+}
+
+bool azure_blob_download_to_sink(
+    const AzureSasUrlParts &sas,
+    const String &blob_name,
+    const AzureBlobSink &sink,
+    uint32_t timeout_ms,
+    uint8_t retries,
+    uint32_t retry_delay_ms,
+    int *out_http_code
+) {
     if (out_http_code) *out_http_code = 0;
+    if (!sink.begin || !sink.write) return false;
 
     const String url = azure_blob_build_blob_url(sas, blob_name);
 
@@ -372,40 +378,25 @@ bool azure_blob_download_to_buffer_bounded(
                 }
 
                 const size_t total_size = static_cast<size_t>(remaining);
-                if (max_bytes > 0 && total_size > max_bytes) {
+                if (!sink.begin(static_cast<uint32_t>(total_size), sink.user)) {
                     http.end();
-                    LOGW("Azure", "Refusing large download (%lu>%lu): %s",
-                         (unsigned long)total_size,
-                         (unsigned long)max_bytes,
-                         blob_name.c_str());
                     return false;
                 }
 
-                uint8_t *buffer = (uint8_t *)heap_caps_malloc(total_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                if (!buffer) {
-                    buffer = (uint8_t *)heap_caps_malloc(total_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-                }
-                if (!buffer) {
-                    http.end();
-                    LOGE("Azure", "Alloc failed (%lu bytes)", (unsigned long)total_size);
-                    return false;
-                }
-
-                uint8_t buf[1024];
+                uint8_t buf[kDownloadChunkBytes];
                 size_t total = 0;
                 bool ok = true;
 
                 while (http.connected() && remaining > 0) {
                     const size_t available = stream->available();
                     if (available) {
-                        const size_t to_read = available > sizeof(buf) ? sizeof(buf) : available;
+                        const size_t to_read = min(min(available, sizeof(buf)), static_cast<size_t>(remaining));
                         const int read = stream->readBytes(buf, to_read);
                         if (read <= 0) break;
-                        if (total + static_cast<size_t>(read) > total_size) {
+                        if (!sink.write(buf, static_cast<size_t>(read), sink.user)) {
                             ok = false;
                             break;
                         }
-                        memcpy(buffer + total, buf, static_cast<size_t>(read));
                         total += static_cast<size_t>(read);
                         remaining -= read;
                     } else {
@@ -415,14 +406,12 @@ bool azure_blob_download_to_buffer_bounded(
 
                 http.end();
 
-                if (!ok || remaining != 0 || total != total_size) {
+                // A refusing sink has logged why.
+                if (!ok) return false;
+                if (remaining != 0 || total != total_size) {
                     LOGW("Azure", "Download incomplete (%lu/%lu)", (unsigned long)total, (unsigned long)total_size);
-                    heap_caps_free(buffer);
                     return false;
                 }
-
-                if (out_buf) *out_buf = buffer;
-                if (out_size) *out_size = total_size;
                 return true;
             }
 
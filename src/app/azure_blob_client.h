@@ -2,7 +2,7 @@
 
 #include <Arduino.h>
 
-#include <vector>
+#include "name_list.h"
 
 struct AzureSasUrlParts {
     String base;
@@ -17,13 +17,14 @@ bool azure_blob_parse_sas_url(const char *url, AzureSasUrlParts &out);
 String azure_blob_build_blob_url(const AzureSasUrlParts &sas, const String &blob_name);
 
 // List a single page of blobs under a prefix (never list the entire container).
-// Returns names (may include non-.g4) and an optional continuation marker.
+// Replaces out_names with the page's names (may include non-.g4) and returns an
+// optional continuation marker.
 bool azure_blob_list_page(
     const AzureSasUrlParts &sas,
     const String &prefix,
     const String &marker,
     uint16_t max_results,
-    std::vector<String> &out_names,
+    NameList &out_names,
     String &out_next_marker,
     uint32_t timeout_ms,
     uint8_t retries,
@@ -68,6 +69,27 @@ bool azure_blob_download_to_buffer_ex(
     int *out_http_code
 );
 
+// Streaming download. `begin` gets the content length before the body and
+// may refuse it; `write` then gets the body in order, in chunks of at most
+// 1 KB. Either returning false ends the download without a retry, as does an
+// interrupted body; only failed requests are retried. Memory use is the
+// sink's plus one chunk on the stack, whatever the blob size.
+struct AzureBlobSink {
+    bool (*begin)(uint32_t total_bytes, void *user);
+    bool (*write)(const uint8_t *data, size_t len, void *user);
+    void *user;
+};
+
+bool azure_blob_download_to_sink(
+    const AzureSasUrlParts &sas,
+    const String &blob_name,
+    const AzureBlobSink &sink,
+    uint32_t timeout_ms,
+    uint8_t retries,
+    uint32_t retry_delay_ms,
+    int *out_http_code
+);
+
 // Delete a blob. Returns true when the server accepted the delete.
 bool azure_blob_delete(
     const AzureSasUrlParts &sas,
@@ -9,9 +9,6 @@
 #include <WiFi.h>
 #include <esp_heap_caps.h>
 
-#include <algorithm>
-#include <vector>
-
 namespace {
 static constexpr uint32_t kBlobHttpTimeoutMs = 15000;
 static constexpr uint32_t kBlobHttpRetryDelayMs = 1000;
@@ -142,29 +139,32 @@ static String derive_thumb_blob_name(const String &queue_g4_name) {
     return String();
 }
 
-static bool list_prefix_sorted(const AzureSasUrlParts &sas, const String &prefix, std::vector<String> &out_names) {
+static bool list_prefix_sorted(const AzureSasUrlParts &sas, const String &prefix, NameList &out_names) {
     out_names.clear();
 
+    NameList names;
     String marker;
     uint32_t pages = 0;
     while (true) {
         pages++;
-        std::vector<String> names;
         String next_marker;
         if (!azure_blob_list_page(sas, prefix, marker, kBlobListMaxResults, names, next_marker, kBlobHttpTimeoutMs, kBlobHttpRetries, kBlobHttpRetryDelayMs)) {
             LOGW("Cmd", "List failed (prefix=%s page=%lu)", prefix.c_str(), (unsigned long)pages);
             return false;
         }
 
-        out_names.insert(out_names.end(), names.begin(), names.end());
+        for (size_t i = 0; i < names.size(); i++) {
+            if (!out_names.push_back(names[i])) {
+                LOGW("Cmd", "List out of memory (prefix=%s)", prefix.c_str());
+                return false;
+            }
+        }
 
         if (next_marker.length() == 0) break;
         marker = next_marker;
     }
 
-    std::sort(out_names.begin(), out_names.end(), [](const String &a, const String &b) {
-        return a.compareTo(b) < 0;
-    });
+    out_names.sort();
     return true;
 }
 
@@ -289,11 +289,12 @@ static bool handle_clean_all_content(const AzureSasUrlParts &sas, SPIClass &spi,
         if (list_job != 0) {
             const bool listed = wait_sd_job(list_job, "SD list");
             if (listed) {
-                std::vector<String> names;
+                NameList names;
                 if (sd_storage_get_job_names(list_job, names)) {
-                    for (const auto &name : names) {
-                        if (!(name.startsWith("queue-permanent/") || name.startsWith("queue-temporary/"))) continue;
-                        const uint32_t del_job = sd_storage_enqueue_delete(name.c_str());
+                    for (size_t n = 0; n < names.size(); n++) {
+                        const char *name = names[n];
+                        if (strncmp(name, "queue-permanent/", 16) != 0 && strncmp(name, "queue-temporary/", 16) != 0) continue;
+                        const uint32_t del_job = sd_storage_enqueue_delete(name);
                         if (del_job != 0) {
                             (void)wait_sd_job(del_job, "SD delete");
                         }
@@ -315,12 +316,12 @@ static bool handle_clean_all_content(const AzureSasUrlParts &sas, SPIClass &spi,
     };
 
     for (size_t i = 0; i < (sizeof(prefixes) / sizeof(prefixes[0])); i++) {
-        std::vector<String> names;
+        NameList names;
         if (!list_prefix_sorted(sas, String(prefixes[i]), names)) {
             continue;
         }
-        for (const auto &name : names) {
-            (void)azure_blob_delete(sas, name, kBlobHttpTimeoutMs, kBlobHttpRetries, kBlobHttpRetryDelayMs);
+        for (size_t n = 0; n < names.size(); n++) {
+            (void)azure_blob_delete(sas, String(names[n]), kBlobHttpTimeoutMs, kBlobHttpRetries, kBlobHttpRetryDelayMs);
         }
     }
 
@@ -438,30 +439,27 @@ bool blob_commands_process(DeviceConfig &config, SPIClass &spi, const SdCardPins
         return false;
     }
 
-    std::vector<String> names;
+    NameList names;
     if (!list_prefix_sorted(sas, String("commands/"), names)) {
         return false;
     }
 
-    // Filter, validate and sort.
-    std::vector<String> filtered;
-    filtered.reserve(names.size());
-    for (const auto &name : names) {
-        if (is_valid_command_blob_name(name)) {
-            filtered.push_back(name);
+    // Filter and validate (the listing is already sorted).
+    NameList filtered;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (is_valid_command_blob_name(String(names[i])) && !filtered.push_back(names[i])) {
+            LOGW("Cmd", "Command list out of memory");
+            return false;
         }
     }
 
     if (filtered.empty()) return false;
 
-    std::sort(filtered.begin(), filtered.end(), [](const String &a, const String &b) {
-        return a.compareTo(b) < 0;
-    });
-
     uint8_t executed = 0;
 
-    for (const auto &command_blob : filtered) {
+    for (size_t i = 0; i < filtered.size(); i++) {
         if (executed >= kMaxCommandsPerWake) break;
+        const String command_blob(filtered[i]);
 
         uint8_t *buf = nullptr;
         size_t size = 0;
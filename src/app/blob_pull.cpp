@@ -2,7 +2,7 @@
 
 #include "azure_blob_client.h"
 
-#include "board_config.h"
+#include "jpeg_g4.h"
 #include "log_manager.h"
 #include "sd_storage_service.h"
 #include "rtc_state.h"
@@ -12,8 +12,7 @@
 #include <WiFiClientSecure.h>
 #include <esp_heap_caps.h>
 
-#include <algorithm>
-#include <vector>
+#include <strings.h>
 
 namespace {
 static constexpr uint32_t kBlobHttpTimeoutMs = 15000;
@@ -21,13 +20,16 @@ static constexpr uint32_t kBlobHttpRetryDelayMs = 1000;
 static constexpr uint8_t kBlobHttpRetries = 3;
 static constexpr uint16_t kBlobListMaxResults = 50;
 static constexpr size_t kMaxG4NameLen = 127;
-static constexpr uint32_t kBlobUploadJobTimeoutMs = 120000;
+static constexpr uint32_t kBlobDownloadJobTimeoutMs = 180000;
 
-static bool name_is_g4(const String &name) {
-    if (name.length() < 3) return false;
-    String lower = name;
-    lower.toLowerCase();
-    return lower.endsWith(".g4");
+static bool name_is_g4(const char *name) {
+    const size_t len = strlen(name);
+    return len >= 3 && strcasecmp(name + len - 3, ".g4") == 0;
+}
+
+// JPEGs are converted on the device (3-5x less to download than a .g4).
+static bool name_is_photo(const char *name) {
+    return name_is_g4(name) || jpeg_g4_is_jpeg_name(name);
 }
 
 static void log_memory_snapshot(const char *label) {
@@ -55,23 +57,17 @@ static String make_sd_path(const String &name) {
     return path;
 }
 
-static bool download_blob_to_buffer(const AzureSasUrlParts &sas, const String &name, uint8_t **out_buf, size_t *out_size) {
+// The SD worker streams the blob into its queue file (see sd_storage_enqueue_download).
+static bool download_blob_to_sd_and_wait(const char *sas_url, const String &name) {
     log_memory_snapshot("HTTP download");
-    return azure_blob_download_to_buffer(sas, name, out_buf, out_size, kBlobHttpTimeoutMs, kBlobHttpRetries, kBlobHttpRetryDelayMs);
-}
-
-static bool enqueue_sd_upload_and_wait(const String &name, uint8_t *buffer, size_t size) {
-    if (!buffer || size == 0) return false;
-
-    uint32_t job_id = sd_storage_enqueue_upload(name.c_str(), buffer, size);
+    const uint32_t job_id = sd_storage_enqueue_download(sas_url, name.c_str(), name.c_str());
     if (job_id == 0) {
-        LOGW("Blob", "SD upload enqueue failed for %s", name.c_str());
-        heap_caps_free(buffer);
+        LOGW("Blob", "SD download enqueue failed for %s", name.c_str());
         return false;
     }
 
     const uint32_t start = millis();
-    while (millis() - start < kBlobUploadJobTimeoutMs) {
+    while (millis() - start < kBlobDownloadJobTimeoutMs) {
         SdJobInfo info = {};
         if (!sd_storage_get_job(job_id, &info)) {
             delay(50);
@@ -79,20 +75,20 @@ static bool enqueue_sd_upload_and_wait(const String &name, uint8_t *buffer, size
         }
         if (info.state == SdJobState::Done) {
             if (info.success) {
-                LOGI("Blob", "SD upload complete: %s", name.c_str());
+                LOGI("Blob", "SD download complete: %s (%lu bytes)", name.c_str(), (unsigned long)info.bytes);
                 return true;
             }
-            LOGW("Blob", "SD upload failed: %s (%s)", name.c_str(), info.message);
+            LOGW("Blob", "SD download failed: %s (%s)", name.c_str(), info.message);
             return false;
         }
         if (info.state == SdJobState::Error) {
-            LOGW("Blob", "SD upload error: %s (%s)", name.c_str(), info.message);
+            LOGW("Blob", "SD download error: %s (%s)", name.c_str(), info.message);
             return false;
         }
         delay(50);
     }
 
-    LOGW("Blob", "SD upload timeout: %s", name.c_str());
+    LOGW("Blob", "SD download timeout: %s", name.c_str());
     return false;
 }
 
@@ -130,8 +126,9 @@ bool blob_pull_download_once(const DeviceConfig &config, SPIClass &spi, const Sd
         String marker;
         uint32_t page = 0;
 
+        NameList names;
+        NameList filtered;
         while (true) {
-            std::vector<String> names;
             String next_marker;
             page++;
             log_memory_snapshot("HTTP list");
@@ -140,25 +137,23 @@ bool blob_pull_download_once(const DeviceConfig &config, SPIClass &spi, const Sd
                 break;
             }
 
-            // Filter to .g4 and sort lexicographically.
-            std::vector<String> filtered;
-            filtered.reserve(names.size());
-            for (const auto &name : names) {
-                if (name_is_g4(name)) {
-                    filtered.push_back(name);
+            // Filter to .g4/JPEG and sort lexicographically.
+            filtered.clear();
+            for (size_t i = 0; i < names.size(); i++) {
+                if (name_is_photo(names[i]) && !filtered.push_back(names[i])) {
+                    LOGW("Blob", "List out of memory (prefix=%s)", prefix.c_str());
+                    break;
                 }
             }
+            filtered.sort();
 
-            std::sort(filtered.begin(), filtered.end(), [](const String &a, const String &b) {
-                return a.compareTo(b) < 0;
-            });
-
-            for (const auto &name : filtered) {
-                if (name.length() > kMaxG4NameLen) {
-                    LOGW("Blob", "Skip long blob name: %s", name.c_str());
+            for (size_t i = 0; i < filtered.size(); i++) {
+                if (strlen(filtered[i]) > kMaxG4NameLen) {
+                    LOGW("Blob", "Skip long blob name: %s", filtered[i]);
                     continue;
                 }
 
+                const String name(filtered[i]);
                 const String path = make_sd_path(name);
                 if (path.length() == 0) {
                     LOGW("Blob", "Skip invalid blob name");
@@ -166,18 +161,11 @@ bool blob_pull_download_once(const DeviceConfig &config, SPIClass &spi, const Sd
                 }
 
                 LOGI("Blob", "Attempting %s", name.c_str());
-                uint8_t *buffer = nullptr;
-                size_t size = 0;
-                if (!download_blob_to_buffer(sas, name, &buffer, &size)) {
+                if (!download_blob_to_sd_and_wait(config.blob_sas_url, name)) {
                     LOGW("Blob", "Download failed: %s", name.c_str());
                     continue;
                 }
 
-                if (!enqueue_sd_upload_and_wait(name, buffer, size)) {
-                    LOGW("Blob", "Upload failed: %s", name.c_str());
-                    continue;
-                }
-
                 LOGI("Blob", "Stored on SD: %s", path.c_str());
                 rtc_image_state_set_priority_image_name(name.c_str());
 
@@ -250,6 +250,50 @@
 #define EINK_MIN_PRESENT_INTERVAL_MS 1000
 #endif
 
+// Bring the IT8951 up with the lean native sequence (reset, SYS_RUN, dev info,
+// VCOM, LISAR) instead of GxEPD2 init(). GxEPD2 is then only initialized on
+// demand for raw8/full-white rendering. Set false to compare timings.
+#ifndef IT8951_NATIVE_INIT
+#define IT8951_NATIVE_INIT true
+#endif
+
+// Light-sleep the CPU while waiting for an e-ink waveform to finish (only when
+// WiFi is off). Disabled by default on USB CDC boards: light sleep drops the
+// USB serial connection.
+#ifndef EINK_REFRESH_LIGHT_SLEEP
+#if defined(ARDUINO_USB_CDC_ON_BOOT) && ARDUINO_USB_CDC_ON_BOOT
+#define EINK_REFRESH_LIGHT_SLEEP false
+#else
+#define EINK_REFRESH_LIGHT_SLEEP true
+#endif
+#endif
+
+// Dithering for on-device conversions (BMP, JPEG), see g4_dither.h:
+// 0 = none (grey >> 4), 1 = Bayer 4x4, 2 = Floyd-Steinberg, 3 = blue noise.
+#ifndef G4_DITHER_MODE
+#define G4_DITHER_MODE 2
+#endif
+
+// Default photo orientation relative to the encoded library (config
+// photo_orientation, see PhotoOrientation in it8951_renderer.h): 0 = as
+// encoded, 1 = rotate 180, 2 = mirror X, 3 = mirror Y. Converted libraries
+// match DISPLAY_ROTATION 2 mounting; a frame mounted the other way up uses 1.
+#ifndef PHOTO_ORIENTATION
+#define PHOTO_ORIENTATION 0
+#endif
+
+// Default photo overlays (config photo_overlays, CONFIG_OVERLAY_* bits):
+// 1 = clock, 2 = battery, 4 = caption (file name). 0 shows the photo alone.
+#ifndef PHOTO_OVERLAYS
+#define PHOTO_OVERLAYS 0
+#endif
+
+// Keep the on-device JPEG conversion as a .g4 under /jpeg-cache so later
+// wakes render the cached frame instead of decoding again.
+#ifndef JPEG_G4_CACHE
+#define JPEG_G4_CACHE true
+#endif
+
 // ============================================================================
 // Backlight Configuration
 // ============================================================================
@@ -0,0 +1,51 @@
+#include "collage_plan.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+void collage_plan(const CollageCell &cell, uint16_t sw, uint16_t sh, CollageFit fit, CollagePlan &p) {
+    const uint32_t k_contain = std::max((sw + cell.w - 1) / cell.w, (sh + cell.h - 1) / cell.h);
+    const uint32_t k_cover = std::max((uint32_t)1, std::min((uint32_t)(sw / cell.w), (uint32_t)(sh / cell.h)));
+    uint32_t k = fit == CollageFit::Cover ? k_cover : k_contain;
+    if (fit == CollageFit::Auto) {
+        const bool small_crop = (uint32_t)sw / k_cover * 4 <= (uint32_t)cell.w * 5 &&
+                                (uint32_t)sh / k_cover * 4 <= (uint32_t)cell.h * 5;
+        k = small_crop ? k_cover : k_contain;
+    }
+    k = std::min(std::max(k, (uint32_t)1), (uint32_t)kCollageMaxScale);
+    p.k = (uint8_t)k;
+    p.out_w = (uint16_t)(std::min((uint32_t)cell.w, sw / k) & ~3u);
+    p.out_h = (uint16_t)std::min((uint32_t)cell.h, sh / k);
+    p.src_x = (uint16_t)((sw - (uint32_t)p.out_w * k) / 2);
+    if (k == 1) p.src_x &= ~1u;
+    p.src_y = (uint16_t)((sh - (uint32_t)p.out_h * k) / 2);
+    p.dst_x = (uint16_t)(cell.x + (((cell.w - p.out_w) / 2) & ~3u));
+    p.dst_y = (uint16_t)(cell.y + (cell.h - p.out_h) / 2);
+}
+
+static inline uint8_t packed_level(const uint8_t *row, uint16_t x) {
+    const uint8_t b = row[x >> 1];
+    return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+void collage_accumulate(const CollagePlan &p, const uint8_t *row, uint16_t *sums) {
+    uint16_t x = p.src_x;
+    for (uint16_t ox = 0; ox < p.out_w; ox++) {
+        uint16_t sum = 0;
+        for (uint8_t j = 0; j < p.k; j++) {
+            sum += packed_level(row, x++);
+        }
+        sums[ox] += sum;
+    }
+}
+
+void collage_pack_row(const CollagePlan &p, uint16_t *sums, uint8_t *out) {
+    const uint16_t n = (uint16_t)p.k * p.k;
+    for (uint16_t ox = 0; ox < p.out_w; ox += 2) {
+        const uint8_t a = (uint8_t)((sums[ox] + n / 2) / n);
+        const uint8_t b = (uint8_t)((sums[ox + 1] + n / 2) / n);
+        out[ox / 2] = (uint8_t)((a << 4) | b);
+    }
+    memset(sums, 0, sizeof(uint16_t) * p.out_w);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+// Collage layout (it8951_render_collage): how each G4 file is shrunk and
+// cropped into its cell, and the k x k box average applied to its rows while
+// they stream. No Arduino dependencies: also built into the host tests
+// (tools/g4codec).
+
+// Cells are in frame space like G4 sub-frames (x and w multiples of 4) and
+// should not overlap; the rest of the panel is filled white. The loaded area
+// (dst_x, out_w) stays on the same 4-px grid.
+static constexpr uint8_t kCollageMaxCells = 4;
+static constexpr uint8_t kCollageMaxScale = 8;
+
+enum class CollageFit : uint8_t {
+    Contain = 0,  // whole source visible, white margins in the cell
+    Cover,        // cell filled, source cropped
+    Auto,         // Cover when that crops at most a fifth of either side
+};
+
+struct CollageCell {
+    const char *g4_path;
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+struct CollagePlan {
+    uint8_t k;
+    uint16_t src_x;   // crop window origin in the stored frame
+    uint16_t src_y;
+    uint16_t out_w;
+    uint16_t out_h;
+    uint16_t dst_x;   // frame position of the loaded area
+    uint16_t dst_y;
+};
+
+// Size a `sw` x `sh` source for `cell`. out_w or out_h is 0 when the cell is
+// too small for the source at kCollageMaxScale.
+void collage_plan(const CollageCell &cell, uint16_t sw, uint16_t sh, CollageFit fit, CollagePlan &p);
+
+// Add one packed source row to `sums` (out_w entries), the column sums of the
+// current output row.
+void collage_accumulate(const CollagePlan &p, const uint8_t *row, uint16_t *sums);
+
+// Pack the k x k averages (levels, rounded) of `sums` into `out` (out_w / 2
+// bytes) and clear the sums for the next output row.
+void collage_pack_row(const CollagePlan &p, uint16_t *sums, uint8_t *out);
@@ -9,6 +9,7 @@
 #include "board_config.h"
 #include "web_assets.h"
 #include "log_manager.h"
+#include "panel_levels.h"
 #include <Preferences.h>
 #include <nvs_flash.h>
 
@@ -35,6 +36,12 @@
 #define KEY_MQTT_PASS      "mqtt_pass"
 #define KEY_MQTT_INTERVAL  "mqtt_int"
 #define KEY_BACKLIGHT_BRIGHTNESS "bl_bright"
+#define KEY_REFRESH_CLEAN  "rf_clean"
+#define KEY_REFRESH_INIT_H "rf_init_h"
+#define KEY_REFRESH_HIST   "rf_hist"
+#define KEY_PANEL_LEVELS   "panel_lvl"
+#define KEY_PHOTO_ORIENT   "photo_orient"
+#define KEY_PHOTO_OVERLAYS "photo_ovl"
 
 // Azure Blob pull-on-wake
 #define KEY_BLOB_SAS_URL   "blob_sas"
@@ -47,6 +54,8 @@
 
 static Preferences preferences;
 
+static_assert(CONFIG_PANEL_LEVELS == kPanelLevels, "panel_levels holds one entry per 4-bit level");
+
 // Initialize NVS
 void config_manager_init() {
     LOGI("Config", "NVS init start");
@@ -117,6 +126,12 @@ bool config_manager_load(DeviceConfig *config) {
 
     LOGI("Config", "Load start");
 
+    // Linear panel levels unless NVS holds a calibration (an all-zero table
+    // would render every photo black); same for the board's photo orientation.
+    panel_levels_identity(config->panel_levels);
+    config->photo_orientation = PHOTO_ORIENTATION;
+    config->photo_overlays = PHOTO_OVERLAYS;
+
     // Use read-write mode here: on a fresh flash the namespace doesn't exist yet
     // and Preferences.begin(..., true) (read-only) will fail.
     if (!preferences.begin(CONFIG_NAMESPACE, false)) {
@@ -139,6 +154,11 @@ bool config_manager_load(DeviceConfig *config) {
         config->mqtt_port = 0;
         config->mqtt_interval_seconds = 0;
 
+        // Refresh policy defaults
+        config->refresh_clean_every = CONFIG_REFRESH_CLEAN_EVERY_DEFAULT;
+        config->refresh_init_hours = CONFIG_REFRESH_INIT_HOURS_DEFAULT;
+        config->refresh_hist_delta_pct = CONFIG_REFRESH_HIST_DELTA_PCT_DEFAULT;
+
         // Azure Blob defaults
         config->blob_sas_url[0] = '\0';
 
@@ -193,6 +213,15 @@ bool config_manager_load(DeviceConfig *config) {
     // Load display settings
     config->backlight_brightness = preferences.getUChar(KEY_BACKLIGHT_BRIGHTNESS, 100);
     LOGI("Config", "Loaded brightness: %d%%", config->backlight_brightness);
+    config->refresh_clean_every = preferences.getUChar(KEY_REFRESH_CLEAN, CONFIG_REFRESH_CLEAN_EVERY_DEFAULT);
+    config->refresh_init_hours = preferences.getUShort(KEY_REFRESH_INIT_H, CONFIG_REFRESH_INIT_HOURS_DEFAULT);
+    config->refresh_hist_delta_pct = preferences.getUChar(KEY_REFRESH_HIST, CONFIG_REFRESH_HIST_DELTA_PCT_DEFAULT);
+    if (preferences.getBytesLength(KEY_PANEL_LEVELS) == CONFIG_PANEL_LEVELS) {
+        preferences.getBytes(KEY_PANEL_LEVELS, config->panel_levels, CONFIG_PANEL_LEVELS);
+    }
+    config->photo_orientation = preferences.getUChar(KEY_PHOTO_ORIENT, PHOTO_ORIENTATION);
+    if (config->photo_orientation > CONFIG_PHOTO_ORIENTATION_MAX) config->photo_orientation = PHOTO_ORIENTATION;
+    config->photo_overlays = preferences.getUChar(KEY_PHOTO_OVERLAYS, PHOTO_OVERLAYS) & CONFIG_OVERLAY_MASK;
 
     // Load Basic Auth settings
     config->basic_auth_enabled = preferences.getBool(KEY_BASIC_AUTH_ENABLED, false);
@@ -266,6 +295,12 @@ bool config_manager_save(const DeviceConfig *config) {
     // Save display settings
     LOGI("Config", "Saving brightness: %d%%", config->backlight_brightness);
     preferences.putUChar(KEY_BACKLIGHT_BRIGHTNESS, config->backlight_brightness);
+    preferences.putUChar(KEY_REFRESH_CLEAN, config->refresh_clean_every);
+    preferences.putUShort(KEY_REFRESH_INIT_H, config->refresh_init_hours);
+    preferences.putUChar(KEY_REFRESH_HIST, config->refresh_hist_delta_pct);
+    preferences.putBytes(KEY_PANEL_LEVELS, config->panel_levels, CONFIG_PANEL_LEVELS);
+    preferences.putUChar(KEY_PHOTO_ORIENT, config->photo_orientation);
+    preferences.putUChar(KEY_PHOTO_OVERLAYS, config->photo_overlays);
 
     // Save Basic Auth settings
     preferences.putBool(KEY_BASIC_AUTH_ENABLED, config->basic_auth_enabled);
@@ -331,6 +366,18 @@ void config_manager_print(const DeviceConfig *config) {
     LOGI("Config", "Image selection: %s", config->image_selection_mode);
     LOGI("Config", "Long press: %ums", (unsigned)config->long_press_ms);
     LOGI("Config", "Always-on: %s", config->always_on ? "enabled" : "disabled");
+    LOGI("Config", "Refresh policy: clean every %u, init every %uh, histogram %u%%",
+         (unsigned)config->refresh_clean_every,
+         (unsigned)config->refresh_init_hours,
+         (unsigned)config->refresh_hist_delta_pct);
+    char levels[CONFIG_PANEL_LEVELS_STR_MAX_LEN];
+    panel_levels_format(config->panel_levels, levels, sizeof(levels));
+    LOGI("Config", "Panel levels: %s", levels);
+    LOGI("Config", "Photo orientation: %u", (unsigned)config->photo_orientation);
+    LOGI("Config", "Photo overlays: clock=%d battery=%d caption=%d",
+         (config->photo_overlays & CONFIG_OVERLAY_CLOCK) ? 1 : 0,
+         (config->photo_overlays & CONFIG_OVERLAY_BATTERY) ? 1 : 0,
+         (config->photo_overlays & CONFIG_OVERLAY_CAPTION) ? 1 : 0);
     
     if (strlen(config->fixed_ip) > 0) {
         LOGI("Config", "IP: %s", config->fixed_ip);
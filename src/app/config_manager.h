@@ -42,6 +42,24 @@
 // Azure Blob pull-on-wake settings
 #define CONFIG_BLOB_SAS_URL_MAX_LEN 512
 
+// Photo refresh policy defaults (see refresh_policy.h)
+#define CONFIG_REFRESH_CLEAN_EVERY_DEFAULT 8
+#define CONFIG_REFRESH_INIT_HOURS_DEFAULT 24
+#define CONFIG_REFRESH_HIST_DELTA_PCT_DEFAULT 35
+
+// Panel gray calibration: one loaded level per encoded 4-bit level
+#define CONFIG_PANEL_LEVELS 16
+#define CONFIG_PANEL_LEVELS_STR_MAX_LEN 48
+
+// Photo orientation values (PhotoOrientation in it8951_renderer.h)
+#define CONFIG_PHOTO_ORIENTATION_MAX 3
+
+// Photo overlay bits (photo_overlay.h)
+#define CONFIG_OVERLAY_CLOCK   0x01
+#define CONFIG_OVERLAY_BATTERY 0x02
+#define CONFIG_OVERLAY_CAPTION 0x04
+#define CONFIG_OVERLAY_MASK    0x07
+
 // Configuration structure
 struct DeviceConfig {
     // WiFi credentials
@@ -77,6 +95,16 @@ struct DeviceConfig {
     // Display settings
     uint8_t backlight_brightness;  // 0-100%, default 100
 
+    // Photo refresh policy (0 disables the respective trigger)
+    uint8_t refresh_clean_every;     // two-pass clean after N single-pass renders, default 8
+    uint16_t refresh_init_hours;     // INIT clear at least every N hours, default 24
+    uint8_t refresh_hist_delta_pct;  // two-pass clean when the histogram moves >= N%, default 35
+
+    // Panel gray calibration (encoded level i is loaded as panel_levels[i]), default identity
+    uint8_t panel_levels[CONFIG_PANEL_LEVELS];
+    uint8_t photo_orientation;  // 0 as encoded, 1 rotate 180, 2 mirror X, 3 mirror Y, default PHOTO_ORIENTATION
+    uint8_t photo_overlays;     // CONFIG_OVERLAY_* bits drawn on photos, default PHOTO_OVERLAYS
+
     // Web portal Basic Auth (optional; enforced in STA/full mode only)
     bool basic_auth_enabled;
     char basic_auth_username[CONFIG_BASIC_AUTH_USERNAME_MAX_LEN];
@@ -18,6 +18,7 @@
 #include "mqtt_manager.h"
 #endif
 #include "display_manager.h"
+#include "it8951_renderer.h"
 #include "max17048_fuel_gauge.h"
 
 // Temperature sensor support (ESP32-C3, ESP32-S2, ESP32-S3, ESP32-C2, ESP32-C6, ESP32-H2)
@@ -1087,6 +1088,18 @@ static void fill_common(
             doc["display_lv_timer_us"] = nullptr;
             doc["display_present_us"] = nullptr;
         }
+
+        // E-ink controller waits of the last completed render.
+        It8951BusyStats busy;
+        if (it8951_renderer_get_busy_stats(&busy)) {
+            doc["eink_busy_wait_ms"] = (busy.hrdy_us + busy.refresh_us) / 1000;
+            doc["eink_refresh_wait_ms"] = busy.refresh_us / 1000;
+            doc["eink_light_sleep_ms"] = busy.sleep_us / 1000;
+        } else {
+            doc["eink_busy_wait_ms"] = nullptr;
+            doc["eink_refresh_wait_ms"] = nullptr;
+            doc["eink_light_sleep_ms"] = nullptr;
+        }
     }
 
     // WiFi stats
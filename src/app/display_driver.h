@@ -18,6 +18,8 @@
 
 #include <Arduino.h>
 
+#include "eink_waveform.h"
+
 // ============================================================================
 // Display Driver Interface
 // ============================================================================
@@ -38,12 +40,13 @@ public:
     // Busy guard for long-running transfers.
     virtual bool isBusy() const = 0;
 
-    // Present a full-screen 4bpp (packed) buffer.
-    virtual bool presentG4Full(const uint8_t* g4, bool fullRefresh) = 0;
+    // Present a full-screen 4bpp (packed) buffer with the given waveform.
+    virtual bool presentG4Full(const uint8_t* g4, EinkWaveform waveform) = 0;
 
-    // Present a region 4bpp (packed) buffer.
+    // Present a region 4bpp (packed) buffer; only that area is refreshed.
+    // x and w are multiples of 4.
     virtual bool presentG4Region(const uint8_t* g4, uint16_t x, uint16_t y,
-                                 uint16_t w, uint16_t h, bool fullRefresh) = 0;
+                                 uint16_t w, uint16_t h, EinkWaveform waveform) = 0;
 
     // Optional direct RGB565 write path (used by JPEG strip decoder on color panels).
     virtual void startWrite() {}
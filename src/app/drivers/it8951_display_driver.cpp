@@ -22,13 +22,13 @@ bool IT8951_Display_Driver::isBusy() const {
     return it8951_renderer_is_busy();
 }
 
-bool IT8951_Display_Driver::presentG4Full(const uint8_t* g4, bool fullRefresh) {
-    return it8951_render_g4_buffer_ex(g4, DISPLAY_WIDTH, DISPLAY_HEIGHT, fullRefresh);
+bool IT8951_Display_Driver::presentG4Full(const uint8_t* g4, EinkWaveform waveform) {
+    return it8951_render_g4_buffer_ex(g4, DISPLAY_WIDTH, DISPLAY_HEIGHT, waveform);
 }
 
 bool IT8951_Display_Driver::presentG4Region(const uint8_t* g4, uint16_t x, uint16_t y,
-                                            uint16_t w, uint16_t h, bool fullRefresh) {
-    return it8951_render_g4_region(g4, x, y, w, h, fullRefresh);
+                                            uint16_t w, uint16_t h, EinkWaveform waveform) {
+    return it8951_render_g4_region(g4, x, y, w, h, waveform);
 }
 
 uint32_t IT8951_Display_Driver::minPresentIntervalMs() const {
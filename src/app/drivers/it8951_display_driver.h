@@ -12,9 +12,9 @@ public:
     int height() override;
     bool isBusy() const override;
 
-    bool presentG4Full(const uint8_t* g4, bool fullRefresh) override;
+    bool presentG4Full(const uint8_t* g4, EinkWaveform waveform) override;
     bool presentG4Region(const uint8_t* g4, uint16_t x, uint16_t y,
-                         uint16_t w, uint16_t h, bool fullRefresh) override;
+                         uint16_t w, uint16_t h, EinkWaveform waveform) override;
 
     uint32_t minPresentIntervalMs() const override;
 };
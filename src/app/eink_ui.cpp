@@ -59,7 +59,8 @@ EInkUi::EInkUi()
     : driver(nullptr), canvas(nullptr), g4Buffer(nullptr), g4BufferBytes(0),
             g4RegionBuffer(nullptr), g4RegionBytes(0), width(0), height(0),
             currentBounds({0, 0, 0, 0, false}), lastBounds({0, 0, 0, 0, false}),
-            lastRenderPartial(false), progress(-1) {
+            lastRenderPartial(false), lastRenderWaveform(EinkWaveform::GC16), textChanged(true),
+            progress(-1) {
     title[0] = '\0';
     status[0] = '\0';
 }
@@ -92,10 +93,12 @@ bool EInkUi::init(DisplayDriver* displayDriver) {
 }
 
 void EInkUi::setTitle(const char* text) {
+    if (strcmp(title, text ? text : "") != 0) textChanged = true;
     strlcpy(title, text ? text : "", sizeof(title));
 }
 
 void EInkUi::setStatus(const char* text) {
+    if (strcmp(status, text ? text : "") != 0) textChanged = true;
     strlcpy(status, text ? text : "", sizeof(status));
 }
 
@@ -106,6 +109,8 @@ void EInkUi::setProgress(int percent) {
 }
 
 void EInkUi::clearProgress() {
+    // Removing the bar leaves A2 residue; let the next update use DU.
+    if (progress >= 0) textChanged = true;
     progress = -1;
 }
 
@@ -135,20 +140,16 @@ EInkUi::Rect EInkUi::clampRect(const Rect& r, uint16_t maxW, uint16_t maxH) {
     return out;
 }
 
-EInkUi::Rect EInkUi::alignRectEven(const Rect& r, uint16_t maxW, uint16_t maxH) {
+// 4bpp loads take whole 16-bit words per row: widen to 4-px boundaries.
+EInkUi::Rect EInkUi::alignRectWord(const Rect& r, uint16_t maxW, uint16_t maxH) {
     if (!r.valid) return r;
     Rect out = r;
-    if (out.x & 1U) {
-        if (out.x > 0) out.x -= 1;
-        if (out.x + out.w < maxW) out.w += 1;
-    }
-    if (out.w & 1U) {
-        if (out.x + out.w < maxW) {
-            out.w += 1;
-        } else if (out.w > 1) {
-            out.w -= 1;
-        }
-    }
+    const uint16_t x0 = (uint16_t)(out.x & ~3U);
+    uint16_t x1 = (uint16_t)((out.x + out.w + 3U) & ~3U);
+    if (x1 > maxW) x1 = (uint16_t)(maxW & ~3U);
+    if (x1 <= x0) return {0, 0, 0, 0, false};
+    out.x = x0;
+    out.w = x1 - x0;
     return clampRect(out, maxW, maxH);
 }
 
@@ -181,17 +182,21 @@ bool EInkUi::render(bool fullRefresh, bool allowPartial) {
     convertToG4();
 
     lastRenderPartial = false;
+    const bool onlyProgress = !textChanged;
+    textChanged = false;
 
     if (fullRefresh || !allowPartial) {
         lastBounds = currentBounds;
-        return driver->presentG4Full(g4Buffer, fullRefresh);
+        lastRenderWaveform = fullRefresh ? EinkWaveform::GC16 : EinkWaveform::DU;
+        return driver->presentG4Full(g4Buffer, lastRenderWaveform);
     }
 
+    lastRenderWaveform = EinkWaveform::DU;
     Rect dirty = unionRect(lastBounds, currentBounds);
     dirty = clampRect(dirty, width, height);
     if (!dirty.valid || (dirty.w == width && dirty.h == height)) {
         lastBounds = currentBounds;
-        return driver->presentG4Full(g4Buffer, false);
+        return driver->presentG4Full(g4Buffer, EinkWaveform::DU);
     }
 
     // Apply 180° rotation to dirty bounds if needed.
@@ -201,15 +206,15 @@ bool EInkUi::render(bool fullRefresh, bool allowPartial) {
         rotated.y = (uint16_t)(height - (dirty.y + dirty.h));
     }
 
-    rotated = alignRectEven(rotated, width, height);
+    rotated = alignRectWord(rotated, width, height);
     if (!rotated.valid) {
         lastBounds = currentBounds;
-        return driver->presentG4Full(g4Buffer, false);
+        return driver->presentG4Full(g4Buffer, EinkWaveform::DU);
     }
 
     if (!ensureRegionBuffer(rotated.w, rotated.h)) {
         lastBounds = currentBounds;
-        return driver->presentG4Full(g4Buffer, false);
+        return driver->presentG4Full(g4Buffer, EinkWaveform::DU);
     }
 
     const uint16_t packed_width = width / 2;
@@ -222,7 +227,9 @@ bool EInkUi::render(bool fullRefresh, bool allowPartial) {
         memcpy(&g4RegionBuffer[dst_offset], &g4Buffer[src_offset], region_packed);
     }
 
-    const bool ok = driver->presentG4Region(g4RegionBuffer, rotated.x, rotated.y, rotated.w, rotated.h, false);
+    lastRenderWaveform = onlyProgress ? EinkWaveform::A2 : EinkWaveform::DU;
+    const bool ok = driver->presentG4Region(g4RegionBuffer, rotated.x, rotated.y, rotated.w, rotated.h,
+                                            lastRenderWaveform);
     lastRenderPartial = ok;
     lastBounds = currentBounds;
     return ok;
@@ -35,9 +35,12 @@ public:
     void setProgress(int percent); // 0-100, or -1 to hide
     void clearProgress();
 
+    // fullRefresh uses GC16 (cleans ghosting). Otherwise the UI is 1-bit, so
+    // DU is enough; partial updates where only the progress bar changed use A2.
     bool render(bool fullRefresh);
     bool render(bool fullRefresh, bool allowPartial);
     bool didPartialLast() const { return lastRenderPartial; }
+    EinkWaveform lastWaveform() const { return lastRenderWaveform; }
 
 private:
     struct Rect {
@@ -54,7 +57,7 @@ private:
     bool ensureRegionBuffer(uint16_t w, uint16_t h);
     static Rect unionRect(const Rect& a, const Rect& b);
     static Rect clampRect(const Rect& r, uint16_t maxW, uint16_t maxH);
-    static Rect alignRectEven(const Rect& r, uint16_t maxW, uint16_t maxH);
+    static Rect alignRectWord(const Rect& r, uint16_t maxW, uint16_t maxH);
 
     DisplayDriver* driver;
     EInkCanvas1* canvas;
@@ -68,6 +71,8 @@ private:
     Rect currentBounds;
     Rect lastBounds;
     bool lastRenderPartial;
+    EinkWaveform lastRenderWaveform;
+    bool textChanged;
 
     char title[64];
     char status[96];
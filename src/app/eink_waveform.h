@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// E-ink waveform (update mode) for a refresh. Pick the cheapest one that is
+// still correct for what changed:
+//   GC16 - 16-level grayscale with flashing; photos, clears accumulated ghosting.
+//   GL16 - 16-level without flashing; grayscale content on a mostly white page.
+//   DU   - direct update to black/white (~250 ms); text and UI screens.
+//   A2   - fastest black/white (~120 ms); progress bars. Ghosts more, so
+//          alternate with DU/GC16.
+//   Init - drive the whole area to white; deep clean, slowest.
+enum class EinkWaveform : uint8_t {
+    Init = 0,
+    DU,
+    GC16,
+    GL16,
+    A2,
+};
+
+static constexpr uint8_t kEinkWaveformCount = 5;
+
+inline const char* eink_waveform_name(EinkWaveform waveform) {
+    switch (waveform) {
+        case EinkWaveform::Init: return "INIT";
+        case EinkWaveform::DU: return "DU";
+        case EinkWaveform::GC16: return "GC16";
+        case EinkWaveform::GL16: return "GL16";
+        case EinkWaveform::A2: return "A2";
+    }
+    return "?";
+}
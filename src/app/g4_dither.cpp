@@ -0,0 +1,213 @@
+#include "g4_dither.h"
+
+#include <string.h>
+
+// Also built into the host codec (tools/g4codec): device-only bits are guarded.
+#ifdef ARDUINO
+#include "log_manager.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#else
+#include <chrono>
+#include <stdlib.h>
+#endif
+
+namespace {
+#ifdef ARDUINO
+static void *alloc_bytes(size_t bytes) {
+    void *ptr = nullptr;
+    if (psramFound()) {
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!ptr) {
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+static void free_bytes(void *ptr) {
+    heap_caps_free(ptr);
+}
+
+static uint32_t now_us() {
+    return micros();
+}
+#else
+static void *alloc_bytes(size_t bytes) {
+    return malloc(bytes);
+}
+
+static void free_bytes(void *ptr) {
+    free(ptr);
+}
+
+static uint32_t now_us() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static const uint8_t kBayer4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+// 16x16 void-and-cluster ranks (0..255), sigma 1.5, tiles seamlessly.
+static const uint8_t kBlueNoise16[16][16] = {
+    {234,  50, 188,  19,  58, 171, 121,  47, 163,   3, 247, 104,  22, 132,  14,  65},
+    {209,   8, 118,  97, 240, 205,  23, 228, 138,  64, 123, 170,  72, 224,  99, 149},
+    { 85, 139, 229, 165,  78, 146, 111,  84, 176, 216,  30, 231, 153, 201,  42, 180},
+    { 25,  62, 195,  29,  43, 185,   7, 249,  41, 100, 191,  48,  87,   5, 128, 243},
+    {221, 152, 101, 253, 130, 220,  59, 200, 156,  12, 136, 112, 254, 174,  69, 109},
+    { 46, 189,   2,  73, 172,  90, 142, 116,  80, 237, 210,  61, 147,  33, 206, 160},
+    { 81, 124, 217, 113, 208,  15, 241,  27, 168,  45, 178,  20, 193,  96, 225,  18},
+    {242, 164,  60,  35, 157,  53, 181,  68, 223, 105, 125,  83, 236, 131,  55, 141},
+    {197,  10, 227, 134, 246,  95, 126, 198, 148,   1, 244, 161,  71,   9, 182, 106},
+    { 40,  93, 179,  75, 192,   6, 218,  36,  91,  57, 202,  34, 215, 155, 233,  74},
+    {252, 120, 150,  24, 110,  63, 166, 119, 232, 183, 133, 103,  49, 117,  31, 167},
+    { 16, 212,  51, 238, 207, 137, 255,  21,  76, 151,  13, 250, 190,  88, 203, 135},
+    {102, 184,  82, 169,  38,  89, 187,  52, 204,  98, 173,  67, 129,   4, 222,  56},
+    {230, 144,   0, 127, 226,  11, 154, 114, 239,  39, 219,  28, 235, 145, 175,  77},
+    {196,  37, 248,  70, 107, 199,  66, 177,  17, 143, 115, 159,  86,  44, 108,  26},
+    {122,  92, 158, 214, 140,  32, 245,  94, 213,  79, 194,  54, 211, 186, 251, 162},
+};
+
+// One output level is 17 gray steps; FloydSteinberg errors are kept in 1/16
+// steps (Q4). The clamp keeps pathological inputs inside int16.
+static constexpr int32_t kLevelQ4 = 17 * 16;
+static constexpr int32_t kMaxErrorQ4 = 256 * 16;
+
+static int16_t *alloc_errors(uint16_t width) {
+    const size_t bytes = sizeof(int16_t) * ((size_t)width + 2);
+    void *ptr = alloc_bytes(bytes);
+    if (ptr) memset(ptr, 0, bytes);
+    return static_cast<int16_t*>(ptr);
+}
+
+static inline int32_t clamp_i32(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static inline uint8_t quantize_offset(int32_t v, int32_t offset) {
+    v = clamp_i32(v + offset, 0, 255);
+    const int32_t q = (v + 8) >> 4;
+    return (uint8_t)(q > 15 ? 15 : q);
+}
+
+// opt-bayer adds int(t - 7.5): -7..0 below 8, 0..7 from 8 up.
+static inline int32_t bayer_offset(uint8_t t) {
+    return t < 8 ? (int32_t)t - 7 : (int32_t)t - 8;
+}
+
+static void row_floyd_steinberg(G4Dither &d, const uint8_t *gray, uint8_t *levels) {
+    int16_t *cur = d.err_cur;
+    int16_t *next = d.err_next;
+    memset(next, 0, sizeof(int16_t) * ((size_t)d.width + 2));
+    for (uint16_t x = 0; x < d.width; x++) {
+        const int32_t v = ((int32_t)gray[x] << 4) + cur[x + 1];
+        int32_t level = v <= 0 ? 0 : (v + kLevelQ4 / 2) / kLevelQ4;
+        if (level > 15) level = 15;
+        levels[x] = (uint8_t)level;
+        const int32_t e = clamp_i32(v - level * kLevelQ4, -kMaxErrorQ4, kMaxErrorQ4);
+        cur[x + 2] += (int16_t)((e * 7 + 8) >> 4);
+        next[x] += (int16_t)((e * 3 + 8) >> 4);
+        next[x + 1] += (int16_t)((e * 5 + 8) >> 4);
+        next[x + 2] += (int16_t)((e + 8) >> 4);
+    }
+    // Entries 0 and width + 1 catch error pushed past the edges; it is dropped
+    // like in the tool.
+    d.err_cur = next;
+    d.err_next = cur;
+}
+} // namespace
+
+const char *g4_dither_mode_name(G4DitherMode mode) {
+    switch (mode) {
+        case G4DitherMode::None: return "none";
+        case G4DitherMode::Bayer: return "bayer";
+        case G4DitherMode::FloydSteinberg: return "fs";
+        case G4DitherMode::BlueNoise: return "blue-noise";
+    }
+    return "unknown";
+}
+
+bool g4_dither_begin(G4Dither &d, G4DitherMode mode, uint16_t width, uint16_t x0, uint16_t y0) {
+    memset(&d, 0, sizeof(d));
+    d.mode = mode;
+    d.width = width;
+    d.x0 = x0;
+    d.y = y0;
+    if (mode != G4DitherMode::FloydSteinberg) return true;
+
+    d.err_cur = alloc_errors(width);
+    d.err_next = alloc_errors(width);
+    if (!d.err_cur || !d.err_next) {
+#ifdef ARDUINO
+        LOGE("EINK", "Dither buffer alloc failed (%u px)", (unsigned)width);
+#endif
+        g4_dither_end(d);
+        return false;
+    }
+    return true;
+}
+
+void g4_dither_row(G4Dither &d, const uint8_t *gray, uint8_t *levels) {
+    const uint32_t start_us = now_us();
+    switch (d.mode) {
+        case G4DitherMode::Bayer: {
+            const uint8_t *t = kBayer4[d.y & 3];
+            for (uint16_t x = 0; x < d.width; x++) {
+                levels[x] = quantize_offset(gray[x], bayer_offset(t[(d.x0 + x) & 3]));
+            }
+        } break;
+        case G4DitherMode::BlueNoise: {
+            const uint8_t *t = kBlueNoise16[d.y & 15];
+            for (uint16_t x = 0; x < d.width; x++) {
+                levels[x] = quantize_offset(gray[x], ((int32_t)t[(d.x0 + x) & 15] - 128) >> 4);
+            }
+        } break;
+        case G4DitherMode::FloydSteinberg:
+            if (d.err_cur) {
+                row_floyd_steinberg(d, gray, levels);
+                break;
+            }
+            // No error buffers (begin failed): plain quantization.
+            // fall through
+        case G4DitherMode::None:
+        default:
+            for (uint16_t x = 0; x < d.width; x++) {
+                levels[x] = gray[x] >> 4;
+            }
+            break;
+    }
+    d.y++;
+    d.pixels += d.width;
+    d.busy_us += now_us() - start_us;
+}
+
+void g4_dither_end(G4Dither &d) {
+#ifdef ARDUINO
+    if (d.pixels > 0) {
+        const uint32_t ms_per_mp = (uint32_t)((uint64_t)d.busy_us * 1000 / d.pixels);
+        LOGI("EINK", "Dither %s %lu px %lu ms (%lu ms/MP)", g4_dither_mode_name(d.mode),
+             (unsigned long)d.pixels, (unsigned long)(d.busy_us / 1000), (unsigned long)ms_per_mp);
+    }
+#endif
+    free_bytes(d.err_cur);
+    free_bytes(d.err_next);
+    d.err_cur = nullptr;
+    d.err_next = nullptr;
+    d.pixels = 0;
+    d.busy_us = 0;
+}
+
+void g4_pack_levels(const uint8_t *levels, uint16_t width, uint8_t *packed, bool mirror) {
+    for (uint16_t x = 0; x + 1 < width; x += 2) {
+        const uint8_t a = mirror ? levels[width - 1 - x] : levels[x];
+        const uint8_t b = mirror ? levels[width - 2 - x] : levels[x + 1];
+        packed[x / 2] = (uint8_t)((a << 4) | b);
+    }
+}
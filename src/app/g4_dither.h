@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fixed-point dithering of 8-bit gray rows to 4-bit panel levels, for
+// on-device conversions (BMP, JPEG) and the host codec (tools/g4codec), which
+// builds this file unchanged so both produce identical frames. Rows are fed
+// top-down one at a time; all kernels use integer math only.
+//
+// Kernels match the tools/jpg_to_g4.py variants:
+//   None            grey >> 4 (plain truncation)
+//   Bayer           4x4 ordered threshold offsets, as opt-bayer
+//   FloydSteinberg  error diffusion (7/3/5/1), as opt-fs; errors are carried
+//                   in a two-row int16 buffer in 1/16 gray steps
+//   BlueNoise       16x16 void-and-cluster threshold table, same amplitude as Bayer
+
+enum class G4DitherMode : uint8_t {
+    None = 0,
+    Bayer = 1,
+    FloydSteinberg = 2,
+    BlueNoise = 3,
+};
+
+struct G4Dither {
+    G4DitherMode mode;
+    uint16_t width;
+    uint16_t x0;          // canvas position of column 0 / the next row (threshold phase)
+    uint16_t y;
+    int16_t *err_cur;     // width + 2 entries (FloydSteinberg only)
+    int16_t *err_next;
+    uint32_t pixels;
+    uint32_t busy_us;
+};
+
+const char *g4_dither_mode_name(G4DitherMode mode);
+
+// Prepare a dither pass over rows of `width` pixels. (x0, y0) is the canvas
+// position of the first row's first pixel, so ordered patterns line up with
+// the tool's output. Fails only if the error buffer cannot be allocated.
+bool g4_dither_begin(G4Dither &d, G4DitherMode mode, uint16_t width, uint16_t x0 = 0, uint16_t y0 = 0);
+
+// Quantize the next row. `levels` receives one 0..15 level per pixel and may
+// alias `gray`.
+void g4_dither_row(G4Dither &d, const uint8_t *gray, uint8_t *levels);
+
+// Free buffers and log the pass timing (ms per megapixel, device only).
+void g4_dither_end(G4Dither &d);
+
+// Pack a row of levels (even width) two per byte, high nibble first.
+// `mirror` reverses the row (the panel's 180 degree rotation).
+void g4_pack_levels(const uint8_t *levels, uint16_t width, uint8_t *packed, bool mirror);
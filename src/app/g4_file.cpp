@@ -0,0 +1,114 @@
+#include "g4_file.h"
+
+#include "g4_tile_map.h"
+
+#include <string.h>
+
+namespace {
+static uint32_t g_crc_table[256];
+static bool g_crc_table_ready = false;
+
+static void ensure_crc_table() {
+    if (g_crc_table_ready) return;
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (uint8_t k = 0; k < 8; k++) {
+            c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        }
+        g_crc_table[i] = c;
+    }
+    g_crc_table_ready = true;
+}
+
+static bool fail(const char **error, const char *reason) {
+    if (error) *error = reason;
+    return false;
+}
+} // namespace
+
+bool g4_file_parse_header(const uint8_t *data, size_t len, uint32_t total_bytes,
+                          uint16_t panel_w, uint16_t panel_h,
+                          G4FileHeader *out, const char **error) {
+    if (!out) return fail(error, "no output");
+    const uint32_t frame_bytes = (uint32_t)(panel_w / 2) * panel_h;
+
+    uint32_t magic = 0;
+    if (data && len >= sizeof(magic)) {
+        memcpy(&magic, data, sizeof(magic));
+    }
+    // Exact frame size wins: a raw frame may start with any four bytes.
+    if (total_bytes == frame_bytes || magic != kG4FileMagic) {
+        if (total_bytes != frame_bytes) return fail(error, "size is not a frame");
+        memset(out, 0, sizeof(*out));
+        out->magic = kG4FileMagic;
+        out->version = kG4FileVersion;
+        out->encoding = (uint8_t)G4Encoding::Raw;
+        out->width = panel_w;
+        out->height = panel_h;
+        out->background = 0x0F;
+        out->header_bytes = 0;
+        out->payload_bytes = frame_bytes;
+        return true;
+    }
+
+    if (len < sizeof(G4FileHeader)) return fail(error, "short header");
+    G4FileHeader h;
+    memcpy(&h, data, sizeof(h));
+
+    if (h.version != kG4FileVersion) return fail(error, "unsupported version");
+    if (h.encoding != (uint8_t)G4Encoding::Raw && h.encoding != (uint8_t)G4Encoding::G4z) {
+        return fail(error, "unknown encoding");
+    }
+    if (h.width == 0 || h.height == 0 || (h.width & 3) || (h.x & 3)) return fail(error, "bad geometry");
+    if (h.background > 0x0F) return fail(error, "bad background");
+    if ((uint32_t)h.x + h.width > panel_w || (uint32_t)h.y + h.height > panel_h) {
+        return fail(error, "exceeds panel");
+    }
+    if (h.strip_rows == 0 || h.strip_count != (h.height + h.strip_rows - 1) / h.strip_rows) {
+        return fail(error, "bad strips");
+    }
+    const bool has_tiles = (h.flags & kG4FileHasTileHashes) != 0;
+    if (has_tiles != (h.tile_size != 0)) return fail(error, "bad tile table");
+
+    uint32_t tables = 0;
+    if (h.encoding == (uint8_t)G4Encoding::G4z) tables += 4u * (h.strip_count + 1);
+    if (h.flags & kG4FileHasStripCrc) tables += 4u * h.strip_count;
+    if (has_tiles) tables += 4u * g4_file_tile_count(h);
+    if (h.header_bytes != sizeof(G4FileHeader) + tables) return fail(error, "bad header size");
+    if ((uint64_t)h.header_bytes + h.payload_bytes != total_bytes) return fail(error, "size mismatch");
+    if (h.encoding == (uint8_t)G4Encoding::Raw && h.payload_bytes != (uint32_t)(h.width / 2) * h.height) {
+        return fail(error, "raw payload size");
+    }
+
+    *out = h;
+    return true;
+}
+
+uint32_t g4_file_crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    ensure_crc_table();
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = g_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void g4_file_tile_hashes(const uint8_t *packed, uint16_t width, uint16_t height,
+                         uint16_t tile_size, uint32_t *out) {
+    if (!packed || !out || tile_size == 0) return;
+    const size_t row_bytes = width / 2;
+    const size_t tile_bytes = tile_size / 2;
+    const uint32_t cols = (width + tile_size - 1) / tile_size;
+    const uint32_t rows = (height + tile_size - 1) / tile_size;
+    for (uint32_t i = 0; i < cols * rows; i++) out[i] = kG4TileHashSeed;
+
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t *row = packed + (size_t)y * row_bytes;
+        uint32_t *hashes = out + (y / tile_size) * cols;
+        for (uint32_t tx = 0; tx < cols; tx++) {
+            const size_t start = tx * tile_bytes;
+            const size_t len = start + tile_bytes <= row_bytes ? tile_bytes : row_bytes - start;
+            hashes[tx] = g4_tile_hash_span(hashes[tx], row + start, len);
+        }
+    }
+}
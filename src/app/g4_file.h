@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// G4 container: optional header in front of a packed 4bpp frame.
+//
+// A headerless .g4 (exactly panel_w * panel_h / 2 bytes) is still accepted.
+// With a header the file is (little-endian):
+//   G4FileHeader
+//   uint32_t strip_offsets[strip_count + 1]   encoding G4z only; relative to payload
+//   uint32_t strip_crc32[strip_count]         kG4FileHasStripCrc; CRC-32 of decoded strip
+//   uint32_t tile_hashes[cols * rows]         kG4FileHasTileHashes; see g4_tile_map.h
+//   payload (raw packed rows or G4Z strips, see g4z_codec.h)
+//
+// Validation only needs the header and the file size. A frame smaller than the
+// panel is placed at (x, y); the renderer fills the rest with `background`.
+
+static constexpr uint32_t kG4FileMagic = 0x31483447; // "G4H1"
+static constexpr uint8_t kG4FileVersion = 1;
+
+enum class G4Encoding : uint8_t {
+    Raw = 0,
+    G4z = 1,
+};
+
+static constexpr uint8_t kG4FileHasStripCrc = 0x01;
+static constexpr uint8_t kG4FileHasTileHashes = 0x02;
+
+struct G4FileHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t encoding;      // G4Encoding
+    uint8_t variant;       // encoder variant (informational, see tools/jpg_to_g4.py)
+    uint8_t flags;
+    uint16_t width;
+    uint16_t height;
+    uint16_t x;            // placement on the panel (sub-frames: rest is background);
+                           // x and width are multiples of 4 (16-bit host words)
+    uint16_t y;
+    uint16_t strip_rows;
+    uint16_t strip_count;
+    uint16_t tile_size;    // tile hash grid; 0 without kG4FileHasTileHashes
+    uint8_t background;    // 4-bit level around a sub-frame (letterbox)
+    uint8_t reserved;
+    uint32_t header_bytes; // header + tables = payload offset
+    uint32_t payload_bytes;
+};
+
+static_assert(sizeof(G4FileHeader) == 32, "G4FileHeader layout");
+
+static inline uint32_t g4_file_tile_count(const G4FileHeader &h) {
+    if (h.tile_size == 0) return 0;
+    return (uint32_t)((h.width + h.tile_size - 1) / h.tile_size) * ((h.height + h.tile_size - 1) / h.tile_size);
+}
+
+// Parse the first bytes of a .g4 (file or buffer) of `total_bytes`. Headerless
+// frames get a synthesized Raw header covering the panel. Returns false with a
+// short reason when the header is malformed or doesn't match the size/panel.
+bool g4_file_parse_header(const uint8_t *data, size_t len, uint32_t total_bytes,
+                          uint16_t panel_w, uint16_t panel_h,
+                          G4FileHeader *out, const char **error);
+
+// Tile hash table of a packed width x height frame (row-major, cols * rows
+// entries), hashed with g4_tile_hash_span like g4_tile_map. Used by encoders.
+void g4_file_tile_hashes(const uint8_t *packed, uint16_t width, uint16_t height,
+                         uint16_t tile_size, uint32_t *out);
+
+// CRC-32 (IEEE, zlib-compatible). Pass 0 to start, the previous result to continue.
+uint32_t g4_file_crc32(uint32_t crc, const uint8_t *data, size_t len);
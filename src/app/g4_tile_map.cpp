@@ -0,0 +1,176 @@
+#include "g4_tile_map.h"
+
+#include "board_config.h"
+
+#include <Arduino.h>
+
+namespace {
+static constexpr uint16_t kMaxTileCols = (DISPLAY_WIDTH + kG4TileSize - 1) / kG4TileSize;
+static constexpr uint16_t kMaxTileRows = (DISPLAY_HEIGHT + kG4TileSize - 1) / kG4TileSize;
+static constexpr uint16_t kMaxTiles = kMaxTileCols * kMaxTileRows;
+
+static constexpr uint32_t kRtcTileMapMagic = 0x52544354; // "RTCT"
+
+struct RtcTileMap {
+    uint32_t magic;
+    uint16_t w;
+    uint16_t h;
+    bool valid;
+    uint32_t hashes[kMaxTiles];
+};
+
+RTC_DATA_ATTR RtcTileMap g_rtc_tile_map;
+
+static uint32_t g_next_hashes[kMaxTiles];
+// Kept apart from the hashes: add_rows() is still accumulating them.
+static uint32_t g_next_salts[kMaxTiles];
+static uint16_t g_w = 0;
+static uint16_t g_h = 0;
+static uint16_t g_cols = 0;
+static uint16_t g_rows = 0;
+
+static inline uint32_t next_hash(uint16_t i) {
+    return g_next_hashes[i] ^ g_next_salts[i];
+}
+
+static void salt_tiles(uint32_t *hashes, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t salt) {
+    if (salt == 0 || w == 0 || h == 0) return;
+    const uint16_t tx_end = (uint16_t)min((uint32_t)g_cols, ((uint32_t)x + w + kG4TileSize - 1) / kG4TileSize);
+    const uint16_t ty_end = (uint16_t)min((uint32_t)g_rows, ((uint32_t)y + h + kG4TileSize - 1) / kG4TileSize);
+    for (uint16_t ty = y / kG4TileSize; ty < ty_end; ty++) {
+        for (uint16_t tx = x / kG4TileSize; tx < tx_end; tx++) {
+            const uint16_t i = ty * g_cols + tx;
+            // Per-tile value, so equal salts on neighbouring tiles stay distinct.
+            hashes[i] ^= (salt ^ ((uint32_t)i * 0x9E3779B1u)) * kG4TileHashPrime;
+        }
+    }
+}
+} // namespace
+
+void g4_tile_map_begin(uint16_t w, uint16_t h) {
+    g_w = min(w, (uint16_t)DISPLAY_WIDTH);
+    g_h = min(h, (uint16_t)DISPLAY_HEIGHT);
+    g_cols = (uint16_t)((g_w + kG4TileSize - 1) / kG4TileSize);
+    g_rows = (uint16_t)((g_h + kG4TileSize - 1) / kG4TileSize);
+    for (uint16_t i = 0; i < kMaxTiles; i++) {
+        g_next_hashes[i] = kG4TileHashSeed;
+        g_next_salts[i] = 0;
+    }
+}
+
+void g4_tile_map_set_hashes(const uint32_t *hashes, uint16_t count) {
+    if (!hashes) return;
+    const uint16_t n = min(count, (uint16_t)(g_cols * g_rows));
+    memcpy(g_next_hashes, hashes, sizeof(uint32_t) * n);
+}
+
+void g4_tile_map_add_rows(const uint8_t *data, uint16_t first_row, uint16_t rows, size_t stride) {
+    if (!data) return;
+    const size_t tile_bytes = kG4TileSize / 2;
+    const size_t row_bytes = g_w / 2;
+    for (uint16_t r = 0; r < rows; r++) {
+        const uint16_t y = first_row + r;
+        if (y >= g_h) break;
+        const uint8_t *row = data + (size_t)r * stride;
+        uint32_t *tile_hashes = &g_next_hashes[(y / kG4TileSize) * g_cols];
+        // Tile row spans are 32 bytes; the last one is shorter when the width
+        // is not a multiple of kG4TileSize (8 bytes on the 1872 px panel).
+        for (uint16_t tx = 0; tx < g_cols; tx++) {
+            const size_t offset = tx * tile_bytes;
+            const size_t len = min(tile_bytes, row_bytes - offset);
+            tile_hashes[tx] = g4_tile_hash_span(tile_hashes[tx], row + offset, len);
+        }
+    }
+}
+
+void g4_tile_map_salt(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t salt) {
+    salt_tiles(g_next_salts, x, y, w, h, salt);
+}
+
+void g4_tile_map_salt_previous(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t salt) {
+    if (!g4_tile_map_has_previous()) return;
+    salt_tiles(g_rtc_tile_map.hashes, x, y, w, h, salt);
+}
+
+bool g4_tile_map_has_previous() {
+    return g_rtc_tile_map.magic == kRtcTileMapMagic && g_rtc_tile_map.valid &&
+           g_rtc_tile_map.w == g_w && g_rtc_tile_map.h == g_h;
+}
+
+bool g4_tile_map_tile_changed(uint16_t tx, uint16_t ty) {
+    if (!g4_tile_map_has_previous()) return true;
+    const uint16_t i = ty * g_cols + tx;
+    return next_hash(i) != g_rtc_tile_map.hashes[i];
+}
+
+bool g4_tile_map_previous_is_solid(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t level) {
+    if (!g4_tile_map_has_previous()) return false;
+    if (w == 0 || h == 0) return true;
+    const size_t tile_bytes = kG4TileSize / 2;
+    const size_t row_bytes = g_w / 2;
+    const uint8_t packed = (uint8_t)((level << 4) | (level & 0x0F));
+    uint8_t span[kG4TileSize / 2];
+    memset(span, packed, sizeof(span));
+
+    const uint16_t tx_end = (uint16_t)min((uint32_t)g_cols, ((uint32_t)x + w + kG4TileSize - 1) / kG4TileSize);
+    const uint16_t ty_end = (uint16_t)min((uint32_t)g_rows, ((uint32_t)y + h + kG4TileSize - 1) / kG4TileSize);
+    for (uint16_t ty = y / kG4TileSize; ty < ty_end; ty++) {
+        const uint16_t tile_rows = (uint16_t)min((uint32_t)kG4TileSize, (uint32_t)(g_h - ty * kG4TileSize));
+        for (uint16_t tx = x / kG4TileSize; tx < tx_end; tx++) {
+            const size_t len = min(tile_bytes, row_bytes - tx * tile_bytes);
+            uint32_t hash = kG4TileHashSeed;
+            for (uint16_t r = 0; r < tile_rows; r++) {
+                hash = g4_tile_hash_span(hash, span, len);
+            }
+            if (g_rtc_tile_map.hashes[ty * g_cols + tx] != hash) return false;
+        }
+    }
+    return true;
+}
+
+uint16_t g4_tile_map_cols() {
+    return g_cols;
+}
+
+uint16_t g4_tile_map_rows() {
+    return g_rows;
+}
+
+G4TileDiff g4_tile_map_diff() {
+    G4TileDiff diff = {};
+    diff.total_tiles = g_cols * g_rows;
+
+    uint16_t min_tx = g_cols, min_ty = g_rows, max_tx = 0, max_ty = 0;
+    for (uint16_t ty = 0; ty < g_rows; ty++) {
+        for (uint16_t tx = 0; tx < g_cols; tx++) {
+            if (!g4_tile_map_tile_changed(tx, ty)) continue;
+            diff.changed_tiles++;
+            min_tx = min(min_tx, tx);
+            min_ty = min(min_ty, ty);
+            max_tx = max(max_tx, tx);
+            max_ty = max(max_ty, ty);
+        }
+    }
+
+    if (diff.changed_tiles > 0) {
+        diff.x = min_tx * kG4TileSize;
+        diff.y = min_ty * kG4TileSize;
+        diff.w = (uint16_t)min((uint32_t)(max_tx + 1) * kG4TileSize, (uint32_t)g_w) - diff.x;
+        diff.h = (uint16_t)min((uint32_t)(max_ty + 1) * kG4TileSize, (uint32_t)g_h) - diff.y;
+    }
+    return diff;
+}
+
+void g4_tile_map_commit() {
+    g_rtc_tile_map.magic = kRtcTileMapMagic;
+    g_rtc_tile_map.w = g_w;
+    g_rtc_tile_map.h = g_h;
+    for (uint16_t i = 0; i < kMaxTiles; i++) {
+        g_rtc_tile_map.hashes[i] = next_hash(i);
+    }
+    g_rtc_tile_map.valid = true;
+}
+
+void g4_tile_map_invalidate() {
+    g_rtc_tile_map.valid = false;
+}
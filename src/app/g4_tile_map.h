@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Per-tile content hashes of the last photo on the panel, for differential
+// updates. The frame is split into kG4TileSize x kG4TileSize tiles; hashes of
+// the frame being loaded are accumulated row by row and compared against the
+// previous frame's map (kept in RTC memory, so it survives deep sleep).
+
+static constexpr uint16_t kG4TileSize = 64;
+
+// Tile hashes are FNV-1a over each tile's packed row spans, in 32-bit words
+// with a byte-wise tail. Shared with the G4 container's tile table
+// (g4_file_tile_hashes) and tools/jpg_to_g4.py, so the three must agree.
+static constexpr uint32_t kG4TileHashSeed = 2166136261u;
+static constexpr uint32_t kG4TileHashPrime = 16777619u;
+
+static inline uint32_t g4_tile_hash_span(uint32_t h, const uint8_t *p, size_t len) {
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        uint32_t word;
+        memcpy(&word, p + i, sizeof(word));
+        h = (h ^ word) * kG4TileHashPrime;
+    }
+    for (; i < len; i++) {
+        h = (h ^ p[i]) * kG4TileHashPrime;
+    }
+    return h;
+}
+
+struct G4TileDiff {
+    uint16_t changed_tiles;
+    uint16_t total_tiles;
+    // Union of the changed tiles in panel pixels (valid when changed_tiles > 0).
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+// Start hashing a new w x h frame (packed 4bpp).
+void g4_tile_map_begin(uint16_t w, uint16_t h);
+
+// Use hashes computed by the encoder (G4 container tile table, row-major,
+// cols * rows entries) instead of hashing rows on device.
+void g4_tile_map_set_hashes(const uint32_t *hashes, uint16_t count);
+
+// Hash `rows` consecutive packed rows starting at panel row `first_row`.
+// `stride` is the distance between rows in `data` (bytes).
+void g4_tile_map_add_rows(const uint8_t *data, uint16_t first_row, uint16_t rows, size_t stride);
+
+// True when the previous map describes what the panel currently shows.
+bool g4_tile_map_has_previous();
+
+// Mix `salt` into every tile overlapping the area (frame pixels), for content
+// loaded on top of the frame (photo overlays). Salting a tile again with the
+// same value takes it out. The next map's salts are cleared by begin();
+// _previous patches the map of what the panel shows (overlay-only updates).
+void g4_tile_map_salt(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t salt);
+void g4_tile_map_salt_previous(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t salt);
+
+// Whether tile (tx, ty) differs from the previous frame. All rows of that tile
+// row must have been added. Always true without a previous map.
+bool g4_tile_map_tile_changed(uint16_t tx, uint16_t ty);
+
+uint16_t g4_tile_map_cols();
+uint16_t g4_tile_map_rows();
+
+// Whether every tile overlapping the area held a solid `level` in the previous
+// frame (e.g. the letterbox around a sub-frame is already on the panel).
+bool g4_tile_map_previous_is_solid(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t level);
+
+// Compare the complete new frame against the previous one.
+G4TileDiff g4_tile_map_diff();
+
+// The new frame is on the panel now; it becomes the previous map.
+void g4_tile_map_commit();
+
+// Something else was drawn; the next photo can't be diffed.
+void g4_tile_map_invalidate();
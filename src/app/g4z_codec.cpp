@@ -0,0 +1,128 @@
+#include "g4z_codec.h"
+
+#include <string.h>
+
+namespace {
+static constexpr uint16_t kNoPos = 0xFFFF;
+
+static inline uint32_t prefix_hash(const uint8_t *p) {
+    const uint32_t key = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (key * 2654435761u) >> 20; // 12 bits, kG4zHashSize
+}
+
+static bool flush_literals(const uint8_t *in, size_t start, size_t end,
+                           uint8_t *out, size_t out_cap, size_t &op) {
+    while (start < end) {
+        const size_t n = end - start < kG4zMaxLiteral ? end - start : kG4zMaxLiteral;
+        if (op + 1 + n > out_cap) return false;
+        out[op++] = (uint8_t)(n - 1);
+        memcpy(out + op, in + start, n);
+        op += n;
+        start += n;
+    }
+    return true;
+}
+
+static size_t match_length(const uint8_t *in, size_t i, size_t limit, size_t distance) {
+    size_t n = 0;
+    while (i + n < limit && in[i + n] == in[i + n - distance]) n++;
+    return n;
+}
+} // namespace
+
+size_t g4z_encode_strip(const uint8_t *in, size_t len, size_t row_bytes,
+                        uint8_t *out, size_t out_cap, uint16_t *scratch) {
+    if (!in || !out || !scratch || len >= kNoPos) return 0;
+    // Chained hash of visited positions: head per bucket, prev per position.
+    uint16_t *head = scratch;
+    uint16_t *prev = scratch + kG4zHashSize;
+    for (size_t k = 0; k < kG4zHashSize; k++) head[k] = kNoPos;
+
+    size_t op = 0;
+    size_t lit_start = 0;
+    size_t i = 0;
+    while (i < len) {
+        const size_t limit = len < i + kG4zMaxRun ? len : i + kG4zMaxRun;
+        size_t run_len = 1;
+        while (i + run_len < limit && in[i + run_len] == in[i]) run_len++;
+
+        size_t best_len = 0;
+        size_t best_dist = 0;
+        if (i >= row_bytes) {
+            best_len = match_length(in, i, limit, row_bytes);
+            best_dist = row_bytes;
+        }
+        const bool has_key = i + 3 <= len;
+        uint32_t bucket = 0;
+        if (has_key) {
+            bucket = prefix_hash(in + i);
+            for (uint16_t p = head[bucket]; p != kNoPos; p = prev[p]) {
+                if (memcmp(in + p, in + i, 3) != 0) continue;
+                const size_t distance = i - p;
+                if (distance != row_bytes) {
+                    const size_t n = match_length(in, i, limit, distance);
+                    if (n > best_len) {
+                        best_len = n;
+                        best_dist = distance;
+                    }
+                }
+                break;
+            }
+            prev[i] = head[bucket];
+            head[bucket] = (uint16_t)i;
+        }
+
+        if (run_len >= kG4zMinRun && run_len >= best_len) {
+            if (!flush_literals(in, lit_start, i, out, out_cap, op) || op + 2 > out_cap) return 0;
+            out[op++] = (uint8_t)(0x80 | (run_len - kG4zMinRun));
+            out[op++] = in[i];
+            i += run_len;
+            lit_start = i;
+        } else if (best_len >= kG4zMinRun) {
+            if (!flush_literals(in, lit_start, i, out, out_cap, op) || op + 3 > out_cap) return 0;
+            out[op++] = (uint8_t)(0xC0 | (best_len - kG4zMinRun));
+            out[op++] = (uint8_t)(best_dist & 0xFF);
+            out[op++] = (uint8_t)(best_dist >> 8);
+            i += best_len;
+            lit_start = i;
+        } else {
+            i++;
+        }
+    }
+    if (!flush_literals(in, lit_start, len, out, out_cap, op)) return 0;
+    return op;
+}
+
+bool g4z_decode_strip(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_len) {
+    if (!in || !out) return false;
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < in_len) {
+        const uint8_t token = in[ip++];
+        if (token < 0x80) {
+            const size_t n = (size_t)token + 1;
+            if (ip + n > in_len || op + n > out_len) return false;
+            memcpy(out + op, in + ip, n);
+            ip += n;
+            op += n;
+        } else if (token < 0xC0) {
+            const size_t n = (size_t)(token & 0x3F) + kG4zMinRun;
+            if (ip >= in_len || op + n > out_len) return false;
+            memset(out + op, in[ip++], n);
+            op += n;
+        } else {
+            const size_t n = (size_t)(token & 0x3F) + kG4zMinRun;
+            if (ip + 2 > in_len || op + n > out_len) return false;
+            const size_t distance = (size_t)in[ip] | ((size_t)in[ip + 1] << 8);
+            ip += 2;
+            if (distance == 0 || distance > op) return false;
+            // Byte-wise: overlapping matches repeat the pattern.
+            const uint8_t *src = out + op - distance;
+            for (size_t i = 0; i < n; i++) {
+                out[op + i] = src[i];
+            }
+            op += n;
+        }
+    }
+    return op == out_len;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// G4Z: compressed packed-4bpp payload of a G4 container (encoding G4z, see
+// g4_file.h), decoded strip by strip via the container's strip index.
+//
+// Each strip holds `strip_rows` packed rows (the last one may be shorter) and
+// decodes independently: back-references never leave the strip, so the decoder
+// only needs the strip's own output buffer as its window.
+//
+// Strip token stream:
+//   0x00-0x7F  literal run, (t + 1) bytes follow
+//   0x80-0xBF  byte run, (t & 0x3F) + 3 copies of the next byte
+//   0xC0-0xFF  match, (t & 0x3F) + 3 bytes copied from `distance` bytes back
+//              (uint16_t distance follows; may overlap the output)
+
+static constexpr uint8_t kG4zMinRun = 3;
+static constexpr uint8_t kG4zMaxRun = 0x3F + kG4zMinRun;
+static constexpr uint8_t kG4zMaxLiteral = 0x80;
+
+// Worst case encoded size of `raw_bytes`: runs and matches never grow, but each
+// one (>= 3 bytes) can split the literals around it and cost an extra token.
+static inline size_t g4z_max_encoded_size(size_t raw_bytes) {
+    return raw_bytes + raw_bytes / (kG4zMinRun + 1) + raw_bytes / kG4zMaxLiteral + 2;
+}
+
+// Scratch entries (uint16_t) g4z_encode_strip needs for a strip of `len` bytes.
+static constexpr size_t kG4zHashSize = 4096;
+static inline size_t g4z_encode_scratch_entries(size_t len) {
+    return kG4zHashSize + len;
+}
+
+// Encode one strip of packed rows (`row_bytes` each, len < 65535): greedy byte
+// runs, matches against the previous row and against the last position of the
+// same 3-byte prefix. Byte-identical to tools/jpg_to_g4.py. Returns the encoded
+// size, or 0 if `out_cap` is too small.
+size_t g4z_encode_strip(const uint8_t *in, size_t len, size_t row_bytes,
+                        uint8_t *out, size_t out_cap, uint16_t *scratch);
+
+// Decode one strip. Fails unless exactly `out_len` bytes are produced from
+// exactly `in_len` input bytes.
+bool g4z_decode_strip(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_len);
@@ -1,16 +1,43 @@
 #include "image_render_service.h"
 
 #include "display_manager.h"
+#include "board_config.h"
 #include "it8951_renderer.h"
+#include "jpeg_g4.h"
 #include "log_manager.h"
+#include "photo_catalog.h"
+#include "photo_overlay.h"
 #include "rtc_state.h"
 #include "time_utils.h"
 
 #include <SD.h>
-#include <algorithm>
-#include <vector>
 
 namespace {
+// G4 file to render for a queue path: the path itself, or for a JPEG its cached
+// conversion (empty when there is none yet).
+static String g4_path_for(const String &path) {
+    if (!jpeg_g4_is_jpeg_name(path.c_str())) return path;
+    if (!JPEG_G4_CACHE) return String();
+    const String cache = jpeg_g4_cache_path(path.c_str());
+    return SD.exists(cache) ? cache : String();
+}
+
+static bool render_jpeg_path(const String &path) {
+    const String cache = g4_path_for(path);
+    if (cache.length() > 0) {
+        LOGI("EINK", "Render JPEG cache=%s", cache.c_str());
+        if (it8951_render_g4(cache.c_str())) return true;
+        LOGW("EINK", "JPEG cache render failed, converting again");
+    }
+    LOGI("EINK", "Render JPEG=%s", path.c_str());
+    const String cache_path = jpeg_g4_cache_path(path.c_str());
+    if (!it8951_render_jpeg(path.c_str(), JPEG_G4_CACHE ? cache_path.c_str() : nullptr)) {
+        LOGE("EINK", "Render JPEG failed");
+        return false;
+    }
+    return true;
+}
+
 static bool render_g4_path(const String &path) {
     const bool ui_was_active = display_manager_ui_is_active();
     if (ui_was_active) {
@@ -24,6 +51,11 @@ static bool render_g4_path(const String &path) {
     }
     LOG_DURATION("EINK", "Init", disp_start);
 
+    photo_overlay_set_caption(path.c_str());
+    if (jpeg_g4_is_jpeg_name(path.c_str())) {
+        return render_jpeg_path(path);
+    }
+
     LOGI("EINK", "Render G4=%s", path.c_str());
     if (!it8951_render_g4(path.c_str())) {
         LOGE("EINK", "Render G4 failed");
@@ -33,114 +65,118 @@ static bool render_g4_path(const String &path) {
     return true;
 }
 
-// Extract the expiry from queue-temporary/<EXPIRES_UTC>__<UPLOAD_UTC>__<slug>.g4.
-// We only need the first timestamp for expiry cleanup.
-static bool parse_temp_expiry(const String &name, time_t *out_epoch) {
-    if (!out_epoch) return false;
-    if (!name.startsWith("queue-temporary/")) return false;
-    const int prefix_len = strlen("queue-temporary/");
-    const int first_sep = name.indexOf("__", prefix_len);
-    if (first_sep < 0) return false;
-    const String ts = name.substring(prefix_len, first_sep);
-    return time_utils::parse_utc_timestamp(ts.c_str(), out_epoch);
+static bool pick_from_queue(PhotoQueue queue, uint32_t count, SdImageSelectMode mode, const char *last_name,
+                            String &out) {
+    if (count == 0) return false;
+    uint32_t index = 0;
+    if (mode == SdImageSelectMode::Random) {
+        index = (uint32_t)random(count);
+    } else if (last_name && last_name[0] != '\0' && photo_catalog_index_of(last_name, &index)) {
+        index = (index + 1) % count;
+    } else {
+        index = 0;
+    }
+    return photo_catalog_get(queue, index, out);
 }
 
-// Collect .g4 names from a single directory and apply a prefix so the caller
-// receives logical paths like queue-permanent/<name> or queue-temporary/<name>.
-static bool list_g4_names_in_dir(const char *dir, const char *prefix, std::vector<String> &out) {
-    if (!dir) return false;
-    if (!SD.exists(dir)) return true;
+// Pick the next queue image (no priority override) from the photo catalog.
+// Alternates permanent and temporary queues when both have candidates.
+static bool select_from_catalog(SdImageSelectMode mode, String &out_name, bool *out_is_temp) {
+    PhotoCatalogInfo info;
+    if (!photo_catalog_open(&info)) {
+        LOGE("SD", "Photo catalog unavailable");
+        return false;
+    }
+
+    // Only delete expired temp files when we have a valid clock. When time is
+    // not valid, all temp files stay candidates.
+    if (time_utils::is_time_valid() && info.earliest_expiry != 0 &&
+        photo_catalog_purge_expired((uint32_t)time(nullptr)) > 0) {
+        if (!photo_catalog_open(&info)) return false;
+    }
 
-    File root = SD.open(dir);
-    if (!root) return false;
-    if (!root.isDirectory()) {
-        root.close();
+    const uint32_t perm_count = info.count[(uint8_t)PhotoQueue::Permanent];
+    const uint32_t temp_count = info.count[(uint8_t)PhotoQueue::Temporary];
+    const bool has_temp = temp_count > 0;
+    const bool has_perm = perm_count > 0;
+    if (!has_temp && !has_perm) {
+        LOGW("SD", "No .g4 files found");
         return false;
     }
 
-    File file = root.openNextFile();
-    while (file) {
-        if (!file.isDirectory()) {
-            const char *name = file.name();
-            if (name) {
-                const size_t len = strlen(name);
-                if (len >= 3 && strcmp(name + (len - 3), ".g4") == 0) {
-                    String entry = prefix ? String(prefix) + String(name) : String(name);
-                    out.push_back(entry);
-                }
-            }
+    // Alternate permanent/temporary when both are available. If one is empty, always use the other.
+    const bool choose_temp = has_temp && (!has_perm || !rtc_image_state_get_last_was_temp());
+    if (choose_temp) {
+        if (!pick_from_queue(PhotoQueue::Temporary, temp_count, mode, rtc_image_state_get_last_temp_name(), out_name)) {
+            return false;
         }
-        file.close();
-        file = root.openNextFile();
+        *out_is_temp = true;
+        return true;
     }
-
-    root.close();
+    if (!pick_from_queue(PhotoQueue::Permanent, perm_count, mode, rtc_image_state_get_last_perm_name(), out_name)) {
+        return false;
+    }
+    *out_is_temp = false;
     return true;
 }
 
-static void sort_names(std::vector<String> &names) {
-    std::sort(names.begin(), names.end(), [](const String &a, const String &b) {
-        return a.compareTo(b) < 0;
-    });
-}
-
-static bool pick_random_from_list(const std::vector<String> &names, String &out) {
-    if (names.empty()) return false;
-    const size_t index = static_cast<size_t>(random(names.size()));
-    out = names[index];
-    return true;
+static bool select_next_image(SdImageSelectMode mode, String &out_name, bool *out_is_temp) {
+    const unsigned long start_ms = millis();
+    bool ok = select_from_catalog(mode, out_name, out_is_temp);
+    // A pick that is gone means the card changed behind the catalog's back.
+    if (ok && !SD.exists("/" + out_name)) {
+        LOGW("SD", "Catalog entry missing on SD: %s", out_name.c_str());
+        photo_catalog_invalidate();
+        ok = select_from_catalog(mode, out_name, out_is_temp);
+    }
+    LOG_DURATION("SD", "Pick", start_ms);
+    return ok;
 }
 
-static bool pick_sequential_from_list(const std::vector<String> &names, const char *last_name, String &out) {
-    if (names.empty()) return false;
-    size_t index = 0;
-    bool found_last = false;
-    if (last_name && last_name[0] != '\0') {
-        for (size_t i = 0; i < names.size(); i++) {
-            if (names[i] == last_name) {
-                index = (i + 1) % names.size();
-                found_last = true;
-                break;
-            }
-        }
+static void record_rendered(SdImageSelectMode mode, const String &name, bool is_temp) {
+    if (mode == SdImageSelectMode::Sequential) {
+        rtc_image_state_set_last_image_name(name.c_str());
     }
-    if (!found_last) {
-        index = 0;
+    // Store per-queue last names so sequential mode advances within each queue.
+    if (is_temp) {
+        rtc_image_state_set_last_temp_name(name.c_str());
+    } else {
+        rtc_image_state_set_last_perm_name(name.c_str());
     }
-    out = names[index];
-    return true;
+    rtc_image_state_set_last_was_temp(is_temp);
 }
 
-static bool select_from_list(
-    const std::vector<String> &names,
-    SdImageSelectMode mode,
-    const char *last_name,
-    String &out
-) {
-    if (mode == SdImageSelectMode::Random) {
-        return pick_random_from_list(names, out);
-    }
-    return pick_sequential_from_list(names, last_name, out);
+// Pick made ahead of time by image_render_service_stage_next(); the renderer
+// holds the pixels in its spare controller buffer.
+static String g_staged_name;
+static bool g_staged_is_temp = false;
+static SdImageSelectMode g_staged_mode = SdImageSelectMode::Random;
+
+static void clear_staged_pick() {
+    g_staged_name = "";
+    g_staged_is_temp = false;
 }
 
-// Filter temp names, optionally deleting expired files if time is valid.
-// When time is not valid, we skip cleanup and treat all temp files as candidates.
-static bool build_temp_candidates(std::vector<String> &names, bool allow_cleanup, time_t now, std::vector<String> &out) {
-    out.clear();
-    for (const auto &name : names) {
-        if (allow_cleanup) {
-            time_t expiry = 0;
-            if (parse_temp_expiry(name, &expiry) && expiry <= now) {
-                const String path = "/" + name;
-                if (SD.exists(path)) {
-                    SD.remove(path);
-                }
-                continue;
-            }
-        }
-        out.push_back(name);
-    }
-    return !out.empty();
+// Present the staged pick if it is still usable. Returns false (and forgets
+// it) when the caller should fall back to a regular render.
+static bool present_staged_pick(SdImageSelectMode mode) {
+    if (g_staged_name.length() == 0) return false;
+    const String name = g_staged_name;
+    const bool is_temp = g_staged_is_temp;
+    const bool same_mode = g_staged_mode == mode;
+    clear_staged_pick();
+
+    const String path = "/" + name;
+    if (!same_mode || !SD.exists(path)) return false;
+    if (display_manager_ui_is_active()) return false;
+    const String g4_path = g4_path_for(path);
+    if (g4_path.length() == 0) return false;
+
+    LOGI("EINK", "Present staged G4=%s", g4_path.c_str());
+    photo_overlay_set_caption(path.c_str());
+    if (!it8951_renderer_present_staged(g4_path.c_str())) return false;
+    record_rendered(mode, name, is_temp);
+    return true;
 }
 }
 
@@ -152,107 +188,116 @@ bool image_render_service_render_next(SdImageSelectMode mode, uint32_t last_inde
         const String priority_path = "/" + String(priority_name);
         rtc_image_state_clear_priority_image_name();
         if (SD.exists(priority_path)) {
+            clear_staged_pick();
             if (!render_g4_path(priority_path)) {
                 return false;
             }
-            if (mode == SdImageSelectMode::Sequential) {
-                rtc_image_state_set_last_image_name(priority_name);
-            }
-            const bool is_temp = String(priority_name).startsWith("queue-temporary/");
-            if (is_temp) {
-                rtc_image_state_set_last_temp_name(priority_name);
-            } else {
-                rtc_image_state_set_last_perm_name(priority_name);
-            }
-            rtc_image_state_set_last_was_temp(is_temp);
+            const String name(priority_name);
+            record_rendered(mode, name, name.startsWith("queue-temporary/"));
             return true;
         }
     }
 
-    // Build logical lists from /queue-permanent and /queue-temporary only (no root fallback).
-    std::vector<String> perm_names;
-    std::vector<String> temp_names;
-    if (!list_g4_names_in_dir("/queue-permanent", "queue-permanent/", perm_names)) {
-        LOGE("SD", "Failed to open /queue-permanent");
-        return false;
+    if (present_staged_pick(mode)) {
+        return true;
     }
-    if (!list_g4_names_in_dir("/queue-temporary", "queue-temporary/", temp_names)) {
-        LOGE("SD", "Failed to open /queue-temporary");
+
+    String selected_name;
+    bool selected_is_temp = false;
+    if (!select_next_image(mode, selected_name, &selected_is_temp)) {
         return false;
     }
 
-    sort_names(perm_names);
-    sort_names(temp_names);
-
-    // Only delete expired temp files when we have a valid clock.
-    const bool can_cleanup = time_utils::is_time_valid();
-    time_t now = 0;
-    if (can_cleanup) {
-        now = time(nullptr);
+    const String selected_path = "/" + selected_name;
+    if (!render_g4_path(selected_path)) {
+        return false;
     }
 
-    std::vector<String> temp_candidates;
-    const bool has_temp = build_temp_candidates(temp_names, can_cleanup, now, temp_candidates);
-    const bool has_perm = !perm_names.empty();
+    record_rendered(mode, selected_name, selected_is_temp);
+    return true;
+}
+
+bool image_render_service_stage_next(SdImageSelectMode mode) {
+    clear_staged_pick();
+    if (rtc_image_state_get_priority_image_name()[0] != '\0') return false;
+    if (display_manager_ui_is_active()) return false;
 
-    if (!has_temp && !has_perm) {
-        LOGW("SD", "No .g4 files found");
+    String selected_name;
+    bool selected_is_temp = false;
+    if (!select_next_image(mode, selected_name, &selected_is_temp)) {
         return false;
     }
 
-    // Alternate permanent/temporary when both are available. If one is empty, always use the other.
-    const bool last_was_temp = rtc_image_state_get_last_was_temp();
-    bool choose_temp = false;
-    if (has_temp && has_perm) {
-        choose_temp = !last_was_temp;
-    } else if (has_temp) {
-        choose_temp = true;
-    } else {
-        choose_temp = false;
+    // JPEGs are only staged once a cached conversion exists.
+    const String selected_path = g4_path_for("/" + selected_name);
+    if (selected_path.length() == 0) {
+        return false;
     }
-
-    String selected_name;
-    bool selected_is_temp = false;
-    if (choose_temp && has_temp) {
-        const char *last_temp = rtc_image_state_get_last_temp_name();
-        if (!select_from_list(temp_candidates, mode, last_temp, selected_name)) {
-            choose_temp = false;
-        } else {
-            selected_is_temp = true;
-        }
+    // The staged frame carries its own caption; the photo on the panel keeps
+    // the current one for overlay-only updates until it is presented.
+    char shown_caption[48];
+    strlcpy(shown_caption, photo_overlay_caption(), sizeof(shown_caption));
+    photo_overlay_set_caption(("/" + selected_name).c_str());
+    const bool staged = it8951_renderer_stage_g4(selected_path.c_str());
+    photo_overlay_set_caption_text(shown_caption);
+    if (!staged) {
+        return false;
     }
+    g_staged_name = selected_name;
+    g_staged_is_temp = selected_is_temp;
+    g_staged_mode = mode;
+    return true;
+}
 
-    if (!selected_is_temp) {
-        const char *last_perm = rtc_image_state_get_last_perm_name();
-        if (!select_from_list(perm_names, mode, last_perm, selected_name)) {
-            if (has_temp) {
-                const char *last_temp = rtc_image_state_get_last_temp_name();
-                if (!select_from_list(temp_candidates, mode, last_temp, selected_name)) {
-                    LOGW("SD", "No .g4 files found");
-                    return false;
-                }
-                selected_is_temp = true;
-            } else {
-                LOGW("SD", "No .g4 files found");
-                return false;
-            }
+void image_render_service_forget_staged(const char *name) {
+    if (g_staged_name.length() == 0) return;
+    if (name && g_staged_name != name) return;
+    LOGI("EINK", "Dropping staged %s", g_staged_name.c_str());
+    clear_staged_pick();
+}
+
+bool image_render_service_render_collage(const NameList &names) {
+    if (names.size() < 2 || names.size() > kCollageMaxCells) return false;
+    const uint8_t count = (uint8_t)names.size();
+    clear_staged_pick();
+
+    String paths[kCollageMaxCells];
+    for (uint8_t i = 0; i < count; i++) {
+        paths[i] = g4_path_for("/" + String(names[i]));
+        if (paths[i].length() == 0 || !SD.exists(paths[i])) {
+            LOGE("EINK", "Collage image unavailable: %s", names[i]);
+            return false;
         }
     }
 
-    const String selected_path = "/" + selected_name;
-    if (!render_g4_path(selected_path)) {
-        return false;
+    // Grid in viewer space, then mapped to frame space like the tool's output.
+    static constexpr uint16_t kGutter = 8;
+    const uint8_t cols = count == 4 ? 2 : count;
+    const uint8_t rows = count == 4 ? 2 : 1;
+    const uint16_t cell_w = (uint16_t)(((DISPLAY_WIDTH - (cols + 1) * kGutter) / cols) & ~3u);
+    const uint16_t cell_h = (uint16_t)((DISPLAY_HEIGHT - (rows + 1) * kGutter) / rows);
+    CollageCell cells[kCollageMaxCells];
+    for (uint8_t i = 0; i < count; i++) {
+        CollageCell &cell = cells[i];
+        cell.g4_path = paths[i].c_str();
+        cell.w = cell_w;
+        cell.h = cell_h;
+        cell.x = (uint16_t)(kGutter + (i % cols) * (cell_w + kGutter));
+        cell.y = (uint16_t)(kGutter + (i / cols) * (cell_h + kGutter));
+        if (DISPLAY_ROTATION == 2) {
+            cell.x = (uint16_t)(DISPLAY_WIDTH - cell.x - cell.w);
+            cell.y = (uint16_t)(DISPLAY_HEIGHT - cell.y - cell.h);
+        }
     }
 
-    if (mode == SdImageSelectMode::Sequential) {
-        rtc_image_state_set_last_image_name(selected_name.c_str());
+    if (display_manager_ui_is_active()) {
+        display_manager_ui_stop();
     }
-    // Store per-queue last names so sequential mode advances within each queue.
-    if (selected_is_temp) {
-        rtc_image_state_set_last_temp_name(selected_name.c_str());
-    } else {
-        rtc_image_state_set_last_perm_name(selected_name.c_str());
+    if (!it8951_renderer_init()) {
+        LOGE("EINK", "Init failed");
+        return false;
     }
-    rtc_image_state_set_last_was_temp(selected_is_temp);
-    return true;
+    photo_overlay_set_caption(nullptr);
+    LOGI("EINK", "Render collage of %u", (unsigned)count);
+    return it8951_render_collage(cells, count, CollageFit::Auto);
 }
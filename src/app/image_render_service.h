@@ -1,8 +1,23 @@
 #pragma once
 
 #include <Arduino.h>
+#include "name_list.h"
 #include "sd_photo_picker.h"
 
 // Central image render pipeline: priority override + sequential/random selection.
 // Returns true if an image was rendered successfully.
 bool image_render_service_render_next(SdImageSelectMode mode, uint32_t last_index, const char *last_name);
+
+// Always-on idle work: pick the next image now and preload it into spare
+// IT8951 memory, so the next render_next() only has to trigger the refresh.
+// The pick is dropped if anything else renders first. Returns true if staged.
+bool image_render_service_stage_next(SdImageSelectMode mode);
+
+// Forget the staged pick when its queue file (name relative to the SD root)
+// was replaced or deleted; nullptr forgets it regardless of name.
+void image_render_service_forget_staged(const char *name);
+
+// Show 2..4 queue images (names relative to the SD root) side by side in one
+// refresh: 2 or 3 in a row, 4 as a 2x2 grid, in viewer orientation. JPEGs need
+// a cached conversion. Returns true if the collage was rendered.
+bool image_render_service_render_collage(const NameList &names);
@@ -3,12 +3,31 @@
 #include "board_config.h"
 #include "display_power.h"
 #include "display_manager.h"
+#include "g4_dither.h"
+#include "g4_file.h"
+#include "g4_tile_map.h"
+#include "g4z_codec.h"
+#include "jpeg_g4.h"
+#include "it8951_transport.h"
 #include "log_manager.h"
+#include "panel_levels.h"
+#include "photo_overlay.h"
+#include "refresh_policy.h"
 
 #include <SD.h>
+#include <WiFi.h>
 #include <GxEPD2.h>
 #include <it8951/GxEPD2_it78_1872x1404.h>
+#include <driver/gpio.h>
 #include <esp_heap_caps.h>
+#include <esp_sleep.h>
+#include <soc/soc_caps.h>
+
+#include <algorithm>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
 
 // ---------------------------------------------------------------------------
 // Display wiring (from board overrides)
@@ -31,11 +50,19 @@ static uint8_t *grey_palette_buffer = nullptr;
 static uint8_t *raw_row_buffer = nullptr;
 static uint8_t *g4_row_buffer = nullptr;
 static uint8_t *g4_chunk_buffer = nullptr;
+static uint8_t *g4_chunk_buffer_alt = nullptr;
 
 // Forward declarations for low-level IT8951 I80 helpers (defined below).
 static void it8951_wait_ready(uint16_t busy_time_ms);
 static void it8951_write_command16(uint16_t cmd);
 static void it8951_write_data16(uint16_t data);
+static void it8951_display_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h, EinkWaveform waveform);
+static void it8951_read_data_words(uint16_t *out, uint16_t count);
+static uint16_t it8951_read_reg(uint16_t reg);
+static void it8951_write_reg(uint16_t reg, uint16_t value);
+static void photo_orient_rect(uint16_t &x, uint16_t &y, uint16_t w, uint16_t h);
+static inline void it8951_refresh_region(int16_t x, int16_t y, int16_t w, int16_t h,
+                                         EinkWaveform waveform, const char *tag);
 
 static bool buffers_ready = false;
 static bool buffers_logged = false;
@@ -63,8 +90,10 @@ static bool ensure_buffers() {
     raw_row_buffer = static_cast<uint8_t*>(alloc_buffer(kMaxRowWidth, "raw"));
     g4_row_buffer = static_cast<uint8_t*>(alloc_buffer(kMaxRowWidth / 2, "g4_row"));
     g4_chunk_buffer = static_cast<uint8_t*>(alloc_buffer((kMaxRowWidth / 2) * kChunkRows, "g4_chunk"));
+    g4_chunk_buffer_alt = static_cast<uint8_t*>(alloc_buffer((kMaxRowWidth / 2) * kChunkRows, "g4_chunk_alt"));
 
-    buffers_ready = input_buffer && output_rows_gray_buffer && grey_palette_buffer && raw_row_buffer && g4_row_buffer && g4_chunk_buffer;
+    buffers_ready = input_buffer && output_rows_gray_buffer && grey_palette_buffer && raw_row_buffer && g4_row_buffer &&
+                    g4_chunk_buffer && g4_chunk_buffer_alt;
     if (buffers_ready && !buffers_logged) {
         buffers_logged = true;
         auto log_buf = [](const char *label, const void *ptr) {
@@ -77,6 +106,7 @@ static bool ensure_buffers() {
         log_buf("raw", raw_row_buffer);
         log_buf("g4_row", g4_row_buffer);
         log_buf("g4_chunk", g4_chunk_buffer);
+        log_buf("g4_chunk_alt", g4_chunk_buffer_alt);
     }
     return buffers_ready;
 }
@@ -91,36 +121,101 @@ static bool is_ui_active() {
     return display_manager_ui_is_active();
 }
 
-// GxEPD2 IT8951 API: refresh(bool partial_update_mode = false)
-// Our code commonly reasons in terms of "full refresh".
 static constexpr bool kLogRefreshModes = false;
-static inline void it8951_refresh_from_full_flag(bool full_refresh, const char *tag) {
-    const bool partial_update_mode = !full_refresh;
+static inline void it8951_refresh_fullscreen(EinkWaveform waveform, const char *tag) {
     if (kLogRefreshModes) {
-        LOGI("EINK", "Refresh(%s): full=%s -> partial=%s",
-             tag ? tag : "?",
-             full_refresh ? "true" : "false",
-             partial_update_mode ? "true" : "false");
+        LOGI("EINK", "Refresh(%s): mode=%s", tag ? tag : "?", eink_waveform_name(waveform));
+    }
+    it8951_display_area(0, 0, display.WIDTH, display.HEIGHT, waveform);
+}
+
+// Legacy "full refresh" flag: full = GC16, otherwise DU (GxEPD2's partial mode).
+static inline void it8951_refresh_from_full_flag(bool full_refresh, const char *tag) {
+    it8951_refresh_fullscreen(full_refresh ? EinkWaveform::GC16 : EinkWaveform::DU, tag);
+}
+
+// G4 level histogram of the image being loaded (sampled), for the refresh policy.
+static const size_t kHistogramSampleStride = 4;
+static uint32_t g_render_histogram[kRefreshHistogramBins] = {};
+static bool g_render_histogram_valid = false;
+// Differential load that skipped unchanged bands: the histogram misses them.
+static bool g_render_histogram_partial = false;
+
+static void histogram_reset() {
+    memset(g_render_histogram, 0, sizeof(g_render_histogram));
+    g_render_histogram_valid = false;
+    g_render_histogram_partial = false;
+}
+
+static void histogram_add_g4(const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i += kHistogramSampleStride) {
+        g_render_histogram[data[i] >> 4]++;
+        g_render_histogram[data[i] & 0x0F]++;
     }
-    display.refresh(partial_update_mode);
+    g_render_histogram_valid = true;
 }
 
-// Stronger refresh for photo presentation.
-// Motivation: after deep sleep, a normal full refresh (mode=2) may still leave ghosting.
-static constexpr uint8_t kPhotoFullRefreshPasses = 2; // extra cleanup (slower, but reduces ghosting)
+static void histogram_add_gray8(const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i += kHistogramSampleStride) {
+        g_render_histogram[data[i] >> 4]++;
+    }
+    g_render_histogram_valid = true;
+}
 
-static inline void it8951_photo_refresh_fullscreen(const char *tag) {
-    for (uint8_t i = 0; i < kPhotoFullRefreshPasses; i++) {
-        it8951_refresh_from_full_flag(true, tag);
+// Differential photo updates: a single-pass refresh is limited to the union of
+// changed tiles while that stays below this share of the panel.
+static const uint8_t kDiffRefreshMaxPct = 50;
+
+// Photo presentation: the refresh policy picks single GC16, a two-pass clean or
+// an INIT clear from the panel's refresh history. With a tile diff, a single
+// pass only drives the changed area.
+static void it8951_photo_refresh(const char *tag, const G4TileDiff *diff) {
+    const uint32_t *histogram = g_render_histogram_valid ? g_render_histogram : nullptr;
+    const bool partial = g_render_histogram_partial;
+    const RefreshPlan plan = refresh_policy_decide(histogram, partial, tag);
+    if (plan == RefreshPlan::Single && diff && diff->changed_tiles > 0) {
+        const uint32_t area = (uint32_t)diff->w * diff->h;
+        const uint32_t panel = (uint32_t)display.WIDTH * display.HEIGHT;
+        if (area * 100 <= panel * kDiffRefreshMaxPct) {
+            // The tile map is in frame space.
+            uint16_t x = diff->x;
+            uint16_t y = diff->y;
+            photo_orient_rect(x, y, diff->w, diff->h);
+            it8951_refresh_region((int16_t)x, (int16_t)y, (int16_t)diff->w, (int16_t)diff->h,
+                                  EinkWaveform::GC16, tag);
+            refresh_policy_record(plan, histogram, partial);
+            return;
+        }
     }
+    switch (plan) {
+        case RefreshPlan::InitClear:
+            it8951_refresh_fullscreen(EinkWaveform::Init, tag);
+            it8951_refresh_fullscreen(EinkWaveform::GC16, tag);
+            break;
+        case RefreshPlan::DoubleClean:
+            it8951_refresh_fullscreen(EinkWaveform::GC16, tag);
+            it8951_refresh_fullscreen(EinkWaveform::GC16, tag);
+            break;
+        case RefreshPlan::Single:
+        default:
+            it8951_refresh_fullscreen(EinkWaveform::GC16, tag);
+            break;
+    }
+    refresh_policy_record(plan, histogram, partial);
 }
 
-static inline void it8951_refresh_partial_region(int16_t x, int16_t y, int16_t w, int16_t h, const char *tag) {
+static inline void it8951_refresh_region(int16_t x, int16_t y, int16_t w, int16_t h,
+                                         EinkWaveform waveform, const char *tag) {
     if (kLogRefreshModes) {
-        LOGI("EINK", "RefreshRegion(%s): x=%d y=%d w=%d h=%d (partial waveform)",
-             tag ? tag : "?", (int)x, (int)y, (int)w, (int)h);
+        LOGI("EINK", "RefreshRegion(%s): x=%d y=%d w=%d h=%d mode=%s",
+             tag ? tag : "?", (int)x, (int)y, (int)w, (int)h, eink_waveform_name(waveform));
     }
-    display.refresh(x, y, w, h);
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > display.WIDTH) w = display.WIDTH - x;
+    if (y + h > display.HEIGHT) h = display.HEIGHT - y;
+    if (w <= 0 || h <= 0) return;
+    it8951_display_area((uint16_t)x, (uint16_t)y, (uint16_t)w, (uint16_t)h, waveform);
 }
 
 bool it8951_renderer_is_busy() {
@@ -133,72 +228,215 @@ bool it8951_renderer_is_busy() {
 
 // IT8951 I80 command constants (mirroring GxEPD2 driver)
 static const uint16_t IT8951_TCON_SYS_RUN = 0x0001;
+static const uint16_t IT8951_TCON_SLEEP = 0x0003;
+static const uint16_t IT8951_TCON_REG_RD = 0x0010;
+static const uint16_t IT8951_TCON_REG_WR = 0x0011;
 static const uint16_t IT8951_TCON_LD_IMG_AREA = 0x0021;
 static const uint16_t IT8951_TCON_LD_IMG_END = 0x0022;
+static const uint16_t IT8951_USDEF_I80_CMD_DPY_AREA = 0x0034;
+static const uint16_t IT8951_USDEF_I80_CMD_DPY_BUF_AREA = 0x0037;
 static const uint16_t IT8951_USDEF_I80_CMD_VCOM = 0x0039;
+static const uint16_t IT8951_USDEF_I80_CMD_GET_DEV_INFO = 0x0302;
+
+// LUT engine status; non-zero while any waveform is still running.
+static const uint16_t IT8951_REG_LUTAFSR = 0x1224;
+// I80 packed-write enable, and the image-buffer base (LISAR low/high words).
+static const uint16_t IT8951_REG_I80CPCR = 0x0004;
+static const uint16_t IT8951_REG_LISAR = 0x0208;
 
 static const uint16_t IT8951_ROTATE_0 = 0;
 static const uint16_t IT8951_4BPP = 2;
 static const uint16_t IT8951_LDIMG_B_ENDIAN = 1;
 
+// DPY_AREA mode numbers in the panel's waveform table (ED103TC2 / 10.3").
+static uint16_t it8951_waveform_mode(EinkWaveform waveform) {
+    switch (waveform) {
+        case EinkWaveform::Init: return 0;
+        case EinkWaveform::DU: return 1;
+        case EinkWaveform::GC16: return 2;
+        case EinkWaveform::GL16: return 3;
+        case EinkWaveform::A2: return 6;
+    }
+    return 2;
+}
+
 static const uint32_t kBusyTimeoutUs = 10000000;
 
+// HRDY normally drops for a few microseconds per word; spin that long before
+// arming the edge interrupt and blocking.
+static const uint32_t kBusySpinUs = 20;
+// Upper bound for one blocking slice; the pin is re-checked after each one.
+static const uint32_t kBusyBlockSliceMs = 10;
+
+// Waveform completion is polled via LUTAFSR. Most of the expected duration is
+// slept up front (light sleep when allowed), the tail is polled.
+static const uint32_t kRefreshPollMs = 10;
+static const uint32_t kRefreshMinSleepMs = 30;
+static const uint32_t kRefreshTimeoutMs = 10000;
+
+// Used by GxEPD2 calls; direct I80 traffic goes through it8951_transport.
 static SPISettings it8951_spi_settings(24000000, MSBFIRST, SPI_MODE0);
-static SPISettings it8951_spi_settings_read(1000000, MSBFIRST, SPI_MODE0);
+
+// Upper bound for one writeBytes() call inside an open load stream; keeps the
+// scheduler responsive between bursts without ending the CS transaction.
+static const size_t kLoadBurstBytes = 32 * 1024;
+
+// Per-render I80 traffic counters (CS-asserted transactions + payload bytes).
+struct It8951BusStats {
+    uint32_t transactions;
+    uint32_t commands;
+    uint32_t payload_bytes;
+};
+
+static It8951BusStats g_bus_stats = {};
+
+static It8951BusyStats g_busy_stats = {};
+static It8951BusyStats g_last_busy_stats = {};
+static bool g_have_busy_stats = false;
+
+static void bus_stats_reset() {
+    g_bus_stats = {};
+    g_busy_stats = {};
+    histogram_reset();
+    it8951_transport_reset_stats();
+}
+
+static void bus_stats_log(const char *tag) {
+    const It8951TransportStats t = it8951_transport_get_stats();
+    // bytes per microsecond == MB/s
+    const float mbps = t.payload_us > 0 ? (float)t.payload_bytes / (float)t.payload_us : 0.0f;
+    LOGI("EINK", "%s bus txn=%lu cmd=%lu bytes=%lu dma=%lu payload=%lums rate=%.2fMB/s",
+         tag ? tag : "?",
+         (unsigned long)g_bus_stats.transactions,
+         (unsigned long)g_bus_stats.commands,
+         (unsigned long)g_bus_stats.payload_bytes,
+         (unsigned long)t.dma_transactions,
+         (unsigned long)(t.payload_us / 1000),
+         mbps);
+}
+
+// Snapshot this render's busy-wait totals for /api/health and log them.
+static void busy_stats_commit(const char *tag) {
+    LOGI("EINK", "%s busy hrdy=%lums waits=%lu blocked=%lu refresh=%lums sleep=%lums",
+         tag ? tag : "?",
+         (unsigned long)(g_busy_stats.hrdy_us / 1000),
+         (unsigned long)g_busy_stats.hrdy_waits,
+         (unsigned long)g_busy_stats.hrdy_blocked,
+         (unsigned long)(g_busy_stats.refresh_us / 1000),
+         (unsigned long)(g_busy_stats.sleep_us / 1000));
+    portENTER_CRITICAL(&g_render_mux);
+    g_last_busy_stats = g_busy_stats;
+    g_have_busy_stats = true;
+    portEXIT_CRITICAL(&g_render_mux);
+}
+
+bool it8951_renderer_get_busy_stats(It8951BusyStats *out) {
+    if (!out) return false;
+    portENTER_CRITICAL(&g_render_mux);
+    const bool have = g_have_busy_stats;
+    *out = g_last_busy_stats;
+    portEXIT_CRITICAL(&g_render_mux);
+    return have;
+}
+
+// HRDY (BUSY pin) rising edge wakes the task blocked in it8951_wait_ready().
+static TaskHandle_t volatile g_busy_waiter = nullptr;
+static bool g_busy_irq_attached = false;
+
+static void IRAM_ATTR it8951_busy_isr() {
+    TaskHandle_t waiter = g_busy_waiter;
+    if (!waiter) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(waiter, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void it8951_attach_busy_irq() {
+    if (g_busy_irq_attached || IT8951_BUSY_PIN < 0) return;
+    attachInterrupt(digitalPinToInterrupt(IT8951_BUSY_PIN), it8951_busy_isr, RISING);
+    g_busy_irq_attached = true;
+}
+
+static inline bool it8951_busy_low() {
+    return digitalRead(IT8951_BUSY_PIN) == LOW;
+}
 
 static void it8951_wait_ready(uint16_t busy_time_ms = 1) {
-    if (IT8951_BUSY_PIN >= 0) {
-        const unsigned long start = micros();
-        while (digitalRead(IT8951_BUSY_PIN) == LOW) {
-            delay(1);
+    if (IT8951_BUSY_PIN < 0) {
+        delay(busy_time_ms);
+        return;
+    }
+
+    // Fast path: controller already ready, nothing to account.
+    if (!it8951_busy_low()) return;
+
+    const uint32_t start = micros();
+    while (it8951_busy_low() && (micros() - start) < kBusySpinUs) {
+    }
+
+    if (it8951_busy_low()) {
+        g_busy_stats.hrdy_blocked++;
+        if (g_busy_irq_attached) {
+            // Drop a stale give from an earlier edge, then arm before re-checking
+            // the pin so an edge in between still wakes us.
+            ulTaskNotifyTake(pdTRUE, 0);
+            g_busy_waiter = xTaskGetCurrentTaskHandle();
+        }
+        while (it8951_busy_low()) {
             if (micros() - start > kBusyTimeoutUs) {
                 LOGW("EINK", "IT8951 busy timeout");
                 break;
             }
+            if (g_busy_irq_attached) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kBusyBlockSliceMs));
+            } else {
+                delay(1);
+            }
         }
-    } else {
-        delay(busy_time_ms);
+        g_busy_waiter = nullptr;
     }
+
+    g_busy_stats.hrdy_waits++;
+    g_busy_stats.hrdy_us += micros() - start;
 }
 
 static uint16_t it8951_transfer16(uint16_t value) {
-    uint16_t rv = SPI.transfer(value >> 8) << 8;
-    return (rv | SPI.transfer(value));
+    return it8951_transport_transfer16(value);
 }
 
 static void it8951_write_command16(uint16_t cmd) {
+    g_bus_stats.transactions++;
+    g_bus_stats.commands++;
     it8951_wait_ready();
-    SPI.beginTransaction(it8951_spi_settings);
-    digitalWrite(IT8951_CS_PIN, LOW);
+    it8951_transport_begin_transaction(false);
     it8951_transfer16(0x6000);
     it8951_wait_ready();
     it8951_transfer16(cmd);
-    digitalWrite(IT8951_CS_PIN, HIGH);
-    SPI.endTransaction();
+    it8951_transport_end_transaction();
 }
 
 static void it8951_write_data16(uint16_t data) {
+    g_bus_stats.transactions++;
     it8951_wait_ready();
-    SPI.beginTransaction(it8951_spi_settings);
-    digitalWrite(IT8951_CS_PIN, LOW);
+    it8951_transport_begin_transaction(false);
     it8951_transfer16(0x0000);
     it8951_wait_ready();
     it8951_transfer16(data);
-    digitalWrite(IT8951_CS_PIN, HIGH);
-    SPI.endTransaction();
+    it8951_transport_end_transaction();
 }
 
 static uint16_t it8951_read_data16() {
+    g_bus_stats.transactions++;
     it8951_wait_ready();
-    SPI.beginTransaction(it8951_spi_settings_read);
-    digitalWrite(IT8951_CS_PIN, LOW);
+    it8951_transport_begin_transaction(true);
     it8951_transfer16(0x1000); // preamble for read data
     it8951_wait_ready();
     it8951_transfer16(0); // dummy
     it8951_wait_ready();
     const uint16_t rv = it8951_transfer16(0);
-    digitalWrite(IT8951_CS_PIN, HIGH);
-    SPI.endTransaction();
+    it8951_transport_end_transaction();
     return rv;
 }
 
@@ -224,6 +462,210 @@ static uint16_t it8951_get_vcom() {
     return it8951_read_data16();
 }
 
+static void it8951_apply_vcom() {
+#ifdef IT8951_VCOM
+    it8951_set_vcom(IT8951_VCOM);
+    const uint16_t vcom_readback = it8951_get_vcom();
+    LOGI("EINK", "VCOM set to -%.3fV (readback -%.3fV)",
+         (float)IT8951_VCOM / 1000.0f,
+         (float)vcom_readback / 1000.0f);
+#endif
+}
+
+// Native wake-up sequence: everything the G4 paths need, nothing else.
+// GxEPD2's init() additionally sets up its paged buffers and flags the first
+// write/refresh as "initial" (clearing the panel); it's only brought up lazily
+// for the paths that still draw through it (it8951_ensure_gxepd2()).
+static const uint32_t kResetPulseMs = 10;
+static const uint32_t kResetSettleMs = 20;
+
+struct It8951DevInfo {
+    uint16_t panel_w;
+    uint16_t panel_h;
+    uint16_t img_buf_addr_l;
+    uint16_t img_buf_addr_h;
+    uint16_t fw_version[8];
+    uint16_t lut_version[8];
+};
+
+static uint32_t g_img_buf_addr = 0;
+// Buffer the panel is driven from and LISAR points at (loads land here). Equal
+// to g_img_buf_addr until a staged photo has been presented from the spare one.
+static uint32_t g_front_buf_addr = 0;
+static void staged_invalidate();
+
+static bool it8951_native_init() {
+    const unsigned long start_ms = millis();
+
+    if (IT8951_RST_PIN >= 0) {
+        digitalWrite(IT8951_RST_PIN, LOW);
+        delay(kResetPulseMs);
+        digitalWrite(IT8951_RST_PIN, HIGH);
+        delay(kResetSettleMs);
+    }
+    it8951_wait_ready();
+    const unsigned long reset_ms = millis() - start_ms;
+
+    it8951_write_command16(IT8951_TCON_SYS_RUN);
+
+    It8951DevInfo info = {};
+    it8951_write_command16(IT8951_USDEF_I80_CMD_GET_DEV_INFO);
+    it8951_read_data_words(reinterpret_cast<uint16_t*>(&info), sizeof(info) / sizeof(uint16_t));
+    if (info.panel_w != display.WIDTH || info.panel_h != display.HEIGHT) {
+        LOGW("EINK", "IT8951 dev info mismatch %ux%u (expected %ux%u)",
+             (unsigned)info.panel_w, (unsigned)info.panel_h,
+             (unsigned)display.WIDTH, (unsigned)display.HEIGHT);
+        return false;
+    }
+    g_img_buf_addr = ((uint32_t)info.img_buf_addr_h << 16) | info.img_buf_addr_l;
+
+    it8951_write_reg(IT8951_REG_I80CPCR, 0x0001);
+    it8951_apply_vcom();
+
+    // Load target = start of the image buffer.
+    it8951_write_reg(IT8951_REG_LISAR + 2, info.img_buf_addr_h);
+    it8951_write_reg(IT8951_REG_LISAR, info.img_buf_addr_l);
+    g_front_buf_addr = g_img_buf_addr;
+    staged_invalidate();
+
+    LOGI("EINK", "Init native dur=%lums reset=%lums img_buf=0x%08lx",
+         (unsigned long)(millis() - start_ms),
+         (unsigned long)reset_ms,
+         (unsigned long)g_img_buf_addr);
+    return true;
+}
+
+static bool g_gxepd2_ready = false;
+
+// GxEPD2 paths (raw8 writeNative, clearScreen) need its own init; this
+// resets the controller, so VCOM is re-applied afterwards.
+static void it8951_ensure_gxepd2() {
+    it8951_transport_suspend();
+    if (g_gxepd2_ready) return;
+    const unsigned long start_ms = millis();
+    display.init(115200);
+    // GxEPD2 re-runs pinMode() on BUSY; make sure the edge interrupt survives.
+    g_busy_irq_attached = false;
+    it8951_attach_busy_irq();
+    it8951_apply_vcom();
+    // init() points LISAR back at the default buffer; read it so staging also
+    // works when the native init is disabled.
+    g_img_buf_addr = ((uint32_t)it8951_read_reg(IT8951_REG_LISAR + 2) << 16) | it8951_read_reg(IT8951_REG_LISAR);
+    g_front_buf_addr = g_img_buf_addr;
+    staged_invalidate();
+    g_gxepd2_ready = true;
+    LOG_DURATION("EINK", "GxEPD2Init", start_ms);
+}
+
+// Burst read: one preamble + dummy word, then `count` words under one CS.
+static void it8951_read_data_words(uint16_t *out, uint16_t count) {
+    g_bus_stats.transactions++;
+    it8951_wait_ready();
+    it8951_transport_begin_transaction(true);
+    it8951_transfer16(0x1000);
+    it8951_wait_ready();
+    it8951_transfer16(0); // dummy
+    for (uint16_t i = 0; i < count; i++) {
+        it8951_wait_ready();
+        out[i] = it8951_transfer16(0);
+    }
+    it8951_transport_end_transaction();
+}
+
+static uint16_t it8951_read_reg(uint16_t reg) {
+    it8951_write_command16(IT8951_TCON_REG_RD);
+    it8951_write_data16(reg);
+    return it8951_read_data16();
+}
+
+static void it8951_write_reg(uint16_t reg, uint16_t value) {
+    it8951_write_command16(IT8951_TCON_REG_WR);
+    it8951_write_data16(reg);
+    it8951_write_data16(value);
+}
+
+// Keep the panel control lines at their active levels through light sleep
+// (chips with sleep-mode GPIO switching would otherwise float them).
+static void it8951_keep_pins_in_light_sleep() {
+#if SOC_GPIO_SUPPORT_SLP_SWITCH
+    static bool done = false;
+    if (done) return;
+    done = true;
+    if (IT8951_CS_PIN >= 0) gpio_sleep_sel_dis((gpio_num_t)IT8951_CS_PIN);
+    if (IT8951_RST_PIN >= 0) gpio_sleep_sel_dis((gpio_num_t)IT8951_RST_PIN);
+#if defined(DISPLAY_POWER_EN_PIN)
+    if (DISPLAY_POWER_EN_PIN >= 0) gpio_sleep_sel_dis((gpio_num_t)DISPLAY_POWER_EN_PIN);
+#endif
+#endif
+}
+
+static bool it8951_light_sleep_allowed() {
+#if EINK_REFRESH_LIGHT_SLEEP
+    // Light sleep pauses every task and the radio; only use it when nothing else
+    // needs the CPU (sleep-cycle renders run with WiFi already shut down).
+    return WiFi.getMode() == WIFI_OFF;
+#else
+    return false;
+#endif
+}
+
+static void it8951_refresh_sleep(uint32_t ms) {
+    const uint32_t start = micros();
+    if (it8951_light_sleep_allowed()) {
+        it8951_keep_pins_in_light_sleep();
+        Serial.flush();
+        esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+        esp_light_sleep_start();
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    } else {
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+    g_busy_stats.sleep_us += micros() - start;
+}
+
+// Last measured waveform time per mode, kept across deep sleep so the first
+// refresh after wake can sleep through most of it.
+RTC_DATA_ATTR static uint16_t g_refresh_learned_ms[kEinkWaveformCount] = {0};
+
+static void it8951_wait_display_ready(EinkWaveform waveform) {
+    const uint32_t start = millis();
+    uint16_t &learned = g_refresh_learned_ms[(uint8_t)waveform % kEinkWaveformCount];
+
+    const uint32_t expected_sleep_ms = (uint32_t)learned * 7 / 8;
+    if (expected_sleep_ms >= kRefreshMinSleepMs) {
+        it8951_refresh_sleep(expected_sleep_ms);
+    }
+
+    while (it8951_read_reg(IT8951_REG_LUTAFSR) != 0) {
+        if (millis() - start > kRefreshTimeoutMs) {
+            LOGW("EINK", "IT8951 refresh timeout");
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(kRefreshPollMs));
+    }
+
+    const uint32_t elapsed_ms = millis() - start;
+    learned = (uint16_t)min(elapsed_ms, (uint32_t)kRefreshTimeoutMs);
+    g_busy_stats.refresh_waits++;
+    g_busy_stats.refresh_us += elapsed_ms * 1000UL;
+}
+
+// Native replacement for GxEPD2 refresh(): DPY_AREA, then wait for the waveform.
+// Once the front buffer has moved off the default address, DPY_BUF_AREA names it.
+static void it8951_display_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h, EinkWaveform waveform) {
+    const uint16_t mode = it8951_waveform_mode(waveform);
+    if (g_front_buf_addr != g_img_buf_addr) {
+        const uint16_t args[7] = {x, y, w, h, mode,
+                                  (uint16_t)(g_front_buf_addr & 0xFFFF), (uint16_t)(g_front_buf_addr >> 16)};
+        it8951_write_command_data16(IT8951_USDEF_I80_CMD_DPY_BUF_AREA, args, 7);
+    } else {
+        const uint16_t args[5] = {x, y, w, h, mode};
+        it8951_write_command_data16(IT8951_USDEF_I80_CMD_DPY_AREA, args, 5);
+    }
+    it8951_wait_ready();
+    it8951_wait_display_ready(waveform);
+}
+
 static void it8951_set_partial_area_4bpp(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
     uint16_t args[5];
     args[0] = (IT8951_LDIMG_B_ENDIAN << 8) | (IT8951_4BPP << 4) | (IT8951_ROTATE_0);
@@ -235,20 +677,260 @@ static void it8951_set_partial_area_4bpp(uint16_t x, uint16_t y, uint16_t w, uin
 }
 
 static void it8951_write_data_bytes(const uint8_t* data, size_t length) {
+    g_bus_stats.transactions++;
+    g_bus_stats.payload_bytes += length;
     it8951_wait_ready();
-    SPI.beginTransaction(it8951_spi_settings);
-    digitalWrite(IT8951_CS_PIN, LOW);
+    it8951_transport_begin_transaction(false);
     it8951_transfer16(0x0000);
     it8951_wait_ready();
-#if defined(ARDUINO_ARCH_ESP32)
-    SPI.writeBytes(data, length);
-#else
-    for (size_t i = 0; i < length; i++) {
-        SPI.transfer(data[i]);
+    it8951_transport_write_bytes(data, length);
+    it8951_transport_end_transaction();
+}
+
+// Streaming 4bpp load: one LD_IMG_AREA for the whole frame/region, then the
+// payload in large bursts. With hold_cs the data preamble and busy checks run
+// once and CS stays asserted until it8951_load_end(); without it (SD sharing the
+// SPI bus) each burst is its own data transaction inside the same image area.
+static bool g_load_hold_cs = false;
+
+// Panel calibration (it8951_set_panel_levels): encoded level -> level loaded,
+// expanded to a byte LUT over nibble pairs. The transport maps 4bpp payload
+// through it while copying into its DMA buffers, so every 4bpp load (files,
+// fills, UI buffers) is corrected at one lookup per byte. Histograms and tile
+// hashes keep using the encoded data.
+static uint8_t g_panel_lut[256];
+static bool g_panel_lut_active = false;
+
+// Photo orientation (it8951_set_photo_orientation): photo loads describe areas
+// in frame space, the orientation the library was encoded for, and are mapped
+// to the panel here. Mirror X reverses each row with its nibbles swapped;
+// mirror Y loads every it8951_load_write_rows() call as its own image area with
+// the rows bottom-up, so SD reads stay sequential. Rotate 180 is both. Only
+// photo renders (PhotoLoadScope) are mapped; UI buffers are already in panel
+// orientation.
+static bool g_photo_mirror_x = false;
+static bool g_photo_mirror_y = false;
+static bool g_load_oriented = false;
+static uint8_t *g4_orient_buffer = nullptr;
+
+// Photo overlays (photo_overlay.h): boxes in panel space, copied over the rows
+// of a photo load on their way to the controller (it8951_load_emit), in
+// g4_orient_buffer, so the chunk buffers - and with them histograms and tile
+// hashes - keep the photo. Tiles under a box get its signature mixed into
+// their hash instead. g_load_boxes is what the current photo load draws,
+// g_front_boxes/g_staged_boxes what the front and spare buffers hold.
+static PhotoOverlayBox g_load_boxes[kPhotoOverlaySlots] = {};
+static PhotoOverlayBox g_front_boxes[kPhotoOverlaySlots] = {};
+static PhotoOverlayBox g_staged_boxes[kPhotoOverlaySlots] = {};
+static bool g_load_overlays = false;
+
+static bool ensure_orient_buffer() {
+    if (!g4_orient_buffer) {
+        g4_orient_buffer = static_cast<uint8_t*>(
+            alloc_buffer((size_t)(kMaxRowWidth / 2) * kChunkRows, "g4_orient"));
+    }
+    return g4_orient_buffer != nullptr;
+}
+
+static void overlay_snapshot() {
+    photo_overlay_prepare();
+    bool any = false;
+    for (uint8_t i = 0; i < kPhotoOverlaySlots; i++) {
+        g_load_boxes[i] = photo_overlay_box((PhotoOverlaySlot)i);
+        any = any || g_load_boxes[i].sig != 0;
+    }
+    if (any && !ensure_orient_buffer()) {
+        LOGW("EINK", "Overlays skipped (no buffer)");
+        memset(g_load_boxes, 0, sizeof(g_load_boxes));
+        any = false;
+    }
+    g_load_overlays = any;
+}
+
+struct PhotoLoadScope {
+    PhotoLoadScope() {
+        g_load_oriented = g_photo_mirror_x || g_photo_mirror_y;
+        overlay_snapshot();
+    }
+    ~PhotoLoadScope() {
+        g_load_oriented = false;
+        g_load_overlays = false;
+    }
+};
+
+struct LoadArea {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t next_row;  // mirror Y: frame rows already loaded
+    bool mirror_x;
+    bool mirror_y;
+    // Panel position of the image area open on the controller and the rows
+    // sent to it so far (overlay placement).
+    uint16_t panel_x;
+    uint16_t panel_y;
+    uint16_t panel_rows;
+};
+static LoadArea g_load_area = {};
+
+static void photo_orient_rect(uint16_t &x, uint16_t &y, uint16_t w, uint16_t h) {
+    if (g_photo_mirror_x) x = (uint16_t)(display.WIDTH - x - w);
+    if (g_photo_mirror_y) y = (uint16_t)(display.HEIGHT - y - h);
+}
+
+static void it8951_load_stream_begin() {
+    if (!g_load_hold_cs) return;
+    g_bus_stats.transactions++;
+    it8951_wait_ready();
+    it8951_transport_begin_transaction(false);
+    it8951_transfer16(0x0000);
+    it8951_wait_ready();
+}
+
+static void it8951_load_stream_end() {
+    if (g_load_hold_cs) {
+        it8951_transport_end_transaction();
+    }
+}
+
+static void it8951_load_begin_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool hold_cs,
+                                   bool mirror_x, bool mirror_y) {
+    g_load_area = {x, y, w, h, 0, mirror_x, mirror_y, 0, 0, 0};
+    it8951_transport_set_payload_lut(g_panel_lut_active ? g_panel_lut : nullptr);
+    g_load_hold_cs = hold_cs;
+    // Mirror Y: the image areas are opened per write.
+    if (mirror_y) return;
+    if (mirror_x) x = (uint16_t)(display.WIDTH - x - w);
+    g_load_area.panel_x = x;
+    g_load_area.panel_y = y;
+    it8951_set_partial_area_4bpp(x, y, w, h);
+    it8951_load_stream_begin();
+}
+
+static void it8951_load_begin_4bpp(uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool hold_cs) {
+    it8951_load_begin_area(x, y, w, h, hold_cs, g_load_oriented && g_photo_mirror_x,
+                           g_load_oriented && g_photo_mirror_y);
+}
+
+static void it8951_load_write(const uint8_t* data, size_t length) {
+    if (!g_load_hold_cs) {
+        it8951_write_data_bytes(data, length);
+        return;
+    }
+    g_bus_stats.payload_bytes += length;
+    it8951_transport_write_bytes(data, length);
+}
+
+// Write a contiguous span in kLoadBurstBytes pieces, yielding between bursts.
+static void it8951_load_write_bursts(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        const size_t n = length > kLoadBurstBytes ? kLoadBurstBytes : length;
+        it8951_load_write(data, n);
+        data += n;
+        length -= n;
+        if (length > 0) {
+            yield();
+        }
+    }
+}
+
+static bool overlay_hits(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    return photo_overlay_boxes_hit(g_load_boxes, kPhotoOverlaySlots, x, y, w, h);
+}
+
+// Copy the overlay pixels over `rows` rows (panel row `y` first) of the open
+// area held in `buf`.
+static void overlay_blend(uint8_t *buf, uint16_t y, uint16_t rows) {
+    photo_overlay_boxes_blend(g_load_boxes, kPhotoOverlaySlots, buf, g_load_area.panel_x, g_load_area.w, y, rows);
+}
+
+// Send `rows` contiguous rows of the open area (already in panel order). Rows
+// crossing an overlay box go through g4_orient_buffer with the box copied in;
+// everything else is written as is.
+static void it8951_load_emit(const uint8_t *data, uint16_t rows) {
+    LoadArea &a = g_load_area;
+    const size_t row_bytes = a.w / 2;
+    const uint16_t y = a.panel_y + a.panel_rows;
+    a.panel_rows += rows;
+    if (!g_load_overlays || !overlay_hits(a.panel_x, y, a.w, rows)) {
+        it8951_load_write(data, (size_t)rows * row_bytes);
+        return;
+    }
+    for (uint16_t done = 0; done < rows;) {
+        const uint16_t n = (uint16_t)min((uint32_t)kChunkRows, (uint32_t)(rows - done));
+        if (data != g4_orient_buffer) {
+            memcpy(g4_orient_buffer, data + (size_t)done * row_bytes, (size_t)n * row_bytes);
+        }
+        overlay_blend(g4_orient_buffer, y + done, n);
+        it8951_load_write(g4_orient_buffer, (size_t)n * row_bytes);
+        done += n;
+    }
+}
+
+// Write `rows` whole rows of the current area, `stride` bytes apart in `data`.
+// Photo loads use this so the orientation can be applied: mirrored rows are
+// rebuilt kChunkRows at a time in g4_orient_buffer and sent as one burst.
+static void it8951_load_write_rows(const uint8_t *data, size_t stride, uint16_t rows) {
+    LoadArea &a = g_load_area;
+    const size_t row_bytes = a.w / 2;
+    if (!a.mirror_x && !a.mirror_y) {
+        if (stride == row_bytes) {
+            it8951_load_emit(data, rows);
+            return;
+        }
+        for (uint16_t r = 0; r < rows; r++) {
+            it8951_load_emit(data + (size_t)r * stride, 1);
+        }
+        return;
+    }
+
+    if (a.mirror_y) {
+        uint16_t x = a.x;
+        uint16_t y = a.y + a.next_row;
+        photo_orient_rect(x, y, a.w, rows);
+        a.panel_x = x;
+        a.panel_y = y;
+        a.panel_rows = 0;
+        it8951_set_partial_area_4bpp(x, y, a.w, rows);
+        it8951_load_stream_begin();
+    }
+    for (uint16_t done = 0; done < rows;) {
+        const uint16_t n = (uint16_t)min((uint32_t)kChunkRows, (uint32_t)(rows - done));
+        for (uint16_t r = 0; r < n; r++) {
+            const uint16_t src_row = a.mirror_y ? rows - 1 - (done + r) : done + r;
+            const uint8_t *src = data + (size_t)src_row * stride;
+            uint8_t *dst = g4_orient_buffer + (size_t)r * row_bytes;
+            if (!a.mirror_x) {
+                memcpy(dst, src, row_bytes);
+                continue;
+            }
+            for (size_t i = 0; i < row_bytes; i++) {
+                const uint8_t b = src[row_bytes - 1 - i];
+                dst[i] = (uint8_t)((b << 4) | (b >> 4));
+            }
+        }
+        it8951_load_emit(g4_orient_buffer, n);
+        done += n;
+    }
+    if (a.mirror_y) {
+        it8951_load_stream_end();
+        it8951_write_command16(IT8951_TCON_LD_IMG_END);
+        a.next_row += rows;
+    }
+}
+
+static void it8951_load_end() {
+    const bool area_open = !g_load_area.mirror_y;
+    if (area_open) {
+        it8951_load_stream_end();
+    }
+    g_load_hold_cs = false;
+    g_load_area = {};
+    it8951_transport_set_payload_lut(nullptr);
+    if (area_open) {
+        it8951_write_command16(IT8951_TCON_LD_IMG_END);
     }
-#endif
-    digitalWrite(IT8951_CS_PIN, HIGH);
-    SPI.endTransaction();
 }
 
 static uint8_t read8(File &f) {
@@ -271,172 +953,245 @@ static uint32_t read32(File &f) {
     return result;
 }
 
-static bool draw_bmp_16gray(File &file, int16_t x, int16_t y) {
+// BMP -> packed 4bpp: every depth is quantized straight to a G4 level through a
+// lookup table (palette index, RGB565/555 word, or luminance byte) and streamed
+// with the same LD_IMG_AREA loader as G4 files.
+static uint8_t g_gray_level_lut[256];
+static bool g_gray_level_lut_ready = false;
+static uint8_t *bmp_rgb16_lut = nullptr;
+static uint32_t bmp_rgb16_lut_format = 0xFFFFFFFF;
+
+static void ensure_gray_level_lut() {
+    if (g_gray_level_lut_ready) return;
+    for (uint16_t i = 0; i < 256; i++) {
+        g_gray_level_lut[i] = (uint8_t)(i >> 4);
+    }
+    g_gray_level_lut_ready = true;
+}
+
+static inline uint8_t luma8(uint16_t red, uint16_t green, uint16_t blue) {
+    return uint8_t((red * 77 + green * 150 + blue * 29) >> 8);
+}
+
+// 64K-entry table indexed by the little-endian pixel word (format 0 = RGB555,
+// 3 = RGB565 bitfields). Built once per format, lives in PSRAM when present.
+static bool ensure_rgb16_lut(uint32_t format) {
+    if (!bmp_rgb16_lut) {
+        bmp_rgb16_lut = static_cast<uint8_t*>(alloc_buffer(65536, "bmp_rgb16_lut"));
+        if (!bmp_rgb16_lut) return false;
+    }
+    if (bmp_rgb16_lut_format == format) return true;
+    for (uint32_t v = 0; v < 65536; v++) {
+        const uint8_t lsb = (uint8_t)v;
+        const uint8_t msb = (uint8_t)(v >> 8);
+        uint16_t red, green, blue;
+        if (format == 0) {
+            blue = (lsb & 0x1F) << 3;
+            green = ((msb & 0x03) << 6) | ((lsb & 0xE0) >> 2);
+            red = (msb & 0x7C) << 1;
+        } else {
+            blue = (lsb & 0x1F) << 3;
+            green = ((msb & 0x07) << 5) | ((lsb & 0xE0) >> 3);
+            red = (msb & 0xF8);
+        }
+        bmp_rgb16_lut[v] = g_gray_level_lut[luma8(red, green, blue)];
+    }
+    bmp_rgb16_lut_format = format;
+    return true;
+}
+
+// Stream a solid level over an area (BMP or G4 sub-frame background). The
+// data is uniform, so an oriented photo load only needs the area mapped.
+static void it8951_load_fill_4bpp(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t level) {
+    const uint16_t packed_width = w / 2;
+    memset(g4_chunk_buffer, (level << 4) | level, (size_t)packed_width * kChunkRows);
+    if (g_load_oriented) photo_orient_rect(x, y, w, h);
+    it8951_load_begin_area(x, y, w, h, true, false, false);
+    for (uint16_t row = 0; row < h; row += kChunkRows) {
+        const uint16_t rows = (uint16_t)min((uint32_t)kChunkRows, (uint32_t)(h - row));
+        it8951_load_emit(g4_chunk_buffer, rows);
+    }
+    it8951_load_end();
+}
+
+static bool draw_bmp_4bpp(File &file, int16_t x, int16_t y) {
     const unsigned long start_ms = millis();
     if ((x >= display.WIDTH) || (y >= display.HEIGHT)) return false;
 
-    bool valid = false;
-    bool flip = false;
-
     uint16_t signature = read16(file);
     if (signature != 0x4D42) {
-        Serial.println("BMP signature mismatch");
+        LOGE("EINK", "BMP signature mismatch");
         return false;
     }
 
-    uint32_t file_size = read32(file);
-    (void)file_size;
-    uint32_t creator_bytes = read32(file);
-    (void)creator_bytes;
+    (void)read32(file); // file size
+    (void)read32(file); // creator bytes
     uint32_t image_offset = read32(file);
-    uint32_t header_size = read32(file);
+    (void)read32(file); // header size
     uint32_t width = read32(file);
     int32_t height = (int32_t)read32(file);
     uint16_t planes = read16(file);
     uint16_t depth = read16(file);
     uint32_t format = read32(file);
 
-    if ((planes == 1) && ((format == 0) || (format == 3))) {
-        uint32_t row_size = (width * depth / 8 + 3) & ~3;
-        if (depth < 8) {
-            row_size = ((width * depth + 8 - depth) / 8 + 3) & ~3;
-        }
-        if (height < 0) {
-            height = -height;
-            flip = false;
-        }
-
-        uint16_t w = width;
-        uint16_t h = height;
-        if ((x + w - 1) >= display.WIDTH) w = display.WIDTH - x;
-        if ((y + h - 1) >= display.HEIGHT) h = display.HEIGHT - y;
-
-        if (w <= kMaxRowWidth) {
-            valid = true;
-            uint8_t bitmask = 0xFF;
-            uint8_t bitshift = 8 - depth;
-            uint16_t red, green, blue;
-            uint8_t grey;
-
-            if (depth <= 8) {
-                if (depth < 8) bitmask >>= depth;
-                file.seek(image_offset - (4 << depth));
-                for (uint16_t pn = 0; pn < (1 << depth); pn++) {
-                    blue = read8(file);
-                    green = read8(file);
-                    red = read8(file);
-                    read8(file);
-                    grey = uint8_t((red + green + blue) / 3);
-                    grey_palette_buffer[pn] = grey;
-                }
-            }
-
-            display.clearScreen();
-
-            uint32_t row_position = flip ? image_offset + (height - h) * row_size : image_offset;
-            const unsigned long rows_start = millis();
-            for (uint16_t row = 0; row < h; row++, row_position += row_size) {
-                uint32_t in_remain = row_size;
-                uint32_t in_idx = 0;
-                uint32_t in_bytes = 0;
-                uint8_t in_byte = 0;
-                uint8_t in_bits = 0;
-                uint32_t out_idx = 0;
-
-                file.seek(row_position);
-                for (uint16_t col = 0; col < w; col++) {
-                    if (in_idx >= in_bytes) {
-                        in_bytes = file.read(input_buffer, in_remain > kInputBufferBytes ? kInputBufferBytes : in_remain);
-                        in_remain -= in_bytes;
-                        in_idx = 0;
-                    }
+    if ((planes != 1) || !((format == 0) || (format == 3))) {
+        LOGE("EINK", "BMP format unsupported");
+        return false;
+    }
+    if (!(depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16 || depth == 24 || depth == 32)) {
+        LOGE("EINK", "BMP depth unsupported");
+        return false;
+    }
+    if (height < 0) {
+        height = -height;
+    }
 
-                    switch (depth) {
-                        case 32:
-                            blue = input_buffer[in_idx++];
-                            green = input_buffer[in_idx++];
-                            red = input_buffer[in_idx++];
-                            in_idx++;
-                            grey = uint8_t((red * 77 + green * 150 + blue * 29) >> 8);
-                            break;
-                        case 24:
-                            blue = input_buffer[in_idx++];
-                            green = input_buffer[in_idx++];
-                            red = input_buffer[in_idx++];
-                            grey = uint8_t((red * 77 + green * 150 + blue * 29) >> 8);
-                            break;
-                        case 16: {
-                            uint8_t lsb = input_buffer[in_idx++];
-                            uint8_t msb = input_buffer[in_idx++];
-                            if (format == 0) {
-                                blue = (lsb & 0x1F) << 3;
-                                green = ((msb & 0x03) << 6) | ((lsb & 0xE0) >> 2);
-                                red = (msb & 0x7C) << 1;
-                            } else {
-                                blue = (lsb & 0x1F) << 3;
-                                green = ((msb & 0x07) << 5) | ((lsb & 0xE0) >> 3);
-                                red = (msb & 0xF8);
-                            }
-                            grey = uint8_t((red * 77 + green * 150 + blue * 29) >> 8);
-                        } break;
-                        case 1:
-                        case 2:
-                        case 4:
-                        case 8: {
-                            if (in_bits == 0) {
-                                in_byte = input_buffer[in_idx++];
-                                in_bits = 8;
-                            }
-                            uint16_t pn = (in_byte >> bitshift) & bitmask;
-                            grey = grey_palette_buffer[pn];
-                            in_byte <<= depth;
-                            in_bits -= depth;
-                        } break;
-                        default:
-                            valid = false;
-                            break;
-                    }
+    uint32_t row_size = (width * depth / 8 + 3) & ~3;
+    if (depth < 8) {
+        row_size = ((width * depth + 8 - depth) / 8 + 3) & ~3;
+    }
 
-                    if (!valid) break;
+    uint16_t w = width;
+    uint16_t h = height;
+    if ((x + w - 1) >= display.WIDTH) w = display.WIDTH - x;
+    if ((y + h - 1) >= display.HEIGHT) h = display.HEIGHT - y;
+    if (w > kMaxRowWidth || w == 0 || h == 0) return false;
+
+    // The controller takes whole 16-bit words per row, so the packed load is
+    // 4-px aligned like the other 4bpp paths; the padding columns are white.
+    // Without room to pad at the right edge, the last columns are clipped.
+    uint16_t load_w = (w + 3) & ~3;
+    if (x + load_w > display.WIDTH) {
+        load_w = w & ~3;
+        w = load_w;
+    }
+    if (load_w == 0) return false;
+    const uint16_t packed_width = load_w / 2;
 
-                    const uint8_t level = grey >> 4; // 0-15
-                    output_rows_gray_buffer[(row % kChunkRows) * kMaxRowWidth + out_idx++] = level * 17; // expand to 0-255
-                }
+    ensure_gray_level_lut();
+    const uint8_t bitmask = depth < 8 ? (0xFF >> (8 - depth)) : 0xFF;
+    const uint8_t bitshift = 8 - depth;
+    if (depth <= 8) {
+        file.seek(image_offset - (4 << depth));
+        for (uint16_t pn = 0; pn < (1 << depth); pn++) {
+            const uint8_t blue = read8(file);
+            const uint8_t green = read8(file);
+            const uint8_t red = read8(file);
+            read8(file);
+            grey_palette_buffer[pn] = g_gray_level_lut[luma8(red, green, blue)];
+        }
+    } else if (depth == 16 && !ensure_rgb16_lut(format)) {
+        return false;
+    }
 
-                if (!valid) break;
+    it8951_write_command16(IT8951_TCON_SYS_RUN);
+    const bool covers_panel = x == 0 && y == 0 && load_w >= display.WIDTH && h >= display.HEIGHT;
+    if (!covers_panel) {
+        it8951_load_fill_4bpp(0, 0, display.WIDTH, display.HEIGHT, 0x0F);
+    }
 
-                const bool chunk_ready = ((row % kChunkRows) == (kChunkRows - 1)) || (row == (h - 1));
-                if (chunk_ready) {
-                    const uint16_t chunk_rows = (row % kChunkRows) + 1;
-                    const uint16_t yrow = y + (flip ? (h - row - chunk_rows) : (row - chunk_rows + 1));
-                    display.writeNative(output_rows_gray_buffer, nullptr, x, yrow, w, chunk_rows, false, false, false);
-                }
+    // Rows are contiguous (row_size includes padding); only a clipped row
+    // leaves bytes behind and needs a seek.
+    const bool clipped = w < width;
+    file.seek(image_offset);
+    const unsigned long rows_start = millis();
+    // Holding CS across SD reads is only safe when SD has its own SPI host.
+    it8951_load_begin_4bpp(x, y, load_w, h, !SD_USE_ARDUINO_SPI);
+    bool ok = true;
+    for (uint16_t row = 0; row < h && ok; row++) {
+        if (clipped) {
+            file.seek(image_offset + (uint32_t)row * row_size);
+        }
+        uint32_t in_remain = row_size;
+        uint32_t in_idx = 0;
+        uint32_t in_bytes = 0;
+        uint8_t in_byte = 0;
+        uint8_t in_bits = 0;
 
-                if ((row % 200) == 0) {
-                    LOGD("EINK", "Row %u/%u", (unsigned)row, (unsigned)h);
+        uint8_t *out = &g4_chunk_buffer[(row % kChunkRows) * packed_width];
+        uint8_t pack = 0;
+        for (uint16_t col = 0; col < w; col++) {
+            if (in_idx >= in_bytes) {
+                in_bytes = file.read(input_buffer, in_remain > kInputBufferBytes ? kInputBufferBytes : in_remain);
+                if (in_bytes == 0) {
+                    LOGE("EINK", "BMP short read row=%u", (unsigned)row);
+                    ok = false;
+                    break;
                 }
+                in_remain -= in_bytes;
+                in_idx = 0;
+            }
 
-                if ((row % 32) == 0) {
-                    yield();
-                }
+            uint8_t level;
+            switch (depth) {
+                case 32:
+                    level = g_gray_level_lut[luma8(input_buffer[in_idx + 2], input_buffer[in_idx + 1], input_buffer[in_idx])];
+                    in_idx += 4;
+                    break;
+                case 24:
+                    level = g_gray_level_lut[luma8(input_buffer[in_idx + 2], input_buffer[in_idx + 1], input_buffer[in_idx])];
+                    in_idx += 3;
+                    break;
+                case 16:
+                    level = bmp_rgb16_lut[input_buffer[in_idx] | (input_buffer[in_idx + 1] << 8)];
+                    in_idx += 2;
+                    break;
+                default:
+                    if (in_bits == 0) {
+                        in_byte = input_buffer[in_idx++];
+                        in_bits = 8;
+                    }
+                    level = grey_palette_buffer[(in_byte >> bitshift) & bitmask];
+                    in_byte <<= depth;
+                    in_bits -= depth;
+                    break;
             }
-            LOG_DURATION("EINK", "Rows", rows_start);
 
-            if (valid) {
-                const unsigned long refresh_start = millis();
-                // Full-screen photo render should use full update waveform.
-                it8951_refresh_from_full_flag(true, "bmp16gray");
-                LOG_DURATION("EINK", "Refresh", refresh_start);
+            if ((col & 1) == 0) {
+                pack = (uint8_t)(level << 4);
+            } else {
+                *out++ = pack | level;
             }
         }
+        if (!ok) break;
+        if (w & 1) {
+            *out++ = pack | 0x0F;
+        }
+        for (uint16_t col = (w + 1) & ~1; col < load_w; col += 2) {
+            *out++ = 0xFF;
+        }
+
+        const bool chunk_ready = ((row % kChunkRows) == (kChunkRows - 1)) || (row == (h - 1));
+        if (chunk_ready) {
+            const uint16_t chunk_rows = (row % kChunkRows) + 1;
+            it8951_load_write_rows(g4_chunk_buffer, packed_width, chunk_rows);
+        }
+
+        if ((row % 200) == 0) {
+            LOGD("EINK", "Row %u/%u", (unsigned)row, (unsigned)h);
+        }
+
+        if ((row % 32) == 0) {
+            yield();
+        }
+    }
+    it8951_load_end();
+    LOG_DURATION("EINK", "Rows", rows_start);
+
+    if (ok) {
+        const unsigned long refresh_start = millis();
+        // Full-screen photo render should use full update waveform.
+        it8951_refresh_from_full_flag(true, "bmp4bpp");
+        LOG_DURATION("EINK", "Refresh", refresh_start);
     }
 
     LOG_DURATION("EINK", "BMP", start_ms);
-    return valid;
+    return ok;
 }
 
 static bool render_raw_rows(File &file, uint16_t w, uint16_t h) {
     const unsigned long rows_start = millis();
+    it8951_ensure_gxepd2();
     for (uint16_t row = 0; row < h; row++) {
         const int read_bytes = file.read(raw_row_buffer, w);
         if (read_bytes != (int)w) {
@@ -445,6 +1200,7 @@ static bool render_raw_rows(File &file, uint16_t w, uint16_t h) {
         }
 
         memcpy(&output_rows_gray_buffer[(row % kChunkRows) * kMaxRowWidth], raw_row_buffer, w);
+        histogram_add_gray8(raw_row_buffer, w);
 
         const bool chunk_ready = ((row % kChunkRows) == (kChunkRows - 1)) || (row == (h - 1));
         if (chunk_ready) {
@@ -465,29 +1221,304 @@ static bool render_raw_rows(File &file, uint16_t w, uint16_t h) {
     return true;
 }
 
-static bool render_g4_rows(File &file, uint16_t w, uint16_t h) {
+// ---------------------------------------------------------------------------
+// G4 file source
+// ---------------------------------------------------------------------------
+// Produces packed rows from a .g4: headerless frame, or a G4 container (see
+// g4_file.h) with raw or G4Z payload, optional strip CRCs and tile hashes.
+// Callers read whole chunks of kChunkRows rows; containers with strip tables
+// must use the same strip height. Rows are those of the stored frame, which
+// may be a sub-frame placed at (header.x, header.y).
+static const uint16_t kG4MaxStrips = (DISPLAY_HEIGHT + kChunkRows - 1) / kChunkRows;
+static const uint16_t kG4MaxTiles = ((DISPLAY_WIDTH + kG4TileSize - 1) / kG4TileSize) *
+                                    ((DISPLAY_HEIGHT + kG4TileSize - 1) / kG4TileSize);
+
+struct G4Source {
+    File *file;
+    G4FileHeader header;
+    uint16_t packed_width;
+    bool full_frame;
+    bool compressed;
+    bool check_crc;
+    bool has_tile_hashes;
+    uint16_t next_strip;
+};
+
+static uint32_t g4_strip_offsets[kG4MaxStrips + 1];
+static uint32_t g4_strip_crcs[kG4MaxStrips];
+static uint32_t g4_tile_hashes[kG4MaxTiles];
+static uint8_t *g4z_in_buffer = nullptr;
+
+static bool g4_source_read_table(File &file, uint32_t *out, uint32_t count, const char *label) {
+    const size_t bytes = sizeof(uint32_t) * count;
+    if (file.read(reinterpret_cast<uint8_t*>(out), bytes) != (int)bytes) {
+        LOGE("EINK", "G4 %s table short read", label);
+        return false;
+    }
+    return true;
+}
+
+// Validate the header against the file size (no payload reads) and load the
+// tables. The file is left at the start of the payload.
+static bool g4_source_open(File &file, uint16_t w, uint16_t h, G4Source *src) {
+    *src = {};
+    src->file = &file;
+
+    uint8_t head[sizeof(G4FileHeader)] = {0};
+    const int head_len = file.read(head, sizeof(head));
+    const char *error = nullptr;
+    if (!g4_file_parse_header(head, head_len > 0 ? (size_t)head_len : 0, (uint32_t)file.size(),
+                              w, h, &src->header, &error)) {
+        LOGE("EINK", "G4 invalid: %s (bytes=%lu)", error ? error : "?", (unsigned long)file.size());
+        return false;
+    }
+    const G4FileHeader &hdr = src->header;
+    file.seek(hdr.header_bytes);
+
+    src->packed_width = hdr.width / 2;
+    src->full_frame = hdr.x == 0 && hdr.y == 0 && hdr.width == w && hdr.height == h;
+    src->compressed = hdr.encoding == (uint8_t)G4Encoding::G4z;
+    src->check_crc = (hdr.flags & kG4FileHasStripCrc) != 0;
+    if ((src->compressed || src->check_crc) && hdr.strip_rows != kChunkRows) {
+        LOGE("EINK", "G4 strip rows %u unsupported", (unsigned)hdr.strip_rows);
+        return false;
+    }
+    if (hdr.header_bytes == 0) return true;
+
+    file.seek(sizeof(G4FileHeader));
+    if (src->compressed && !g4_source_read_table(file, g4_strip_offsets, hdr.strip_count + 1, "strip index")) {
+        return false;
+    }
+    if (src->check_crc && !g4_source_read_table(file, g4_strip_crcs, hdr.strip_count, "strip CRC")) {
+        return false;
+    }
+    if (hdr.flags & kG4FileHasTileHashes) {
+        const uint32_t tiles = g4_file_tile_count(hdr);
+        // The table describes the stored frame; only a full frame lines up with the panel grid.
+        if (src->full_frame && hdr.tile_size == kG4TileSize && tiles <= kG4MaxTiles) {
+            if (!g4_source_read_table(file, g4_tile_hashes, tiles, "tile hash")) return false;
+            src->has_tile_hashes = true;
+        }
+    }
+    file.seek(hdr.header_bytes);
+
+    if (src->compressed && !g4z_in_buffer) {
+        g4z_in_buffer = static_cast<uint8_t*>(
+            alloc_buffer(g4z_max_encoded_size((size_t)(kMaxRowWidth / 2) * kChunkRows), "g4z_in"));
+        if (!g4z_in_buffer) return false;
+    }
+
+    LOGI("EINK", "G4 v%u enc=%u variant=%u %ux%u@%u,%u strips=%u crc=%d tiles=%d bytes=%lu",
+         (unsigned)hdr.version, (unsigned)hdr.encoding, (unsigned)hdr.variant,
+         (unsigned)hdr.width, (unsigned)hdr.height, (unsigned)hdr.x, (unsigned)hdr.y,
+         (unsigned)hdr.strip_count, src->check_crc ? 1 : 0, src->has_tile_hashes ? 1 : 0,
+         (unsigned long)file.size());
+    return true;
+}
+
+// Fill `out` with `rows` packed rows (a multiple of kChunkRows, or the tail).
+// Returns the number of bytes produced; short on read, decode or CRC errors.
+static int32_t g4_source_read(G4Source &src, uint8_t *out, uint16_t rows) {
+    const size_t want = (size_t)rows * src.packed_width;
+    if (!src.compressed && !src.check_crc) {
+        return (int32_t)src.file->read(out, want);
+    }
+
+    const size_t strip_bytes = (size_t)kChunkRows * src.packed_width;
+    size_t produced = 0;
+    while (produced < want && src.next_strip < src.header.strip_count) {
+        const uint16_t i = src.next_strip;
+        const size_t out_len = min(strip_bytes, want - produced);
+        uint8_t *dst = out + produced;
+        if (src.compressed) {
+            const uint32_t in_len = g4_strip_offsets[i + 1] - g4_strip_offsets[i];
+            if (g4_strip_offsets[i + 1] < g4_strip_offsets[i] || in_len > g4z_max_encoded_size(strip_bytes)) {
+                LOGE("EINK", "G4Z strip %u bad length %lu", (unsigned)i, (unsigned long)in_len);
+                break;
+            }
+            if (src.file->read(g4z_in_buffer, in_len) != (int)in_len) break;
+            if (!g4z_decode_strip(g4z_in_buffer, in_len, dst, out_len)) {
+                LOGE("EINK", "G4Z strip %u decode failed", (unsigned)i);
+                break;
+            }
+        } else if (src.file->read(dst, out_len) != (int)out_len) {
+            break;
+        }
+        if (src.check_crc && g4_file_crc32(0, dst, out_len) != g4_strip_crcs[i]) {
+            LOGE("EINK", "G4 strip %u CRC mismatch", (unsigned)i);
+            break;
+        }
+        produced += out_len;
+        src.next_strip++;
+    }
+    return (int32_t)produced;
+}
+
+// Skip `rows` packed rows (same granularity as g4_source_read) without reading them.
+static bool g4_source_skip(G4Source &src, uint16_t rows) {
+    const uint32_t payload = src.header.header_bytes;
+    if (!src.compressed && !src.check_crc) {
+        return src.file->seek(src.file->position() + (uint32_t)rows * src.packed_width);
+    }
+    const uint16_t strips = (rows + kChunkRows - 1) / kChunkRows;
+    src.next_strip = (uint16_t)min((uint32_t)src.header.strip_count, (uint32_t)src.next_strip + strips);
+    const uint32_t offset = src.compressed
+        ? g4_strip_offsets[src.next_strip]
+        : (uint32_t)src.next_strip * kChunkRows * src.packed_width;
+    return src.file->seek(payload + offset);
+}
+
+static inline uint8_t g4_source_background_byte(const G4Source &src) {
+    return (uint8_t)((src.header.background << 4) | src.header.background);
+}
+
+// Hash rows on device unless the container already carries the tile table.
+// `first_row` is a row of the stored frame; sub-frame rows are hashed as full
+// panel rows (background around them) so the map always covers the panel.
+static void g4_source_hash_rows(const G4Source &src, const uint8_t *data, uint16_t first_row,
+                                uint16_t rows) {
+    if (src.has_tile_hashes) return;
+    if (src.full_frame) {
+        g4_tile_map_add_rows(data, first_row, rows, src.packed_width);
+        return;
+    }
+    const size_t panel_bytes = display.WIDTH / 2;
+    const size_t left = src.header.x / 2;
+    const size_t right = left + src.packed_width;
+    const uint8_t bg = g4_source_background_byte(src);
+    memset(g4_row_buffer, bg, left);
+    memset(g4_row_buffer + right, bg, panel_bytes - right);
+    for (uint16_t r = 0; r < rows; r++) {
+        memcpy(g4_row_buffer + left, data + (size_t)r * src.packed_width, src.packed_width);
+        g4_tile_map_add_rows(g4_row_buffer, src.header.y + first_row + r, 1, panel_bytes);
+    }
+}
+
+// Hash the background rows above (before the frame rows) or below (after) a sub-frame.
+static void g4_source_hash_background(const G4Source &src, bool above) {
+    if (src.has_tile_hashes || src.full_frame) return;
+    const uint16_t first = above ? 0 : src.header.y + src.header.height;
+    const uint16_t rows = above ? src.header.y : display.HEIGHT - first;
+    if (rows == 0) return;
+    memset(g4_row_buffer, g4_source_background_byte(src), display.WIDTH / 2);
+    // Stride 0: the same background row for every panel row.
+    g4_tile_map_add_rows(g4_row_buffer, first, rows, 0);
+}
+
+// ---------------------------------------------------------------------------
+// G4 SD -> IT8951 ping-pong pipeline
+// ---------------------------------------------------------------------------
+// A small reader task fills one chunk buffer from SD while the caller streams the
+// other one to the IT8951. Buffer ownership moves through two queues:
+// free (writer -> reader) and filled (reader -> writer). The reader always ends a
+// job with a chunk flagged `last` (or !ok), so the writer can drain safely.
+// SD and IT8951 must sit on separate SPI hosts for the transfers to overlap.
+static const uint32_t kG4ReaderStackSize = 4096;
+static const uint8_t kG4PipelineDepth = 2;
+
+struct G4ReadChunk {
+    uint8_t index;
+    uint16_t row;
+    uint16_t rows;
+    int32_t read_bytes;
+    bool ok;
+    bool last;
+};
+
+struct G4ReadJob {
+    G4Source *source;
+    uint16_t packed_width;
+    uint16_t h;
+    uint32_t read_us;
+};
+
+static TaskHandle_t g_g4_reader_task = nullptr;
+static QueueHandle_t g_g4_free_queue = nullptr;
+static QueueHandle_t g_g4_filled_queue = nullptr;
+static G4ReadJob g_g4_read_job = {};
+
+static uint8_t *g4_pipeline_buffer(uint8_t index) {
+    return index == 0 ? g4_chunk_buffer : g4_chunk_buffer_alt;
+}
+
+static void g4_reader_task(void *param) {
+    (void)param;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        G4ReadJob &job = g_g4_read_job;
+        job.read_us = 0;
+        for (uint16_t row = 0; row < job.h; row += kChunkRows) {
+            G4ReadChunk chunk = {};
+            xQueueReceive(g_g4_free_queue, &chunk.index, portMAX_DELAY);
+
+            chunk.row = row;
+            chunk.rows = (uint16_t)min((uint16_t)kChunkRows, (uint16_t)(job.h - row));
+            const size_t chunk_bytes = (size_t)chunk.rows * job.packed_width;
+
+            // Rows are contiguous in the file, so one read covers the whole chunk
+            // (G4Z: one strip read + decode, still on this task).
+            const uint32_t read_start = micros();
+            chunk.read_bytes = g4_source_read(*job.source, g4_pipeline_buffer(chunk.index), chunk.rows);
+            job.read_us += micros() - read_start;
+
+            chunk.ok = (chunk.read_bytes == (int32_t)chunk_bytes);
+            chunk.last = !chunk.ok || ((uint32_t)row + chunk.rows >= job.h);
+            xQueueSend(g_g4_filled_queue, &chunk, portMAX_DELAY);
+            if (chunk.last) break;
+        }
+    }
+}
+
+static bool ensure_g4_reader() {
+#if SD_USE_ARDUINO_SPI
+    // Shared SPI bus: SD and IT8951 transfers would serialize anyway.
+    return false;
+#else
+    if (g_g4_reader_task) return true;
+    if (!g_g4_free_queue) {
+        g_g4_free_queue = xQueueCreate(kG4PipelineDepth, sizeof(uint8_t));
+    }
+    if (!g_g4_filled_queue) {
+        g_g4_filled_queue = xQueueCreate(kG4PipelineDepth, sizeof(G4ReadChunk));
+    }
+    if (!g_g4_free_queue || !g_g4_filled_queue) {
+        LOGW("EINK", "G4 reader queues alloc failed");
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(g4_reader_task, "g4_reader", kG4ReaderStackSize, nullptr,
+                                uxTaskPriorityGet(nullptr), &g_g4_reader_task, tskNO_AFFINITY) != pdPASS) {
+        g_g4_reader_task = nullptr;
+        LOGW("EINK", "G4 reader task create failed");
+        return false;
+    }
+    return true;
+#endif
+}
+
+static bool render_g4_rows_serial(G4Source &src) {
     const unsigned long rows_start = millis();
+    const uint16_t w = src.header.width;
+    const uint16_t h = src.header.height;
     const uint16_t packed_width = w / 2;
     it8951_write_command16(IT8951_TCON_SYS_RUN);
-    for (uint16_t row = 0; row < h; row++) {
-        const uint16_t chunk_offset = (row % kChunkRows) * packed_width;
-        const int read_bytes = file.read(&g4_chunk_buffer[chunk_offset], packed_width);
-        if (read_bytes != (int)packed_width) {
-            LOGE("EINK", "G4 short read row=%u bytes=%d", (unsigned)row, read_bytes);
+    // Holding CS across SD reads is only safe when SD has its own SPI host.
+    it8951_load_begin_4bpp(src.header.x, src.header.y, w, h, !SD_USE_ARDUINO_SPI);
+    for (uint16_t row = 0; row < h; row += kChunkRows) {
+        const uint16_t chunk_rows = (uint16_t)min((uint32_t)kChunkRows, (uint32_t)(h - row));
+        const size_t chunk_bytes = (size_t)chunk_rows * packed_width;
+        const int32_t read_bytes = g4_source_read(src, g4_chunk_buffer, chunk_rows);
+        if (read_bytes != (int32_t)chunk_bytes) {
+            LOGE("EINK", "G4 short read row=%u bytes=%ld", (unsigned)row, (long)read_bytes);
+            it8951_load_end();
             return false;
         }
 
-        const bool chunk_ready = ((row % kChunkRows) == (kChunkRows - 1)) || (row == (h - 1));
-        if (chunk_ready) {
-            const uint16_t chunk_rows = (row % kChunkRows) + 1;
-            const uint16_t yrow = row - chunk_rows + 1;
-            const size_t chunk_bytes = (size_t)chunk_rows * packed_width;
-            it8951_set_partial_area_4bpp(0, yrow, w, chunk_rows);
-            it8951_write_data_bytes(g4_chunk_buffer, chunk_bytes);
-            it8951_write_command16(IT8951_TCON_LD_IMG_END);
-        }
+        it8951_load_write_rows(g4_chunk_buffer, packed_width, chunk_rows);
+        histogram_add_g4(g4_chunk_buffer, chunk_bytes);
+        g4_source_hash_rows(src, g4_chunk_buffer, row, chunk_rows);
 
-        if ((row % 200) == 0) {
+        if ((row % 200) < kChunkRows) {
             LOGD("EINK", "G4 Row %u/%u", (unsigned)row, (unsigned)h);
         }
 
@@ -495,10 +1526,298 @@ static bool render_g4_rows(File &file, uint16_t w, uint16_t h) {
             yield();
         }
     }
+    it8951_load_end();
     LOG_DURATION("EINK", "Rows", rows_start);
     return true;
 }
 
+static bool render_g4_rows(G4Source &src) {
+    const uint16_t w = src.header.width;
+    const uint16_t h = src.header.height;
+    if (h == 0) return true;
+    if (!ensure_g4_reader()) {
+        return render_g4_rows_serial(src);
+    }
+
+    const unsigned long rows_start = millis();
+    const uint16_t packed_width = w / 2;
+
+    // Keep the reader at the caller's priority so neither side starves the other.
+    vTaskPrioritySet(g_g4_reader_task, uxTaskPriorityGet(nullptr));
+
+    xQueueReset(g_g4_free_queue);
+    xQueueReset(g_g4_filled_queue);
+    for (uint8_t i = 0; i < kG4PipelineDepth; i++) {
+        xQueueSend(g_g4_free_queue, &i, 0);
+    }
+
+    g_g4_read_job.source = &src;
+    g_g4_read_job.packed_width = packed_width;
+    g_g4_read_job.h = h;
+    g_g4_read_job.read_us = 0;
+
+    it8951_write_command16(IT8951_TCON_SYS_RUN);
+    it8951_load_begin_4bpp(src.header.x, src.header.y, w, h, true);
+    xTaskNotifyGive(g_g4_reader_task);
+
+    bool ok = true;
+    uint32_t write_us = 0;
+    uint32_t wait_us = 0;
+    while (true) {
+        G4ReadChunk chunk = {};
+        const uint32_t wait_start = micros();
+        xQueueReceive(g_g4_filled_queue, &chunk, portMAX_DELAY);
+        wait_us += micros() - wait_start;
+
+        if (!chunk.ok) {
+            LOGE("EINK", "G4 short read row=%u bytes=%ld", (unsigned)chunk.row, (long)chunk.read_bytes);
+            ok = false;
+            break;
+        }
+
+        const uint32_t write_start = micros();
+        const size_t chunk_bytes = (size_t)chunk.rows * packed_width;
+        it8951_load_write_rows(g4_pipeline_buffer(chunk.index), packed_width, chunk.rows);
+        write_us += micros() - write_start;
+        // Runs while the last DMA bursts of this chunk are still in flight.
+        histogram_add_g4(g4_pipeline_buffer(chunk.index), chunk_bytes);
+        g4_source_hash_rows(src, g4_pipeline_buffer(chunk.index), chunk.row, chunk.rows);
+
+        if ((chunk.row % 200) < kChunkRows) {
+            LOGD("EINK", "G4 Row %u/%u", (unsigned)chunk.row, (unsigned)h);
+        }
+
+        if (chunk.last) break;
+        xQueueSend(g_g4_free_queue, &chunk.index, portMAX_DELAY);
+    }
+
+    it8951_load_end();
+    LOG_DURATION("EINK", "Rows", rows_start);
+
+    // Overlap = time both buses were busy at once (sum of busy times minus wall time).
+    const uint32_t wall_us = (uint32_t)(millis() - rows_start) * 1000UL;
+    const uint32_t read_us = g_g4_read_job.read_us;
+    const uint32_t busy_us = read_us + write_us;
+    const uint32_t overlap_us = busy_us > wall_us ? busy_us - wall_us : 0;
+    LOGI("EINK", "Rows pipeline read=%lums write=%lums wait=%lums overlap=%lums",
+         (unsigned long)(read_us / 1000),
+         (unsigned long)(write_us / 1000),
+         (unsigned long)(wait_us / 1000),
+         (unsigned long)(overlap_us / 1000));
+    return ok;
+}
+
+// Fill the panel area around a sub-frame with its background level. The
+// IT8951 has no fill command, so each margin is streamed from one memset
+// chunk (no SD reads); with `background_known` margins whose tiles already
+// hold that level in controller memory are skipped, one tile row at a time.
+static void load_g4_background(const G4Source &src, bool background_known) {
+    const uint16_t panel_w = display.WIDTH;
+    const uint16_t panel_h = display.HEIGHT;
+    const uint16_t x0 = src.header.x;
+    const uint16_t y0 = src.header.y;
+    const uint16_t x1 = x0 + src.header.width;
+    const uint16_t y1 = y0 + src.header.height;
+    const uint8_t level = src.header.background;
+    const unsigned long fill_start = millis();
+    uint32_t filled = 0;
+    uint32_t skipped = 0;
+
+    it8951_write_command16(IT8951_TCON_SYS_RUN);
+    for (uint16_t band_y = 0; band_y < panel_h; band_y += kG4TileSize) {
+        const uint16_t band_end = (uint16_t)min((uint32_t)panel_h, (uint32_t)band_y + kG4TileSize);
+        // Rows of this band above/below the frame span the panel; rows beside it only the side margins.
+        const uint16_t top_end = min(band_end, y0);
+        const uint16_t bottom_start = max(band_y, y1);
+        const uint16_t mid_start = max(band_y, y0);
+        const uint16_t mid_end = min(band_end, y1);
+        const uint16_t mid_rows = mid_end > mid_start ? mid_end - mid_start : 0;
+        const struct { uint16_t x, y, w, h; } margins[4] = {
+            {0, band_y, panel_w, (uint16_t)(top_end > band_y ? top_end - band_y : 0)},
+            {0, bottom_start, panel_w, (uint16_t)(band_end > bottom_start ? band_end - bottom_start : 0)},
+            {0, mid_start, x0, mid_rows},
+            {x1, mid_start, (uint16_t)(panel_w - x1), mid_rows},
+        };
+        for (const auto &m : margins) {
+            if (m.w == 0 || m.h == 0) continue;
+            if (background_known && g4_tile_map_previous_is_solid(m.x, m.y, m.w, m.h, level)) {
+                skipped += (uint32_t)m.w * m.h / 2;
+                continue;
+            }
+            it8951_load_fill_4bpp(m.x, m.y, m.w, m.h, level);
+            filled += (uint32_t)m.w * m.h / 2;
+        }
+    }
+    LOG_DURATION("EINK", "Background", fill_start);
+    LOGI("EINK", "Background level=%u filled=%lu skipped=%lu bytes",
+         (unsigned)level, (unsigned long)filled, (unsigned long)skipped);
+}
+
+// Background around a sub-frame (panel + histogram + tile hashes above it).
+// The frame rows follow, then load_g4_frame_end().
+static void load_g4_frame_begin(const G4Source &src, bool background_known) {
+    if (!src.full_frame) {
+        load_g4_background(src, background_known);
+        // Sampled like histogram_add_g4: one pixel in kHistogramSampleStride.
+        const uint32_t background_px =
+            (uint32_t)display.WIDTH * display.HEIGHT - (uint32_t)src.header.width * src.header.height;
+        g_render_histogram[src.header.background] += background_px / kHistogramSampleStride;
+        g_render_histogram_valid = true;
+    }
+    g4_source_hash_background(src, true);
+}
+
+static void load_g4_frame_end(const G4Source &src) {
+    g4_source_hash_background(src, false);
+}
+
+// Load a complete frame into the current load buffer: the background around a
+// sub-frame, then the stored rows at their placement.
+static bool load_g4_frame(G4Source &src, bool background_known) {
+    load_g4_frame_begin(src, background_known);
+    const bool ok = render_g4_rows(src);
+    load_g4_frame_end(src);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// G4 differential load
+// ---------------------------------------------------------------------------
+// When controller memory still holds the previous photo (same power session),
+// the file is read one tile row (band) at a time and only runs of changed tiles
+// are loaded, each as its own image area.
+static const uint16_t kDiffBandRows = kG4TileSize;
+static uint8_t *g4_band_buffer = nullptr;
+
+// A complete photo frame sits in controller memory and matches the tile map.
+// Anything that overwrites the frame or cuts controller power clears it.
+static bool g_controller_has_photo = false;
+
+static void photo_state_invalidate() {
+    g_controller_has_photo = false;
+    g4_tile_map_invalidate();
+    staged_invalidate();
+}
+
+static bool band_has_changes(uint16_t ty, uint16_t cols) {
+    for (uint16_t tx = 0; tx < cols; tx++) {
+        if (g4_tile_map_tile_changed(tx, ty)) return true;
+    }
+    return false;
+}
+
+static bool ensure_g4_band_buffer() {
+    if (!g4_band_buffer) {
+        g4_band_buffer = static_cast<uint8_t*>(alloc_buffer((size_t)(kMaxRowWidth / 2) * kDiffBandRows, "g4_band"));
+    }
+    return g4_band_buffer != nullptr;
+}
+
+static bool render_g4_rows_diff(G4Source &src, uint16_t w, uint16_t h, uint32_t *uploaded_bytes) {
+    if (!ensure_g4_band_buffer()) return false;
+
+    const unsigned long rows_start = millis();
+    const uint16_t packed_width = w / 2;
+    const uint16_t cols = g4_tile_map_cols();
+    bool sys_run_sent = false;
+    uint32_t spans = 0;
+    *uploaded_bytes = 0;
+
+    uint16_t skipped_bands = 0;
+
+    for (uint16_t band_y = 0; band_y < h; band_y += kDiffBandRows) {
+        const uint16_t rows = (uint16_t)min((uint32_t)kDiffBandRows, (uint32_t)(h - band_y));
+        const size_t band_bytes = (size_t)rows * packed_width;
+        const uint16_t ty = band_y / kG4TileSize;
+        if (src.has_tile_hashes && !band_has_changes(ty, cols)) {
+            // Hashes came from the file: unchanged bands need not be read at all.
+            // The histogram then only covers the bands being reloaded, so the
+            // refresh policy treats it as partial.
+            if (!g4_source_skip(src, rows)) {
+                LOGE("EINK", "G4 seek failed row=%u", (unsigned)band_y);
+                return false;
+            }
+            skipped_bands++;
+            g_render_histogram_partial = true;
+            continue;
+        }
+        const int32_t read_bytes = g4_source_read(src, g4_band_buffer, rows);
+        if (read_bytes != (int32_t)band_bytes) {
+            LOGE("EINK", "G4 short read row=%u bytes=%ld", (unsigned)band_y, (long)read_bytes);
+            return false;
+        }
+        histogram_add_g4(g4_band_buffer, band_bytes);
+        g4_source_hash_rows(src, g4_band_buffer, band_y, rows);
+
+        uint16_t tx = 0;
+        while (tx < cols) {
+            if (!g4_tile_map_tile_changed(tx, ty)) {
+                tx++;
+                continue;
+            }
+            uint16_t end = tx + 1;
+            while (end < cols && g4_tile_map_tile_changed(end, ty)) end++;
+
+            const uint16_t x = tx * kG4TileSize;
+            const uint16_t span_w = (uint16_t)min((uint32_t)end * kG4TileSize, (uint32_t)w) - x;
+            if (!sys_run_sent) {
+                it8951_write_command16(IT8951_TCON_SYS_RUN);
+                sys_run_sent = true;
+            }
+            it8951_load_begin_4bpp(x, band_y, span_w, rows, true);
+            it8951_load_write_rows(&g4_band_buffer[x / 2], packed_width, rows);
+            it8951_load_end();
+            *uploaded_bytes += (uint32_t)rows * (span_w / 2);
+            spans++;
+            tx = end;
+        }
+        yield();
+    }
+
+    LOG_DURATION("EINK", "RowsDiff", rows_start);
+    LOGI("EINK", "Rows diff spans=%lu skipped_bands=%u uploaded=%lu/%lu bytes",
+         (unsigned long)spans,
+         (unsigned)skipped_bands,
+         (unsigned long)*uploaded_bytes,
+         (unsigned long)((uint32_t)h * packed_width));
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Staged photo (always-on preload)
+// ---------------------------------------------------------------------------
+// Controller SDRAM holds far more than one frame. The next photo is loaded into
+// the spare buffer (LISAR moved there for the load) while the device is idle;
+// presenting it only swaps front/spare and triggers the refresh. The controller
+// stores 1 byte per pixel regardless of the load format.
+static const uint32_t kImgBufAlign = 0x1000;
+
+static bool g_staged_valid = false;
+static char g_staged_path[128] = {0};
+static uint32_t g_staged_histogram[kRefreshHistogramBins] = {};
+static bool g_staged_histogram_valid = false;
+
+static void staged_invalidate() {
+    g_staged_valid = false;
+    g_staged_path[0] = '\0';
+}
+
+// Signature of the panel levels the tile map was built with (0 = unknown). A
+// change means controller memory and the map no longer agree on pixel values.
+RTC_DATA_ATTR static uint32_t g_rtc_panel_levels_sig = 0;
+// Same for the photo orientation (1 + mirror bits, 0 = unknown).
+RTC_DATA_ATTR static uint32_t g_rtc_photo_orientation = 0;
+
+static void it8951_set_load_addr(uint32_t addr) {
+    it8951_write_reg(IT8951_REG_LISAR + 2, (uint16_t)(addr >> 16));
+    it8951_write_reg(IT8951_REG_LISAR, (uint16_t)(addr & 0xFFFF));
+}
+
+static uint32_t it8951_spare_buf_addr() {
+    const uint32_t frame_bytes = ((uint32_t)display.WIDTH * display.HEIGHT + kImgBufAlign - 1) & ~(kImgBufAlign - 1);
+    return g_front_buf_addr == g_img_buf_addr ? g_img_buf_addr + frame_bytes : g_img_buf_addr;
+}
+
 bool it8951_renderer_init() {
     if (g_display_ready) return true;
 
@@ -528,22 +1847,76 @@ bool it8951_renderer_init() {
     LOGI("EINK", "IT8951 SPI pins: SCK=%d MISO=%d MOSI=%d CS=%d",
          IT8951_SCK_PIN, IT8951_MISO_PIN, IT8951_MOSI_PIN, IT8951_CS_PIN);
 #endif
-    display.init(115200);
-#ifdef IT8951_VCOM
-    it8951_set_vcom(IT8951_VCOM);
-    const uint16_t vcom_readback = it8951_get_vcom();
-    LOGI("EINK", "VCOM set to -%.3fV (readback -%.3fV)",
-         (float)IT8951_VCOM / 1000.0f,
-         (float)vcom_readback / 1000.0f);
+    it8951_attach_busy_irq();
+#if IT8951_NATIVE_INIT
+    if (!it8951_native_init()) {
+        LOGW("EINK", "Native init failed; falling back to GxEPD2 init");
+        it8951_ensure_gxepd2();
+    }
+#else
+    it8951_ensure_gxepd2();
 #endif
     g_display_ready = true;
     LOGI("EINK", "Init OK");
     return true;
 }
 
+// Panel levels and photo orientation are applied while loading, so the tile
+// map only describes controller memory under the settings it was built with.
+static void photo_state_check_setting(uint32_t &rtc_value, uint32_t value, const char *what) {
+    if (rtc_value != 0 && rtc_value != value) {
+        LOGI("EINK", "%s changed; next photo loads in full", what);
+        photo_state_invalidate();
+    }
+    rtc_value = value;
+}
+
+void it8951_set_panel_levels(const uint8_t levels[16]) {
+    if (!levels) return;
+    uint32_t sig = 0;
+    g_panel_lut_active = panel_levels_build_lut(levels, g_panel_lut, &sig);
+    photo_state_check_setting(g_rtc_panel_levels_sig, sig, "Panel levels");
+    if (g_panel_lut_active) {
+        char text[48];
+        panel_levels_format(levels, text, sizeof(text));
+        LOGI("EINK", "Panel levels: %s", text);
+    }
+}
+
+const char *it8951_photo_orientation_name(uint8_t orientation) {
+    switch ((PhotoOrientation)orientation) {
+        case PhotoOrientation::AsEncoded: return "as-encoded";
+        case PhotoOrientation::Rotate180: return "rotate-180";
+        case PhotoOrientation::MirrorX: return "mirror-x";
+        case PhotoOrientation::MirrorY: return "mirror-y";
+    }
+    return "unknown";
+}
+
+void it8951_set_photo_orientation(uint8_t orientation) {
+    const PhotoOrientation o = (PhotoOrientation)orientation;
+    bool mirror_x = o == PhotoOrientation::Rotate180 || o == PhotoOrientation::MirrorX;
+    bool mirror_y = o == PhotoOrientation::Rotate180 || o == PhotoOrientation::MirrorY;
+    if (mirror_x || mirror_y) {
+        if (!ensure_orient_buffer()) {
+            LOGE("EINK", "Photo orientation %s unavailable (no buffer)", it8951_photo_orientation_name(orientation));
+            mirror_x = false;
+            mirror_y = false;
+        }
+    }
+    g_photo_mirror_x = mirror_x;
+    g_photo_mirror_y = mirror_y;
+    photo_state_check_setting(g_rtc_photo_orientation, 1u + (mirror_x ? 1u : 0u) + (mirror_y ? 2u : 0u),
+                              "Photo orientation");
+    if (mirror_x || mirror_y) {
+        LOGI("EINK", "Photo orientation: %s", it8951_photo_orientation_name(orientation));
+    }
+}
+
 bool it8951_render_bmp_from_sd(const char *path) {
     if (!path) return false;
     if (!g_display_ready && !it8951_renderer_init()) return false;
+    photo_state_invalidate();
     const unsigned long start_ms = millis();
     File file = SD.open(path, FILE_READ);
     if (!file) {
@@ -551,8 +1924,11 @@ bool it8951_render_bmp_from_sd(const char *path) {
         return false;
     }
 
-    const bool ok = draw_bmp_16gray(file, 0, 0);
+    bus_stats_reset();
+    PhotoLoadScope photo_scope;
+    const bool ok = draw_bmp_4bpp(file, 0, 0);
     file.close();
+    busy_stats_commit("RenderBmp");
     LOG_DURATION("EINK", "RenderTotal", start_ms);
     return ok;
 }
@@ -634,6 +2010,14 @@ bool it8951_convert_bmp_to_raw_g4(const char *bmp_path, const char *raw_path, co
         return false;
     }
 
+    G4Dither dither;
+    if (!g4_dither_begin(dither, (G4DitherMode)G4_DITHER_MODE, (uint16_t)width)) {
+        bmp.close();
+        raw.close();
+        g4.close();
+        return false;
+    }
+
     bmp.seek(image_offset);
 
     for (uint16_t row = 0; row < height; row++) {
@@ -643,10 +2027,6 @@ bool it8951_convert_bmp_to_raw_g4(const char *bmp_path, const char *raw_path, co
         uint8_t in_byte = 0;
         uint8_t in_bits = 0;
 
-        uint32_t raw_idx = 0;
-        uint32_t g4_idx = 0;
-        uint8_t g4_pack = 0;
-
         for (uint16_t col = 0; col < width; col++) {
             if (in_idx >= in_bytes) {
                 in_bytes = bmp.read(input_buffer, in_remain > kInputBufferBytes ? kInputBufferBytes : in_remain);
@@ -699,19 +2079,18 @@ bool it8951_convert_bmp_to_raw_g4(const char *bmp_path, const char *raw_path, co
                     bmp.close();
                     raw.close();
                     g4.close();
+                    g4_dither_end(dither);
                     LOGE("EINK", "BMP depth unsupported");
                     return false;
             }
 
-            const uint8_t level = grey >> 4;
-            raw_row_buffer[raw_idx++] = level * 17;
+            raw_row_buffer[col] = grey;
+        }
 
-            if ((col & 1) == 0) {
-                g4_pack = (level << 4);
-            } else {
-                g4_pack |= level;
-                g4_row_buffer[g4_idx++] = g4_pack;
-            }
+        g4_dither_row(dither, raw_row_buffer, raw_row_buffer);
+        g4_pack_levels(raw_row_buffer, (uint16_t)width, g4_row_buffer, false);
+        for (uint16_t col = 0; col < width; col++) {
+            raw_row_buffer[col] *= 17;
         }
 
         raw.write(raw_row_buffer, width);
@@ -725,6 +2104,7 @@ bool it8951_convert_bmp_to_raw_g4(const char *bmp_path, const char *raw_path, co
     bmp.close();
     raw.close();
     g4.close();
+    g4_dither_end(dither);
     LOG_DURATION("EINK", "Convert", start_ms);
     return true;
 }
@@ -734,6 +2114,7 @@ bool it8951_render_raw8(const char *raw_path) {
     if (!g_display_ready && !it8951_renderer_init()) return false;
     if (it8951_renderer_is_busy()) return false;
     set_render_busy(true);
+    photo_state_invalidate();
     File raw = SD.open(raw_path, FILE_READ);
     if (!raw) {
         LOGE("EINK", "RAW open failed");
@@ -744,20 +2125,139 @@ bool it8951_render_raw8(const char *raw_path) {
     const unsigned long start_ms = millis();
     const uint16_t w = display.WIDTH;
     const uint16_t h = display.HEIGHT;
+    bus_stats_reset();
     const bool ok = render_raw_rows(raw, w, h);
     raw.close();
 
     if (ok) {
         const unsigned long refresh_start = millis();
-        it8951_photo_refresh_fullscreen("raw8");
+        it8951_photo_refresh("raw8", nullptr);
         LOG_DURATION("EINK", "Refresh", refresh_start);
     }
+    busy_stats_commit("RenderRaw");
 
     LOG_DURATION("EINK", "RenderRaw", start_ms);
     set_render_busy(false);
     return ok;
 }
 
+// ---------------------------------------------------------------------------
+// Photo overlays
+// ---------------------------------------------------------------------------
+// Mix the boxes drawn by the current photo load into the tile map being built
+// (frame space, like the map).
+static void overlay_salt_next() {
+    for (const PhotoOverlayBox &b : g_load_boxes) {
+        if (b.sig == 0) continue;
+        uint16_t x = b.x;
+        uint16_t y = b.y;
+        photo_orient_rect(x, y, b.w, b.h);
+        g4_tile_map_salt(x, y, b.w, b.h, b.sig);
+    }
+}
+
+struct OverlayUpdate {
+    uint8_t count;
+    PhotoOverlayBox boxes[kPhotoOverlaySlots];
+};
+
+// Whether the current boxes can be drawn over `base` (what a buffer holds)
+// without the photo underneath: a box may appear or change text in place; one
+// that moved or went away needs a full render.
+static bool overlay_update_possible(const PhotoOverlayBox *base) {
+    for (uint8_t i = 0; i < kPhotoOverlaySlots; i++) {
+        const PhotoOverlayBox &cur = photo_overlay_box((PhotoOverlaySlot)i);
+        const PhotoOverlayBox &old = base[i];
+        if (cur.sig == old.sig || old.sig == 0) continue;
+        if (cur.sig == 0 || cur.x != old.x || cur.y != old.y || cur.w != old.w || cur.h != old.h) return false;
+    }
+    return true;
+}
+
+// Load the boxes that differ from `base` into the current load buffer, each as
+// its own image area, and move their signatures in the tile map: the map of
+// the panel (`committed`) or the one being built. `base` becomes the current
+// set. Check overlay_update_possible() first.
+static void overlay_load_changes(PhotoOverlayBox *base, bool committed, OverlayUpdate &update) {
+    update = {};
+    for (uint8_t i = 0; i < kPhotoOverlaySlots; i++) {
+        const PhotoOverlayBox &cur = photo_overlay_box((PhotoOverlaySlot)i);
+        const uint32_t old_sig = base[i].sig;
+        if (cur.sig == old_sig) continue;
+        if (update.count == 0) {
+            it8951_write_command16(IT8951_TCON_SYS_RUN);
+        }
+        it8951_load_begin_area(cur.x, cur.y, cur.w, cur.h, true, false, false);
+        it8951_load_write(cur.pixels, (size_t)(cur.w / 2) * cur.h);
+        it8951_load_end();
+        uint16_t x = cur.x;
+        uint16_t y = cur.y;
+        photo_orient_rect(x, y, cur.w, cur.h);
+        for (const uint32_t salt : {old_sig, cur.sig}) {
+            if (committed) {
+                g4_tile_map_salt_previous(x, y, cur.w, cur.h, salt);
+            } else {
+                g4_tile_map_salt(x, y, cur.w, cur.h, salt);
+            }
+        }
+        base[i] = cur;
+        update.boxes[update.count++] = cur;
+    }
+}
+
+bool it8951_render_overlays() {
+    if (!g_display_ready || !g_controller_has_photo) return false;
+    if (is_ui_active()) return false;
+    if (it8951_renderer_is_busy()) return false;
+    set_render_busy(true);
+
+    const unsigned long start_ms = millis();
+    photo_overlay_prepare();
+    const bool ok = overlay_update_possible(g_front_boxes);
+    if (!ok) {
+        LOGI("EINK", "Overlay moved or hidden: needs a full render");
+    } else {
+        bus_stats_reset();
+        OverlayUpdate update;
+        overlay_load_changes(g_front_boxes, true, update);
+        // Boxes are black and white only: DU, each box on its own so the photo
+        // between them is not driven.
+        for (uint8_t i = 0; i < update.count; i++) {
+            const PhotoOverlayBox &b = update.boxes[i];
+            it8951_refresh_region((int16_t)b.x, (int16_t)b.y, (int16_t)b.w, (int16_t)b.h, EinkWaveform::DU, "overlay");
+        }
+        if (update.count > 0) {
+            bus_stats_log("RenderOverlays");
+            LOGI("EINK", "Overlays updated=%u", (unsigned)update.count);
+            LOG_DURATION("EINK", "RenderOverlays", start_ms);
+        }
+    }
+    set_render_busy(false);
+    return ok;
+}
+
+// A complete photo frame is in the front buffer and its tile hashes have been
+// accumulated: refresh what changed and make it the new reference.
+static void present_loaded_photo(const char *tag, bool have_previous) {
+    const G4TileDiff diff = g4_tile_map_diff();
+    if (have_previous) {
+        LOGI("EINK", "Tiles changed=%u/%u bounds=%ux%u@%u,%u",
+             (unsigned)diff.changed_tiles, (unsigned)diff.total_tiles,
+             (unsigned)diff.w, (unsigned)diff.h, (unsigned)diff.x, (unsigned)diff.y);
+    }
+
+    const unsigned long refresh_start = millis();
+    if (have_previous && diff.changed_tiles == 0) {
+        LOGI("EINK", "Refresh skipped (unchanged)");
+    } else {
+        it8951_photo_refresh(tag, have_previous ? &diff : nullptr);
+    }
+    LOG_DURATION("EINK", "Refresh", refresh_start);
+    g4_tile_map_commit();
+    g_controller_has_photo = true;
+    memcpy(g_front_boxes, g_load_boxes, sizeof(g_front_boxes));
+}
+
 bool it8951_render_g4(const char *g4_path) {
     if (!g4_path) return false;
     if (is_ui_active()) {
@@ -767,6 +2267,9 @@ bool it8951_render_g4(const char *g4_path) {
     if (!g_display_ready && !it8951_renderer_init()) return false;
     if (it8951_renderer_is_busy()) return false;
     set_render_busy(true);
+    PhotoLoadScope photo_scope;
+    // The tile map is about to be rebuilt for this frame.
+    staged_invalidate();
     File g4 = SD.open(g4_path, FILE_READ);
     if (!g4) {
         LOGE("EINK", "G4 open failed");
@@ -777,66 +2280,533 @@ bool it8951_render_g4(const char *g4_path) {
     const unsigned long start_ms = millis();
     const uint16_t w = display.WIDTH;
     const uint16_t h = display.HEIGHT;
-    const bool ok = render_g4_rows(g4, w, h);
+    G4Source src;
+    if (!g4_source_open(g4, w, h, &src)) {
+        g4.close();
+        set_render_busy(false);
+        return false;
+    }
+    bus_stats_reset();
+    g4_tile_map_begin(w, h);
+    if (src.has_tile_hashes) {
+        g4_tile_map_set_hashes(g4_tile_hashes, (uint16_t)g4_file_tile_count(src.header));
+    }
+    overlay_salt_next();
+    const bool have_previous = g4_tile_map_has_previous();
+
+    bool ok = false;
+    uint32_t uploaded_bytes = 0;
+    if (g_controller_has_photo && have_previous && src.full_frame) {
+        ok = render_g4_rows_diff(src, w, h, &uploaded_bytes);
+    } else {
+        // Controller memory still holds the previous frame: its background margins can stay.
+        ok = load_g4_frame(src, g_controller_has_photo && have_previous);
+    }
     g4.close();
+    bus_stats_log("RenderG4");
 
     if (ok) {
-        const unsigned long refresh_start = millis();
-        it8951_photo_refresh_fullscreen("g4_file");
-        LOG_DURATION("EINK", "Refresh", refresh_start);
+        present_loaded_photo("g4_file", have_previous);
+    } else {
+        photo_state_invalidate();
     }
+    busy_stats_commit("RenderG4");
 
     LOG_DURATION("EINK", "RenderG4", start_ms);
     set_render_busy(false);
     return ok;
 }
 
-bool it8951_render_g4_buffer(const uint8_t* g4, uint16_t w, uint16_t h) {
-    return it8951_render_g4_buffer_ex(g4, w, h, true);
+bool it8951_renderer_stage_g4(const char *g4_path) {
+    if (!g4_path) return false;
+    if (is_ui_active()) return false;
+    if (!g_display_ready && !it8951_renderer_init()) return false;
+    if (g_img_buf_addr == 0) return false;
+    if (it8951_renderer_is_busy()) return false;
+    set_render_busy(true);
+    PhotoLoadScope photo_scope;
+    staged_invalidate();
+    File g4 = SD.open(g4_path, FILE_READ);
+    if (!g4) {
+        LOGE("EINK", "G4 open failed");
+        set_render_busy(false);
+        return false;
+    }
+
+    const unsigned long start_ms = millis();
+    const uint16_t w = display.WIDTH;
+    const uint16_t h = display.HEIGHT;
+    const uint32_t spare_addr = it8951_spare_buf_addr();
+    G4Source src;
+    if (!g4_source_open(g4, w, h, &src)) {
+        g4.close();
+        set_render_busy(false);
+        return false;
+    }
+    bus_stats_reset();
+    g4_tile_map_begin(w, h);
+    if (src.has_tile_hashes) {
+        g4_tile_map_set_hashes(g4_tile_hashes, (uint16_t)g4_file_tile_count(src.header));
+    }
+    overlay_salt_next();
+
+    it8951_set_load_addr(spare_addr);
+    // Spare buffer contents are unknown: always fill the background.
+    const bool ok = load_g4_frame(src, false);
+    it8951_set_load_addr(g_front_buf_addr);
+    g4.close();
+    bus_stats_log("StageG4");
+
+    if (ok) {
+        memcpy(g_staged_histogram, g_render_histogram, sizeof(g_staged_histogram));
+        g_staged_histogram_valid = g_render_histogram_valid;
+        memcpy(g_staged_boxes, g_load_boxes, sizeof(g_staged_boxes));
+        strlcpy(g_staged_path, g4_path, sizeof(g_staged_path));
+        g_staged_valid = true;
+        LOGI("EINK", "Staged G4=%s buf=0x%08lx", g4_path, (unsigned long)spare_addr);
+    }
+
+    LOG_DURATION("EINK", "StageG4", start_ms);
+    set_render_busy(false);
+    return ok;
 }
 
-bool it8951_render_g4_buffer_ex(const uint8_t* g4, uint16_t w, uint16_t h, bool full_refresh) {
-    if (!g4) return false;
+bool it8951_renderer_present_staged(const char *g4_path) {
+    if (!g4_path || !g_staged_valid || !g_display_ready) return false;
+    if (strcmp(g4_path, g_staged_path) != 0) return false;
+    if (is_ui_active()) return false;
+    if (it8951_renderer_is_busy()) return false;
+    set_render_busy(true);
+    // Overlays that changed since staging (clock) are redrawn into the staged
+    // frame before it is shown; one that moved or went away needs the photo.
+    photo_overlay_prepare();
+    if (!overlay_update_possible(g_staged_boxes)) {
+        LOGI("EINK", "Staged overlays out of date; rendering instead");
+        staged_invalidate();
+        set_render_busy(false);
+        return false;
+    }
+
+    const unsigned long start_ms = millis();
+    bus_stats_reset();
+    memcpy(g_render_histogram, g_staged_histogram, sizeof(g_render_histogram));
+    g_render_histogram_valid = g_staged_histogram_valid;
+
+    // The spare buffer becomes the front one; the old front is the next spare.
+    g_front_buf_addr = it8951_spare_buf_addr();
+    staged_invalidate();
+    it8951_set_load_addr(g_front_buf_addr);
+    memcpy(g_load_boxes, g_staged_boxes, sizeof(g_load_boxes));
+    OverlayUpdate overlays;
+    overlay_load_changes(g_load_boxes, false, overlays);
+
+    present_loaded_photo("g4_staged", g4_tile_map_has_previous());
+    busy_stats_commit("PresentStaged");
+
+    LOG_DURATION("EINK", "PresentStaged", start_ms);
+    set_render_busy(false);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// JPEG (on-device conversion)
+// ---------------------------------------------------------------------------
+// jpeg_g4 delivers dithered packed strips bottom-up; each is loaded as its own
+// image area at its place in the frame. Tile hashes need rows top-down per
+// tile, so strips are collected into the 64-row band buffer and a band is
+// hashed once its top row has arrived. With a cache path the strips are also
+// written as a G4 container (raw, strip CRCs) for later wakes.
+static_assert(kJpegG4StripRows == kChunkRows, "JPEG strips feed the chunk loader");
+
+struct JpegRenderJob {
+    G4Source *src;
+    int32_t next_band;         // lowest panel tile row not hashed yet (counts down)
+    File cache;
+    bool cache_ok;
+    uint32_t cache_crcs[kG4MaxStrips];
+};
+
+static void jpeg_hash_band(const G4Source &src, uint16_t ty) {
+    const uint16_t y0 = src.header.y;
+    const uint16_t first = max((uint16_t)(ty * kG4TileSize), y0);
+    const uint16_t end = min((uint16_t)((ty + 1) * kG4TileSize), (uint16_t)(y0 + src.header.height));
+    if (end <= first) return;
+    g4_source_hash_rows(src, &g4_band_buffer[(size_t)(first % kG4TileSize) * src.packed_width],
+                        first - y0, end - first);
+}
+
+static bool jpeg_strip_sink(const uint8_t *packed, uint16_t first_row, uint16_t rows, void *user) {
+    JpegRenderJob &job = *static_cast<JpegRenderJob*>(user);
+    const G4Source &src = *job.src;
+    const size_t strip_bytes = (size_t)rows * src.packed_width;
+
+    it8951_load_begin_4bpp(src.header.x, src.header.y + first_row, src.header.width, rows, true);
+    it8951_load_write_rows(packed, src.packed_width, rows);
+    it8951_load_end();
+    histogram_add_g4(packed, strip_bytes);
+
+    if (!src.has_tile_hashes) {
+        // Bottom row first, so a band is complete before the next band's rows reuse the buffer.
+        for (int32_t r = rows - 1; r >= 0; r--) {
+            const uint16_t py = src.header.y + first_row + r;
+            memcpy(&g4_band_buffer[(size_t)(py % kG4TileSize) * src.packed_width],
+                   packed + (size_t)r * src.packed_width, src.packed_width);
+            const uint16_t ty = py / kG4TileSize;
+            if ((int32_t)ty == job.next_band && py == max((uint16_t)(ty * kG4TileSize), src.header.y)) {
+                jpeg_hash_band(src, ty);
+                job.next_band--;
+            }
+        }
+    }
+
+    if (job.cache_ok) {
+        const uint32_t offset = src.header.header_bytes + (uint32_t)first_row * src.packed_width;
+        job.cache_ok = job.cache.seek(offset) && job.cache.write(packed, strip_bytes) == strip_bytes;
+        job.cache_crcs[first_row / kChunkRows] = g4_file_crc32(0, packed, strip_bytes);
+    }
+    yield();
+    return true;
+}
+
+// Header + zeroed CRC table; the table is rewritten once all strips are in.
+static bool jpeg_cache_begin(JpegRenderJob &job, const char *tmp_path) {
+    if (SD.exists(tmp_path)) SD.remove(tmp_path);
+    const String path(tmp_path);
+    const int slash = path.lastIndexOf('/');
+    if (slash > 0) {
+        const String dir = path.substring(0, slash);
+        if (!SD.exists(dir) && !SD.mkdir(dir)) return false;
+    }
+    job.cache = SD.open(tmp_path, FILE_WRITE);
+    if (!job.cache) return false;
+    memset(job.cache_crcs, 0, sizeof(job.cache_crcs));
+    const G4FileHeader &hdr = job.src->header;
+    return job.cache.write(reinterpret_cast<const uint8_t*>(&hdr), sizeof(hdr)) == sizeof(hdr) &&
+           job.cache.write(reinterpret_cast<const uint8_t*>(job.cache_crcs), 4u * hdr.strip_count) ==
+               4u * hdr.strip_count;
+}
+
+static void jpeg_cache_end(JpegRenderJob &job, bool ok, const char *tmp_path, const char *cache_path) {
+    if (job.cache) {
+        const size_t table = 4u * job.src->header.strip_count;
+        ok = ok && job.cache_ok && job.cache.seek(sizeof(G4FileHeader)) &&
+             job.cache.write(reinterpret_cast<const uint8_t*>(job.cache_crcs), table) == table;
+        job.cache.flush();
+        job.cache.close();
+    }
+    if (ok) {
+        if (SD.exists(cache_path)) SD.remove(cache_path);
+        ok = SD.rename(tmp_path, cache_path);
+    }
+    if (ok) {
+        LOGI("EINK", "JPEG cached as %s", cache_path);
+    } else {
+        SD.remove(tmp_path);
+        LOGW("EINK", "JPEG cache write failed: %s", cache_path);
+    }
+}
+
+bool it8951_render_jpeg(const char *jpeg_path, const char *cache_g4_path) {
+    if (!jpeg_path) return false;
     if (is_ui_active()) {
         LOGE("EINK", "Render blocked: UI active. Call display_manager_ui_stop() before rendering.");
         return false;
     }
     if (!g_display_ready && !it8951_renderer_init()) return false;
     if (it8951_renderer_is_busy()) return false;
+    if (!ensure_buffers() || !ensure_g4_band_buffer()) return false;
     set_render_busy(true);
-
-    if (w != display.WIDTH || h != display.HEIGHT) {
-        LOGW("EINK", "G4 buffer size mismatch %ux%u (panel %ux%u)",
-             (unsigned)w, (unsigned)h, (unsigned)display.WIDTH, (unsigned)display.HEIGHT);
+    PhotoLoadScope photo_scope;
+    staged_invalidate();
+    File jpeg = SD.open(jpeg_path, FILE_READ);
+    if (!jpeg) {
+        LOGE("EINK", "JPEG open failed");
+        set_render_busy(false);
+        return false;
     }
 
     const unsigned long start_ms = millis();
-    const uint16_t packed_width = w / 2;
+    const uint16_t w = display.WIDTH;
+    const uint16_t h = display.HEIGHT;
+    JpegG4Frame frame = {};
+    if (!jpeg_g4_open(jpeg, w, h, &frame)) {
+        jpeg.close();
+        set_render_busy(false);
+        return false;
+    }
+
+    // Describe the converted frame like a raw G4 sub-frame so placement,
+    // background fill and tile hashing are shared with the G4 path.
+    G4Source src = {};
+    G4FileHeader &hdr = src.header;
+    hdr.magic = kG4FileMagic;
+    hdr.version = kG4FileVersion;
+    hdr.encoding = (uint8_t)G4Encoding::Raw;
+    hdr.flags = kG4FileHasStripCrc;
+    hdr.width = frame.w;
+    hdr.height = frame.h;
+    hdr.x = frame.x;
+    hdr.y = frame.y;
+    hdr.strip_rows = kChunkRows;
+    hdr.strip_count = (frame.h + kChunkRows - 1) / kChunkRows;
+    hdr.background = 0x0F;
+    hdr.header_bytes = sizeof(G4FileHeader) + 4u * hdr.strip_count;
+    hdr.payload_bytes = (uint32_t)(frame.w / 2) * frame.h;
+    src.packed_width = frame.w / 2;
+    src.full_frame = frame.x == 0 && frame.y == 0 && frame.w == w && frame.h == h;
+
+    JpegRenderJob job = {};
+    job.src = &src;
+    job.next_band = (frame.y + frame.h - 1) / kG4TileSize;
+    String tmp_path;
+    if (cache_g4_path) {
+        tmp_path = String(cache_g4_path) + ".tmp";
+        job.cache_ok = jpeg_cache_begin(job, tmp_path.c_str());
+        if (!job.cache_ok) {
+            LOGW("EINK", "JPEG cache open failed: %s", tmp_path.c_str());
+        }
+    }
 
+    bus_stats_reset();
+    g4_tile_map_begin(w, h);
+    overlay_salt_next();
+    const bool have_previous = g4_tile_map_has_previous();
+    load_g4_frame_begin(src, g_controller_has_photo && have_previous);
     it8951_write_command16(IT8951_TCON_SYS_RUN);
+    const bool ok = jpeg_g4_decode(frame, (G4DitherMode)G4_DITHER_MODE, g4_chunk_buffer, jpeg_strip_sink, &job);
+    load_g4_frame_end(src);
+    jpeg_g4_close();
+    jpeg.close();
+    bus_stats_log("RenderJpeg");
+
+    if (job.cache) {
+        jpeg_cache_end(job, ok, tmp_path.c_str(), cache_g4_path);
+    }
 
-    for (uint16_t row = 0; row < h; row += kChunkRows) {
-        const uint16_t chunk_rows = (uint16_t)min((uint16_t)kChunkRows, (uint16_t)(h - row));
-        const size_t chunk_bytes = (size_t)chunk_rows * packed_width;
-        const uint8_t* chunk_ptr = g4 + (size_t)row * packed_width;
+    if (ok) {
+        present_loaded_photo("jpeg", have_previous);
+    } else {
+        photo_state_invalidate();
+    }
+    busy_stats_commit("RenderJpeg");
 
-        it8951_set_partial_area_4bpp(0, row, w, chunk_rows);
-        it8951_write_data_bytes(chunk_ptr, chunk_bytes);
-        it8951_write_command16(IT8951_TCON_LD_IMG_END);
+    LOG_DURATION("EINK", "RenderJpeg", start_ms);
+    set_render_busy(false);
+    return ok;
+}
 
-        if ((row % 200) == 0) {
-            LOGD("EINK", "G4 buf Row %u/%u", (unsigned)row, (unsigned)h);
+// ---------------------------------------------------------------------------
+// Collage
+// ---------------------------------------------------------------------------
+// Each cell reads its file strip by strip like a normal render. Rows outside
+// the crop window are dropped as they arrive; kept rows are averaged k x k
+// (levels, rounded) into the output chunk and loaded as one image area at the
+// cell's place. Nothing larger than a chunk is buffered, so the SPI payload is
+// the collage area, not the sum of the files.
+static uint16_t *collage_sums = nullptr;
+
+static bool collage_load_cell(G4Source &src, const CollagePlan &p) {
+    const uint16_t src_pw = src.packed_width;
+    const uint16_t out_pw = p.out_w / 2;
+    const uint16_t src_end = p.src_y + p.out_h * p.k;
+    uint16_t row = (p.src_y / kChunkRows) * kChunkRows;
+    if (row > 0 && !g4_source_skip(src, row)) return false;
+
+    memset(collage_sums, 0, sizeof(uint16_t) * p.out_w);
+    uint8_t *out = g4_chunk_buffer_alt;
+    uint16_t out_rows = 0;
+    uint8_t summed = 0;
+    bool ok = true;
+    it8951_load_begin_4bpp(p.dst_x, p.dst_y, p.out_w, p.out_h, !SD_USE_ARDUINO_SPI);
+    while (row < src_end) {
+        const uint16_t n = (uint16_t)min((uint32_t)kChunkRows, (uint32_t)(src.header.height - row));
+        if (g4_source_read(src, g4_chunk_buffer, n) != (int32_t)n * src_pw) {
+            LOGE("EINK", "Collage short read row=%u", (unsigned)row);
+            ok = false;
+            break;
+        }
+        const uint16_t first = max(row, p.src_y);
+        const uint16_t last = min((uint16_t)(row + n), src_end);
+        for (uint16_t y = first; y < last; y++) {
+            const uint8_t *data = g4_chunk_buffer + (size_t)(y - row) * src_pw;
+            if (p.k == 1) {
+                memcpy(out + (size_t)out_rows * out_pw, data + p.src_x / 2, out_pw);
+                out_rows++;
+            } else {
+                collage_accumulate(p, data, collage_sums);
+                if (++summed == p.k) {
+                    collage_pack_row(p, collage_sums, out + (size_t)out_rows * out_pw);
+                    summed = 0;
+                    out_rows++;
+                }
+            }
+            if (out_rows == kChunkRows) {
+                it8951_load_write_rows(out, out_pw, out_rows);
+                histogram_add_g4(out, (size_t)out_rows * out_pw);
+                out_rows = 0;
+            }
         }
+        row += n;
+        yield();
+    }
+    if (ok && out_rows > 0) {
+        it8951_load_write_rows(out, out_pw, out_rows);
+        histogram_add_g4(out, (size_t)out_rows * out_pw);
+    }
+    it8951_load_end();
+    return ok;
+}
 
-        if ((row % 32) == 0) {
-            yield();
+// White around the loaded areas: the panel is cut into bands at every area
+// edge and the gaps between areas in each band are filled.
+static void collage_fill_gaps(const CollagePlan *plans, uint8_t count) {
+    const uint16_t panel_w = display.WIDTH;
+    const uint16_t panel_h = display.HEIGHT;
+    uint16_t edges[2 * kCollageMaxCells + 2];
+    uint8_t n_edges = 0;
+    edges[n_edges++] = 0;
+    edges[n_edges++] = panel_h;
+    for (uint8_t i = 0; i < count; i++) {
+        edges[n_edges++] = plans[i].dst_y;
+        edges[n_edges++] = plans[i].dst_y + plans[i].out_h;
+    }
+    std::sort(edges, edges + n_edges);
+
+    uint32_t filled = 0;
+    for (uint8_t e = 0; e + 1 < n_edges; e++) {
+        const uint16_t y0 = edges[e];
+        const uint16_t y1 = edges[e + 1];
+        if (y1 <= y0) continue;
+        struct Span { uint16_t x0, x1; } spans[kCollageMaxCells];
+        uint8_t n_spans = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            const CollagePlan &p = plans[i];
+            if (p.dst_y <= y0 && y1 <= p.dst_y + p.out_h) {
+                spans[n_spans++] = {p.dst_x, (uint16_t)(p.dst_x + p.out_w)};
+            }
+        }
+        std::sort(spans, spans + n_spans, [](const Span &a, const Span &b) { return a.x0 < b.x0; });
+        uint16_t x = 0;
+        for (uint8_t i = 0; i <= n_spans; i++) {
+            const uint16_t gap_end = i < n_spans ? spans[i].x0 : panel_w;
+            if (gap_end > x) {
+                it8951_load_fill_4bpp(x, y0, gap_end - x, y1 - y0, 0x0F);
+                filled += (uint32_t)(gap_end - x) * (y1 - y0);
+            }
+            if (i < n_spans) x = max(x, spans[i].x1);
+        }
+    }
+    g_render_histogram[0x0F] += filled / kHistogramSampleStride;
+    g_render_histogram_valid = true;
+}
+
+bool it8951_render_collage(const CollageCell *cells, uint8_t count, CollageFit fit) {
+    if (!cells || count == 0 || count > kCollageMaxCells) return false;
+    if (is_ui_active()) {
+        LOGE("EINK", "Render blocked: UI active. Call display_manager_ui_stop() before rendering.");
+        return false;
+    }
+    if (!g_display_ready && !it8951_renderer_init()) return false;
+    if (it8951_renderer_is_busy()) return false;
+    if (!ensure_buffers()) return false;
+    if (!collage_sums) {
+        collage_sums = static_cast<uint16_t*>(alloc_buffer(sizeof(uint16_t) * kMaxRowWidth, "collage_sums"));
+        if (!collage_sums) return false;
+    }
+    set_render_busy(true);
+    PhotoLoadScope photo_scope;
+    const unsigned long start_ms = millis();
+
+    // Size every cell first: the gaps are filled before the cells stream in.
+    CollagePlan plans[kCollageMaxCells] = {};
+    for (uint8_t i = 0; i < count; i++) {
+        const CollageCell &cell = cells[i];
+        if (!cell.g4_path || (cell.x & 3) || cell.w < 4 || cell.h == 0 ||
+            cell.x + cell.w > display.WIDTH || cell.y + cell.h > display.HEIGHT) {
+            LOGE("EINK", "Collage cell %u invalid", (unsigned)i);
+            set_render_busy(false);
+            return false;
+        }
+        File g4 = SD.open(cell.g4_path, FILE_READ);
+        G4Source src;
+        const bool opened = g4 && g4_source_open(g4, display.WIDTH, display.HEIGHT, &src);
+        if (g4) g4.close();
+        if (!opened) {
+            LOGE("EINK", "Collage open failed: %s", cell.g4_path);
+            set_render_busy(false);
+            return false;
         }
+        collage_plan(cell, src.header.width, src.header.height, fit, plans[i]);
+        if (plans[i].out_w == 0 || plans[i].out_h == 0) {
+            LOGE("EINK", "Collage cell %u too small for %s", (unsigned)i, cell.g4_path);
+            set_render_busy(false);
+            return false;
+        }
+        LOGI("EINK", "Collage cell %u: %ux%u /%u -> %ux%u@%u,%u", (unsigned)i,
+             (unsigned)src.header.width, (unsigned)src.header.height, (unsigned)plans[i].k,
+             (unsigned)plans[i].out_w, (unsigned)plans[i].out_h,
+             (unsigned)plans[i].dst_x, (unsigned)plans[i].dst_y);
+    }
+
+    // Controller memory stops matching any tile map.
+    photo_state_invalidate();
+    bus_stats_reset();
+    it8951_write_command16(IT8951_TCON_SYS_RUN);
+    collage_fill_gaps(plans, count);
+    bool ok = true;
+    for (uint8_t i = 0; i < count && ok; i++) {
+        File g4 = SD.open(cells[i].g4_path, FILE_READ);
+        G4Source src;
+        ok = g4 && g4_source_open(g4, display.WIDTH, display.HEIGHT, &src) && collage_load_cell(src, plans[i]);
+        if (g4) g4.close();
+    }
+    bus_stats_log("RenderCollage");
+
+    if (ok) {
+        const unsigned long refresh_start = millis();
+        it8951_photo_refresh("collage", nullptr);
+        LOG_DURATION("EINK", "Refresh", refresh_start);
+    }
+    busy_stats_commit("RenderCollage");
+    LOG_DURATION("EINK", "RenderCollage", start_ms);
+    set_render_busy(false);
+    return ok;
+}
+
+bool it8951_render_g4_buffer(const uint8_t* g4, uint16_t w, uint16_t h) {
+    return it8951_render_g4_buffer_ex(g4, w, h, EinkWaveform::GC16);
+}
+
+bool it8951_render_g4_buffer_ex(const uint8_t* g4, uint16_t w, uint16_t h, EinkWaveform waveform) {
+    if (!g4) return false;
+    if (is_ui_active()) {
+        LOGE("EINK", "Render blocked: UI active. Call display_manager_ui_stop() before rendering.");
+        return false;
+    }
+    if (!g_display_ready && !it8951_renderer_init()) return false;
+    if (it8951_renderer_is_busy()) return false;
+    set_render_busy(true);
+    photo_state_invalidate();
+
+    if (w != display.WIDTH || h != display.HEIGHT) {
+        LOGW("EINK", "G4 buffer size mismatch %ux%u (panel %ux%u)",
+             (unsigned)w, (unsigned)h, (unsigned)display.WIDTH, (unsigned)display.HEIGHT);
     }
 
+    const unsigned long start_ms = millis();
+    const uint16_t packed_width = w / 2;
+
+    bus_stats_reset();
+    it8951_write_command16(IT8951_TCON_SYS_RUN);
+    it8951_load_begin_4bpp(0, 0, w, h, true);
+    it8951_load_write_bursts(g4, (size_t)h * packed_width);
+    it8951_load_end();
+    bus_stats_log("RenderG4Buf");
+
     const unsigned long refresh_start = millis();
-    // refresh(bool) expects partial_update_mode; invert our full_refresh flag.
-    it8951_refresh_from_full_flag(full_refresh, "g4buf");
+    it8951_refresh_fullscreen(waveform, "g4buf");
     LOG_DURATION("EINK", "Refresh", refresh_start);
+    busy_stats_commit("RenderG4Buf");
 
     LOG_DURATION("EINK", "RenderG4Buf", start_ms);
     set_render_busy(false);
@@ -872,28 +2842,20 @@ bool it8951_render_g4_buffer_region(const uint8_t* g4, uint16_t panel_w, uint16_
     if (w == 0 || h == 0) return false;
 
     set_render_busy(true);
+    photo_state_invalidate();
     const unsigned long start_ms = millis();
     const uint16_t packed_width = panel_w / 2;
     const uint16_t region_bytes_per_row = w / 2;
 
+    bus_stats_reset();
     it8951_write_command16(IT8951_TCON_SYS_RUN);
+    it8951_load_begin_4bpp(x, y, w, h, true);
 
-    for (uint16_t row = 0; row < h; row += kChunkRows) {
-        const uint16_t chunk_rows = (uint16_t)min((uint16_t)kChunkRows, (uint16_t)(h - row));
-        const uint16_t yrow = (uint16_t)(y + row);
-
-        // Pack region rows into contiguous chunk buffer.
-        for (uint16_t r = 0; r < chunk_rows; r++) {
-            const uint32_t src_row = (uint32_t)(yrow + r);
-            const uint32_t src_offset = src_row * packed_width + (x / 2);
-            const uint32_t dst_offset = (uint32_t)r * region_bytes_per_row;
-            memcpy(&g4_chunk_buffer[dst_offset], &g4[src_offset], region_bytes_per_row);
-        }
-
-        const size_t chunk_bytes = (size_t)chunk_rows * region_bytes_per_row;
-        it8951_set_partial_area_4bpp(x, yrow, w, chunk_rows);
-        it8951_write_data_bytes(g4_chunk_buffer, chunk_bytes);
-        it8951_write_command16(IT8951_TCON_LD_IMG_END);
+    // Region rows are strided in the panel buffer; inside the open stream each
+    // row goes out directly, so no repacking into the chunk buffer is needed.
+    for (uint16_t row = 0; row < h; row++) {
+        const uint32_t src_offset = (uint32_t)(y + row) * packed_width + (x / 2);
+        it8951_load_write(&g4[src_offset], region_bytes_per_row);
 
         if ((row % 200) == 0) {
             LOGD("EINK", "G4 buf region Row %u/%u", (unsigned)row, (unsigned)h);
@@ -904,9 +2866,13 @@ bool it8951_render_g4_buffer_region(const uint8_t* g4, uint16_t panel_w, uint16_
         }
     }
 
+    it8951_load_end();
+    bus_stats_log("RenderG4BufRegion");
+
     const unsigned long refresh_start = millis();
     it8951_refresh_from_full_flag(true, "g4buf_region");
     LOG_DURATION("EINK", "Refresh", refresh_start);
+    busy_stats_commit("RenderG4BufRegion");
 
     LOG_DURATION("EINK", "RenderG4BufRegion", start_ms);
     set_render_busy(false);
@@ -914,49 +2880,33 @@ bool it8951_render_g4_buffer_region(const uint8_t* g4, uint16_t panel_w, uint16_
 }
 
 bool it8951_render_g4_region(const uint8_t* g4_region, uint16_t x, uint16_t y,
-                             uint16_t w, uint16_t h, bool full_refresh) {
+                             uint16_t w, uint16_t h, EinkWaveform waveform) {
     if (!g4_region) return false;
     if (w == 0 || h == 0) return false;
-    if (x & 1U || w & 1U) {
-        LOGW("EINK", "G4 region requires even x/width (x=%u w=%u)", (unsigned)x, (unsigned)w);
+    if ((x & 3U) || (w & 3U)) {
+        LOGW("EINK", "G4 region requires x/width multiples of 4 (x=%u w=%u)", (unsigned)x, (unsigned)w);
         return false;
     }
     if (!g_display_ready && !it8951_renderer_init()) return false;
     if (it8951_renderer_is_busy()) return false;
 
     set_render_busy(true);
+    photo_state_invalidate();
     const unsigned long start_ms = millis();
     const uint16_t packed_width = w / 2;
 
+    bus_stats_reset();
     it8951_write_command16(IT8951_TCON_SYS_RUN);
-
-    for (uint16_t row = 0; row < h; row += kChunkRows) {
-        const uint16_t chunk_rows = (uint16_t)min((uint16_t)kChunkRows, (uint16_t)(h - row));
-        const uint16_t yrow = (uint16_t)(y + row);
-        const size_t chunk_bytes = (size_t)chunk_rows * packed_width;
-        const uint8_t* chunk_ptr = g4_region + (size_t)row * packed_width;
-
-        it8951_set_partial_area_4bpp(x, yrow, w, chunk_rows);
-        it8951_write_data_bytes(chunk_ptr, chunk_bytes);
-        it8951_write_command16(IT8951_TCON_LD_IMG_END);
-
-        if ((row % 200) == 0) {
-            LOGD("EINK", "G4 region Row %u/%u", (unsigned)row, (unsigned)h);
-        }
-
-        if ((row % 32) == 0) {
-            yield();
-        }
-    }
+    it8951_load_begin_4bpp(x, y, w, h, true);
+    it8951_load_write_bursts(g4_region, (size_t)h * packed_width);
+    it8951_load_end();
+    bus_stats_log("RenderG4Region");
 
     const unsigned long refresh_start = millis();
-    if (full_refresh) {
-        // Force a full update waveform; this is a full-screen refresh from controller memory.
-        it8951_refresh_from_full_flag(true, "g4region_full");
-    } else {
-        it8951_refresh_partial_region((int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h, "g4region_partial");
-    }
+    // Only the loaded area is driven; the rest of the panel keeps its image.
+    it8951_refresh_region((int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h, waveform, "g4region");
     LOG_DURATION("EINK", "Refresh", refresh_start);
+    busy_stats_commit("RenderG4Region");
 
     LOG_DURATION("EINK", "RenderG4Region", start_ms);
     set_render_busy(false);
@@ -966,6 +2916,7 @@ bool it8951_render_g4_region(const uint8_t* g4_region, uint16_t x, uint16_t y,
 void it8951_renderer_prepare_for_power_cut() {
     // Avoid back-powering the HAT through SPI/control pins after removing 5V.
     // Keep this safe even if the display wasn't fully initialized.
+    it8951_transport_end();
     if (IT8951_CS_PIN >= 0) pinMode(IT8951_CS_PIN, INPUT);
     #if defined(IT8951_SCK_PIN)
     if (IT8951_SCK_PIN >= 0) pinMode(IT8951_SCK_PIN, INPUT);
@@ -981,11 +2932,19 @@ void it8951_renderer_prepare_for_power_cut() {
 
 void it8951_renderer_hibernate() {
     if (!g_display_ready) return;
-    display.hibernate();
+    it8951_write_command16(IT8951_TCON_SLEEP);
+    it8951_wait_ready();
 
     it8951_renderer_prepare_for_power_cut();
 
     display_power_prepare_for_sleep();
+
+    // The rail is off now; the next render has to bring the controller up again.
+    // The panel keeps its image (tile map stays valid), controller memory doesn't.
+    g_display_ready = false;
+    g_controller_has_photo = false;
+    g_gxepd2_ready = false;
+    staged_invalidate();
 }
 
 bool it8951_render_full_white() {
@@ -993,10 +2952,14 @@ bool it8951_render_full_white() {
     if (it8951_renderer_is_busy()) return false;
 
     set_render_busy(true);
+    photo_state_invalidate();
     const unsigned long start_ms = millis();
 
+    bus_stats_reset();
+    it8951_ensure_gxepd2();
     display.clearScreen();
     it8951_refresh_from_full_flag(true, "full_white");
+    busy_stats_commit("FullWhite");
 
     LOG_DURATION("EINK", "FullWhite", start_ms);
     set_render_busy(false);
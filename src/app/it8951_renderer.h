@@ -2,17 +2,58 @@
 
 #include <Arduino.h>
 
+#include "collage_plan.h"
+#include "eink_waveform.h"
+
 bool it8951_renderer_init();
+// Per-panel grayscale calibration: levels[i] is the 4-bit level actually loaded
+// for encoded level i (identity = linear). Applied to every 4bpp load while
+// streaming; a change drops the tile map so the next photo loads in full.
+void it8951_set_panel_levels(const uint8_t levels[16]);
+
+// How photos are placed relative to the orientation they were encoded in
+// (tools/jpg_to_g4.py output, made for DISPLAY_ROTATION 2 mounting). Applied
+// while streaming, so one library serves any mounting; UI renders are not
+// affected. A change drops the tile map like a panel level change.
+enum class PhotoOrientation : uint8_t {
+    AsEncoded = 0,
+    Rotate180 = 1,
+    MirrorX = 2,
+    MirrorY = 3,
+};
+void it8951_set_photo_orientation(uint8_t orientation);
+const char *it8951_photo_orientation_name(uint8_t orientation);
 bool it8951_renderer_is_busy();
 bool it8951_render_bmp_from_sd(const char *path);
 bool it8951_convert_bmp_to_raw_g4(const char *bmp_path, const char *raw_path, const char *g4_path);
 bool it8951_render_raw8(const char *raw_path);
 bool it8951_render_g4(const char *g4_path);
+// Convert a baseline JPEG on the fly (letterboxed, dithered) and show it. With
+// cache_g4_path the converted frame is also written there as a G4 container.
+bool it8951_render_jpeg(const char *jpeg_path, const char *cache_g4_path);
+// Preload a G4 file into the controller's spare image buffer without touching
+// the panel. Dropped by any other render, hibernate or re-init.
+bool it8951_renderer_stage_g4(const char *g4_path);
+// Show the staged file (refresh only, no SD/SPI load). Returns false when
+// nothing usable is staged for this path; render it normally then.
+bool it8951_renderer_present_staged(const char *g4_path);
+// Redraw photo overlays (photo_overlay.h) whose text changed since the photo
+// was loaded: just their boxes are loaded and refreshed (DU). Returns false
+// when no photo is on the panel or a box moved or went away (render again).
+bool it8951_render_overlays();
+
+// Collage: several G4 files, each shrunk by an integer factor (box average)
+// and/or center-cropped into its cell while it is read, loaded straight into
+// the cell's panel area; one refresh at the end (cells: collage_plan.h).
+bool it8951_render_collage(const CollageCell *cells, uint8_t count, CollageFit fit);
 bool it8951_render_g4_buffer(const uint8_t* g4, uint16_t w, uint16_t h);
-bool it8951_render_g4_buffer_ex(const uint8_t* g4, uint16_t w, uint16_t h, bool full_refresh);
+bool it8951_render_g4_buffer_ex(const uint8_t* g4, uint16_t w, uint16_t h, EinkWaveform waveform);
 bool it8951_render_g4_buffer_region(const uint8_t* g4, uint16_t panel_w, uint16_t panel_h,
 									uint16_t x, uint16_t y, uint16_t w, uint16_t h);
-bool it8951_render_g4_region(const uint8_t* g4_region, uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool full_refresh);
+// Load a packed region and refresh only that area with the given waveform.
+// x and w are multiples of 4 (whole 16-bit words of packed pixels).
+bool it8951_render_g4_region(const uint8_t* g4_region, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                             EinkWaveform waveform);
 bool it8951_render_full_white();
 void it8951_renderer_hibernate();
 
@@ -20,3 +61,19 @@ void it8951_renderer_hibernate();
 // This prevents back-powering the HAT through IO protection diodes.
 // Safe to call even if the display was never fully initialized.
 void it8951_renderer_prepare_for_power_cut();
+
+// Time the last completed render spent waiting on the controller.
+// hrdy_*: host-ready (BUSY pin) waits around I80 words/bursts.
+// refresh_*: waveform completion waits after display-area commands;
+// sleep_us is the part of refresh_us spent in light sleep.
+struct It8951BusyStats {
+    uint32_t hrdy_waits;
+    uint32_t hrdy_blocked;
+    uint32_t hrdy_us;
+    uint32_t refresh_waits;
+    uint32_t refresh_us;
+    uint32_t sleep_us;
+};
+
+// Returns false until the first render has completed.
+bool it8951_renderer_get_busy_stats(It8951BusyStats *out);
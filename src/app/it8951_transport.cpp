@@ -0,0 +1,258 @@
+#include "it8951_transport.h"
+
+#include "board_config.h"
+#include "log_manager.h"
+
+#include <SPI.h>
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
+
+namespace {
+// Arduino's global SPI (FSPI) is SPI2_HOST on the ESP32-S2/S3.
+static constexpr spi_host_device_t kHost = SPI2_HOST;
+static constexpr int kWriteClockHz = 24000000;
+static constexpr int kReadClockHz = 1000000;
+static constexpr size_t kBounceBytes = 8 * 1024;
+static constexpr uint8_t kBounceCount = 2;
+
+static SPISettings g_fallback_settings(kWriteClockHz, MSBFIRST, SPI_MODE0);
+static SPISettings g_fallback_settings_read(kReadClockHz, MSBFIRST, SPI_MODE0);
+
+static bool g_active = false;
+static bool g_fallback = false;
+static bool g_in_transaction = false;
+
+static spi_device_handle_t g_write_dev = nullptr;
+static spi_device_handle_t g_read_dev = nullptr;
+static spi_device_handle_t g_current_dev = nullptr;
+
+static uint8_t *g_bounce[kBounceCount] = {nullptr};
+static spi_transaction_t g_bounce_trans[kBounceCount];
+static uint8_t g_next_bounce = 0;
+static uint8_t g_in_flight = 0;
+
+static It8951TransportStats g_stats = {};
+
+// Optional byte map applied to payload (panel calibration), see set_payload_lut.
+static const uint8_t *g_payload_lut = nullptr;
+
+static void copy_payload(uint8_t *dst, const uint8_t *src, size_t n) {
+    if (!g_payload_lut) {
+        memcpy(dst, src, n);
+        return;
+    }
+    const uint8_t *lut = g_payload_lut;
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+static bool ensure_bounce_buffers() {
+    for (uint8_t i = 0; i < kBounceCount; i++) {
+        if (g_bounce[i]) continue;
+        g_bounce[i] = static_cast<uint8_t*>(heap_caps_malloc(kBounceBytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL));
+        if (!g_bounce[i]) {
+            LOGE("EINK", "Transport bounce alloc failed (%u bytes)", (unsigned)kBounceBytes);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void drain_queue() {
+    while (g_in_flight > 0) {
+        spi_transaction_t *done = nullptr;
+        if (spi_device_get_trans_result(g_current_dev, &done, portMAX_DELAY) != ESP_OK) {
+            LOGE("EINK", "Transport drain failed");
+            g_in_flight = 0;
+            break;
+        }
+        g_in_flight--;
+    }
+}
+
+static void release_host() {
+    if (g_write_dev) spi_bus_remove_device(g_write_dev);
+    if (g_read_dev) spi_bus_remove_device(g_read_dev);
+    g_write_dev = nullptr;
+    g_read_dev = nullptr;
+    g_current_dev = nullptr;
+    spi_bus_free(kHost);
+    g_active = false;
+}
+
+static bool activate() {
+    if (g_active) return true;
+    if (g_fallback) return false;
+
+#if SD_USE_ARDUINO_SPI
+    // SD shares Arduino SPI on this board; spi_master can't own the host.
+    g_fallback = true;
+    return false;
+#else
+    if (!ensure_bounce_buffers()) {
+        g_fallback = true;
+        return false;
+    }
+
+    // Detach Arduino SPI from the pins/peripheral before spi_master claims the host.
+    SPI.end();
+
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = IT8951_MOSI_PIN;
+    bus.miso_io_num = IT8951_MISO_PIN;
+    bus.sclk_io_num = IT8951_SCK_PIN;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = kBounceBytes;
+
+    esp_err_t err = spi_bus_initialize(kHost, &bus, SPI_DMA_CH_AUTO);
+    if (err == ESP_OK) {
+        spi_device_interface_config_t dev = {};
+        dev.mode = 0;
+        dev.spics_io_num = -1; // CS is driven manually (preamble + payload share one assertion)
+        dev.clock_speed_hz = kWriteClockHz;
+        dev.queue_size = kBounceCount;
+        err = spi_bus_add_device(kHost, &dev, &g_write_dev);
+        if (err == ESP_OK) {
+            dev.clock_speed_hz = kReadClockHz;
+            dev.queue_size = 1;
+            err = spi_bus_add_device(kHost, &dev, &g_read_dev);
+        }
+        if (err != ESP_OK) {
+            release_host();
+        }
+    }
+
+    if (err != ESP_OK) {
+        LOGW("EINK", "Transport init failed err=%d; using Arduino SPI", (int)err);
+        g_fallback = true;
+        SPI.begin(IT8951_SCK_PIN, IT8951_MISO_PIN, IT8951_MOSI_PIN, IT8951_CS_PIN);
+        return false;
+    }
+
+    pinMode(IT8951_CS_PIN, OUTPUT);
+    digitalWrite(IT8951_CS_PIN, HIGH);
+    g_active = true;
+    return true;
+#endif
+}
+} // namespace
+
+void it8951_transport_suspend() {
+    if (!g_active) return;
+    release_host();
+    SPI.begin(IT8951_SCK_PIN, IT8951_MISO_PIN, IT8951_MOSI_PIN, IT8951_CS_PIN);
+}
+
+void it8951_transport_end() {
+    if (!g_active) return;
+    release_host();
+}
+
+void it8951_transport_begin_transaction(bool read) {
+    if (activate()) {
+        g_current_dev = read ? g_read_dev : g_write_dev;
+        spi_device_acquire_bus(g_current_dev, portMAX_DELAY);
+    } else {
+        SPI.beginTransaction(read ? g_fallback_settings_read : g_fallback_settings);
+    }
+    g_in_transaction = true;
+    digitalWrite(IT8951_CS_PIN, LOW);
+}
+
+void it8951_transport_end_transaction() {
+    if (!g_in_transaction) return;
+    if (g_active) {
+        const uint32_t drain_start = micros();
+        drain_queue();
+        g_stats.payload_us += micros() - drain_start;
+        digitalWrite(IT8951_CS_PIN, HIGH);
+        spi_device_release_bus(g_current_dev);
+    } else {
+        digitalWrite(IT8951_CS_PIN, HIGH);
+        SPI.endTransaction();
+    }
+    g_in_transaction = false;
+}
+
+uint16_t it8951_transport_transfer16(uint16_t value) {
+    if (!g_active) {
+        uint16_t rv = SPI.transfer(value >> 8) << 8;
+        return (rv | SPI.transfer(value));
+    }
+
+    drain_queue();
+    spi_transaction_t t = {};
+    t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+    t.length = 16;
+    t.tx_data[0] = (uint8_t)(value >> 8);
+    t.tx_data[1] = (uint8_t)value;
+    spi_device_polling_transmit(g_current_dev, &t);
+    return (uint16_t)((t.rx_data[0] << 8) | t.rx_data[1]);
+}
+
+void it8951_transport_write_bytes(const uint8_t* data, size_t length) {
+    if (!data || length == 0) return;
+    const uint32_t start = micros();
+    g_stats.payload_bytes += length;
+
+    if (!g_active) {
+        if (!g_payload_lut) {
+            SPI.writeBytes(data, length);
+        } else {
+            uint8_t mapped[64];
+            while (length > 0) {
+                const size_t n = length > sizeof(mapped) ? sizeof(mapped) : length;
+                copy_payload(mapped, data, n);
+                SPI.writeBytes(mapped, n);
+                data += n;
+                length -= n;
+            }
+        }
+        g_stats.payload_us += micros() - start;
+        return;
+    }
+
+    while (length > 0) {
+        // Slots are reused round-robin; with all slots queued the oldest result
+        // belongs to the slot we are about to refill.
+        if (g_in_flight >= kBounceCount) {
+            spi_transaction_t *done = nullptr;
+            spi_device_get_trans_result(g_current_dev, &done, portMAX_DELAY);
+            g_in_flight--;
+        }
+
+        const uint8_t slot = g_next_bounce;
+        const size_t n = length > kBounceBytes ? kBounceBytes : length;
+        copy_payload(g_bounce[slot], data, n);
+
+        spi_transaction_t &t = g_bounce_trans[slot];
+        t = {};
+        t.length = n * 8;
+        t.tx_buffer = g_bounce[slot];
+        if (spi_device_queue_trans(g_current_dev, &t, portMAX_DELAY) != ESP_OK) {
+            LOGE("EINK", "Transport queue failed");
+            break;
+        }
+
+        g_in_flight++;
+        g_stats.dma_transactions++;
+        g_next_bounce = (uint8_t)((slot + 1) % kBounceCount);
+        data += n;
+        length -= n;
+    }
+    g_stats.payload_us += micros() - start;
+}
+
+void it8951_transport_reset_stats() {
+    g_stats = {};
+}
+
+It8951TransportStats it8951_transport_get_stats() {
+    return g_stats;
+}
+
+void it8951_transport_set_payload_lut(const uint8_t *lut) {
+    g_payload_lut = lut;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+// IT8951 SPI transport built on ESP-IDF spi_master.
+//
+// Payload bursts are copied into DMA-capable internal-SRAM bounce buffers and
+// queued with spi_device_queue_trans(), so the CPU can fill the next buffer (or
+// block) while DMA drains the current one. CS is driven by the transport itself
+// so an I80 preamble and its payload share one CS assertion.
+//
+// GxEPD2 drives the same SPI host through Arduino's SPI class. Call
+// it8951_transport_suspend() before any GxEPD2 call; the transport reclaims the
+// host lazily on the next transaction. When SD shares the panel bus
+// (SD_USE_ARDUINO_SPI) the transport stays on Arduino SPI.
+
+struct It8951TransportStats {
+    uint32_t payload_bytes;
+    uint32_t payload_us;
+    uint32_t dma_transactions;
+};
+
+// Hand the SPI host back to Arduino SPI (for GxEPD2). No-op when not active.
+void it8951_transport_suspend();
+
+// Release the SPI host entirely (before cutting panel power). No-op when not active.
+void it8951_transport_end();
+
+// Assert CS for one I80 transaction. `read` selects the slow read clock.
+void it8951_transport_begin_transaction(bool read);
+// Wait for queued DMA payload to drain, then release CS.
+void it8951_transport_end_transaction();
+
+// Full-duplex 16-bit word (MSB first). Waits for queued payload first.
+uint16_t it8951_transport_transfer16(uint16_t value);
+
+// Queue payload bytes through the bounce buffers. Returns once the data has been
+// copied; the last bursts may still be in flight until end_transaction().
+void it8951_transport_write_bytes(const uint8_t* data, size_t length);
+
+// Map every payload byte through `lut` (256 entries) while it is copied into
+// the bounce buffers; nullptr sends payload unchanged. Commands and reads are
+// never mapped.
+void it8951_transport_set_payload_lut(const uint8_t *lut);
+
+void it8951_transport_reset_stats();
+It8951TransportStats it8951_transport_get_stats();
@@ -0,0 +1,313 @@
+#include "jpeg_g4.h"
+
+#include "log_manager.h"
+
+#include <JPEGDEC.h>
+#include <esp_heap_caps.h>
+
+#include <new>
+
+namespace {
+static constexpr uint8_t kWhiteLevel = 0x0F;
+static constexpr uint8_t kMaxScaleShift = 3;
+static constexpr uint16_t kMaxMcuRows = 16;
+// Same contrast boost as tools/jpg_to_g4.py (1.10), Q8.
+static constexpr int32_t kContrastQ8 = 282;
+
+struct DecodeState {
+    const JpegG4Frame *frame;
+    uint16_t dec_w;          // decoded (pre-scaled) size
+    uint16_t dec_h;
+    uint16_t photo_w;
+    uint8_t *band;           // one MCU row of luma, dec_w * kMaxMcuRows
+    int band_y;
+    uint16_t band_rows;
+    uint16_t *x_start;       // source column range per photo column (photo_w + 1)
+    uint32_t *acc;           // vertical accumulation of horizontally scaled rows
+    uint16_t acc_rows;
+    uint8_t *row;            // scaled + tone mapped photo row, dithered in place
+    G4Dither dither;
+    uint16_t src_row;        // next decoded row
+    uint16_t out_row;        // next photo row (top-down)
+    uint8_t *strip;
+    JpegG4StripSink sink;
+    void *user;
+    bool ok;
+};
+
+static JPEGDEC *g_jpeg = nullptr;
+static bool g_jpeg_open = false;
+static uint8_t g_tone_lut[256];
+static bool g_tone_lut_ready = false;
+
+static void *alloc_buffer(size_t bytes, const char *label) {
+    void *ptr = nullptr;
+    if (psramFound()) {
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!ptr) {
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!ptr) {
+        LOGE("JPEG", "Buffer alloc failed: %s (%u bytes)", label, (unsigned)bytes);
+    }
+    return ptr;
+}
+
+static void ensure_tone_lut() {
+    if (g_tone_lut_ready) return;
+    for (int32_t i = 0; i < 256; i++) {
+        const int32_t v = 128 + (((i - 128) * kContrastQ8 + 128) >> 8);
+        g_tone_lut[i] = (uint8_t)constrain(v, 0, 255);
+    }
+    g_tone_lut_ready = true;
+}
+
+static int32_t jpeg_read(JPEGFILE *handle, uint8_t *buf, int32_t len) {
+    File *file = static_cast<File*>(handle->fHandle);
+    const int32_t n = (int32_t)file->read(buf, len);
+    handle->iPos = (int32_t)file->position();
+    return n;
+}
+
+static int32_t jpeg_seek(JPEGFILE *handle, int32_t position) {
+    File *file = static_cast<File*>(handle->fHandle);
+    if (!file->seek(position)) return -1;
+    handle->iPos = position;
+    return position;
+}
+
+static void jpeg_close_file(void *handle) {
+    (void)handle; // owned by the caller
+}
+
+// Quantize one photo row and place it, mirrored, in the strip; hand the strip
+// over when its top row is done.
+static void emit_row(DecodeState &s) {
+    const JpegG4Frame &f = *s.frame;
+    const uint16_t frame_row = f.h - 1 - s.out_row;
+    const uint16_t packed_width = f.w / 2;
+    uint8_t *out = s.strip + (size_t)(frame_row % kJpegG4StripRows) * packed_width;
+    memset(out, (kWhiteLevel << 4) | kWhiteLevel, packed_width);
+
+    g4_dither_row(s.dither, s.row, s.row);
+    for (uint16_t c = 0; c < s.photo_w; c++) {
+        const uint8_t level = s.row[c];
+        const uint16_t fx = f.photo_x + (f.photo_w - 1 - c);
+        uint8_t &byte = out[fx / 2];
+        byte = (fx & 1) ? (uint8_t)((byte & 0xF0) | level) : (uint8_t)((byte & 0x0F) | (level << 4));
+    }
+    s.out_row++;
+
+    if ((frame_row % kJpegG4StripRows) == 0 && s.ok) {
+        const uint16_t rows = (uint16_t)min((uint32_t)kJpegG4StripRows, (uint32_t)(f.h - frame_row));
+        if (!s.sink(s.strip, frame_row, rows, s.user)) {
+            s.ok = false;
+        }
+    }
+}
+
+// Area-scale one decoded luma row into the accumulator; emit every photo row
+// that is complete once this source row is in.
+static void process_source_row(DecodeState &s, const uint8_t *src) {
+    const uint16_t photo_h = s.frame->h;
+    for (uint16_t c = 0; c < s.photo_w; c++) {
+        const uint16_t x0 = s.x_start[c];
+        const uint16_t x1 = max((uint16_t)(x0 + 1), s.x_start[c + 1]);
+        uint32_t sum = 0;
+        for (uint16_t x = x0; x < x1; x++) sum += src[x];
+        s.acc[c] += sum / (x1 - x0);
+    }
+    s.acc_rows++;
+
+    const uint16_t done = (uint16_t)min((uint32_t)photo_h, (uint32_t)(s.src_row + 1) * photo_h / s.dec_h);
+    s.src_row++;
+    if (done <= s.out_row) return;
+
+    for (uint16_t c = 0; c < s.photo_w; c++) {
+        s.row[c] = g_tone_lut[s.acc[c] / s.acc_rows];
+        s.acc[c] = 0;
+    }
+    s.acc_rows = 0;
+    // Upscaling repeats the row; downscaling completes at most one per source row.
+    while (s.out_row < done && s.ok) {
+        emit_row(s);
+    }
+}
+
+static void flush_band(DecodeState &s) {
+    if (s.band_y < 0) return;
+    for (uint16_t r = 0; r < s.band_rows && s.ok; r++) {
+        if ((uint32_t)s.band_y + r >= s.dec_h) break;
+        process_source_row(s, s.band + (size_t)r * s.dec_w);
+    }
+    s.band_y = -1;
+    s.band_rows = 0;
+}
+
+static int jpeg_draw(JPEGDRAW *draw) {
+    DecodeState &s = *static_cast<DecodeState*>(draw->pUser);
+    if (!s.ok) return 0;
+    if (s.band_y >= 0 && draw->y != s.band_y) {
+        flush_band(s);
+    }
+    s.band_y = draw->y;
+    s.band_rows = (uint16_t)min(draw->iHeight, (int)kMaxMcuRows);
+
+    const uint8_t *pixels = reinterpret_cast<const uint8_t*>(draw->pPixels);
+    if (draw->x < s.dec_w) {
+        const uint16_t cols = (uint16_t)min(draw->iWidth, (int)(s.dec_w - draw->x));
+        for (uint16_t r = 0; r < s.band_rows; r++) {
+            memcpy(s.band + (size_t)r * s.dec_w + draw->x, pixels + (size_t)r * draw->iWidth, cols);
+        }
+    }
+    if (draw->x + draw->iWidth >= s.dec_w) {
+        flush_band(s);
+    }
+    return s.ok ? 1 : 0;
+}
+} // namespace
+
+bool jpeg_g4_is_jpeg_name(const char *name) {
+    if (!name) return false;
+    const size_t len = strlen(name);
+    return (len >= 4 && strcasecmp(name + len - 4, ".jpg") == 0) ||
+           (len >= 5 && strcasecmp(name + len - 5, ".jpeg") == 0);
+}
+
+bool jpeg_g4_has_signature(const uint8_t *data, size_t len) {
+    return data && len >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+bool jpeg_g4_open(File &file, uint16_t panel_w, uint16_t panel_h, JpegG4Frame *out) {
+    if (!out) return false;
+    jpeg_g4_close();
+    if (!g_jpeg) {
+        void *mem = alloc_buffer(sizeof(JPEGDEC), "jpegdec");
+        if (!mem) return false;
+        g_jpeg = new (mem) JPEGDEC();
+    }
+
+    file.seek(0);
+    if (!g_jpeg->open(&file, (int)file.size(), jpeg_close_file, jpeg_read, jpeg_seek, jpeg_draw)) {
+        LOGE("JPEG", "Open failed err=%d", g_jpeg->getLastError());
+        return false;
+    }
+    g_jpeg_open = true;
+    if (g_jpeg->getJPEGType() != JPEG_MODE_BASELINE) {
+        LOGE("JPEG", "Progressive JPEG unsupported");
+        jpeg_g4_close();
+        return false;
+    }
+
+    const uint32_t src_w = (uint32_t)g_jpeg->getWidth();
+    const uint32_t src_h = (uint32_t)g_jpeg->getHeight();
+    if (src_w == 0 || src_h == 0) {
+        jpeg_g4_close();
+        return false;
+    }
+
+    // Letterbox fit (same rounding as tools/jpg_to_g4.py), then rotate 180.
+    uint32_t photo_w = panel_w;
+    uint32_t photo_h = panel_h;
+    if (src_w * panel_h > src_h * panel_w) {
+        photo_h = max(1UL, (unsigned long)(src_h * panel_w / src_w));
+    } else {
+        photo_w = max(1UL, (unsigned long)(src_w * panel_h / src_h));
+    }
+    const uint32_t left = (panel_w - photo_w) / 2;
+    const uint32_t top = (panel_h - photo_h) / 2;
+    const uint32_t px = panel_w - left - photo_w;
+    const uint32_t x0 = px & ~3UL;
+    const uint32_t x1 = min((uint32_t)panel_w, (uint32_t)((px + photo_w + 3) & ~3UL));
+
+    // Largest decoder pre-scale that still leaves at least the fitted size.
+    uint8_t scale = 0;
+    while (scale < kMaxScaleShift &&
+           ((src_w + (2U << scale) - 1) >> (scale + 1)) >= photo_w &&
+           ((src_h + (2U << scale) - 1) >> (scale + 1)) >= photo_h) {
+        scale++;
+    }
+
+    out->src_w = (uint16_t)src_w;
+    out->src_h = (uint16_t)src_h;
+    out->x = (uint16_t)x0;
+    out->y = (uint16_t)(panel_h - top - photo_h);
+    out->w = (uint16_t)(x1 - x0);
+    out->h = (uint16_t)photo_h;
+    out->photo_x = (uint16_t)(px - x0);
+    out->photo_w = (uint16_t)photo_w;
+    out->canvas_x = (uint16_t)left;
+    out->canvas_y = (uint16_t)top;
+    out->scale = scale;
+    LOGI("JPEG", "src=%lux%lu scale=1/%u frame=%ux%u@%u,%u",
+         (unsigned long)src_w, (unsigned long)src_h, (unsigned)(1U << scale),
+         (unsigned)out->w, (unsigned)out->h, (unsigned)out->x, (unsigned)out->y);
+    return true;
+}
+
+bool jpeg_g4_decode(const JpegG4Frame &frame, G4DitherMode dither, uint8_t *strip,
+                    JpegG4StripSink sink, void *user) {
+    if (!g_jpeg_open || !strip || !sink) return false;
+    ensure_tone_lut();
+
+    DecodeState s = {};
+    s.frame = &frame;
+    s.dec_w = (uint16_t)((frame.src_w + (1U << frame.scale) - 1) >> frame.scale);
+    s.dec_h = (uint16_t)((frame.src_h + (1U << frame.scale) - 1) >> frame.scale);
+    s.photo_w = frame.photo_w;
+    s.band_y = -1;
+    s.strip = strip;
+    s.sink = sink;
+    s.user = user;
+    s.ok = true;
+
+    s.band = static_cast<uint8_t*>(alloc_buffer((size_t)s.dec_w * kMaxMcuRows, "jpeg_band"));
+    s.x_start = static_cast<uint16_t*>(alloc_buffer(sizeof(uint16_t) * (s.photo_w + 1), "jpeg_xmap"));
+    s.acc = static_cast<uint32_t*>(alloc_buffer(sizeof(uint32_t) * s.photo_w, "jpeg_acc"));
+    s.row = static_cast<uint8_t*>(alloc_buffer(s.photo_w, "jpeg_row"));
+    bool ok = s.band && s.x_start && s.acc && s.row &&
+              g4_dither_begin(s.dither, dither, s.photo_w, frame.canvas_x, frame.canvas_y);
+
+    if (ok) {
+        for (uint32_t c = 0; c <= s.photo_w; c++) {
+            s.x_start[c] = (uint16_t)min((uint32_t)s.dec_w - 1, c * s.dec_w / s.photo_w);
+        }
+        s.x_start[s.photo_w] = s.dec_w;
+        memset(s.acc, 0, sizeof(uint32_t) * s.photo_w);
+
+        const int options = frame.scale == 0 ? 0 : (1 << frame.scale); // JPEG_SCALE_HALF/QUARTER/EIGHTH
+        g_jpeg->setPixelType(EIGHT_BIT_GRAYSCALE);
+        g_jpeg->setUserPointer(&s);
+        const unsigned long start_ms = millis();
+        ok = g_jpeg->decode(0, 0, options) == 1;
+        flush_band(s);
+        ok = ok && s.ok && s.out_row == frame.h;
+        if (!ok) {
+            LOGE("JPEG", "Decode failed err=%d rows=%u/%u", g_jpeg->getLastError(),
+                 (unsigned)s.out_row, (unsigned)frame.h);
+        }
+        LOG_DURATION("JPEG", "Decode", start_ms);
+    }
+
+    heap_caps_free(s.band);
+    heap_caps_free(s.x_start);
+    heap_caps_free(s.acc);
+    heap_caps_free(s.row);
+    g4_dither_end(s.dither);
+    return ok;
+}
+
+void jpeg_g4_close() {
+    if (g_jpeg && g_jpeg_open) {
+        g_jpeg->close();
+    }
+    g_jpeg_open = false;
+}
+
+String jpeg_g4_cache_path(const char *jpeg_path) {
+    String name = jpeg_path ? String(jpeg_path) : String();
+    while (name.startsWith("/")) name.remove(0, 1);
+    name.replace("/", "__");
+    return String("/jpeg-cache/") + name + ".g4";
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "g4_dither.h"
+
+// On-device baseline JPEG -> packed 4bpp (G4) conversion, streamed in strips.
+//
+// Luma is decoded one MCU row at a time (JPEGDEC, grayscale output with
+// power-of-two pre-scaling), area-scaled to the letterbox fit, tone mapped and
+// dithered in fixed point (g4_dither). Output matches tools/jpg_to_g4.py
+// orientation (rotated 180 degrees), so strips are produced bottom-up. No
+// full-frame buffer: memory is one MCU row of luma plus a few scaled rows.
+
+static constexpr uint16_t kJpegG4StripRows = 16;
+
+struct JpegG4Frame {
+    uint16_t src_w;   // JPEG size
+    uint16_t src_h;
+    uint16_t x;       // packed frame placement on the panel (x, w multiples of 4)
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t photo_x; // fitted photo columns inside the frame (rest is white padding)
+    uint16_t photo_w;
+    uint16_t canvas_x; // photo origin before the 180 degree rotation (dither phase)
+    uint16_t canvas_y;
+    uint8_t scale;    // JPEGDEC pre-scale shift (0..3)
+};
+
+// One finished strip: `rows` packed rows of frame.w / 2 bytes starting at frame
+// row `first_row`. The bottom strip (possibly shorter) comes first; all others
+// are kJpegG4StripRows tall and aligned to multiples of it. Return false to abort.
+typedef bool (*JpegG4StripSink)(const uint8_t *packed, uint16_t first_row, uint16_t rows, void *user);
+
+bool jpeg_g4_is_jpeg_name(const char *name);
+
+// SOI marker check for uploads (header only).
+bool jpeg_g4_has_signature(const uint8_t *data, size_t len);
+
+// Parse the JPEG header and compute the placement. The file must stay open
+// until jpeg_g4_close().
+bool jpeg_g4_open(File &file, uint16_t panel_w, uint16_t panel_h, JpegG4Frame *out);
+
+// Decode the opened image. `strip` holds kJpegG4StripRows * frame.w / 2 bytes.
+bool jpeg_g4_decode(const JpegG4Frame &frame, G4DitherMode dither, uint8_t *strip,
+                    JpegG4StripSink sink, void *user);
+
+void jpeg_g4_close();
+
+// SD path of the cached conversion of a JPEG ("/jpeg-cache/<flattened name>.g4").
+String jpeg_g4_cache_path(const char *jpeg_path);
@@ -0,0 +1,201 @@
+#include "name_list.h"
+
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace {
+static constexpr size_t kInitialNames = 64;
+static constexpr size_t kInitialArenaBytes = 2048;
+
+static void *alloc_psram(size_t bytes) {
+    void *p = nullptr;
+    if (psramFound()) p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p) p = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    return p;
+}
+} // namespace
+
+NameList::~NameList() {
+    release();
+}
+
+void NameList::clear() {
+    count = 0;
+    arenaUsed = 0;
+    arenaDead = 0;
+}
+
+void NameList::release() {
+    clear();
+    if (arena) heap_caps_free(arena);
+    if (offsets) heap_caps_free(offsets);
+    arena = nullptr;
+    offsets = nullptr;
+    arenaCap = 0;
+    offsetsCap = 0;
+}
+
+bool NameList::reserve(size_t names, size_t bytes) {
+    return reserveOffsets(names) && reserveArena(bytes > arenaUsed ? bytes - arenaUsed : 0);
+}
+
+bool NameList::reserveOffsets(size_t names) {
+    if (names <= offsetsCap) return true;
+    const size_t cap = std::max(names, offsetsCap ? offsetsCap * 2 : kInitialNames);
+    uint32_t *next = static_cast<uint32_t*>(alloc_psram(cap * sizeof(uint32_t)));
+    if (!next) return false;
+    allocCount++;
+    if (offsets) {
+        memcpy(next, offsets, count * sizeof(uint32_t));
+        heap_caps_free(offsets);
+    }
+    offsets = next;
+    offsetsCap = cap;
+    return true;
+}
+
+// Make room for `bytes` more: compact in place of growing when half of the
+// arena is erased names.
+bool NameList::reserveArena(size_t bytes) {
+    if (arenaUsed + bytes <= arenaCap) return true;
+    const bool compact = arenaDead * 2 >= arenaUsed && arenaUsed - arenaDead + bytes <= arenaCap;
+    const size_t cap = compact ? arenaCap
+                               : std::max((size_t)arenaUsed + bytes, arenaCap ? (size_t)arenaCap * 2 : kInitialArenaBytes);
+    char *next = static_cast<char*>(alloc_psram(cap));
+    if (!next) return false;
+    allocCount++;
+    uint32_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char *name = arena + offsets[i];
+        const uint32_t len = (uint32_t)strlen(name) + 1;
+        memcpy(next + used, name, len);
+        offsets[i] = used;
+        used += len;
+    }
+    if (arena) heap_caps_free(arena);
+    arena = next;
+    arenaCap = (uint32_t)cap;
+    arenaUsed = used;
+    arenaDead = 0;
+    return true;
+}
+
+bool NameList::add(size_t index, const char *prefix, size_t prefixLen, const char *name, size_t nameLen) {
+    if (index > count) return false;
+    const size_t len = prefixLen + nameLen + 1;
+    if (!reserveOffsets(count + 1) || !reserveArena(len)) return false;
+    char *dst = arena + arenaUsed;
+    if (prefixLen) memcpy(dst, prefix, prefixLen);
+    memcpy(dst + prefixLen, name, nameLen);
+    dst[prefixLen + nameLen] = '\0';
+    memmove(offsets + index + 1, offsets + index, (count - index) * sizeof(uint32_t));
+    offsets[index] = arenaUsed;
+    arenaUsed += (uint32_t)len;
+    count++;
+    return true;
+}
+
+bool NameList::push_back(const char *name) {
+    if (!name) return false;
+    return add(count, nullptr, 0, name, strlen(name));
+}
+
+bool NameList::push_back(const char *name, size_t len) {
+    if (!name) return false;
+    return add(count, nullptr, 0, name, len);
+}
+
+bool NameList::push_back(const char *prefix, const char *name) {
+    if (!name) return false;
+    return add(count, prefix, prefix ? strlen(prefix) : 0, name, strlen(name));
+}
+
+bool NameList::assign(const NameList &other) {
+    if (&other == this) return true;
+    clear();
+    if (!reserve(other.count, other.bytes())) return false;
+    for (size_t i = 0; i < other.count; i++) {
+        const char *name = other[i];
+        const uint32_t len = (uint32_t)strlen(name) + 1;
+        memcpy(arena + arenaUsed, name, len);
+        offsets[i] = arenaUsed;
+        arenaUsed += len;
+    }
+    count = other.count;
+    return true;
+}
+
+bool NameList::insert(size_t index, const char *name) {
+    if (!name) return false;
+    return add(index, nullptr, 0, name, strlen(name));
+}
+
+void NameList::erase(size_t index) {
+    if (index >= count) return;
+    arenaDead += (uint32_t)strlen(arena + offsets[index]) + 1;
+    memmove(offsets + index, offsets + index + 1, (count - index - 1) * sizeof(uint32_t));
+    count--;
+    if (count == 0) clear();
+}
+
+void NameList::sort() {
+    if (count < 2) return;
+    const char *base = arena;
+    std::sort(offsets, offsets + count, [base](uint32_t a, uint32_t b) {
+        return strcmp(base + a, base + b) < 0;
+    });
+}
+
+bool NameList::find(const char *name, size_t *out_index) const {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const int cmp = strcmp(arena + offsets[mid], name);
+        if (cmp == 0) {
+            if (out_index) *out_index = mid;
+            return true;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (out_index) *out_index = lo;
+    return false;
+}
+
+bool NameList::insertSorted(const char *name) {
+    if (!name) return false;
+    size_t index = 0;
+    if (find(name, &index)) return true;
+    return add(index, nullptr, 0, name, strlen(name));
+}
+
+NameList::Range NameList::prefixRange(const char *prefix) const {
+    const size_t len = strlen(prefix);
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (strncmp(arena + offsets[mid], prefix, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    const size_t first = lo;
+    hi = count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (strncmp(arena + offsets[mid], prefix, len) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return {first, lo - first};
+}
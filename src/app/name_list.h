@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+
+// List of file or blob names kept in two PSRAM blocks: the names,
+// NUL-terminated, back to back in one arena, and a uint32_t offset per name.
+// Adding a name copies it into the arena, so a listing of a few thousand
+// photos costs a handful of allocations (each block doubles when it fills)
+// instead of one heap String per name, and nothing lands in internal RAM
+// unless PSRAM is exhausted.
+//
+// Names stay in insertion order until sort(). find() and prefixRange() need a
+// sorted list; the order is strcmp's, the same as String::compareTo.
+class NameList {
+public:
+    NameList() = default;
+    ~NameList();
+    NameList(const NameList &) = delete;
+    NameList &operator=(const NameList &) = delete;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // Valid until the list is next changed.
+    const char *operator[](size_t index) const { return arena + offsets[index]; }
+
+    // Arena bytes held by the names, NULs included.
+    size_t bytes() const { return arenaUsed - arenaDead; }
+    // Blocks allocated since the list was created.
+    uint32_t allocations() const { return allocCount; }
+
+    // Forget the names but keep the blocks; release() frees them too.
+    void clear();
+    void release();
+    bool reserve(size_t names, size_t bytes);
+
+    // Append a name, `len` bytes of one, or `prefix` followed by `name` as a
+    // single entry. False (and the list unchanged) when out of memory. The
+    // name must not point into this list.
+    bool push_back(const char *name);
+    bool push_back(const char *name, size_t len);
+    bool push_back(const char *prefix, const char *name);
+    // Replace the contents with a copy of `other`.
+    bool assign(const NameList &other);
+
+    bool insert(size_t index, const char *name);
+    // The name's bytes are reclaimed when the arena next has to grow.
+    void erase(size_t index);
+
+    void sort();
+    // Binary search; `out_index` gets the position of the name, or where it
+    // would be inserted when it is missing.
+    bool find(const char *name, size_t *out_index = nullptr) const;
+    // Sorted insert that skips names already present.
+    bool insertSorted(const char *name);
+
+    // Names starting with `prefix` in a sorted list: [first, first + count).
+    struct Range {
+        size_t first;
+        size_t count;
+    };
+    Range prefixRange(const char *prefix) const;
+
+private:
+    bool reserveOffsets(size_t names);
+    bool reserveArena(size_t bytes);
+    bool add(size_t index, const char *prefix, size_t prefixLen, const char *name, size_t nameLen);
+
+    char *arena = nullptr;
+    uint32_t arenaUsed = 0;
+    uint32_t arenaCap = 0;
+    uint32_t arenaDead = 0;
+    uint32_t *offsets = nullptr;
+    size_t count = 0;
+    size_t offsetsCap = 0;
+    uint32_t allocCount = 0;
+};
@@ -0,0 +1,58 @@
+#include "panel_levels.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void panel_levels_identity(uint8_t *levels) {
+    for (uint8_t i = 0; i < kPanelLevels; i++) levels[i] = i;
+}
+
+bool panel_levels_parse(const char *text, uint8_t *levels) {
+    if (!text || !levels) return false;
+    uint8_t parsed[kPanelLevels];
+    const char *p = text;
+    for (uint8_t i = 0; i < kPanelLevels; i++) {
+        while (*p == ' ') p++;
+        if (*p < '0' || *p > '9') return false;
+        unsigned v = 0;
+        while (*p >= '0' && *p <= '9') {
+            v = v * 10 + (unsigned)(*p - '0');
+            if (v > 15) return false;
+            p++;
+        }
+        parsed[i] = (uint8_t)v;
+        while (*p == ' ') p++;
+        if (i + 1 < kPanelLevels) {
+            if (*p != ',') return false;
+            p++;
+        }
+    }
+    if (*p != '\0') return false;
+    memcpy(levels, parsed, sizeof(parsed));
+    return true;
+}
+
+void panel_levels_format(const uint8_t *levels, char *out, size_t max_len) {
+    if (!out || max_len == 0) return;
+    out[0] = '\0';
+    size_t n = 0;
+    for (uint8_t i = 0; i < kPanelLevels && n < max_len; i++) {
+        n += snprintf(out + n, max_len - n, i ? ",%u" : "%u", (unsigned)levels[i]);
+    }
+}
+
+bool panel_levels_build_lut(const uint8_t *levels, uint8_t lut[256], uint32_t *sig) {
+    bool identity = true;
+    uint32_t h = 2166136261u;
+    uint8_t map[kPanelLevels];
+    for (uint8_t i = 0; i < kPanelLevels; i++) {
+        map[i] = levels[i] & 0x0F;
+        identity = identity && map[i] == i;
+        h = (h ^ map[i]) * 16777619u;
+    }
+    for (uint16_t b = 0; b < 256; b++) {
+        lut[b] = (uint8_t)((map[b >> 4] << 4) | map[b & 0x0F]);
+    }
+    if (sig) *sig = h | 1;
+    return !identity;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Panel gray calibration: encoded 4-bit level i is loaded as levels[i]. Text
+// form for NVS/portal and the byte LUT the transport maps 4bpp payload with.
+// No Arduino dependencies: also built into the host tests (tools/g4codec).
+
+static constexpr uint8_t kPanelLevels = 16;
+
+// Linear curve (levels[i] = i).
+void panel_levels_identity(uint8_t *levels);
+
+// Parse "0,1,...,15": exactly 16 values 0-15, spaces allowed around commas.
+// `levels` is left untouched on failure.
+bool panel_levels_parse(const char *text, uint8_t *levels);
+
+void panel_levels_format(const uint8_t *levels, char *out, size_t max_len);
+
+// Expand the curve (masked to 4 bits) into a LUT over nibble pairs and set
+// `*sig` to its FNV-1a signature (never 0). Returns false for the identity
+// curve, which needs no mapping.
+bool panel_levels_build_lut(const uint8_t *levels, uint8_t lut[256], uint32_t *sig);
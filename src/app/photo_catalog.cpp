@@ -0,0 +1,575 @@
+#include "photo_catalog.h"
+
+#include "jpeg_g4.h"
+#include "log_manager.h"
+#include "time_utils.h"
+
+#include <SD.h>
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+
+namespace {
+static constexpr const char *kCatalogPath = "/photo-catalog.bin";
+static constexpr const char *kCatalogTmpPath = "/photo-catalog.tmp";
+static constexpr const char *kGenerationPath = "/photo-catalog.gen";
+static constexpr uint32_t kCatalogMagic = 0x31544350; // "PCT1"
+static constexpr uint16_t kCatalogVersion = 1;
+// Records per read/write while a catalog is copied (4 KB).
+static constexpr size_t kCopyRecords = 32;
+
+static const char *const kQueueDirs[kPhotoQueues] = {"/queue-permanent", "/queue-temporary"};
+static const char *const kQueuePrefixes[kPhotoQueues] = {"queue-permanent/", "queue-temporary/"};
+
+struct PhotoCatalogHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t generation;
+    uint32_t count[kPhotoQueues];
+    uint32_t earliest_expiry;
+    uint32_t reserved[2];
+};
+
+static_assert(sizeof(PhotoCatalogHeader) == 32, "PhotoCatalogHeader layout");
+
+// Header of the catalog on SD; only trusted while g_valid.
+static PhotoCatalogHeader g_header = {};
+static bool g_valid = false;
+// Last generation written to kGenerationPath.
+static uint32_t g_marker = 0;
+
+static uint32_t read_generation() {
+    File f = SD.open(kGenerationPath, FILE_READ);
+    if (!f) return 0;
+    uint32_t gen = 0;
+    if (f.read(reinterpret_cast<uint8_t*>(&gen), sizeof(gen)) != (int)sizeof(gen)) gen = 0;
+    f.close();
+    return gen;
+}
+
+static bool write_generation(uint32_t gen) {
+    File f = SD.open(kGenerationPath, FILE_WRITE);
+    if (!f) return false;
+    const bool ok = f.write(reinterpret_cast<const uint8_t*>(&gen), sizeof(gen)) == sizeof(gen);
+    f.close();
+    if (ok) g_marker = gen;
+    return ok;
+}
+
+static inline uint32_t total_records(const PhotoCatalogHeader &h) {
+    return h.count[0] + h.count[1];
+}
+
+static inline uint32_t record_offset(uint32_t position) {
+    return (uint32_t)sizeof(PhotoCatalogHeader) + position * (uint32_t)sizeof(PhotoCatalogRecord);
+}
+
+static bool record_less(const PhotoCatalogRecord &a, const PhotoCatalogRecord &b) {
+    if (a.queue != b.queue) return a.queue < b.queue;
+    return strcmp(a.name, b.name) < 0;
+}
+
+static bool same_key(const PhotoCatalogRecord &a, const PhotoCatalogRecord &b) {
+    return a.queue == b.queue && strcmp(a.name, b.name) == 0;
+}
+
+static String logical_name(const PhotoCatalogRecord &r) {
+    return String(kQueuePrefixes[r.queue < kPhotoQueues ? r.queue : 0]) + r.name;
+}
+
+static bool is_photo_name(const char *name) {
+    const size_t len = strlen(name);
+    return (len >= 3 && strcmp(name + (len - 3), ".g4") == 0) || jpeg_g4_is_jpeg_name(name);
+}
+
+// Expiry from <EXPIRES_UTC>__<UPLOAD_UTC>__<slug> (temporary queue names).
+static uint32_t parse_expiry(const char *file) {
+    const char *sep = strstr(file, "__");
+    if (!sep || sep == file || (size_t)(sep - file) >= 24) return 0;
+    char ts[24];
+    memcpy(ts, file, sep - file);
+    ts[sep - file] = '\0';
+    time_t epoch = 0;
+    if (!time_utils::parse_utc_timestamp(ts, &epoch) || epoch <= 0) return 0;
+    return (uint32_t)epoch;
+}
+
+static void fill_record(PhotoQueue queue, const char *file, uint32_t size, uint32_t hash, PhotoCatalogRecord &r) {
+    memset(&r, 0, sizeof(r));
+    strlcpy(r.name, file, sizeof(r.name));
+    r.size = size;
+    r.hash = hash;
+    r.queue = (uint8_t)queue;
+    r.expiry = queue == PhotoQueue::Temporary ? parse_expiry(file) : 0;
+}
+
+static void *alloc_psram(size_t bytes) {
+    void *p = nullptr;
+    if (psramFound()) p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p) p = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    return p;
+}
+
+static PhotoCatalogRecord *alloc_records(size_t count) {
+    return static_cast<PhotoCatalogRecord*>(alloc_psram(count * sizeof(PhotoCatalogRecord)));
+}
+
+// Resident copy for the SD worker (always-on and portal modes): the file
+// names of each queue in a sorted NameList. Lookups and listings then never
+// touch the card; put/remove patch it in place once the file is committed.
+static bool g_resident_wanted = false;
+static bool g_res_ready = false;
+static NameList g_res[kPhotoQueues];
+
+static void resident_drop() {
+    g_res_ready = false;
+    for (uint8_t q = 0; q < kPhotoQueues; q++) g_res[q].clear();
+}
+
+static void resident_insert(PhotoQueue queue, const char *file) {
+    if (!g_res_ready) return;
+    if (!g_res[(uint8_t)queue].insertSorted(file)) resident_drop();
+}
+
+static void resident_erase(PhotoQueue queue, const char *file) {
+    if (!g_res_ready) return;
+    size_t index = 0;
+    if (g_res[(uint8_t)queue].find(file, &index)) g_res[(uint8_t)queue].erase(index);
+}
+
+static bool load_header() {
+    g_valid = false;
+    resident_drop();
+    File f = SD.open(kCatalogPath, FILE_READ);
+    if (!f) return false;
+    PhotoCatalogHeader h = {};
+    const bool read_ok = f.read(reinterpret_cast<uint8_t*>(&h), sizeof(h)) == (int)sizeof(h);
+    const uint32_t file_size = (uint32_t)f.size();
+    f.close();
+    g_marker = read_generation();
+    if (!read_ok || h.magic != kCatalogMagic || h.version != kCatalogVersion ||
+        h.record_size != sizeof(PhotoCatalogRecord)) {
+        LOGW("SD", "Photo catalog unreadable (version)");
+        return false;
+    }
+    if (file_size != record_offset(total_records(h))) {
+        LOGW("SD", "Photo catalog size mismatch");
+        return false;
+    }
+    if (h.generation != g_marker) {
+        LOGW("SD", "Photo catalog generation %lu, expected %lu",
+             (unsigned long)h.generation, (unsigned long)g_marker);
+        return false;
+    }
+    g_header = h;
+    g_valid = true;
+    return true;
+}
+
+// Replace the catalog with the finished temp file.
+static bool commit_tmp(const PhotoCatalogHeader &h) {
+    if (SD.exists(kCatalogPath)) SD.remove(kCatalogPath);
+    if (!SD.rename(kCatalogTmpPath, kCatalogPath)) {
+        SD.remove(kCatalogTmpPath);
+        g_valid = false;
+        resident_drop();
+        LOGE("SD", "Photo catalog rename failed");
+        return false;
+    }
+    g_header = h;
+    g_valid = true;
+    return true;
+}
+
+static bool read_records(File &f, uint32_t position, PhotoCatalogRecord *out, size_t count) {
+    const size_t bytes = count * sizeof(PhotoCatalogRecord);
+    return f.seek(record_offset(position)) &&
+           f.read(reinterpret_cast<uint8_t*>(out), bytes) == (int)bytes;
+}
+
+// Append the photos of one queue directory to `records` (grown as needed).
+static bool scan_queue(PhotoQueue queue, PhotoCatalogRecord *&records, size_t &count, size_t &capacity) {
+    const char *dir = kQueueDirs[(uint8_t)queue];
+    if (!SD.exists(dir)) return true;
+    File root = SD.open(dir);
+    if (!root) return false;
+    if (!root.isDirectory()) {
+        root.close();
+        return false;
+    }
+    bool ok = true;
+    File file = root.openNextFile();
+    while (file && ok) {
+        const char *name = file.name();
+        if (!file.isDirectory() && name && name[0] != '\0' && strlen(name) < kPhotoCatalogNameLen &&
+            is_photo_name(name)) {
+            if (count == capacity) {
+                const size_t grown = capacity ? capacity * 2 : 256;
+                PhotoCatalogRecord *next = alloc_records(grown);
+                if (next) {
+                    if (records) memcpy(next, records, count * sizeof(PhotoCatalogRecord));
+                    heap_caps_free(records);
+                    records = next;
+                    capacity = grown;
+                } else {
+                    LOGE("SD", "Photo catalog alloc failed (%u records)", (unsigned)grown);
+                    ok = false;
+                }
+            }
+            if (ok) fill_record(queue, name, (uint32_t)file.size(), 0, records[count++]);
+        }
+        file.close();
+        file = root.openNextFile();
+    }
+    if (file) file.close();
+    root.close();
+    return ok;
+}
+
+// Copy the catalog to the temp file, leaving out records for which `drop`
+// returns true and placing `insert` (if any) in order, then commit it under
+// the next generation.
+template <typename Drop>
+static bool rewrite(const PhotoCatalogRecord *insert, Drop drop) {
+    const uint32_t next_gen = g_header.generation + 1;
+    if (g_marker != next_gen && !write_generation(next_gen)) return false;
+
+    PhotoCatalogRecord *block = alloc_records(kCopyRecords);
+    File in = SD.open(kCatalogPath, FILE_READ);
+    if (SD.exists(kCatalogTmpPath)) SD.remove(kCatalogTmpPath);
+    File out = SD.open(kCatalogTmpPath, FILE_WRITE);
+    PhotoCatalogHeader h = g_header;
+    h.generation = next_gen;
+    h.count[0] = h.count[1] = 0;
+    h.earliest_expiry = 0;
+    bool ok = block && in && out && out.write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) == sizeof(h);
+
+    auto emit = [&](const PhotoCatalogRecord &r) {
+        ok = ok && out.write(reinterpret_cast<const uint8_t*>(&r), sizeof(r)) == sizeof(r);
+        h.count[r.queue]++;
+        if (r.expiry && (h.earliest_expiry == 0 || r.expiry < h.earliest_expiry)) h.earliest_expiry = r.expiry;
+    };
+    bool inserted = insert == nullptr;
+    const uint32_t total = total_records(g_header);
+    for (uint32_t pos = 0; ok && pos < total; pos += kCopyRecords) {
+        const size_t n = min((size_t)(total - pos), kCopyRecords);
+        if (!read_records(in, pos, block, n)) {
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const PhotoCatalogRecord &r = block[i];
+            if (!inserted && !record_less(r, *insert)) {
+                emit(*insert);
+                inserted = true;
+            }
+            if (r.queue >= kPhotoQueues || (insert && same_key(r, *insert)) || drop(r)) continue;
+            emit(r);
+        }
+    }
+    if (!inserted) emit(*insert);
+    ok = ok && out.seek(0) && out.write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) == sizeof(h);
+
+    if (in) in.close();
+    if (out) {
+        out.flush();
+        out.close();
+    }
+    if (block) heap_caps_free(block);
+    if (!ok) {
+        SD.remove(kCatalogTmpPath);
+        // The marker is ahead now, so the next open rebuilds.
+        g_valid = false;
+        resident_drop();
+        LOGE("SD", "Photo catalog update failed");
+        return false;
+    }
+    return commit_tmp(h);
+}
+
+// Read the names of a valid catalog into the resident copy.
+static bool resident_load() {
+    const unsigned long start_ms = millis();
+    resident_drop();
+    const uint32_t total = total_records(g_header);
+    PhotoCatalogRecord *block = alloc_records(kCopyRecords);
+    File f = SD.open(kCatalogPath, FILE_READ);
+    bool ok = block && f;
+    for (uint8_t q = 0; ok && q < kPhotoQueues; q++) {
+        // Typical names are well under half the record field.
+        ok = g_res[q].reserve(g_header.count[q], g_header.count[q] * (kPhotoCatalogNameLen / 2));
+    }
+    for (uint32_t pos = 0; ok && pos < total; pos += kCopyRecords) {
+        const size_t n = min((size_t)(total - pos), kCopyRecords);
+        ok = read_records(f, pos, block, n);
+        for (size_t i = 0; ok && i < n; i++) {
+            block[i].name[kPhotoCatalogNameLen - 1] = '\0';
+            ok = g_res[pos + i < g_header.count[0] ? 0 : 1].push_back(block[i].name);
+        }
+    }
+    if (f) f.close();
+    if (block) heap_caps_free(block);
+    if (!ok) {
+        resident_drop();
+        LOGW("SD", "Photo catalog not resident (%lu records)", (unsigned long)total);
+        return false;
+    }
+    g_res_ready = true;
+    LOGI("SD", "Photo catalog resident: %lu names, %lu bytes",
+         (unsigned long)total, (unsigned long)(g_res[0].bytes() + g_res[1].bytes()));
+    LOG_DURATION("SD", "CatalogLoad", start_ms);
+    return true;
+}
+
+// The patched resident copy must agree with the committed header.
+static void resident_check() {
+    if (!g_res_ready) return;
+    if (g_res[0].size() != g_header.count[0] || g_res[1].size() != g_header.count[1]) {
+        LOGW("SD", "Photo catalog resident copy out of step; reloading");
+        resident_drop();
+    }
+}
+
+// Updates only touch a catalog that is already valid.
+static bool ensure_loaded_for_update() {
+    if (g_valid) return true;
+    if (!SD.exists(kCatalogPath)) return false;
+    return load_header();
+}
+} // namespace
+
+bool photo_catalog_queue_of(const char *logical_name, PhotoQueue *out_queue, const char **out_file) {
+    if (!logical_name) return false;
+    for (uint8_t q = 0; q < kPhotoQueues; q++) {
+        const size_t prefix_len = strlen(kQueuePrefixes[q]);
+        if (strncmp(logical_name, kQueuePrefixes[q], prefix_len) != 0) continue;
+        const char *file = logical_name + prefix_len;
+        if (file[0] == '\0' || strchr(file, '/') || strlen(file) >= kPhotoCatalogNameLen) return false;
+        if (out_queue) *out_queue = (PhotoQueue)q;
+        if (out_file) *out_file = file;
+        return true;
+    }
+    return false;
+}
+
+bool photo_catalog_rebuild() {
+    const unsigned long start_ms = millis();
+    g_valid = false;
+    resident_drop();
+    PhotoCatalogRecord *records = nullptr;
+    size_t count = 0;
+    size_t capacity = 0;
+    PhotoCatalogHeader h = {};
+    h.magic = kCatalogMagic;
+    h.version = kCatalogVersion;
+    h.record_size = sizeof(PhotoCatalogRecord);
+    bool ok = true;
+    for (uint8_t q = 0; q < kPhotoQueues && ok; q++) {
+        const size_t first = count;
+        ok = scan_queue((PhotoQueue)q, records, count, capacity);
+        std::sort(records + first, records + count, record_less);
+        h.count[q] = (uint32_t)(count - first);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t e = records[i].expiry;
+        if (e && (h.earliest_expiry == 0 || e < h.earliest_expiry)) h.earliest_expiry = e;
+    }
+
+    // A crash while writing leaves the marker ahead of any catalog on SD.
+    h.generation = max(read_generation(), g_header.generation) + 1;
+    ok = ok && write_generation(h.generation);
+    if (ok) {
+        if (SD.exists(kCatalogTmpPath)) SD.remove(kCatalogTmpPath);
+        File out = SD.open(kCatalogTmpPath, FILE_WRITE);
+        const size_t bytes = count * sizeof(PhotoCatalogRecord);
+        ok = out && out.write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) == sizeof(h) &&
+             (bytes == 0 || out.write(reinterpret_cast<const uint8_t*>(records), bytes) == bytes);
+        if (out) {
+            out.flush();
+            out.close();
+        }
+        if (ok) {
+            ok = commit_tmp(h);
+        } else {
+            SD.remove(kCatalogTmpPath);
+        }
+    }
+    if (records) heap_caps_free(records);
+
+    if (!ok) {
+        LOGE("SD", "Photo catalog rebuild failed");
+        return false;
+    }
+    LOGI("SD", "Photo catalog rebuilt perm=%lu temp=%lu gen=%lu",
+         (unsigned long)h.count[0], (unsigned long)h.count[1], (unsigned long)h.generation);
+    LOG_DURATION("SD", "CatalogRebuild", start_ms);
+    return true;
+}
+
+bool photo_catalog_open(PhotoCatalogInfo *out) {
+    if (!g_valid && !load_header() && !photo_catalog_rebuild()) return false;
+    if (g_resident_wanted && !g_res_ready) resident_load();
+    if (out) {
+        out->generation = g_header.generation;
+        out->count[0] = g_header.count[0];
+        out->count[1] = g_header.count[1];
+        out->earliest_expiry = g_header.earliest_expiry;
+    }
+    return true;
+}
+
+bool photo_catalog_get(PhotoQueue queue, uint32_t index, String &out_name) {
+    if (!g_valid || index >= g_header.count[(uint8_t)queue]) return false;
+    const uint32_t position = (queue == PhotoQueue::Temporary ? g_header.count[0] : 0) + index;
+    if (g_res_ready) {
+        out_name = String(kQueuePrefixes[(uint8_t)queue]) + g_res[(uint8_t)queue][index];
+        return true;
+    }
+    File f = SD.open(kCatalogPath, FILE_READ);
+    if (!f) return false;
+    PhotoCatalogRecord r;
+    const bool ok = read_records(f, position, &r, 1);
+    f.close();
+    if (!ok) return false;
+    r.name[kPhotoCatalogNameLen - 1] = '\0';
+    out_name = logical_name(r);
+    return true;
+}
+
+bool photo_catalog_index_of(const char *logical_name, uint32_t *out_index) {
+    PhotoQueue queue;
+    const char *file = nullptr;
+    if (!g_valid || !photo_catalog_queue_of(logical_name, &queue, &file)) return false;
+    if (g_res_ready) {
+        size_t index = 0;
+        if (!g_res[(uint8_t)queue].find(file, &index)) return false;
+        if (out_index) *out_index = (uint32_t)index;
+        return true;
+    }
+    const uint32_t base = queue == PhotoQueue::Temporary ? g_header.count[0] : 0;
+    File f = SD.open(kCatalogPath, FILE_READ);
+    if (!f) return false;
+    uint32_t lo = 0;
+    uint32_t hi = g_header.count[(uint8_t)queue];
+    bool found = false;
+    PhotoCatalogRecord r;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (!read_records(f, base + mid, &r, 1)) break;
+        r.name[kPhotoCatalogNameLen - 1] = '\0';
+        const int cmp = strcmp(r.name, file);
+        if (cmp == 0) {
+            if (out_index) *out_index = mid;
+            found = true;
+            break;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    f.close();
+    return found;
+}
+
+bool photo_catalog_list(NameList &out) {
+    if (!photo_catalog_open(nullptr)) return false;
+    const uint32_t total = total_records(g_header);
+    if (g_res_ready) {
+        for (uint8_t q = 0; q < kPhotoQueues; q++) {
+            for (size_t i = 0; i < g_res[q].size(); i++) {
+                if (!out.push_back(kQueuePrefixes[q], g_res[q][i])) return false;
+            }
+        }
+        return true;
+    }
+    PhotoCatalogRecord *block = alloc_records(kCopyRecords);
+    File f = SD.open(kCatalogPath, FILE_READ);
+    bool ok = block && f;
+    for (uint32_t pos = 0; ok && pos < total; pos += kCopyRecords) {
+        const size_t n = min((size_t)(total - pos), kCopyRecords);
+        ok = read_records(f, pos, block, n);
+        for (size_t i = 0; ok && i < n; i++) {
+            const PhotoCatalogRecord &r = block[i];
+            block[i].name[kPhotoCatalogNameLen - 1] = '\0';
+            ok = out.push_back(kQueuePrefixes[r.queue < kPhotoQueues ? r.queue : 0], r.name);
+        }
+    }
+    if (f) f.close();
+    if (block) heap_caps_free(block);
+    return ok;
+}
+
+void photo_catalog_begin_update(const char *logical_name) {
+    if (!photo_catalog_queue_of(logical_name, nullptr, nullptr)) return;
+    if (!ensure_loaded_for_update()) return;
+    const uint32_t next_gen = g_header.generation + 1;
+    if (g_marker != next_gen) write_generation(next_gen);
+}
+
+bool photo_catalog_put(const char *logical_name, uint32_t size, uint32_t hash) {
+    PhotoQueue queue;
+    const char *file = nullptr;
+    if (!photo_catalog_queue_of(logical_name, &queue, &file)) return false;
+    if (!ensure_loaded_for_update()) return true;
+    PhotoCatalogRecord r;
+    fill_record(queue, file, size, hash, r);
+    if (!rewrite(&r, [](const PhotoCatalogRecord &) { return false; })) return false;
+    resident_insert(queue, file);
+    resident_check();
+    return true;
+}
+
+bool photo_catalog_remove(const char *logical_name) {
+    PhotoQueue queue;
+    const char *file = nullptr;
+    if (!photo_catalog_queue_of(logical_name, &queue, &file)) return false;
+    if (!ensure_loaded_for_update()) return true;
+    if (!rewrite(nullptr, [&](const PhotoCatalogRecord &r) {
+            return r.queue == (uint8_t)queue && strncmp(r.name, file, kPhotoCatalogNameLen) == 0;
+        })) {
+        return false;
+    }
+    resident_erase(queue, file);
+    resident_check();
+    return true;
+}
+
+uint32_t photo_catalog_purge_expired(uint32_t now) {
+    if (!g_valid || g_header.earliest_expiry == 0 || g_header.earliest_expiry > now) return 0;
+    const uint32_t next_gen = g_header.generation + 1;
+    if (g_marker != next_gen && !write_generation(next_gen)) return 0;
+    uint32_t removed = 0;
+    const bool ok = rewrite(nullptr, [&](const PhotoCatalogRecord &r) {
+        if (r.queue != (uint8_t)PhotoQueue::Temporary || r.expiry == 0 || r.expiry > now) return false;
+        String path = "/" + logical_name(r);
+        if (SD.exists(path)) SD.remove(path);
+        if (jpeg_g4_is_jpeg_name(path.c_str())) {
+            const String cache = jpeg_g4_cache_path(path.c_str());
+            if (SD.exists(cache)) SD.remove(cache);
+        }
+        removed++;
+        return true;
+    });
+    if (ok) LOGI("SD", "Photo catalog purged %lu expired", (unsigned long)removed);
+    // Reloaded on the next open.
+    resident_drop();
+    return removed;
+}
+
+void photo_catalog_invalidate() {
+    g_valid = false;
+    resident_drop();
+    if (SD.exists(kCatalogPath)) SD.remove(kCatalogPath);
+}
+
+void photo_catalog_set_resident(bool resident) {
+    g_resident_wanted = resident;
+    if (!resident) resident_drop();
+}
+
+uint32_t photo_catalog_generation() {
+    return g_valid ? g_header.generation : 0;
+}
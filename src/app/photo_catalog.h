@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "name_list.h"
+
+// Index of the queue photos on SD, so picking the next photo is a header read
+// plus a record read instead of walking /queue-permanent and /queue-temporary.
+//
+// /photo-catalog.bin holds a PhotoCatalogHeader followed by fixed-size
+// records sorted by queue (permanent first) and name. /photo-catalog.gen holds
+// the generation the catalog is expected to have: it is bumped before the SD
+// worker changes a queue file and the catalog is rewritten (temp file +
+// rename) with that generation afterwards. A missing, foreign-version or
+// out-of-date catalog (a crash between the two) is rebuilt from a directory
+// scan the next time it is opened.
+//
+// Names are logical ("queue-permanent/<file>"), as everywhere else. Only the
+// SD worker (or the wake path, before it runs) touches the catalog.
+//
+// The SD worker also keeps the names resident in PSRAM (a sorted NameList per
+// queue), loaded once and patched by put/remove, so its picks and listings
+// don't read the card. A timer wake only reads the records it needs.
+
+enum class PhotoQueue : uint8_t {
+    Permanent = 0,
+    Temporary = 1,
+};
+
+static constexpr uint8_t kPhotoQueues = 2;
+static constexpr size_t kPhotoCatalogNameLen = 112;
+
+struct PhotoCatalogRecord {
+    char name[kPhotoCatalogNameLen];  // file name inside the queue directory
+    uint32_t size;
+    uint32_t expiry;                  // temporary: from the name (UTC epoch), else 0
+    uint32_t hash;                    // CRC-32 of the file, 0 when unknown (rebuild scan)
+    uint8_t queue;                    // PhotoQueue
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(PhotoCatalogRecord) == 128, "PhotoCatalogRecord layout");
+
+struct PhotoCatalogInfo {
+    uint32_t generation;
+    uint32_t count[kPhotoQueues];
+    uint32_t earliest_expiry;  // earliest temporary expiry, 0 when none
+};
+
+// Load the header, rebuilding the catalog first when it is missing or stale
+// (and the resident names when they are wanted).
+bool photo_catalog_open(PhotoCatalogInfo *out);
+
+// Keep the names in memory from the next open on (SD worker).
+void photo_catalog_set_resident(bool resident);
+
+// Generation of the open catalog (0 when none); changes with every update,
+// so a client holding a listing can tell whether it is still current.
+uint32_t photo_catalog_generation();
+
+// Logical name of the record at `index` within a queue.
+bool photo_catalog_get(PhotoQueue queue, uint32_t index, String &out_name);
+
+// Binary search for a logical name; false when it is not in the catalog.
+bool photo_catalog_index_of(const char *logical_name, uint32_t *out_index);
+
+// Append all logical names, sorted.
+bool photo_catalog_list(NameList &out);
+
+// Call before adding, replacing or deleting a queue file, then report the
+// change with put/remove (a failed change without a report makes the next
+// open rebuild). Names outside the queues are ignored, and so are updates
+// while there is no valid catalog (the next open rebuilds it).
+void photo_catalog_begin_update(const char *logical_name);
+bool photo_catalog_put(const char *logical_name, uint32_t size, uint32_t hash);
+bool photo_catalog_remove(const char *logical_name);
+
+// Delete temporary photos (and their JPEG caches) that expired at `now` and
+// drop them from the catalog. Returns how many were removed.
+uint32_t photo_catalog_purge_expired(uint32_t now);
+
+// Drop the catalog before bulk changes; rebuild it from a scan afterwards.
+void photo_catalog_invalidate();
+bool photo_catalog_rebuild();
+
+// Queue of a logical name; false for names outside the queues.
+bool photo_catalog_queue_of(const char *logical_name, PhotoQueue *out_queue, const char **out_file);
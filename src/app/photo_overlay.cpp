@@ -0,0 +1,212 @@
+#include "photo_overlay.h"
+
+#include "board_config.h"
+#include "eink_ui.h"
+#include "log_manager.h"
+#include "max17048_fuel_gauge.h"
+#include "time_utils.h"
+
+#include <esp_heap_caps.h>
+#include <string.h>
+#include <time.h>
+
+namespace {
+// Adafruit GFX classic font: 6x8 cells, scaled.
+static constexpr uint8_t kTextSize = 3;
+static constexpr uint16_t kCharW = 6 * kTextSize;
+static constexpr uint16_t kCharH = 8 * kTextSize;
+static constexpr uint16_t kPad = 12;
+static constexpr uint16_t kMargin = 24;
+static constexpr uint8_t kTextMax = 48;
+static constexpr uint8_t kCaptionMaxChars = 40;
+static constexpr uint8_t kClockChars = 5;    // "23:59"
+static constexpr uint8_t kBatteryChars = 4;  // "100%"
+static_assert((kMargin & 3) == 0 && (DISPLAY_WIDTH & 3) == 0, "overlay boxes must stay 4-px aligned");
+
+static constexpr uint32_t kFnvOffset = 2166136261u;
+static constexpr uint32_t kFnvPrime = 16777619u;
+
+struct OverlaySlot {
+    char text[kTextMax];
+    PhotoOverlayBox box;
+    uint8_t *pixels;
+};
+
+static uint8_t g_mask = 0;
+static char g_caption[kTextMax] = {0};
+static OverlaySlot g_slots[kPhotoOverlaySlots] = {};
+
+static uint32_t fnv(uint32_t h, const void *data, size_t len) {
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * kFnvPrime;
+    }
+    return h;
+}
+
+static void slot_text(PhotoOverlaySlot slot, char *out) {
+    out[0] = '\0';
+    switch (slot) {
+        case PhotoOverlaySlot::Clock: {
+            if (!(g_mask & CONFIG_OVERLAY_CLOCK) || !time_utils::is_time_valid()) return;
+            const time_t now = time(nullptr);
+            struct tm tm_now;
+            localtime_r(&now, &tm_now);
+            snprintf(out, kTextMax, "%02d:%02d", tm_now.tm_hour, tm_now.tm_min);
+        } break;
+        case PhotoOverlaySlot::Battery: {
+            if (!(g_mask & CONFIG_OVERLAY_BATTERY) || !max17048_available()) return;
+            Max17048Reading r = {};
+            if (!max17048_read(&r) || !r.ok) return;
+            const int soc = constrain((int)(r.soc_percent + 0.5f), 0, 100);
+            snprintf(out, kTextMax, "%d%%", soc);
+        } break;
+        case PhotoOverlaySlot::Caption:
+            if (!(g_mask & CONFIG_OVERLAY_CAPTION)) return;
+            strlcpy(out, g_caption, kTextMax);
+            break;
+    }
+}
+
+// Viewer-space placement: clock bottom left, battery bottom right, caption
+// centered between them. Clock and battery boxes have a fixed width so a new
+// value lands on exactly the same pixels. Boxes sit on the 4-px grid of
+// region presents, also after the 180 degree turn.
+static void slot_rect(PhotoOverlaySlot slot, size_t chars, PhotoOverlayBox &box) {
+    switch (slot) {
+        case PhotoOverlaySlot::Clock: chars = kClockChars; break;
+        case PhotoOverlaySlot::Battery: chars = kBatteryChars; break;
+        case PhotoOverlaySlot::Caption: break;
+    }
+    box.w = (uint16_t)((chars * kCharW + 2 * kPad + 3) & ~3u);
+    box.h = kCharH + 2 * kPad;
+    box.y = DISPLAY_HEIGHT - kMargin - box.h;
+    switch (slot) {
+        case PhotoOverlaySlot::Clock: box.x = kMargin; break;
+        case PhotoOverlaySlot::Battery: box.x = DISPLAY_WIDTH - kMargin - box.w; break;
+        case PhotoOverlaySlot::Caption: box.x = (uint16_t)(((DISPLAY_WIDTH - box.w) / 2) & ~3u); break;
+    }
+}
+
+static void slot_clear(OverlaySlot &s) {
+    if (s.pixels) heap_caps_free(s.pixels);
+    s.pixels = nullptr;
+    s.box = {};
+    s.text[0] = '\0';
+}
+
+// Black text on white with a 2 px frame, drawn 1bpp in viewer orientation and
+// packed to 4bpp in panel orientation (rotated 180 for DISPLAY_ROTATION 2,
+// like the UI).
+static bool slot_rasterize(PhotoOverlaySlot slot, const char *text) {
+    OverlaySlot &s = g_slots[(uint8_t)slot];
+    slot_clear(s);
+    if (!text[0]) return true;
+
+    PhotoOverlayBox box = {};
+    slot_rect(slot, strlen(text), box);
+    EInkCanvas1 canvas(box.w, box.h);
+    if (!canvas.begin()) return false;
+    canvas.drawRect(0, 0, box.w, box.h, 0);
+    canvas.drawRect(1, 1, box.w - 2, box.h - 2, 0);
+    canvas.setTextWrap(false);
+    canvas.setTextSize(kTextSize);
+    canvas.setTextColor(0);
+    const uint16_t text_w = (uint16_t)(strlen(text) * kCharW);
+    canvas.setCursor((int16_t)((box.w - text_w) / 2), kPad);
+    canvas.print(text);
+
+    const size_t row_bytes = box.w / 2;
+    uint8_t *pixels = static_cast<uint8_t*>(heap_caps_malloc(row_bytes * box.h, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!pixels) {
+        pixels = static_cast<uint8_t*>(heap_caps_malloc(row_bytes * box.h, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+    if (!pixels) {
+        LOGE("EINK", "Overlay alloc failed (%u bytes)", (unsigned)(row_bytes * box.h));
+        return false;
+    }
+    const bool rotate = DISPLAY_ROTATION == 2;
+    const uint8_t *bits = canvas.data();
+    for (uint16_t py = 0; py < box.h; py++) {
+        const uint16_t vy = rotate ? box.h - 1 - py : py;
+        uint8_t *dst = pixels + (size_t)py * row_bytes;
+        for (uint16_t px = 0; px < box.w; px += 2) {
+            uint8_t packed = 0;
+            for (uint8_t k = 0; k < 2; k++) {
+                const uint16_t vx = rotate ? box.w - 1 - (px + k) : px + k;
+                const uint32_t idx = (uint32_t)vy * box.w + vx;
+                const bool white = bits[idx >> 3] & (0x80 >> (idx & 7));
+                packed = (uint8_t)((packed << 4) | (white ? 0x0F : 0x00));
+            }
+            dst[px / 2] = packed;
+        }
+    }
+    if (rotate) {
+        box.x = (uint16_t)(DISPLAY_WIDTH - box.x - box.w);
+        box.y = (uint16_t)(DISPLAY_HEIGHT - box.y - box.h);
+    }
+
+    uint32_t sig = fnv(kFnvOffset, text, strlen(text));
+    sig = fnv(sig, &box, 4 * sizeof(uint16_t));
+    box.sig = sig ? sig : 1;
+    box.pixels = pixels;
+    s.box = box;
+    s.pixels = pixels;
+    strlcpy(s.text, text, sizeof(s.text));
+    return true;
+}
+} // namespace
+
+void photo_overlay_apply_config(const DeviceConfig *config) {
+    if (!config) return;
+    g_mask = config->photo_overlays & CONFIG_OVERLAY_MASK;
+}
+
+void photo_overlay_set_caption(const char *path) {
+    if (!path) {
+        g_caption[0] = '\0';
+        return;
+    }
+    const char *slash = strrchr(path, '/');
+    const char *name = slash ? slash + 1 : path;
+    const char *dot = strrchr(name, '.');
+    size_t len = dot && dot != name ? (size_t)(dot - name) : strlen(name);
+    char caption[kTextMax];
+    if (len > kCaptionMaxChars) {
+        memcpy(caption, name, kCaptionMaxChars - 3);
+        strcpy(caption + kCaptionMaxChars - 3, "...");
+    } else {
+        memcpy(caption, name, len);
+        caption[len] = '\0';
+    }
+    strlcpy(g_caption, caption, sizeof(g_caption));
+}
+
+const char *photo_overlay_caption() {
+    return g_caption;
+}
+
+void photo_overlay_set_caption_text(const char *text) {
+    strlcpy(g_caption, text ? text : "", sizeof(g_caption));
+}
+
+void photo_overlay_prepare() {
+    char text[kTextMax];
+    for (uint8_t i = 0; i < kPhotoOverlaySlots; i++) {
+        const PhotoOverlaySlot slot = (PhotoOverlaySlot)i;
+        slot_text(slot, text);
+        const OverlaySlot &s = g_slots[i];
+        if (strcmp(text, s.text) == 0 && (s.pixels || !text[0])) continue;
+        if (!slot_rasterize(slot, text)) {
+            LOGW("EINK", "Overlay %u not drawn", (unsigned)i);
+        }
+    }
+}
+
+const PhotoOverlayBox &photo_overlay_box(PhotoOverlaySlot slot) {
+    return g_slots[(uint8_t)slot].box;
+}
+
+bool photo_overlay_clock_enabled() {
+    return (g_mask & CONFIG_OVERLAY_CLOCK) && time_utils::is_time_valid();
+}
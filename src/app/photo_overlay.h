@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config_manager.h"
+#include "photo_overlay_box.h"
+
+// Clock, battery and caption boxes drawn on top of photos.
+//
+// Boxes are small opaque rectangles along the bottom edge (as the viewer sees
+// the frame), pre-rasterized to packed 4bpp in panel orientation. The renderer
+// copies them over the photo rows while they are streamed to the controller,
+// one chunk at a time, so there is no full frame buffer; when only an overlay
+// changes (the clock ticks) just its box is reloaded and refreshed.
+//
+// Text is set from any task, rasterization happens in photo_overlay_prepare(),
+// which the renderer calls while it holds the display.
+
+enum class PhotoOverlaySlot : uint8_t {
+    Clock = 0,
+    Battery,
+    Caption,
+};
+
+static constexpr uint8_t kPhotoOverlaySlots = 3;
+
+// Enabled overlays (CONFIG_OVERLAY_* bits); none until this is called.
+void photo_overlay_apply_config(const DeviceConfig *config);
+
+// Caption for the photo about to be loaded: the base name of `path` without
+// its extension. Null or empty hides the caption.
+void photo_overlay_set_caption(const char *path);
+// Current caption text, and setting it back verbatim (after loading a
+// different photo into the spare buffer).
+const char *photo_overlay_caption();
+void photo_overlay_set_caption_text(const char *text);
+
+// Read the clock and fuel gauge and rasterize every box whose text changed.
+void photo_overlay_prepare();
+
+// Box for a slot as of the last prepare (sig 0 when hidden).
+const PhotoOverlayBox &photo_overlay_box(PhotoOverlaySlot slot);
+
+// Whether the clock overlay is on and showing a valid time (the minute tick
+// in always-on mode only matters then).
+bool photo_overlay_clock_enabled();
@@ -0,0 +1,32 @@
+#include "photo_overlay_box.h"
+
+#include <string.h>
+
+bool photo_overlay_boxes_hit(const PhotoOverlayBox *boxes, size_t count,
+                             uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    for (size_t i = 0; i < count; i++) {
+        const PhotoOverlayBox &b = boxes[i];
+        if (b.sig == 0) continue;
+        if (x < b.x + b.w && b.x < x + w && y < b.y + b.h && b.y < y + h) return true;
+    }
+    return false;
+}
+
+void photo_overlay_boxes_blend(const PhotoOverlayBox *boxes, size_t count, uint8_t *buf,
+                               uint16_t area_x, uint16_t area_w, uint16_t y, uint16_t rows) {
+    const size_t row_bytes = area_w / 2;
+    for (size_t i = 0; i < count; i++) {
+        const PhotoOverlayBox &b = boxes[i];
+        if (b.sig == 0) continue;
+        const uint32_t x0 = b.x > area_x ? b.x : area_x;
+        const uint32_t x1 = (uint32_t)b.x + b.w < (uint32_t)area_x + area_w ? (uint32_t)b.x + b.w
+                                                                             : (uint32_t)area_x + area_w;
+        const uint32_t y0 = b.y > y ? b.y : y;
+        const uint32_t y1 = (uint32_t)b.y + b.h < (uint32_t)y + rows ? (uint32_t)b.y + b.h : (uint32_t)y + rows;
+        if (x0 >= x1 || y0 >= y1) continue;
+        for (uint32_t py = y0; py < y1; py++) {
+            memcpy(buf + (size_t)(py - y) * row_bytes + (x0 - area_x) / 2,
+                   b.pixels + (size_t)(py - b.y) * (b.w / 2) + (x0 - b.x) / 2, (x1 - x0) / 2);
+        }
+    }
+}
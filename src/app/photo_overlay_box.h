@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Overlay boxes (photo_overlay.h) and compositing them into packed 4bpp rows
+// on their way to the controller. No Arduino dependencies: also built into
+// the host tests (tools/g4codec).
+
+struct PhotoOverlayBox {
+    // Panel pixels; x and w are multiples of 4, so a box can be presented on
+    // its own as a host-word aligned region.
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    // Content and placement, 0 = hidden.
+    uint32_t sig;
+    // h rows of w / 2 bytes.
+    const uint8_t *pixels;
+};
+
+// Whether a shown box intersects the panel rectangle.
+bool photo_overlay_boxes_hit(const PhotoOverlayBox *boxes, size_t count,
+                             uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+// Copy the shown boxes over `rows` packed rows in `buf`: an image area `area_w`
+// pixels wide at panel column `area_x` (even), whose first row is panel row `y`.
+void photo_overlay_boxes_blend(const PhotoOverlayBox *boxes, size_t count, uint8_t *buf,
+                               uint16_t area_x, uint16_t area_w, uint16_t y, uint16_t rows);
@@ -0,0 +1,206 @@
+#include "photo_writer.h"
+
+#include "board_config.h"
+#include "g4_file.h"
+#include "jpeg_g4.h"
+#include "log_manager.h"
+#include "photo_catalog.h"
+
+#include <SD.h>
+#include <esp_heap_caps.h>
+
+namespace {
+static bool has_prefix(const char *name, const char *prefix) {
+    if (!name || !prefix) return false;
+    const size_t prefix_len = strlen(prefix);
+    return strncmp(name, prefix, prefix_len) == 0;
+}
+
+static void set_message(PhotoWriter &w, const char *msg) {
+    strlcpy(w.message, msg, sizeof(w.message));
+}
+
+// Reject truncated or foreign files before the first block reaches SD.
+static bool check_header(PhotoWriter &w, const uint8_t *data, size_t len) {
+    G4FileHeader header;
+    const char *error = nullptr;
+    if (jpeg_g4_is_jpeg_name(w.name)) {
+        if (!jpeg_g4_has_signature(data, len)) {
+            set_message(w, "Invalid JPEG");
+            LOGW("SDJob", "Upload rejected name=%s (not a JPEG)", w.name);
+            return false;
+        }
+    } else if (!g4_file_parse_header(data, len, w.expected, DISPLAY_WIDTH, DISPLAY_HEIGHT, &header, &error)) {
+        snprintf(w.message, sizeof(w.message), "Invalid G4: %s", error ? error : "?");
+        LOGW("SDJob", "Upload rejected name=%s (%s)", w.name, w.message);
+        return false;
+    }
+    w.checked = true;
+    return true;
+}
+
+static bool put_block(PhotoWriter &w, const uint8_t *data, size_t len) {
+    if (!w.checked && !check_header(w, data, len)) return false;
+    if (w.file.write(data, len) != len) {
+        set_message(w, "Write failed");
+        LOGE("SDJob", "Upload write failed %s", w.temp_path.c_str());
+        return false;
+    }
+    if (w.progress) *w.progress += len;
+    return true;
+}
+} // namespace
+
+bool photo_name_valid(const char *name) {
+    if (!name) return false;
+    const size_t len = strlen(name);
+    if (len == 0 || len > kPhotoNameMaxLen) return false;
+    if (strchr(name, '\\')) return false;
+    if (strstr(name, "..")) return false;
+    if ((len < 3 || strcmp(name + (len - 3), ".g4") != 0) && !jpeg_g4_is_jpeg_name(name)) return false;
+
+    size_t slash_count = 0;
+    for (const char *p = name; *p; ++p) {
+        if (*p == '/') slash_count++;
+    }
+
+    if (slash_count == 0) return true;
+    if (slash_count == 1 && (has_prefix(name, "queue-permanent/") || has_prefix(name, "queue-temporary/"))) return true;
+    return false;
+}
+
+void photo_drop_jpeg_cache(const String &path) {
+    if (!jpeg_g4_is_jpeg_name(path.c_str())) return;
+    const String cache = jpeg_g4_cache_path(path.c_str());
+    if (SD.exists(cache)) SD.remove(cache);
+}
+
+void photo_writer_abort(PhotoWriter &w) {
+    if (w.file) w.file.close();
+    if (w.temp_path.length() && SD.exists(w.temp_path)) SD.remove(w.temp_path);
+    if (w.stage) heap_caps_free(w.stage);
+    w.stage = nullptr;
+    w.staged = 0;
+}
+
+bool photo_writer_begin(PhotoWriter &w, uint32_t total_bytes) {
+    photo_writer_abort(w);
+    w.message[0] = '\0';
+    if (!photo_name_valid(w.name)) {
+        set_message(w, "Invalid filename");
+        return false;
+    }
+    if (total_bytes == 0) {
+        set_message(w, "Empty file");
+        return false;
+    }
+
+    const String target_path = "/" + String(w.name);
+    const int last_slash = target_path.lastIndexOf('/');
+    if (last_slash > 0) {
+        const String dir = target_path.substring(0, last_slash);
+        if (!SD.exists(dir)) {
+            if (!SD.mkdir(dir)) {
+                set_message(w, "Create dir failed");
+                LOGE("SDJob", "Upload mkdir failed %s", dir.c_str());
+                return false;
+            }
+        }
+    }
+
+    w.stage = static_cast<uint8_t*>(heap_caps_malloc(kPhotoStageBytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!w.stage) {
+        w.stage = static_cast<uint8_t*>(heap_caps_malloc(kPhotoStageBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+    if (!w.stage) {
+        set_message(w, "Out of memory");
+        LOGE("SDJob", "Upload stage alloc failed (%u bytes)", (unsigned)kPhotoStageBytes);
+        return false;
+    }
+
+    LOGI("SDJob", "Upload start name=%s bytes=%lu", w.name, (unsigned long)total_bytes);
+
+    w.temp_path = target_path + ".tmp";
+    if (SD.exists(w.temp_path)) {
+        SD.remove(w.temp_path);
+    }
+    w.file = SD.open(w.temp_path, FILE_WRITE);
+    if (!w.file) {
+        set_message(w, "Open failed");
+        LOGE("SDJob", "Upload open failed %s", w.temp_path.c_str());
+        photo_writer_abort(w);
+        return false;
+    }
+
+    w.expected = total_bytes;
+    w.received = 0;
+    w.crc = 0;
+    w.checked = false;
+    if (w.progress) *w.progress = 0;
+    return true;
+}
+
+bool photo_writer_write(PhotoWriter &w, const uint8_t *data, size_t len) {
+    if (!w.file) return false;
+    if (len > w.expected - w.received) {
+        set_message(w, "Too much data");
+        LOGW("SDJob", "Upload overrun %s", w.name);
+        return false;
+    }
+    w.crc = g4_file_crc32(w.crc, data, len);
+    w.received += (uint32_t)len;
+    while (len > 0) {
+        // Whole blocks straight from the caller's buffer.
+        if (w.staged == 0 && len >= kPhotoStageBytes) {
+            const size_t n = len - len % kPhotoStageBytes;
+            if (!put_block(w, data, n)) return false;
+            data += n;
+            len -= n;
+            continue;
+        }
+        const size_t n = min(len, kPhotoStageBytes - w.staged);
+        memcpy(w.stage + w.staged, data, n);
+        w.staged += n;
+        data += n;
+        len -= n;
+        if (w.staged == kPhotoStageBytes) {
+            if (!put_block(w, w.stage, w.staged)) return false;
+            w.staged = 0;
+        }
+    }
+    return true;
+}
+
+bool photo_writer_commit(PhotoWriter &w) {
+    if (!w.file) return false;
+    if (w.received != w.expected) {
+        set_message(w, "Incomplete");
+        LOGW("SDJob", "Upload incomplete %s (%lu/%lu)", w.name, (unsigned long)w.received, (unsigned long)w.expected);
+        return false;
+    }
+    if (w.staged > 0 && !put_block(w, w.stage, w.staged)) return false;
+    w.staged = 0;
+    heap_caps_free(w.stage);
+    w.stage = nullptr;
+    w.file.flush();
+    w.file.close();
+
+    const String target_path = "/" + String(w.name);
+    photo_catalog_begin_update(w.name);
+    if (SD.exists(target_path)) {
+        SD.remove(target_path);
+    }
+
+    if (!SD.rename(w.temp_path, target_path)) {
+        SD.remove(w.temp_path);
+        photo_catalog_remove(w.name);
+        set_message(w, "Rename failed");
+        LOGE("SDJob", "Upload rename failed %s", target_path.c_str());
+        return false;
+    }
+
+    photo_drop_jpeg_cache(target_path);
+    photo_catalog_put(w.name, w.received, w.crc);
+    LOGI("SDJob", "Upload committed %s", target_path.c_str());
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// A queue photo on its way to SD (portal uploads and blob downloads): bytes
+// are staged and written to "<name>.tmp" in card-sized blocks, the header is
+// checked as soon as the first block goes out, and the CRC is kept on the
+// fly. Commit renames the file into place and reports it to the catalog;
+// abort removes it. Memory use is the staging block, whatever the file size.
+//
+// Runs on the SD worker. Zero-initialize, set `name` (and `progress`), then
+// begin / write... / commit, and always abort at the end (a no-op after a
+// commit).
+
+static constexpr size_t kPhotoNameMaxLen = 127;
+// Block written to SD per call while a photo streams in.
+static constexpr size_t kPhotoStageBytes = 16 * 1024;
+
+struct PhotoWriter {
+    const char *name;   // "<file>" or "queue-*/<file>", .g4 or JPEG
+    size_t *progress;   // optional: bytes on SD so far (job progress)
+    char message[64];   // why the last call failed
+    String temp_path;
+    File file;
+    uint32_t expected;
+    uint32_t received;
+    uint32_t crc;
+    uint8_t *stage;
+    size_t staged;
+    bool checked;
+};
+
+bool photo_writer_begin(PhotoWriter &w, uint32_t total_bytes);
+bool photo_writer_write(PhotoWriter &w, const uint8_t *data, size_t len);
+bool photo_writer_commit(PhotoWriter &w);
+void photo_writer_abort(PhotoWriter &w);
+
+// Photo names the SD jobs accept: a .g4 or JPEG at the root or directly in
+// one of the queues, no "..".
+bool photo_name_valid(const char *name);
+
+// A replaced or deleted JPEG must not keep rendering from its old conversion.
+void photo_drop_jpeg_cache(const String &path);
@@ -0,0 +1,135 @@
+#include "refresh_policy.h"
+
+#include "log_manager.h"
+
+#include <time.h>
+
+namespace {
+struct RtcRefreshState {
+    uint32_t magic;
+    uint16_t renders_since_clean;
+    bool have_histogram;
+    // Previous image histogram, parts per 10000 per level.
+    uint16_t histogram[kRefreshHistogramBins];
+    int64_t last_init_time;
+};
+
+static constexpr uint32_t kRtcRefreshStateMagic = 0x52544346; // "RTCF"
+static constexpr uint16_t kHistogramScale = 10000;
+
+RTC_DATA_ATTR RtcRefreshState g_rtc_refresh_state;
+
+static uint8_t g_clean_every = CONFIG_REFRESH_CLEAN_EVERY_DEFAULT;
+static uint16_t g_init_hours = CONFIG_REFRESH_INIT_HOURS_DEFAULT;
+static uint8_t g_hist_delta_pct = CONFIG_REFRESH_HIST_DELTA_PCT_DEFAULT;
+
+static bool rtc_refresh_state_init() {
+    if (g_rtc_refresh_state.magic == kRtcRefreshStateMagic) return false;
+    g_rtc_refresh_state = {};
+    g_rtc_refresh_state.magic = kRtcRefreshStateMagic;
+    return true;
+}
+
+static int64_t now_seconds() {
+    // System time keeps running across deep sleep (RTC timer), NTP or not.
+    return (int64_t)time(nullptr);
+}
+
+static void normalize(const uint32_t histogram[kRefreshHistogramBins], uint16_t out[kRefreshHistogramBins]) {
+    uint64_t total = 0;
+    for (uint8_t i = 0; i < kRefreshHistogramBins; i++) total += histogram[i];
+    for (uint8_t i = 0; i < kRefreshHistogramBins; i++) {
+        out[i] = total ? (uint16_t)(((uint64_t)histogram[i] * kHistogramScale) / total) : 0;
+    }
+}
+
+// Share of pixels that would have to move to another level (0-100).
+static uint8_t histogram_delta_pct(const uint32_t histogram[kRefreshHistogramBins]) {
+    if (!histogram || !g_rtc_refresh_state.have_histogram) return 100;
+    uint16_t current[kRefreshHistogramBins];
+    normalize(histogram, current);
+    uint32_t l1 = 0;
+    for (uint8_t i = 0; i < kRefreshHistogramBins; i++) {
+        l1 += (uint32_t)abs((int32_t)current[i] - (int32_t)g_rtc_refresh_state.histogram[i]);
+    }
+    return (uint8_t)((l1 / 2) * 100 / kHistogramScale);
+}
+} // namespace
+
+const char* refresh_policy_plan_name(RefreshPlan plan) {
+    switch (plan) {
+        case RefreshPlan::Single: return "single";
+        case RefreshPlan::DoubleClean: return "double";
+        case RefreshPlan::InitClear: return "init";
+    }
+    return "?";
+}
+
+void refresh_policy_apply_config(const DeviceConfig *config) {
+    if (!config) return;
+    g_clean_every = config->refresh_clean_every;
+    g_init_hours = config->refresh_init_hours;
+    g_hist_delta_pct = config->refresh_hist_delta_pct;
+}
+
+RefreshPlan refresh_policy_decide(const uint32_t histogram[kRefreshHistogramBins], bool partial,
+                                  const char *tag) {
+    const bool cold = rtc_refresh_state_init();
+    const int64_t now = now_seconds();
+    if (cold || now < g_rtc_refresh_state.last_init_time) {
+        // Unknown panel history (or the clock jumped back): restart the interval.
+        g_rtc_refresh_state.last_init_time = now;
+    }
+
+    const uint32_t since_init_s = (uint32_t)(now - g_rtc_refresh_state.last_init_time);
+    const uint16_t renders = g_rtc_refresh_state.renders_since_clean;
+    const uint8_t delta = partial ? 0 : histogram_delta_pct(histogram);
+
+    RefreshPlan plan = RefreshPlan::Single;
+    const char *reason = "default";
+    if (cold) {
+        plan = RefreshPlan::InitClear;
+        reason = "cold_boot";
+    } else if (g_init_hours > 0 && since_init_s >= (uint32_t)g_init_hours * 3600UL) {
+        plan = RefreshPlan::InitClear;
+        reason = "interval";
+    } else if (g_clean_every > 0 && renders >= g_clean_every) {
+        plan = RefreshPlan::DoubleClean;
+        reason = "render_count";
+    } else if (g_hist_delta_pct > 0 && delta >= g_hist_delta_pct) {
+        plan = RefreshPlan::DoubleClean;
+        reason = "histogram";
+    }
+
+    LOGI("EINK", "RefreshPolicy(%s): plan=%s reason=%s renders=%u since_init=%lus hist_delta=%u%%%s",
+         tag ? tag : "?",
+         refresh_policy_plan_name(plan),
+         reason,
+         (unsigned)renders,
+         (unsigned long)since_init_s,
+         (unsigned)delta,
+         partial ? " (partial)" : "");
+    return plan;
+}
+
+void refresh_policy_record(RefreshPlan plan, const uint32_t histogram[kRefreshHistogramBins], bool partial) {
+    rtc_refresh_state_init();
+    if (plan == RefreshPlan::Single) {
+        if (g_rtc_refresh_state.renders_since_clean < UINT16_MAX) {
+            g_rtc_refresh_state.renders_since_clean++;
+        }
+    } else {
+        g_rtc_refresh_state.renders_since_clean = 0;
+    }
+    if (plan == RefreshPlan::InitClear) {
+        g_rtc_refresh_state.last_init_time = now_seconds();
+    }
+    // A partial histogram keeps the previous one: only changed bands were sampled.
+    if (partial) return;
+    if (histogram) {
+        normalize(histogram, g_rtc_refresh_state.histogram);
+        g_rtc_refresh_state.have_histogram = true;
+    } else {
+        g_rtc_refresh_state.have_histogram = false;
+    }
+}
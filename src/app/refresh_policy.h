@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config_manager.h"
+
+// Ghosting-aware refresh planning for photo renders.
+//
+// History lives in RTC memory (survives deep sleep): renders since the last
+// clean, the previous image's luminance histogram and when the panel last got
+// an INIT clear. Each photo render gets one of:
+//   Single      - one GC16 pass (default)
+//   DoubleClean - two GC16 passes, when the image changed a lot or enough
+//                 single passes piled up
+//   InitClear   - INIT (drive to white) + GC16, periodically and after a cold
+//                 boot (panel state unknown)
+
+static constexpr uint8_t kRefreshHistogramBins = 16;
+
+enum class RefreshPlan : uint8_t {
+    Single = 0,
+    DoubleClean,
+    InitClear,
+};
+
+const char* refresh_policy_plan_name(RefreshPlan plan);
+
+// Thresholds come from DeviceConfig; defaults apply until this is called.
+void refresh_policy_apply_config(const DeviceConfig *config);
+
+// Pick a plan for the image whose G4 level histogram is given (may be null).
+// Logs the decision and its reason. `partial` marks a differential load whose
+// histogram only covers the reloaded bands: the histogram check is skipped.
+RefreshPlan refresh_policy_decide(const uint32_t histogram[kRefreshHistogramBins], bool partial,
+                                  const char *tag);
+
+// Record a completed photo refresh. A partial histogram is not stored; the
+// previous one is kept, as the skipped bands did not change.
+void refresh_policy_record(RefreshPlan plan, const uint32_t histogram[kRefreshHistogramBins], bool partial);
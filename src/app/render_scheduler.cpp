@@ -4,6 +4,10 @@
 #include "image_render_service.h"
 #include "rtc_state.h"
 #include "log_manager.h"
+#include "photo_overlay.h"
+#include "web_portal_render_control.h"
+
+#include <time.h>
 
 namespace {
 static uint32_t g_render_job_id = 0;
@@ -16,6 +20,18 @@ static SdImageSelectMode g_mode = SdImageSelectMode::Random;
 static RenderPreEnqueueHook g_pre_enqueue_hook = nullptr;
 static void *g_pre_enqueue_context = nullptr;
 
+// After a rotation, wait this long before preloading the next pick so portal or
+// button activity right after a refresh isn't competing with the SD worker.
+static constexpr uint32_t kStageIdleDelayMs = 5000;
+// Don't start a preload this close to the next rotation.
+static constexpr uint32_t kStageMinLeadMs = 15000;
+static uint32_t g_stage_job_id = 0;
+static bool g_stage_wanted = false;
+
+// Clock overlay: redraw just the overlay boxes when the minute changes.
+static uint32_t g_overlay_job_id = 0;
+static time_t g_overlay_minute = 0;
+
 static bool enqueue_render_job() {
     if (g_render_job_id != 0) return false;
 
@@ -60,10 +76,68 @@ static bool poll_render_job(bool *out_success) {
     }
     return false;
 }
+
+static void poll_stage_job() {
+    if (g_stage_job_id == 0) return;
+    SdJobInfo info = {};
+    if (!sd_storage_get_job(g_stage_job_id, &info)) {
+        g_stage_job_id = 0;
+        return;
+    }
+    if (info.state == SdJobState::Done || info.state == SdJobState::Error) {
+        LOGI("Render", "Stage job %lu %s", (unsigned long)g_stage_job_id,
+             info.success ? "staged" : info.message);
+        g_stage_job_id = 0;
+    }
+}
+
+static void maybe_stage_next(unsigned long now) {
+    if (!g_stage_wanted || g_stage_job_id != 0 || g_render_job_id != 0) return;
+    if (g_pending_refresh || g_refresh_interval_ms == 0) return;
+    if (web_portal_render_is_paused()) return;
+    const unsigned long since_refresh = now - g_last_refresh_ms;
+    if (since_refresh < kStageIdleDelayMs) return;
+    if (since_refresh + kStageMinLeadMs >= g_refresh_interval_ms) return;
+
+    g_stage_wanted = false;
+    g_stage_job_id = sd_storage_enqueue_stage_next(g_mode);
+    if (g_stage_job_id != 0) {
+        LOGI("Render", "Enqueued stage job id=%lu", (unsigned long)g_stage_job_id);
+    }
+}
+
+static void poll_overlay_job() {
+    if (g_overlay_job_id == 0) return;
+    SdJobInfo info = {};
+    if (!sd_storage_get_job(g_overlay_job_id, &info)) {
+        g_overlay_job_id = 0;
+        return;
+    }
+    if (info.state == SdJobState::Done || info.state == SdJobState::Error) {
+        if (!info.success) {
+            LOGW("Render", "Overlay job %lu: %s", (unsigned long)g_overlay_job_id, info.message);
+        }
+        g_overlay_job_id = 0;
+    }
+}
+
+static void maybe_update_overlays() {
+    if (!photo_overlay_clock_enabled()) return;
+    if (g_overlay_job_id != 0 || g_render_job_id != 0 || g_stage_job_id != 0) return;
+    if (g_pending_refresh || web_portal_render_is_paused()) return;
+    const time_t minute = time(nullptr) / 60;
+    if (minute == g_overlay_minute) return;
+    g_overlay_minute = minute;
+    g_overlay_job_id = sd_storage_enqueue_overlays();
+}
 }
 
 void render_scheduler_init(const DeviceConfig &config, uint32_t refresh_interval_ms, uint32_t retry_interval_ms) {
     g_render_job_id = 0;
+    g_stage_job_id = 0;
+    g_stage_wanted = false;
+    g_overlay_job_id = 0;
+    g_overlay_minute = 0;
     g_refresh_interval_ms = refresh_interval_ms;
     g_retry_interval_ms = retry_interval_ms;
     g_pending_refresh = true;
@@ -99,6 +173,7 @@ void render_scheduler_tick() {
             g_last_refresh_ms = now;
             g_pending_refresh = false;
             g_next_attempt_ms = 0;
+            g_stage_wanted = true;
         } else {
             LOGW("Render", "Job failed; retry in %lums", (unsigned long)g_retry_interval_ms);
             g_next_attempt_ms = now + g_retry_interval_ms;
@@ -113,6 +188,11 @@ void render_scheduler_tick() {
             }
         }
     }
+
+    poll_stage_job();
+    maybe_stage_next(now);
+    poll_overlay_job();
+    maybe_update_overlays();
 }
 
 bool render_scheduler_render_once(
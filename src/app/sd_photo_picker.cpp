@@ -2,10 +2,9 @@
 
 #include "board_config.h"
 #include "log_manager.h"
+#include "name_list.h"
 
 #include <ctype.h>
-#include <vector>
-#include <algorithm>
 
 static constexpr size_t kMaxG4NameLen = 127;
 static constexpr uint32_t kInvalidIndex = 0xFFFFFFFFu;
@@ -123,7 +122,7 @@ static bool is_g4_file(const char *name) {
     return strcmp(name + (len - 3), ".g4") == 0;
 }
 
-static bool collect_g4_names(std::vector<String> &names) {
+static bool collect_g4_names(NameList &names) {
     File root = SD.open("/");
     if (!root) return false;
     if (!root.isDirectory()) {
@@ -131,14 +130,15 @@ static bool collect_g4_names(std::vector<String> &names) {
         return false;
     }
 
+    bool ok = true;
     File file = root.openNextFile();
-    while (file) {
+    while (file && ok) {
         if (!file.isDirectory()) {
             const char *name = file.name();
             if (is_g4_file(name)) {
                 const size_t len = strlen(name);
                 if (len <= kMaxG4NameLen) {
-                    names.push_back(String(name));
+                    ok = names.push_back(name);
                 } else {
                     LOGW("SD", "Skip long filename: %s", name);
                 }
@@ -147,15 +147,10 @@ static bool collect_g4_names(std::vector<String> &names) {
         file.close();
         file = root.openNextFile();
     }
+    if (file) file.close();
 
     root.close();
-    return true;
-}
-
-static void sort_names_kiss(std::vector<String> &names) {
-    std::sort(names.begin(), names.end(), [](const String &a, const String &b) {
-        return a.compareTo(b) < 0;
-    });
+    return ok;
 }
 
 bool sd_pick_g4_image(
@@ -170,7 +165,7 @@ bool sd_pick_g4_image(
 ) {
     if (!out_path || out_len == 0) return false;
 
-    std::vector<String> names;
+    NameList names;
     if (!collect_g4_names(names)) {
         LOGE("SD", "Failed to open SD root");
         return false;
@@ -187,7 +182,7 @@ bool sd_pick_g4_image(
         return false;
     }
 
-    sort_names_kiss(names);
+    names.sort();
 
     uint32_t index = 0;
     if (mode == SdImageSelectMode::Random) {
@@ -196,14 +191,10 @@ bool sd_pick_g4_image(
         bool found_last = false;
         uint32_t base_index = kInvalidIndex;
 
-        if (last_name && last_name[0] != '\0') {
-            for (uint32_t i = 0; i < count; i++) {
-                if (names[i] == last_name) {
-                    base_index = i;
-                    found_last = true;
-                    break;
-                }
-            }
+        size_t last = 0;
+        if (last_name && last_name[0] != '\0' && names.find(last_name, &last)) {
+            base_index = (uint32_t)last;
+            found_last = true;
         }
 
         if (!found_last) {
@@ -219,13 +210,14 @@ bool sd_pick_g4_image(
         }
     }
 
-    const String &name = names[index];
-    if (name.length() + 1 >= out_len) return false;
+    const char *name = names[index];
+    const size_t name_len = strlen(name);
+    if (name_len + 1 >= out_len) return false;
     out_path[0] = '/';
-    memcpy(out_path + 1, name.c_str(), name.length() + 1);
+    memcpy(out_path + 1, name, name_len + 1);
 
     if (out_selected_name && out_selected_name_len > 0) {
-        strlcpy(out_selected_name, name.c_str(), out_selected_name_len);
+        strlcpy(out_selected_name, name, out_selected_name_len);
     }
 
     if (out_selected_index) {
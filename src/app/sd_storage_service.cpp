@@ -1,9 +1,14 @@
 #include "sd_storage_service.h"
 
+#include "jpeg_g4.h"
 #include "log_manager.h"
 #include "rtc_state.h"
 #include "it8951_renderer.h"
 #include "image_render_service.h"
+#include "photo_catalog.h"
+#include "photo_overlay.h"
+#include "photo_writer.h"
+#include "upload_stream.h"
 #include "display_manager.h"
 #include "web_portal_render_control.h"
 #include "azure_blob_client.h"
@@ -12,7 +17,6 @@
 
 #include <SD.h>
 #include <vector>
-#include <algorithm>
 
 #include <WiFi.h>
 
@@ -25,11 +29,14 @@
 
 namespace {
 static constexpr size_t kMaxJobs = 16;
-static constexpr size_t kMaxNameLen = 127;
+static constexpr size_t kMaxNameLen = kPhotoNameMaxLen;
 static constexpr uint32_t kJobGcMinAgeMs = 60000;
 static constexpr uint32_t kWorkerStackSize = 8192;
 static constexpr UBaseType_t kWorkerPriority = 2;
 static constexpr size_t kJobQueueDepth = 8;
+// How long the upload worker waits for the next chunk (see upload_stream.h).
+static constexpr uint32_t kUploadIdleMs = 15000;
+static constexpr uint32_t kUploadPollMs = 100;
 #if defined(portNUM_PROCESSORS) && (portNUM_PROCESSORS > 1)
 static constexpr BaseType_t kWorkerCore = 1;
 #else
@@ -47,16 +54,21 @@ struct SdJob {
     char message[96] = {0};
 
     char name[kMaxNameLen + 1] = {0};
-    uint8_t *buffer = nullptr;
-    size_t buffer_size = 0;
+    // Upload: the chunks on their way from the portal.
+    UploadStream *stream = nullptr;
 
     SdImageSelectMode mode = SdImageSelectMode::Random;
     uint32_t last_index = 0;
     char last_name[kMaxNameLen + 1] = {0};
 
     char sas_url[CONFIG_BLOB_SAS_URL_MAX_LEN] = {0};
+    // Download: source blob (stored as `name`).
+    char blob[kMaxNameLen + 1] = {0};
 
-    std::vector<String> names;
+    NameList names;
+    // List: the caller's generation on the way in, the catalog's on the way out.
+    uint32_t generation = 0;
+    bool unchanged = false;
 };
 
 static SPIClass *g_spi = nullptr;
@@ -91,59 +103,68 @@ static SdJob *alloc_job() {
 
 static void free_job(SdJob *job) {
     if (!job) return;
-    if (job->buffer) {
-        heap_caps_free(job->buffer);
-        job->buffer = nullptr;
-    }
+    upload_stream_free(job->stream);
+    job->stream = nullptr;
     delete job;
 }
 
-static void gc_jobs_locked() {
+// Finished jobs past kJobGcMinAgeMs leave the table into `out` (at most
+// kMaxJobs); the caller frees them once it left the critical section, since
+// deleting queues and heap blocks must not run with interrupts masked.
+static size_t take_stale_jobs_locked(SdJob **out) {
     const uint32_t now = millis();
+    size_t count = 0;
     for (size_t i = 0; i < kMaxJobs; i++) {
         SdJob *job = g_jobs[i];
         if (!job) continue;
         if (job->state == SdJobState::Queued || job->state == SdJobState::Running) continue;
         if (now - job->updated_ms < kJobGcMinAgeMs) continue;
-        free_job(job);
+        out[count++] = job;
         g_jobs[i] = nullptr;
     }
+    return count;
+}
+
+static void free_jobs(SdJob **jobs, size_t count) {
+    for (size_t i = 0; i < count; i++) free_job(jobs[i]);
 }
 
 static bool store_job(SdJob *job) {
     if (!job) return false;
+    SdJob *dropped[kMaxJobs];
+    bool stored = false;
     portENTER_CRITICAL(&g_jobs_mux);
-    gc_jobs_locked();
-    for (size_t i = 0; i < kMaxJobs; i++) {
+    size_t dropped_count = take_stale_jobs_locked(dropped);
+    for (size_t i = 0; i < kMaxJobs && !stored; i++) {
         if (!g_jobs[i]) {
             g_jobs[i] = job;
-            portEXIT_CRITICAL(&g_jobs_mux);
-            return true;
+            stored = true;
         }
     }
 
-    // No free slot - evict oldest completed job.
-    size_t oldest_idx = kMaxJobs;
-    uint32_t oldest_ms = UINT32_MAX;
-    for (size_t i = 0; i < kMaxJobs; i++) {
-        SdJob *candidate = g_jobs[i];
-        if (!candidate) continue;
-        if (candidate->state == SdJobState::Queued || candidate->state == SdJobState::Running) continue;
-        if (candidate->updated_ms < oldest_ms) {
-            oldest_ms = candidate->updated_ms;
-            oldest_idx = i;
+    if (!stored) {
+        // No free slot - evict oldest completed job.
+        size_t oldest_idx = kMaxJobs;
+        uint32_t oldest_ms = UINT32_MAX;
+        for (size_t i = 0; i < kMaxJobs; i++) {
+            SdJob *candidate = g_jobs[i];
+            if (!candidate) continue;
+            if (candidate->state == SdJobState::Queued || candidate->state == SdJobState::Running) continue;
+            if (candidate->updated_ms < oldest_ms) {
+                oldest_ms = candidate->updated_ms;
+                oldest_idx = i;
+            }
+        }
+        if (oldest_idx < kMaxJobs) {
+            dropped[dropped_count++] = g_jobs[oldest_idx];
+            g_jobs[oldest_idx] = job;
+            stored = true;
         }
     }
-
-    if (oldest_idx < kMaxJobs) {
-        free_job(g_jobs[oldest_idx]);
-        g_jobs[oldest_idx] = job;
-        portEXIT_CRITICAL(&g_jobs_mux);
-        return true;
-    }
-
     portEXIT_CRITICAL(&g_jobs_mux);
-    return false;
+
+    free_jobs(dropped, dropped_count);
+    return stored;
 }
 
 static SdJob *find_job(uint32_t id) {
@@ -169,30 +190,6 @@ static bool ensure_sd_ready_internal() {
     return true;
 }
 
-static bool has_prefix(const char *name, const char *prefix) {
-    if (!name || !prefix) return false;
-    const size_t prefix_len = strlen(prefix);
-    return strncmp(name, prefix, prefix_len) == 0;
-}
-
-static bool is_valid_g4_name(const char *name) {
-    if (!name) return false;
-    const size_t len = strlen(name);
-    if (len == 0 || len > kMaxNameLen) return false;
-    if (strchr(name, '\\')) return false;
-    if (strstr(name, "..")) return false;
-    if (len < 3 || strcmp(name + (len - 3), ".g4") != 0) return false;
-
-    size_t slash_count = 0;
-    for (const char *p = name; *p; ++p) {
-        if (*p == '/') slash_count++;
-    }
-
-    if (slash_count == 0) return true;
-    if (slash_count == 1 && (has_prefix(name, "queue-permanent/") || has_prefix(name, "queue-temporary/"))) return true;
-    return false;
-}
-
 static bool parse_all_temp_expiry(const String &name, time_t *out_epoch) {
     if (!out_epoch) return false;
     if (!name.startsWith("all/temporary/")) return false;
@@ -215,7 +212,7 @@ static bool derive_queue_name_from_all_blob(const String &all_name, String &out_
     return false;
 }
 
-static bool collect_g4_names_from_dir(const char *dir, const char *prefix, std::vector<String> &names) {
+static bool collect_g4_names_from_dir(const char *dir, const char *prefix, NameList &names) {
     if (!dir) return false;
     if (!SD.exists(dir)) return true;
 
@@ -226,117 +223,129 @@ static bool collect_g4_names_from_dir(const char *dir, const char *prefix, std::
         return false;
     }
 
+    const size_t prefix_len = prefix ? strlen(prefix) : 0;
+    bool ok = true;
     File file = root.openNextFile();
-    while (file) {
+    while (file && ok) {
         if (!file.isDirectory()) {
             const char *name = file.name();
             if (name && name[0] != '\0') {
                 const size_t len = strlen(name);
-                if (len >= 3 && strcmp(name + (len - 3), ".g4") == 0) {
-                    String entry = prefix ? String(prefix) + String(name) : String(name);
-                    if (entry.length() <= kMaxNameLen) {
-                        names.push_back(entry);
-                    }
+                if (((len >= 3 && strcmp(name + (len - 3), ".g4") == 0) || jpeg_g4_is_jpeg_name(name)) &&
+                    prefix_len + len <= kMaxNameLen) {
+                    ok = names.push_back(prefix, name);
                 }
             }
         }
         file.close();
         file = root.openNextFile();
     }
+    if (file) file.close();
 
     root.close();
-    return true;
+    return ok;
 }
 
-static bool collect_g4_names(std::vector<String> &names) {
+static bool collect_g4_names(NameList &names) {
     bool ok = true;
     ok = collect_g4_names_from_dir("/queue-permanent", "queue-permanent/", names) && ok;
     ok = collect_g4_names_from_dir("/queue-temporary", "queue-temporary/", names) && ok;
     return ok;
 }
 
-static void sort_names(std::vector<String> &names) {
-    std::sort(names.begin(), names.end(), [](const String &a, const String &b) {
-        return a.compareTo(b) < 0;
-    });
-}
-
-static bool write_upload_to_sd(SdJob *job) {
-    if (!job || !job->buffer || job->buffer_size == 0) return false;
-    if (!is_valid_g4_name(job->name)) {
-        job_set_message(job, "Invalid filename");
-        return false;
-    }
-
-    const String target_path = "/" + String(job->name);
-    const String temp_path = target_path + ".tmp";
-
-    const int last_slash = target_path.lastIndexOf('/');
-    if (last_slash > 0) {
-        const String dir = target_path.substring(0, last_slash);
-        if (!SD.exists(dir)) {
-            if (!SD.mkdir(dir)) {
-                job_set_message(job, "Create dir failed");
-                LOGE("SDJob", "Upload mkdir failed %s", dir.c_str());
-                return false;
+// Write a portal upload as its chunks arrive. The worker stops taking chunks
+// (and the sender's next write fails) as soon as the file is rejected, and
+// gives up when the sender aborts or goes quiet for kUploadIdleMs.
+static bool handle_upload(SdJob *job) {
+    UploadStream *stream = job->stream;
+    if (!stream) return false;
+    PhotoWriter w = {};
+    w.name = job->name;
+    w.progress = &job->bytes;
+    const unsigned long start_ms = millis();
+    bool ok = photo_writer_begin(w, stream->size);
+    bool last = false;
+    uint32_t idle_ms = millis();
+    while (ok && !last) {
+        if (stream->aborted) {
+            job_set_message(job, "Upload aborted");
+            ok = false;
+            break;
+        }
+        UploadChunk *chunk = upload_stream_receive(stream, kUploadPollMs);
+        if (!chunk) {
+            if (millis() - idle_ms >= kUploadIdleMs) {
+                job_set_message(job, "Upload timed out");
+                LOGW("SDJob", "Upload timed out %s (%lu/%lu)", w.name, (unsigned long)w.received, (unsigned long)w.expected);
+                ok = false;
             }
+            continue;
         }
+        idle_ms = millis();
+        if (chunk->len) ok = photo_writer_write(w, chunk->data, chunk->len);
+        last = chunk->last;
+        upload_stream_release(stream, chunk);
+        if (ok && last) ok = photo_writer_commit(w);
+    }
+    if (ok) image_render_service_forget_staged(job->name);
+    photo_writer_abort(w);
+    if (!ok && w.message[0]) job_set_message(job, w.message);
+    stream->closed = true;
+    if (last || stream->aborted) {
+        // The sender is done with the stream once it posted the last chunk
+        // or aborted.
+        portENTER_CRITICAL(&g_jobs_mux);
+        job->stream = nullptr;
+        portEXIT_CRITICAL(&g_jobs_mux);
+        upload_stream_free(stream);
     }
+    if (ok) LOG_DURATION("SDJob", "Upload", start_ms);
+    return ok;
+}
 
-    LOGI("SDJob", "Upload start name=%s bytes=%u", job->name, (unsigned)job->buffer_size);
-
-    if (SD.exists(temp_path)) {
-        SD.remove(temp_path);
-    }
-
-    File file = SD.open(temp_path, FILE_WRITE);
-    if (!file) {
-        job_set_message(job, "Open failed");
-        LOGE("SDJob", "Upload open failed %s", temp_path.c_str());
-        return false;
-    }
-
-    const size_t written = file.write(job->buffer, job->buffer_size);
-    file.flush();
-    file.close();
-
-    job->bytes = written;
-
-    if (written != job->buffer_size) {
-        SD.remove(temp_path);
-        job_set_message(job, "Write failed");
-        LOGE("SDJob", "Upload write failed %s", temp_path.c_str());
-        return false;
-    }
-
-    if (SD.exists(target_path)) {
-        SD.remove(target_path);
-    }
-
-    if (!SD.rename(temp_path, target_path)) {
-        SD.remove(temp_path);
-        job_set_message(job, "Rename failed");
-        LOGE("SDJob", "Upload rename failed %s", target_path.c_str());
-        return false;
-    }
+static bool photo_sink_begin(uint32_t total_bytes, void *user) {
+    return photo_writer_begin(*static_cast<PhotoWriter*>(user), total_bytes);
+}
 
-    LOGI("SDJob", "Upload committed %s", target_path.c_str());
+static bool photo_sink_write(const uint8_t *data, size_t len, void *user) {
+    return photo_writer_write(*static_cast<PhotoWriter*>(user), data, len);
+}
 
-    return true;
+// Stream a blob into the queue file `name` without holding it in memory.
+static bool download_photo_to_sd(
+    SdJob *job,
+    const AzureSasUrlParts &sas,
+    const String &blob_name,
+    const char *name,
+    int *out_http_code
+) {
+    PhotoWriter w = {};
+    w.name = name;
+    w.progress = &job->bytes;
+    const AzureBlobSink sink = {photo_sink_begin, photo_sink_write, &w};
+    const unsigned long start_ms = millis();
+    const bool ok = azure_blob_download_to_sink(sas, blob_name, sink, 15000, 2, 150, out_http_code) &&
+                    photo_writer_commit(w);
+    photo_writer_abort(w);
+    if (ok) image_render_service_forget_staged(name);
+    if (!ok && w.message[0]) job_set_message(job, w.message);
+    if (ok) LOG_DURATION("SDJob", "Download", start_ms);
+    return ok;
 }
 
 static bool delete_all_g4_files(SdJob *job) {
-    std::vector<String> names;
+    NameList names;
     if (!collect_g4_names(names)) {
         job_set_message(job, "SD unavailable");
         return false;
     }
 
     size_t deleted = 0;
-    for (const auto &name : names) {
-        const String path = "/" + name;
+    for (size_t i = 0; i < names.size(); i++) {
+        const String path = "/" + String(names[i]);
         if (SD.exists(path)) {
             if (SD.remove(path)) {
+                photo_drop_jpeg_cache(path);
                 deleted++;
             } else {
                 LOGW("SDJob", "Failed deleting %s", path.c_str());
@@ -354,15 +363,14 @@ static bool list_all_g4_blobs(
     SdJob *job,
     const AzureSasUrlParts &sas,
     const String &prefix,
-    std::vector<String> &out
+    NameList &out
 ) {
     out.clear();
     String marker;
     String next_marker;
-    std::vector<String> names;
+    NameList names;
 
     while (true) {
-        names.clear();
         next_marker = "";
         const bool ok = azure_blob_list_page(
             sas,
@@ -380,9 +388,12 @@ static bool list_all_g4_blobs(
             return false;
         }
 
-        for (const auto &n : names) {
-            if (n.endsWith(".g4")) {
-                out.push_back(n);
+        for (size_t i = 0; i < names.size(); i++) {
+            const char *n = names[i];
+            const size_t len = strlen(n);
+            if (((len >= 3 && strcmp(n + (len - 3), ".g4") == 0) || jpeg_g4_is_jpeg_name(n)) && !out.push_back(n)) {
+                job_set_message(job, "Out of memory");
+                return false;
             }
         }
 
@@ -390,7 +401,7 @@ static bool list_all_g4_blobs(
         marker = next_marker;
     }
 
-    sort_names(out);
+    out.sort();
     return true;
 }
 
@@ -416,6 +427,9 @@ static bool handle_sync_from_azure(SdJob *job) {
     const bool was_paused = web_portal_render_is_paused();
     web_portal_render_set_paused(true);
 
+    // Rebuilt from a scan once the queues are repopulated.
+    photo_catalog_invalidate();
+    image_render_service_forget_staged(nullptr);
     job_set_message(job, "Deleting SD files...");
     if (!delete_all_g4_files(job)) {
         web_portal_render_set_paused(was_paused);
@@ -428,8 +442,8 @@ static bool handle_sync_from_azure(SdJob *job) {
         return false;
     }
 
-    std::vector<String> queue_temp_blobs;
-    std::vector<String> queue_perm_blobs;
+    NameList queue_temp_blobs;
+    NameList queue_perm_blobs;
     job_set_message(job, "Listing Azure queue-temporary/...");
     if (!list_all_g4_blobs(job, sas, "queue-temporary/", queue_temp_blobs)) {
         web_portal_render_set_paused(was_paused);
@@ -442,8 +456,8 @@ static bool handle_sync_from_azure(SdJob *job) {
         return false;
     }
 
-    std::vector<String> all_temp_blobs;
-    std::vector<String> all_perm_blobs;
+    NameList all_temp_blobs;
+    NameList all_perm_blobs;
     job_set_message(job, "Listing Azure all/temporary/...");
     if (!list_all_g4_blobs(job, sas, "all/temporary/", all_temp_blobs)) {
         web_portal_render_set_paused(was_paused);
@@ -462,11 +476,6 @@ static bool handle_sync_from_azure(SdJob *job) {
         (unsigned)all_temp_blobs.size(),
         (unsigned)all_perm_blobs.size());
 
-    std::vector<String> queue_names;
-    queue_names.reserve(queue_temp_blobs.size() + queue_perm_blobs.size());
-    queue_names.insert(queue_names.end(), queue_temp_blobs.begin(), queue_temp_blobs.end());
-    queue_names.insert(queue_names.end(), queue_perm_blobs.begin(), queue_perm_blobs.end());
-    sort_names(queue_names);
 
     struct SyncTarget {
         String blob_name;
@@ -479,8 +488,7 @@ static bool handle_sync_from_azure(SdJob *job) {
 
     const time_t now = time(nullptr);
     auto is_queued = [&](const String &name) -> bool {
-        return std::binary_search(queue_names.begin(), queue_names.end(), name,
-            [](const String &a, const String &b) { return a.compareTo(b) < 0; });
+        return queue_temp_blobs.find(name.c_str()) || queue_perm_blobs.find(name.c_str());
     };
 
     auto add_target = [&](const String &all_name, bool is_temp) {
@@ -501,8 +509,8 @@ static bool handle_sync_from_azure(SdJob *job) {
         targets.push_back({all_name, queue_name, is_temp});
     };
 
-    for (const auto &b : all_temp_blobs) add_target(b, true);
-    for (const auto &b : all_perm_blobs) add_target(b, false);
+    for (size_t i = 0; i < all_temp_blobs.size(); i++) add_target(String(all_temp_blobs[i]), true);
+    for (size_t i = 0; i < all_perm_blobs.size(); i++) add_target(String(all_perm_blobs[i]), false);
 
     const size_t total = targets.size();
     size_t ok_count = 0;
@@ -516,49 +524,21 @@ static bool handle_sync_from_azure(SdJob *job) {
         snprintf(msg, sizeof(msg), "Downloading %u/%u...", (unsigned)idx, (unsigned)total);
         job_set_message(job, msg);
 
-        uint8_t *buf = nullptr;
-        size_t size = 0;
+        // Streamed straight into queue-temporary/ or queue-permanent/.
         int http_code = 0;
-        const bool ok_dl = azure_blob_download_to_buffer_ex(
-            sas,
-            target.blob_name,
-            &buf,
-            &size,
-            15000,
-            2,
-            150,
-            &http_code
-        );
-        if (!ok_dl || !buf || size == 0) {
-            LOGW("SDJob", "SyncFromAzure download failed: %s (http=%d)", target.blob_name.c_str(), http_code);
+        if (!download_photo_to_sd(job, sas, target.blob_name, target.queue_name.c_str(), &http_code)) {
+            // A 200 means the transfer or the SD write broke, not the blob.
+            const String &failed = http_code == 200 ? target.queue_name : target.blob_name;
+            LOGW("SDJob", "SyncFromAzure download failed: %s (http=%d)", failed.c_str(), http_code);
             fail_count++;
-            job->names.push_back(target.blob_name);
-            if (buf) heap_caps_free(buf);
+            job->names.push_back(failed.c_str());
             return;
         }
-
-        // Reuse upload write path (write under queue-temporary/ or queue-permanent/).
-        strlcpy(job->name, target.queue_name.c_str(), sizeof(job->name));
-        job->buffer = buf;
-        job->buffer_size = size;
-        const bool ok_write = write_upload_to_sd(job);
-        if (!ok_write) {
-            LOGW("SDJob", "SyncFromAzure write failed: %s", target.queue_name.c_str());
-            fail_count++;
-            job->names.push_back(target.queue_name);
-        } else {
-            ok_count++;
-        }
-
-        if (job->buffer) {
-            heap_caps_free(job->buffer);
-            job->buffer = nullptr;
-            job->buffer_size = 0;
-        }
-        job->name[0] = '\0';
+        ok_count++;
     };
 
     for (const auto &t : targets) download_and_write(t);
+    photo_catalog_rebuild();
 
     char final_msg[96];
     snprintf(final_msg, sizeof(final_msg), "Synced: ok=%u failed=%u", (unsigned)ok_count, (unsigned)fail_count);
@@ -569,6 +549,27 @@ static bool handle_sync_from_azure(SdJob *job) {
     return fail_count == 0;
 }
 
+static bool handle_download(SdJob *job) {
+    if (WiFi.status() != WL_CONNECTED) {
+        job_set_message(job, "WiFi not connected");
+        return false;
+    }
+    AzureSasUrlParts sas;
+    if (!azure_blob_parse_sas_url(job->sas_url, sas)) {
+        job_set_message(job, "Invalid SAS URL");
+        return false;
+    }
+    int http_code = 0;
+    if (download_photo_to_sd(job, sas, String(job->blob), job->name, &http_code)) return true;
+    // The writer names SD-side failures itself.
+    if (!job->message[0]) {
+        char msg[48];
+        snprintf(msg, sizeof(msg), "Download failed (http=%d)", http_code);
+        job_set_message(job, msg);
+    }
+    return false;
+}
+
 static bool handle_render_next(SdJob *job) {
     if (!job) return false;
 
@@ -580,8 +581,21 @@ static bool handle_render_next(SdJob *job) {
     return true;
 }
 
+static bool handle_stage_next(SdJob *job) {
+    if (!job) return false;
+
+    if (!image_render_service_stage_next(job->mode)) {
+        job_set_message(job, "Nothing staged");
+        return false;
+    }
+
+    return true;
+}
+
 static void worker_task(void *param) {
     (void)param;
+    // Renders and listings from here on are served from memory.
+    photo_catalog_set_resident(true);
     SdJob *job = nullptr;
     while (true) {
         if (xQueueReceive(g_job_queue, &job, portMAX_DELAY) != pdTRUE) {
@@ -606,16 +620,19 @@ static void worker_task(void *param) {
         switch (job->type) {
             case SdJobType::List: {
                 job->names.clear();
-                ok = collect_g4_names(job->names);
-                if (ok) {
-                    sort_names(job->names);
-                } else {
-                    job_set_message(job, "SD unavailable");
+                PhotoCatalogInfo catalog;
+                ok = photo_catalog_open(&catalog);
+                if (ok && job->generation != 0 && job->generation == catalog.generation) {
+                    job->unchanged = true;
+                } else if (ok) {
+                    job->generation = catalog.generation;
+                    ok = photo_catalog_list(job->names);
                 }
+                if (!ok) job_set_message(job, "SD unavailable");
                 break;
             }
             case SdJobType::Delete: {
-                if (!is_valid_g4_name(job->name)) {
+                if (!photo_name_valid(job->name)) {
                     job_set_message(job, "Invalid name");
                     ok = false;
                     break;
@@ -626,16 +643,22 @@ static void worker_task(void *param) {
                     ok = false;
                     break;
                 }
+                photo_catalog_begin_update(job->name);
                 ok = SD.remove(path);
+                if (ok) {
+                    photo_drop_jpeg_cache(path);
+                    photo_catalog_remove(job->name);
+                    image_render_service_forget_staged(job->name);
+                }
                 if (!ok) job_set_message(job, "Delete failed");
                 break;
             }
             case SdJobType::Upload: {
-                ok = write_upload_to_sd(job);
+                ok = handle_upload(job);
                 break;
             }
             case SdJobType::Display: {
-                if (!is_valid_g4_name(job->name)) {
+                if (!photo_name_valid(job->name)) {
                     job_set_message(job, "Invalid name");
                     ok = false;
                     break;
@@ -655,7 +678,13 @@ static void worker_task(void *param) {
                 if (ui_was_active) {
                     display_manager_ui_stop();
                 }
-                ok = it8951_render_g4(path.c_str());
+                photo_overlay_set_caption(path.c_str());
+                if (jpeg_g4_is_jpeg_name(path.c_str())) {
+                    const String cache = jpeg_g4_cache_path(path.c_str());
+                    ok = it8951_render_jpeg(path.c_str(), JPEG_G4_CACHE ? cache.c_str() : nullptr);
+                } else {
+                    ok = it8951_render_g4(path.c_str());
+                }
                 if (!ok) job_set_message(job, "Render failed");
                 break;
             }
@@ -667,6 +696,24 @@ static void worker_task(void *param) {
                 ok = handle_sync_from_azure(job);
                 break;
             }
+            case SdJobType::StageNext: {
+                ok = handle_stage_next(job);
+                break;
+            }
+            case SdJobType::Overlays: {
+                ok = it8951_render_overlays();
+                if (!ok) job_set_message(job, "Overlays need a full render");
+                break;
+            }
+            case SdJobType::Collage: {
+                ok = image_render_service_render_collage(job->names);
+                if (!ok) job_set_message(job, "Collage render failed");
+                break;
+            }
+            case SdJobType::Download: {
+                ok = handle_download(job);
+                break;
+            }
             default:
                 job_set_message(job, "Unknown job");
                 ok = false;
@@ -682,22 +729,13 @@ static void worker_task(void *param) {
         } else {
             LOGW("SDJob", "Job %lu error: %s", (unsigned long)job->id, job->message);
         }
-
-        if (job->buffer) {
-            heap_caps_free(job->buffer);
-            job->buffer = nullptr;
-            job->buffer_size = 0;
-        }
     }
 }
 
 static uint32_t enqueue_job(SdJob *job) {
     if (!job) return 0;
-    if (!store_job(job)) {
-        free_job(job);
-        return 0;
-    }
-    if (!g_job_queue) {
+    // Checked first: a stored job belongs to the table.
+    if (!g_job_queue || !store_job(job)) {
         free_job(job);
         return 0;
     }
@@ -712,6 +750,20 @@ static uint32_t enqueue_job(SdJob *job) {
     LOGI("SDJob", "Enqueued job %lu type=%u", (unsigned long)job->id, (unsigned)job->type);
     return job->id;
 }
+
+// Stream of a queued or running upload job; null once the worker let go of it.
+static UploadStream *find_upload_stream(uint32_t id) {
+    UploadStream *stream = nullptr;
+    portENTER_CRITICAL(&g_jobs_mux);
+    for (size_t i = 0; i < kMaxJobs; i++) {
+        if (g_jobs[i] && g_jobs[i]->id == id && g_jobs[i]->type == SdJobType::Upload) {
+            stream = g_jobs[i]->stream;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_jobs_mux);
+    return stream;
+}
 }
 
 bool sd_storage_configure(SPIClass &spi, const SdCardPins &pins, uint32_t frequency_hz) {
@@ -734,10 +786,11 @@ bool sd_storage_ensure_ready() {
     return ensure_sd_ready_internal();
 }
 
-uint32_t sd_storage_enqueue_list() {
+uint32_t sd_storage_enqueue_list(uint32_t since_generation) {
     SdJob *job = alloc_job();
     if (!job) return 0;
     job->type = SdJobType::List;
+    job->generation = since_generation;
     return enqueue_job(job);
 }
 
@@ -751,16 +804,30 @@ uint32_t sd_storage_enqueue_delete(const char *name) {
     return enqueue_job(job);
 }
 
-uint32_t sd_storage_enqueue_upload(const char *name, uint8_t *buffer, size_t size) {
+uint32_t sd_storage_upload_begin(const char *name, size_t size) {
+    if (!name || strlen(name) > kMaxNameLen || size == 0 || size > UINT32_MAX) return 0;
     SdJob *job = alloc_job();
     if (!job) return 0;
     job->type = SdJobType::Upload;
-    if (name) {
-        strlcpy(job->name, name, sizeof(job->name));
+    strlcpy(job->name, name, sizeof(job->name));
+    job->stream = upload_stream_alloc((uint32_t)size);
+    if (!job->stream) {
+        free_job(job);
+        return 0;
     }
-    job->buffer = buffer;
-    job->buffer_size = size;
-    return enqueue_job(job);
+    const uint32_t id = enqueue_job(job);
+    SdJobInfo info;
+    if (id == 0 || !sd_storage_get_job(id, &info) || info.state == SdJobState::Error) return 0;
+    return id;
+}
+
+bool sd_storage_upload_write(uint32_t job_id, const uint8_t *data, size_t len) {
+    return upload_stream_write(find_upload_stream(job_id), data, len);
+}
+
+bool sd_storage_upload_end(uint32_t job_id, bool commit) {
+    // After this the worker may free the stream at any time.
+    return upload_stream_end(find_upload_stream(job_id), commit);
 }
 
 uint32_t sd_storage_enqueue_display(const char *name) {
@@ -789,6 +856,44 @@ uint32_t sd_storage_enqueue_render_next(
     return enqueue_job(job);
 }
 
+uint32_t sd_storage_enqueue_stage_next(SdImageSelectMode mode) {
+    SdJob *job = alloc_job();
+    if (!job) return 0;
+    job->type = SdJobType::StageNext;
+    job->mode = mode;
+    return enqueue_job(job);
+}
+
+uint32_t sd_storage_enqueue_overlays() {
+    SdJob *job = alloc_job();
+    if (!job) return 0;
+    job->type = SdJobType::Overlays;
+    return enqueue_job(job);
+}
+
+uint32_t sd_storage_enqueue_collage(const NameList &names) {
+    SdJob *job = alloc_job();
+    if (!job) return 0;
+    job->type = SdJobType::Collage;
+    if (!job->names.assign(names)) {
+        free_job(job);
+        return 0;
+    }
+    return enqueue_job(job);
+}
+
+uint32_t sd_storage_enqueue_download(const char *container_sas_url, const char *blob_name, const char *name) {
+    if (!container_sas_url || !blob_name || !name) return 0;
+    if (strlen(blob_name) > kMaxNameLen || strlen(name) > kMaxNameLen) return 0;
+    SdJob *job = alloc_job();
+    if (!job) return 0;
+    job->type = SdJobType::Download;
+    strlcpy(job->sas_url, container_sas_url, sizeof(job->sas_url));
+    strlcpy(job->blob, blob_name, sizeof(job->blob));
+    strlcpy(job->name, name, sizeof(job->name));
+    return enqueue_job(job);
+}
+
 uint32_t sd_storage_enqueue_sync_from_azure(const char *container_sas_url) {
     SdJob *job = alloc_job();
     if (!job) return 0;
@@ -812,20 +917,23 @@ bool sd_storage_get_job(uint32_t id, SdJobInfo *out) {
     out->created_ms = job->created_ms;
     out->updated_ms = job->updated_ms;
     strlcpy(out->message, job->message, sizeof(out->message));
+    out->generation = job->type == SdJobType::List ? job->generation : 0;
+    out->unchanged = job->unchanged;
     return true;
 }
 
-bool sd_storage_get_job_names(uint32_t id, std::vector<String> &out_names) {
+bool sd_storage_get_job_names(uint32_t id, NameList &out_names) {
     SdJob *job = find_job(id);
     if (!job) return false;
     if (job->type != SdJobType::List && job->type != SdJobType::SyncFromAzure) return false;
-    if (job->state != SdJobState::Done) return false;
-    out_names = job->names;
-    return true;
+    if (job->state != SdJobState::Done || job->unchanged) return false;
+    return out_names.assign(job->names);
 }
 
 void sd_storage_purge_jobs() {
+    SdJob *stale[kMaxJobs];
     portENTER_CRITICAL(&g_jobs_mux);
-    gc_jobs_locked();
+    const size_t count = take_stale_jobs_locked(stale);
     portEXIT_CRITICAL(&g_jobs_mux);
+    free_jobs(stale, count);
 }
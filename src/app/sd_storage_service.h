@@ -2,8 +2,8 @@
 
 #include <Arduino.h>
 #include <SPI.h>
-#include <vector>
 
+#include "name_list.h"
 #include "sd_photo_picker.h"
 
 enum class SdJobType : uint8_t {
@@ -13,6 +13,10 @@ enum class SdJobType : uint8_t {
     Display = 3,
     RenderNext = 4,
     SyncFromAzure = 5,
+    StageNext = 6,
+    Overlays = 7,
+    Collage = 8,
+    Download = 9,
 };
 
 enum class SdJobState : uint8_t {
@@ -31,14 +35,18 @@ struct SdJobInfo {
     uint32_t created_ms = 0;
     uint32_t updated_ms = 0;
     char message[96] = {0};
+    // List: photo catalog generation, and whether it matched the caller's.
+    uint32_t generation = 0;
+    bool unchanged = false;
 };
 
 bool sd_storage_configure(SPIClass &spi, const SdCardPins &pins, uint32_t frequency_hz);
 bool sd_storage_ensure_ready();
 
-uint32_t sd_storage_enqueue_list();
+// List the queue photos. With the generation of an earlier listing, the job
+// only reports `unchanged` when the catalog has not moved since.
+uint32_t sd_storage_enqueue_list(uint32_t since_generation = 0);
 uint32_t sd_storage_enqueue_delete(const char *name);
-uint32_t sd_storage_enqueue_upload(const char *name, uint8_t *buffer, size_t size);
 uint32_t sd_storage_enqueue_display(const char *name);
 uint32_t sd_storage_enqueue_render_next(
     SdImageSelectMode mode,
@@ -46,12 +54,34 @@ uint32_t sd_storage_enqueue_render_next(
     const char *last_name
 );
 
+// Pick the next image and preload it into spare display memory (always-on idle).
+uint32_t sd_storage_enqueue_stage_next(SdImageSelectMode mode);
+
+// Redraw photo overlays whose content changed (clock tick) with a partial refresh.
+uint32_t sd_storage_enqueue_overlays();
+
+// Show several images (2..4 valid .g4 names) as one collage.
+uint32_t sd_storage_enqueue_collage(const NameList &names);
+
+// Stream a blob from the container into the queue file `name` (header checked,
+// written to a temp file and renamed into place), without buffering it whole.
+uint32_t sd_storage_enqueue_download(const char *container_sas_url, const char *blob_name, const char *name);
+
+// Stream an upload of `size` bytes into the queue file `name` (same checks as a
+// download). begin queues the job, write hands over the body in order and end
+// commits it, or drops it when `commit` is false. The worker writes fixed-size
+// chunks as they arrive; write blocks while all of them are in flight and
+// fails once the worker gave up (rejected file, SD busy for too long).
+uint32_t sd_storage_upload_begin(const char *name, size_t size);
+bool sd_storage_upload_write(uint32_t job_id, const uint8_t *data, size_t len);
+bool sd_storage_upload_end(uint32_t job_id, bool commit);
+
 // Re-sync SD contents from Azure Blob Storage. Intended for manual recovery.
 // Downloads blobs from all/temporary and all/permanent, excluding queued items
 // and expired temporaries when time is valid, then writes them to SD.
 uint32_t sd_storage_enqueue_sync_from_azure(const char *container_sas_url);
 
 bool sd_storage_get_job(uint32_t id, SdJobInfo *out);
-bool sd_storage_get_job_names(uint32_t id, std::vector<String> &out_names);
+bool sd_storage_get_job_names(uint32_t id, NameList &out_names);
 
 void sd_storage_purge_jobs();
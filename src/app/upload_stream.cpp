@@ -0,0 +1,102 @@
+#include "upload_stream.h"
+
+#include "log_manager.h"
+
+#include <esp_heap_caps.h>
+
+namespace {
+// Make sure the sender holds a chunk to fill, waiting for the worker to hand
+// one back while all of them are in flight.
+static bool take_chunk(UploadStream *stream) {
+    const uint32_t start_ms = millis();
+    while (!stream->closed) {
+        if (stream->filling) return true;
+        UploadChunk *chunk = nullptr;
+        if (xQueueReceive(stream->free_chunks, &chunk, pdMS_TO_TICKS(50)) == pdTRUE) {
+            chunk->len = 0;
+            chunk->last = false;
+            stream->filling = chunk;
+            return true;
+        }
+        if (millis() - start_ms >= kUploadStallMs) {
+            LOGW("SDJob", "Upload stalled, SD busy");
+            return false;
+        }
+    }
+    return false;
+}
+} // namespace
+
+void upload_stream_free(UploadStream *stream) {
+    if (!stream) return;
+    if (stream->free_chunks) vQueueDelete(stream->free_chunks);
+    if (stream->full_chunks) vQueueDelete(stream->full_chunks);
+    if (stream->pool) heap_caps_free(stream->pool);
+    delete stream;
+}
+
+UploadStream *upload_stream_alloc(uint32_t size) {
+    UploadStream *stream = new UploadStream();
+    if (!stream) return nullptr;
+    const size_t pool_bytes = kUploadChunks * kUploadChunkBytes;
+    stream->pool = static_cast<uint8_t*>(heap_caps_malloc(pool_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!stream->pool) {
+        stream->pool = static_cast<uint8_t*>(heap_caps_malloc(pool_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+    stream->free_chunks = xQueueCreate(kUploadChunks, sizeof(UploadChunk *));
+    stream->full_chunks = xQueueCreate(kUploadChunks, sizeof(UploadChunk *));
+    if (!stream->pool || !stream->free_chunks || !stream->full_chunks) {
+        LOGE("SDJob", "Upload stream alloc failed (%u bytes)", (unsigned)pool_bytes);
+        upload_stream_free(stream);
+        return nullptr;
+    }
+    for (size_t i = 0; i < kUploadChunks; i++) {
+        UploadChunk *chunk = &stream->chunks[i];
+        chunk->data = stream->pool + i * kUploadChunkBytes;
+        xQueueSend(stream->free_chunks, &chunk, 0);
+    }
+    stream->size = size;
+    return stream;
+}
+
+bool upload_stream_write(UploadStream *stream, const uint8_t *data, size_t len) {
+    if (!stream || stream->closed) return false;
+    while (len > 0) {
+        if (!take_chunk(stream)) return false;
+        UploadChunk *chunk = stream->filling;
+        const size_t n = min(len, kUploadChunkBytes - chunk->len);
+        memcpy(chunk->data + chunk->len, data, n);
+        chunk->len += n;
+        data += n;
+        len -= n;
+        if (chunk->len == kUploadChunkBytes) {
+            stream->filling = nullptr;
+            xQueueSend(stream->full_chunks, &chunk, portMAX_DELAY);
+        }
+    }
+    return true;
+}
+
+bool upload_stream_end(UploadStream *stream, bool commit) {
+    if (!stream || stream->closed) return false;
+    if (!commit) {
+        stream->aborted = true;
+        return true;
+    }
+    if (!take_chunk(stream)) return false;
+    UploadChunk *chunk = stream->filling;
+    chunk->last = true;
+    stream->filling = nullptr;
+    xQueueSend(stream->full_chunks, &chunk, portMAX_DELAY);
+    return true;
+}
+
+UploadChunk *upload_stream_receive(UploadStream *stream, uint32_t timeout_ms) {
+    UploadChunk *chunk = nullptr;
+    if (xQueueReceive(stream->full_chunks, &chunk, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) return nullptr;
+    return chunk;
+}
+
+void upload_stream_release(UploadStream *stream, UploadChunk *chunk) {
+    xQueueSend(stream->free_chunks, &chunk, 0);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+// A portal upload on its way to the SD worker. The body travels in chunks
+// that cycle between two queues: the sender (async_tcp) takes one from
+// `free_chunks`, fills it and posts it to `full_chunks`; the worker writes it
+// to SD and hands it back. The sender blocks while all of them are in flight,
+// which bounds memory and throttles WiFi to the card.
+//
+// `aborted` is set by the sender when it drops the upload, `closed` by the
+// worker when it stops taking chunks. Whoever finishes last frees the stream.
+
+static constexpr size_t kUploadChunkBytes = 8 * 1024;
+static constexpr size_t kUploadChunks = 4;
+// How long the sender waits for a free chunk (it runs on the async_tcp task,
+// so keep this under the task watchdog).
+static constexpr uint32_t kUploadStallMs = 3000;
+
+struct UploadChunk {
+    uint8_t *data;
+    size_t len;
+    bool last;
+};
+
+struct UploadStream {
+    UploadChunk chunks[kUploadChunks] = {};
+    uint8_t *pool = nullptr;
+    QueueHandle_t free_chunks = nullptr;
+    QueueHandle_t full_chunks = nullptr;
+    uint32_t size = 0;
+    UploadChunk *filling = nullptr;  // sender only
+    volatile bool aborted = false;
+    volatile bool closed = false;
+};
+
+UploadStream *upload_stream_alloc(uint32_t size);
+void upload_stream_free(UploadStream *stream);
+
+// Sender: copy `data` into chunks, posting each one as it fills. False once
+// the worker closed the stream or no chunk came back within kUploadStallMs.
+bool upload_stream_write(UploadStream *stream, const uint8_t *data, size_t len);
+// Sender: post the partly filled chunk as the last one (commit), or just flag
+// the abort. The worker may free the stream at any time after this.
+bool upload_stream_end(UploadStream *stream, bool commit);
+
+// Worker: the next full chunk, or null after `timeout_ms`. Hand it back with
+// upload_stream_release once its bytes are written.
+UploadChunk *upload_stream_receive(UploadStream *stream, uint32_t timeout_ms);
+void upload_stream_release(UploadStream *stream, UploadChunk *chunk);
@@ -23,6 +23,9 @@ let currentPage = 'home'; // Current page: 'home', 'network', or 'firmware'
 
 let deviceInfoCache = null;
 let sdSelectedFile = null;
+// Last listing and its catalog generation; an unchanged catalog is not resent.
+let sdListGeneration = 0;
+let sdListFiles = [];
 
 /**
  * Scroll input into view when focused (prevents mobile keyboard from covering it)
@@ -695,6 +698,14 @@ async function loadConfig() {
         setValueIfExists('sleep_timeout_seconds', config.sleep_timeout_seconds);
         setValueIfExists('image_selection_mode', config.image_selection_mode);
         setCheckedIfExists('always_on', config.always_on);
+        setValueIfExists('refresh_clean_every', config.refresh_clean_every);
+        setValueIfExists('refresh_hist_delta_pct', config.refresh_hist_delta_pct);
+        setValueIfExists('refresh_init_hours', config.refresh_init_hours);
+        setValueIfExists('panel_levels', config.panel_levels);
+        setValueIfExists('photo_orientation', config.photo_orientation);
+        setCheckedIfExists('overlay_clock', config.overlay_clock);
+        setCheckedIfExists('overlay_battery', config.overlay_battery);
+        setCheckedIfExists('overlay_caption', config.overlay_caption);
 
         // MQTT settings
         setValueIfExists('mqtt_host', config.mqtt_host);
@@ -762,6 +773,9 @@ function extractFormFields(formData) {
     const fields = ['wifi_ssid', 'wifi_password', 'device_name', 'fixed_ip', 
                     'subnet_mask', 'gateway', 'dns1', 'dns2', 'dummy_setting',
                     'sleep_timeout_seconds', 'image_selection_mode', 'always_on',
+                    'refresh_clean_every', 'refresh_hist_delta_pct', 'refresh_init_hours',
+                    'panel_levels', 'photo_orientation',
+                    'overlay_clock', 'overlay_battery', 'overlay_caption',
                     'blob_sas_url',
                     'mqtt_host', 'mqtt_port', 'mqtt_username', 'mqtt_password', 'mqtt_interval_seconds',
                     'basic_auth_enabled', 'basic_auth_username', 'basic_auth_password',
@@ -801,6 +815,14 @@ function validateConfig(config) {
         }
     }
 
+    // Panel gray levels: blank (linear) or 16 comma-separated levels 0-15
+    if (config.panel_levels !== undefined && config.panel_levels.trim() !== '') {
+        const levels = config.panel_levels.split(',').map(v => v.trim());
+        if (levels.length !== 16 || !levels.every(v => /^\d+$/.test(v) && Number(v) <= 15)) {
+            return { valid: false, message: 'Panel gray levels need 16 comma-separated values from 0 to 15' };
+        }
+    }
+
     // Validate Basic Auth only if fields exist on this page
     if (config.basic_auth_enabled === true) {
         const user = (config.basic_auth_username || '').trim();
@@ -1142,10 +1164,13 @@ function sdRenderList(files) {
 
 async function sdLoadImages() {
     try {
-        const jobId = await sdStartJob(API_SD_IMAGES, { cache: 'no-cache' });
+        const url = sdListGeneration ? `${API_SD_IMAGES}?since=${sdListGeneration}` : API_SD_IMAGES;
+        const jobId = await sdStartJob(url, { cache: 'no-cache' });
         const data = await sdWaitJob(jobId, 60000);
         if (!data.ok) throw new Error(data.message || 'Failed to load SD images');
-        sdRenderList(data.files || []);
+        if (!data.unchanged) sdListFiles = data.files || [];
+        sdListGeneration = data.generation || 0;
+        sdRenderList(sdListFiles);
     } catch (e) {
         console.error('SD images load failed:', e);
         sdRenderList([]);
@@ -1186,7 +1211,7 @@ async function sdUploadImage() {
     showBusyOverlay('Uploading image...');
 
     try {
-        const jobId = await sdStartJob(API_SD_IMAGES, {
+        const jobId = await sdStartJob(`${API_SD_IMAGES}?size=${sdSelectedFile.size}`, {
             method: 'POST',
             body: formData
         });
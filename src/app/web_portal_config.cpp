@@ -7,6 +7,7 @@
 #include "config_manager.h"
 #include "device_telemetry.h"
 #include "log_manager.h"
+#include "panel_levels.h"
 #include "psram_json_allocator.h"
 #include "web_portal_json.h"
 #include "display_manager.h"
@@ -92,6 +93,18 @@ void handleGetConfig(AsyncWebServerRequest *request) {
         (*doc)["long_press_ms"] = current_config->long_press_ms;
         (*doc)["always_on"] = current_config->always_on;
 
+        // Photo refresh policy
+        (*doc)["refresh_clean_every"] = current_config->refresh_clean_every;
+        (*doc)["refresh_init_hours"] = current_config->refresh_init_hours;
+        (*doc)["refresh_hist_delta_pct"] = current_config->refresh_hist_delta_pct;
+        char panel_levels[CONFIG_PANEL_LEVELS_STR_MAX_LEN];
+        panel_levels_format(current_config->panel_levels, panel_levels, sizeof(panel_levels));
+        (*doc)["panel_levels"] = panel_levels;
+        (*doc)["photo_orientation"] = current_config->photo_orientation;
+        (*doc)["overlay_clock"] = (current_config->photo_overlays & CONFIG_OVERLAY_CLOCK) != 0;
+        (*doc)["overlay_battery"] = (current_config->photo_overlays & CONFIG_OVERLAY_BATTERY) != 0;
+        (*doc)["overlay_caption"] = (current_config->photo_overlays & CONFIG_OVERLAY_CAPTION) != 0;
+
         // MQTT settings (password not returned)
         (*doc)["mqtt_host"] = current_config->mqtt_host;
         (*doc)["mqtt_port"] = current_config->mqtt_port;
@@ -332,6 +345,96 @@ void handlePostConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len,
         }
     }
 
+    // Photo refresh policy
+    if (doc.containsKey("refresh_clean_every")) {
+        if (doc["refresh_clean_every"].is<const char*>()) {
+            const char* v = doc["refresh_clean_every"];
+            current_config->refresh_clean_every = (uint8_t)constrain(atoi(v ? v : "0"), 0, 255);
+        } else {
+            current_config->refresh_clean_every = (uint8_t)constrain((int)(doc["refresh_clean_every"] | 0), 0, 255);
+        }
+    }
+
+    if (doc.containsKey("refresh_init_hours")) {
+        if (doc["refresh_init_hours"].is<const char*>()) {
+            const char* v = doc["refresh_init_hours"];
+            current_config->refresh_init_hours = (uint16_t)constrain(atoi(v ? v : "0"), 0, 65535);
+        } else {
+            current_config->refresh_init_hours = (uint16_t)constrain((int)(doc["refresh_init_hours"] | 0), 0, 65535);
+        }
+    }
+
+    if (doc.containsKey("refresh_hist_delta_pct")) {
+        if (doc["refresh_hist_delta_pct"].is<const char*>()) {
+            const char* v = doc["refresh_hist_delta_pct"];
+            current_config->refresh_hist_delta_pct = (uint8_t)constrain(atoi(v ? v : "0"), 0, 100);
+        } else {
+            current_config->refresh_hist_delta_pct = (uint8_t)constrain((int)(doc["refresh_hist_delta_pct"] | 0), 0, 100);
+        }
+    }
+
+    // Panel gray levels: "0,1,...,15" or an array of 16 levels (empty string = identity)
+    if (doc.containsKey("panel_levels")) {
+        uint8_t levels[CONFIG_PANEL_LEVELS];
+        bool ok = false;
+        if (doc["panel_levels"].is<JsonArray>()) {
+            JsonArray arr = doc["panel_levels"].as<JsonArray>();
+            ok = arr.size() == CONFIG_PANEL_LEVELS;
+            for (size_t i = 0; ok && i < CONFIG_PANEL_LEVELS; i++) {
+                const int v = arr[i] | -1;
+                ok = v >= 0 && v <= 15;
+                levels[i] = (uint8_t)v;
+            }
+        } else {
+            const char* v = doc["panel_levels"] | "";
+            if (v[0] == '\0') {
+                panel_levels_identity(levels);
+                ok = true;
+            } else {
+                ok = panel_levels_parse(v, levels);
+            }
+        }
+        if (!ok) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"panel_levels needs 16 values 0-15\"}");
+            portENTER_CRITICAL(&g_config_post_mux);
+            config_post_reset();
+            portEXIT_CRITICAL(&g_config_post_mux);
+            return;
+        }
+        memcpy(current_config->panel_levels, levels, sizeof(levels));
+    }
+
+    if (doc.containsKey("photo_orientation")) {
+        if (doc["photo_orientation"].is<const char*>()) {
+            const char* v = doc["photo_orientation"];
+            current_config->photo_orientation = (uint8_t)constrain(atoi(v ? v : "0"), 0, CONFIG_PHOTO_ORIENTATION_MAX);
+        } else {
+            current_config->photo_orientation = (uint8_t)constrain((int)(doc["photo_orientation"] | 0), 0, CONFIG_PHOTO_ORIENTATION_MAX);
+        }
+    }
+
+    // Photo overlays: one checkbox per CONFIG_OVERLAY_* bit
+    static const struct { const char *key; uint8_t bit; } kOverlayFields[] = {
+        {"overlay_clock", CONFIG_OVERLAY_CLOCK},
+        {"overlay_battery", CONFIG_OVERLAY_BATTERY},
+        {"overlay_caption", CONFIG_OVERLAY_CAPTION},
+    };
+    for (const auto &field : kOverlayFields) {
+        if (!doc.containsKey(field.key)) continue;
+        bool on;
+        if (doc[field.key].is<const char*>()) {
+            const char* v = doc[field.key];
+            on = (v && (strcmp(v, "1") == 0 || strcasecmp(v, "true") == 0 || strcasecmp(v, "on") == 0));
+        } else {
+            on = (bool)(doc[field.key] | false);
+        }
+        if (on) {
+            current_config->photo_overlays |= field.bit;
+        } else {
+            current_config->photo_overlays &= (uint8_t)~field.bit;
+        }
+    }
+
     // MQTT host
     if (doc.containsKey("mqtt_host")) {
         strlcpy(current_config->mqtt_host, doc["mqtt_host"] | "", CONFIG_MQTT_HOST_MAX_LEN);
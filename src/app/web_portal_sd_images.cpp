@@ -1,5 +1,6 @@
 #include "web_portal_sd_images.h"
 
+#include "it8951_renderer.h"
 #include "sd_storage_service.h"
 #include "web_portal_auth.h"
 #include "web_portal_json.h"
@@ -7,19 +8,19 @@
 #include "log_manager.h"
 #include "time_utils.h"
 
-#include <esp_heap_caps.h>
-
 namespace {
 static constexpr size_t kMaxG4UploadBytes = 2 * 1024 * 1024;
 static constexpr size_t kMaxG4NameLen = 127;
 
+// Lives in request->_tempObject while the body streams to the SD worker. Plain
+// data from calloc: the request frees it if the client goes away mid-upload.
 struct UploadState {
-    uint8_t *buffer = nullptr;
-    size_t size = 0;
-    size_t capacity = 0;
-    bool error = false;
-    bool responded = false;
-    char name[kMaxG4NameLen + 1] = {0};
+    uint32_t job_id;
+    size_t expected;
+    size_t received;
+    bool error;
+    bool responded;
+    char name[kMaxG4NameLen + 1];
 };
 
 static bool is_valid_g4_name(const String &name) {
@@ -52,13 +53,17 @@ static void send_upload_error(AsyncWebServerRequest *request, UploadState *state
     state->responded = true;
 }
 
-static void free_upload_state(UploadState *state) {
+static void free_upload_state(AsyncWebServerRequest *request, UploadState *state) {
     if (!state) return;
-    if (state->buffer) {
-        heap_caps_free(state->buffer);
-        state->buffer = nullptr;
-    }
-    delete state;
+    free(state);
+    request->_tempObject = nullptr;
+}
+
+// Drop the upload job's file and stop reading the rest of the body into it.
+static void fail_upload(AsyncWebServerRequest *request, UploadState *state, int code, const char *msg) {
+    if (!state->error && state->job_id) sd_storage_upload_end(state->job_id, false);
+    state->error = true;
+    send_upload_error(request, state, code, msg);
 }
 
 static void send_job_queued(AsyncWebServerRequest *request, uint32_t job_id) {
@@ -90,6 +95,10 @@ static const char *job_type_str(SdJobType type) {
         case SdJobType::Display: return "display";
         case SdJobType::RenderNext: return "render_next";
         case SdJobType::SyncFromAzure: return "sync";
+        case SdJobType::StageNext: return "stage_next";
+        case SdJobType::Overlays: return "overlays";
+        case SdJobType::Collage: return "collage";
+        case SdJobType::Download: return "download";
         default: return "unknown";
     }
 }
@@ -97,8 +106,11 @@ static const char *job_type_str(SdJobType type) {
 
 void handleGetSdImages(AsyncWebServerRequest *request) {
     if (!portal_auth_gate(request)) return;
-    const uint32_t job_id = sd_storage_enqueue_list();
-    LOGI("API", "GET /api/sd/images -> job %lu", (unsigned long)job_id);
+    const uint32_t since = request->hasParam("since")
+        ? static_cast<uint32_t>(request->getParam("since")->value().toInt())
+        : 0;
+    const uint32_t job_id = sd_storage_enqueue_list(since);
+    LOGI("API", "GET /api/sd/images -> job %lu since=%lu", (unsigned long)job_id, (unsigned long)since);
     send_job_queued(request, job_id);
 }
 
@@ -122,10 +134,44 @@ void handleDeleteSdImage(AsyncWebServerRequest *request) {
     send_job_queued(request, job_id);
 }
 
+// `names`: comma separated, 2..kCollageMaxCells images shown as one collage.
+static void enqueue_collage_display(AsyncWebServerRequest *request, const String &list) {
+    NameList names;
+    int start = 0;
+    while (start <= (int)list.length()) {
+        int comma = list.indexOf(',', start);
+        if (comma < 0) comma = list.length();
+        String name = list.substring(start, comma);
+        name.trim();
+        if (!is_valid_g4_name(name) || names.size() >= kCollageMaxCells) {
+            LOGW("API", "POST /api/sd/images/display: invalid collage %s", list.c_str());
+            web_portal_send_json_error(request, 400, "Invalid names");
+            return;
+        }
+        if (!names.push_back(name.c_str())) {
+            web_portal_send_json_error(request, 503, "Out of memory");
+            return;
+        }
+        start = comma + 1;
+    }
+    if (names.size() < 2) {
+        web_portal_send_json_error(request, 400, "Collage needs at least 2 names");
+        return;
+    }
+
+    const uint32_t job_id = sd_storage_enqueue_collage(names);
+    LOGI("API", "POST /api/sd/images/display -> job %lu collage of %u", (unsigned long)job_id, (unsigned)names.size());
+    send_job_queued(request, job_id);
+}
+
 void handleDisplaySdImage(AsyncWebServerRequest *request) {
     LOGI("API", "Display request received");
     if (!portal_auth_gate(request)) return;
 
+    if (request->hasParam("names")) {
+        enqueue_collage_display(request, request->getParam("names")->value());
+        return;
+    }
     if (!request->hasParam("name")) {
         LOGW("API", "POST /api/sd/images/display: missing name");
         web_portal_send_json_error(request, 400, "Missing name");
@@ -160,73 +206,75 @@ void handleUploadSdImage(AsyncWebServerRequest *request, String filename, size_t
             return;
         }
 
-        const size_t total = request->contentLength();
-        if (total == 0 || total > kMaxG4UploadBytes) {
-            LOGW("API", "POST /api/sd/images: file too large %s", filename.c_str());
+        // The file size is needed up front: the header is checked against it
+        // before the first block reaches SD.
+        if (!request->hasParam("size")) {
+            web_portal_send_json_error(request, 400, "Missing size");
+            return;
+        }
+        const long size = request->getParam("size")->value().toInt();
+        if (size <= 0 || (size_t)size > kMaxG4UploadBytes || (size_t)size > request->contentLength()) {
+            LOGW("API", "POST /api/sd/images: bad size %ld for %s", size, filename.c_str());
             web_portal_send_json_error(request, 413, "File too large");
             return;
         }
 
-        state = new UploadState();
+        state = static_cast<UploadState*>(calloc(1, sizeof(UploadState)));
         if (!state) {
             web_portal_send_json_error(request, 503, "Out of memory");
             return;
         }
         request->_tempObject = state;
         strlcpy(state->name, target_name.c_str(), sizeof(state->name));
-        LOGI("API", "POST /api/sd/images: start %s bytes=%u", state->name, (unsigned)total);
-        state->capacity = total;
-        state->buffer = static_cast<uint8_t *>(heap_caps_malloc(total, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-        if (!state->buffer) {
-            state->buffer = static_cast<uint8_t *>(heap_caps_malloc(total, MALLOC_CAP_8BIT));
-        }
-        if (!state->buffer) {
-            web_portal_send_json_error(request, 503, "Out of memory");
-            free_upload_state(state);
-            request->_tempObject = nullptr;
-            return;
+        state->expected = (size_t)size;
+        state->job_id = sd_storage_upload_begin(state->name, state->expected);
+        if (state->job_id == 0) {
+            state->error = true;
+            send_upload_error(request, state, 503, "Queue full");
+        } else {
+            LOGI("API", "POST /api/sd/images: start %s bytes=%u job=%lu", state->name, (unsigned)state->expected, (unsigned long)state->job_id);
         }
     }
 
     if (!state) return;
     if (state->error) {
-        if (final) {
-            free_upload_state(state);
-            request->_tempObject = nullptr;
-        }
+        if (final) free_upload_state(request, state);
         return;
     }
 
-    if (state->size + len > state->capacity) {
+    if (state->received + len > state->expected) {
         LOGW("API", "POST /api/sd/images: payload overflow %s", state->name);
-        state->error = true;
-        send_upload_error(request, state, 413, "File too large");
-        if (final) {
-            free_upload_state(state);
-            request->_tempObject = nullptr;
-        }
+        fail_upload(request, state, 413, "File too large");
+        if (final) free_upload_state(request, state);
         return;
     }
 
-    if (len) {
-        memcpy(state->buffer + state->size, data, len);
-        state->size += len;
+    // Blocks while the SD worker is behind, which holds back the TCP window.
+    if (len && !sd_storage_upload_write(state->job_id, data, len)) {
+        SdJobInfo info = {};
+        if (sd_storage_get_job(state->job_id, &info) && info.state == SdJobState::Error) {
+            LOGW("API", "POST /api/sd/images: rejected %s (%s)", state->name, info.message);
+            fail_upload(request, state, 400, info.message[0] ? info.message : "Upload failed");
+        } else {
+            LOGW("API", "POST /api/sd/images: SD busy for %s", state->name);
+            fail_upload(request, state, 503, "SD busy");
+        }
+        if (final) free_upload_state(request, state);
+        return;
     }
+    state->received += len;
 
     if (final) {
-        uint32_t job_id = sd_storage_enqueue_upload(state->name, state->buffer, state->size);
-        if (job_id == 0) {
-            send_upload_error(request, state, 503, "Queue full");
-            free_upload_state(state);
+        if (state->received != state->expected) {
+            LOGW("API", "POST /api/sd/images: size mismatch %s (%u/%u)", state->name, (unsigned)state->received, (unsigned)state->expected);
+            fail_upload(request, state, 400, "Size mismatch");
+        } else if (!sd_storage_upload_end(state->job_id, true)) {
+            fail_upload(request, state, 503, "SD busy");
         } else {
-            state->buffer = nullptr;
-            state->capacity = 0;
-            state->size = 0;
-            LOGI("API", "POST /api/sd/images: queued job %lu name=%s", (unsigned long)job_id, state->name);
-            send_job_queued(request, job_id);
-            free_upload_state(state);
+            LOGI("API", "POST /api/sd/images: sent job %lu name=%s", (unsigned long)state->job_id, state->name);
+            send_job_queued(request, state->job_id);
         }
-        request->_tempObject = nullptr;
+        free_upload_state(request, state);
     }
 }
 
@@ -244,7 +292,7 @@ void handleGetSdJobStatus(AsyncWebServerRequest *request) {
         return;
     }
 
-    std::vector<String> names;
+    NameList names;
     const bool has_names = sd_storage_get_job_names(id, names);
 
     const size_t count = names.size();
@@ -264,10 +312,17 @@ void handleGetSdJobStatus(AsyncWebServerRequest *request) {
     if (info.message[0]) {
         (*doc)["message"] = info.message;
     }
+    if (info.generation) {
+        (*doc)["generation"] = info.generation;
+    }
+    if (info.unchanged) {
+        (*doc)["unchanged"] = true;
+    }
     if (has_names) {
         JsonArray files = (*doc).createNestedArray("files");
-        for (const auto &name : names) {
-            files.add(name);
+        for (size_t i = 0; i < names.size(); i++) {
+            // char * so the document keeps a copy; it is serialized after `names` is gone.
+            files.add(const_cast<char *>(names[i]));
         }
     }
 
@@ -0,0 +1,92 @@
+"""ctypes binding for the native G4 codec (tools/g4codec, built from src/app).
+
+Build once with:
+    cmake -S tools/g4codec -B tools/g4codec/build && cmake --build tools/g4codec/build
+
+The library is looked up in $G4CODEC_LIB, then tools/g4codec/build. When it is
+missing, `available()` is False and callers keep their pure-Python loops.
+Native dithering is the firmware's fixed-point code, so frames match what the
+device produces. Bayer is identical either way. Floyd-Steinberg stays within
+one level per pixel of the float Python version, with the same mean level
+(tools/g4codec/tests/test_dither.py).
+"""
+
+import ctypes
+import os
+from pathlib import Path
+from typing import Optional
+
+DITHER_NONE = 0
+DITHER_BAYER = 1
+DITHER_FS = 2
+DITHER_BLUE_NOISE = 3
+
+_LIB_NAMES = ("libg4codec.so", "libg4codec.dylib", "g4codec.dll")
+_lib: Optional[ctypes.CDLL] = None
+_loaded = False
+
+
+def _load() -> Optional[ctypes.CDLL]:
+    global _lib, _loaded
+    if _loaded:
+        return _lib
+    _loaded = True
+    candidates = []
+    env = os.environ.get("G4CODEC_LIB")
+    if env:
+        candidates.append(Path(env))
+    build_dir = Path(__file__).resolve().parent / "g4codec" / "build"
+    candidates += [build_dir / name for name in _LIB_NAMES]
+    for path in candidates:
+        if not path.is_file():
+            continue
+        try:
+            lib = ctypes.CDLL(str(path))
+        except OSError:
+            continue
+        u8p = ctypes.c_char_p
+        lib.g4codec_dither.argtypes = [u8p, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_int]
+        lib.g4codec_dither.restype = ctypes.c_int
+        lib.g4codec_pack.argtypes = [u8p, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_void_p]
+        lib.g4codec_pack.restype = None
+        lib.g4codec_g4z_encode_strip.argtypes = [u8p, ctypes.c_size_t, ctypes.c_size_t, ctypes.c_void_p, ctypes.c_size_t]
+        lib.g4codec_g4z_encode_strip.restype = ctypes.c_size_t
+        lib.g4codec_tile_hashes.argtypes = [u8p, ctypes.c_uint16, ctypes.c_uint16, ctypes.c_void_p]
+        lib.g4codec_tile_hashes.restype = None
+        _lib = lib
+        break
+    return _lib
+
+
+def available() -> bool:
+    return _load() is not None
+
+
+def dither(gray: bytes, width: int, height: int, mode: int) -> bytes:
+    """Dithered gray (level * 17 per pixel), same layout as the input."""
+    out = ctypes.create_string_buffer(width * height)
+    if _load().g4codec_dither(gray, out, width, height, mode) != 0:
+        raise RuntimeError("g4codec_dither failed")
+    return out.raw
+
+
+def pack(gray: bytes, width: int, height: int) -> bytes:
+    out = ctypes.create_string_buffer(width * height // 2)
+    _load().g4codec_pack(gray, width, height, out)
+    return out.raw
+
+
+def g4z_encode_strip(strip: bytes, row_bytes: int) -> bytes:
+    cap = len(strip) + len(strip) // 4 + len(strip) // 128 + 2
+    out = ctypes.create_string_buffer(cap)
+    n = _load().g4codec_g4z_encode_strip(strip, len(strip), row_bytes, out, cap)
+    if n == 0 and strip:
+        raise RuntimeError("g4codec_g4z_encode_strip failed")
+    return out.raw[:n]
+
+
+def tile_hashes(packed: bytes, width: int, height: int) -> list[int]:
+    count = ((width + 63) // 64) * ((height + 63) // 64)
+    out = (ctypes.c_uint32 * count)()
+    _load().g4codec_tile_hashes(packed, width, height, out)
+    return list(out)
@@ -0,0 +1,165 @@
+#include "g4codec.h"
+
+#include "g4_dither.h"
+#include "g4_file.h"
+#include "g4z_codec.h"
+
+#include <string.h>
+
+#include <vector>
+
+namespace {
+static constexpr uint16_t kStripRows = 16;
+static constexpr uint16_t kTileSize = 64;
+static constexpr uint8_t kWhiteLevel = 0x0F;
+
+static bool dither_levels(const uint8_t *gray, uint8_t *levels, uint32_t width, uint32_t height, int mode) {
+    if (!gray || !levels || width == 0 || width > 0xFFFF) return false;
+    G4Dither d;
+    if (!g4_dither_begin(d, (G4DitherMode)mode, (uint16_t)width)) return false;
+    for (uint32_t y = 0; y < height; y++) {
+        g4_dither_row(d, gray + (size_t)y * width, levels + (size_t)y * width);
+    }
+    g4_dither_end(d);
+    return true;
+}
+
+static void put32(std::vector<uint8_t> &out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+// Same layout and table order as encode_g4_file() in tools/jpg_to_g4.py.
+static bool encode_container(const std::vector<uint8_t> &packed, uint16_t width, uint16_t height,
+                             const G4CodecOptions &opt, bool full_frame, std::vector<uint8_t> &file) {
+    const size_t row_bytes = width / 2;
+    const size_t strip_bytes = row_bytes * kStripRows;
+    const uint16_t strip_count = (uint16_t)((height + kStripRows - 1) / kStripRows);
+
+    std::vector<uint8_t> tables;
+    std::vector<uint8_t> payload;
+    if (opt.g4z) {
+        std::vector<uint16_t> scratch(g4z_encode_scratch_entries(strip_bytes));
+        std::vector<uint8_t> encoded(g4z_max_encoded_size(strip_bytes));
+        put32(tables, 0);
+        for (uint16_t s = 0; s < strip_count; s++) {
+            const size_t start = s * strip_bytes;
+            const size_t len = packed.size() - start < strip_bytes ? packed.size() - start : strip_bytes;
+            const size_t n = g4z_encode_strip(packed.data() + start, len, row_bytes,
+                                              encoded.data(), encoded.size(), scratch.data());
+            if (n == 0) return false;
+            payload.insert(payload.end(), encoded.begin(), encoded.begin() + n);
+            put32(tables, (uint32_t)payload.size());
+        }
+    } else {
+        payload = packed;
+    }
+    for (uint16_t s = 0; s < strip_count; s++) {
+        const size_t start = s * strip_bytes;
+        const size_t len = packed.size() - start < strip_bytes ? packed.size() - start : strip_bytes;
+        put32(tables, g4_file_crc32(0, packed.data() + start, len));
+    }
+
+    G4FileHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = kG4FileMagic;
+    h.version = kG4FileVersion;
+    h.encoding = (uint8_t)(opt.g4z ? G4Encoding::G4z : G4Encoding::Raw);
+    h.variant = opt.variant;
+    h.flags = kG4FileHasStripCrc;
+    h.width = width;
+    h.height = height;
+    h.x = full_frame ? 0 : opt.box_x;
+    h.y = full_frame ? 0 : opt.box_y;
+    h.strip_rows = kStripRows;
+    h.strip_count = strip_count;
+    h.background = kWhiteLevel;
+    if (full_frame) {
+        h.flags |= kG4FileHasTileHashes;
+        h.tile_size = kTileSize;
+        std::vector<uint32_t> hashes(g4_file_tile_count(h));
+        g4_file_tile_hashes(packed.data(), width, height, kTileSize, hashes.data());
+        for (uint32_t v : hashes) put32(tables, v);
+    }
+    h.header_bytes = (uint32_t)(sizeof(h) + tables.size());
+    h.payload_bytes = (uint32_t)payload.size();
+
+    file.resize(sizeof(h));
+    memcpy(file.data(), &h, sizeof(h));
+    file.insert(file.end(), tables.begin(), tables.end());
+    file.insert(file.end(), payload.begin(), payload.end());
+    return true;
+}
+} // namespace
+
+extern "C" {
+
+int g4codec_dither(const uint8_t *gray, uint8_t *out, uint32_t width, uint32_t height, int mode) {
+    if (!out) return -1;
+    if (!dither_levels(gray, out, width, height, mode)) return -1;
+    for (size_t i = 0; i < (size_t)width * height; i++) out[i] *= 17;
+    return 0;
+}
+
+void g4codec_pack(const uint8_t *gray, uint32_t width, uint32_t height, uint8_t *packed) {
+    const size_t count = (size_t)width * height;
+    for (size_t i = 0; i + 1 < count; i += 2) {
+        packed[i / 2] = (uint8_t)((gray[i] & 0xF0) | (gray[i + 1] >> 4));
+    }
+}
+
+size_t g4codec_g4z_encode_strip(const uint8_t *strip, size_t len, size_t row_bytes,
+                                uint8_t *out, size_t out_cap) {
+    std::vector<uint16_t> scratch(g4z_encode_scratch_entries(len));
+    return g4z_encode_strip(strip, len, row_bytes, out, out_cap, scratch.data());
+}
+
+void g4codec_tile_hashes(const uint8_t *packed, uint16_t width, uint16_t height, uint32_t *out) {
+    g4_file_tile_hashes(packed, width, height, kTileSize, out);
+}
+
+size_t g4codec_max_output_bytes(uint16_t panel_w, uint16_t panel_h) {
+    const size_t frame = (size_t)panel_w / 2 * panel_h;
+    const size_t strips = (panel_h + kStripRows - 1) / kStripRows;
+    const size_t tiles = (size_t)((panel_w + kTileSize - 1) / kTileSize) * ((panel_h + kTileSize - 1) / kTileSize);
+    return sizeof(G4FileHeader) + 4 * (2 * strips + 1 + tiles) + g4z_max_encoded_size(frame) + strips;
+}
+
+size_t g4codec_convert(const uint8_t *gray, uint16_t panel_w, uint16_t panel_h,
+                       const G4CodecOptions *options, uint8_t *out, size_t out_cap) {
+    if (!gray || !options || !out || (panel_w & 1) || panel_h == 0) return 0;
+    const G4CodecOptions &opt = *options;
+    uint16_t bx = 0, by = 0, bw = panel_w, bh = panel_h;
+    if (opt.box_w != 0) {
+        if ((opt.box_x & 3) || (opt.box_w & 3) || opt.box_h == 0 ||
+            (uint32_t)opt.box_x + opt.box_w > panel_w || (uint32_t)opt.box_y + opt.box_h > panel_h) {
+            return 0;
+        }
+        bx = opt.box_x;
+        by = opt.box_y;
+        bw = opt.box_w;
+        bh = opt.box_h;
+    }
+    const bool full_frame = bw == panel_w && bh == panel_h;
+
+    std::vector<uint8_t> levels((size_t)panel_w * panel_h);
+    if (!dither_levels(gray, levels.data(), panel_w, panel_h, opt.dither)) return 0;
+
+    // Panel row Y is canvas row H-1-Y, mirrored; the box is in panel coordinates.
+    std::vector<uint8_t> packed((size_t)bw / 2 * bh);
+    for (uint16_t r = 0; r < bh; r++) {
+        const uint8_t *src = levels.data() + (size_t)(panel_h - 1 - (by + r)) * panel_w + (panel_w - bx - bw);
+        g4_pack_levels(src, bw, packed.data() + (size_t)r * (bw / 2), true);
+    }
+
+    std::vector<uint8_t> file;
+    if (opt.header || opt.g4z || !full_frame) {
+        if (!encode_container(packed, bw, bh, opt, full_frame, file)) return 0;
+    } else {
+        file.swap(packed);
+    }
+    if (file.size() > out_cap) return 0;
+    memcpy(out, file.data(), file.size());
+    return file.size();
+}
+
+} // extern "C"
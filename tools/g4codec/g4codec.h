@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Host-side G4 codec: the firmware's dithering, packing, G4Z and container code
+// (src/app/g4_dither, g4z_codec, g4_file) behind a small C ABI, for the g4conv
+// CLI and for the Python tools via ctypes (tools/g4codec.py).
+//
+// Gray buffers are 8-bit, row-major, in canvas orientation (before the panel's
+// 180 degree rotation), like the PIL images in tools/jpg_to_g4.py.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Dither modes, same values as G4DitherMode / G4_DITHER_MODE.
+enum {
+    G4CODEC_DITHER_NONE = 0,
+    G4CODEC_DITHER_BAYER = 1,
+    G4CODEC_DITHER_FS = 2,
+    G4CODEC_DITHER_BLUE_NOISE = 3,
+};
+
+typedef struct {
+    int dither;          // G4CODEC_DITHER_*
+    int header;          // write the G4 container (otherwise headerless packed rows)
+    int g4z;             // G4Z payload (implies header)
+    uint8_t variant;     // informational header field (tools/jpg_to_g4.py G4_VARIANT_IDS)
+    uint16_t box_x;      // sub-frame in panel coordinates, multiple of 4; box_w == 0 stores the full frame
+    uint16_t box_y;
+    uint16_t box_w;      // multiple of 4
+    uint16_t box_h;
+} G4CodecOptions;
+
+// Dither `gray` into `out` as level * 17 (what the Python helpers return).
+// `out` may alias `gray`. Returns 0 on success.
+int g4codec_dither(const uint8_t *gray, uint8_t *out, uint32_t width, uint32_t height, int mode);
+
+// Pack gray >> 4, two pixels per byte (tools/jpg_to_g4.py pack_g4). Width even.
+void g4codec_pack(const uint8_t *gray, uint32_t width, uint32_t height, uint8_t *packed);
+
+// One G4Z strip; returns the encoded size (0 if `out_cap` is too small).
+size_t g4codec_g4z_encode_strip(const uint8_t *strip, size_t len, size_t row_bytes,
+                                uint8_t *out, size_t out_cap);
+
+// 64x64 tile hash table of a packed frame.
+void g4codec_tile_hashes(const uint8_t *packed, uint16_t width, uint16_t height, uint32_t *out);
+
+// Upper bound of g4codec_convert() output for a panel.
+size_t g4codec_max_output_bytes(uint16_t panel_w, uint16_t panel_h);
+
+// Full conversion of a panel-sized gray canvas: dither, rotate 180, crop to the
+// box, pack and (optionally) wrap in the container. Returns the file size, or 0
+// on invalid options / short `out`.
+size_t g4codec_convert(const uint8_t *gray, uint16_t panel_w, uint16_t panel_h,
+                       const G4CodecOptions *options, uint8_t *out, size_t out_cap);
+
+#ifdef __cplusplus
+}
+#endif
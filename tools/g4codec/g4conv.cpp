@@ -0,0 +1,194 @@
+// g4conv: batch-convert gray canvases (binary PGM, panel size) to .g4 with the
+// firmware's codec, one worker thread per core.
+//
+//   g4conv [--dither none|bayer|fs|blue-noise] [--variant NAME] [--header] [--g4z]
+//          [--box X,Y,W,H] [--jobs N] [-o OUTDIR] canvas.pgm...
+//
+// Canvases are the fitted + tone mapped photo before rotation (what
+// tools/jpg_to_g4.py dithers); the output is rotated 180 degrees like the tool.
+
+#include "g4codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Args {
+    G4CodecOptions options;
+    std::string out_dir;
+    unsigned jobs;
+    std::vector<std::string> inputs;
+};
+
+struct VariantName {
+    const char *name;
+    uint8_t id;
+    int dither;
+};
+
+// Same ids as G4_VARIANT_IDS in tools/jpg_to_g4.py.
+static const VariantName kVariants[] = {
+    {"base", 0, G4CODEC_DITHER_NONE},
+    {"opt", 1, G4CODEC_DITHER_NONE},
+    {"opt-bayer", 2, G4CODEC_DITHER_BAYER},
+    {"opt-fs", 3, G4CODEC_DITHER_FS},
+};
+
+static const char *kDitherNames[] = {"none", "bayer", "fs", "blue-noise"};
+
+static void usage() {
+    fprintf(stderr,
+            "usage: g4conv [--dither none|bayer|fs|blue-noise] [--variant base|opt|opt-bayer|opt-fs]\n"
+            "              [--header] [--g4z] [--box X,Y,W,H] [--jobs N] [-o OUTDIR] canvas.pgm...\n");
+}
+
+static bool parse_args(int argc, char **argv, Args &args) {
+    memset(&args.options, 0, sizeof(args.options));
+    args.options.variant = 2;
+    args.options.dither = G4CODEC_DITHER_BAYER;
+    args.jobs = std::thread::hardware_concurrency();
+    int dither = -1;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (!strcmp(a, "--header")) {
+            args.options.header = 1;
+        } else if (!strcmp(a, "--g4z")) {
+            args.options.g4z = 1;
+        } else if (!strcmp(a, "--dither") && has_value) {
+            const char *v = argv[++i];
+            for (int m = 0; m < 4; m++) {
+                if (!strcmp(v, kDitherNames[m])) dither = m;
+            }
+            if (dither < 0) return false;
+        } else if (!strcmp(a, "--variant") && has_value) {
+            const char *v = argv[++i];
+            bool found = false;
+            for (const VariantName &vn : kVariants) {
+                if (!strcmp(v, vn.name)) {
+                    args.options.variant = vn.id;
+                    args.options.dither = vn.dither;
+                    found = true;
+                }
+            }
+            if (!found) return false;
+        } else if (!strcmp(a, "--box") && has_value) {
+            unsigned x, y, w, h;
+            if (sscanf(argv[++i], "%u,%u,%u,%u", &x, &y, &w, &h) != 4) return false;
+            args.options.box_x = (uint16_t)x;
+            args.options.box_y = (uint16_t)y;
+            args.options.box_w = (uint16_t)w;
+            args.options.box_h = (uint16_t)h;
+        } else if (!strcmp(a, "--jobs") && has_value) {
+            args.jobs = (unsigned)atoi(argv[++i]);
+        } else if ((!strcmp(a, "-o") || !strcmp(a, "--output")) && has_value) {
+            args.out_dir = argv[++i];
+        } else if (a[0] == '-') {
+            return false;
+        } else {
+            args.inputs.push_back(a);
+        }
+    }
+    if (dither >= 0) args.options.dither = dither;
+    if (args.jobs == 0) args.jobs = 1;
+    return !args.inputs.empty();
+}
+
+static int read_token(FILE *f) {
+    int c = fgetc(f);
+    while (c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) c = fgetc(f);
+        }
+        c = fgetc(f);
+    }
+    int v = 0;
+    bool any = false;
+    while (c >= '0' && c <= '9') {
+        v = v * 10 + (c - '0');
+        any = true;
+        c = fgetc(f);
+    }
+    return any ? v : -1;
+}
+
+static bool read_pgm(const std::string &path, std::vector<uint8_t> &gray, int &w, int &h) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    bool ok = fgetc(f) == 'P' && fgetc(f) == '5';
+    w = ok ? read_token(f) : -1;
+    h = ok ? read_token(f) : -1;
+    const int maxval = ok ? read_token(f) : -1;
+    ok = ok && w > 0 && h > 0 && maxval == 255;
+    if (ok) {
+        gray.resize((size_t)w * h);
+        ok = fread(gray.data(), 1, gray.size(), f) == gray.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+static std::string output_path(const Args &args, const std::string &input) {
+    std::string name = input;
+    const size_t slash = name.find_last_of('/');
+    std::string dir = slash == std::string::npos ? std::string() : name.substr(0, slash + 1);
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+    const size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos) name = name.substr(0, dot);
+    if (!args.out_dir.empty()) dir = args.out_dir + "/";
+    return dir + name + ".g4";
+}
+
+static bool convert_one(const Args &args, const std::string &input) {
+    std::vector<uint8_t> gray;
+    int w = 0, h = 0;
+    if (!read_pgm(input, gray, w, h) || w > 0xFFFF || h > 0xFFFF) {
+        fprintf(stderr, "%s: not an 8-bit binary PGM\n", input.c_str());
+        return false;
+    }
+    std::vector<uint8_t> out(g4codec_max_output_bytes((uint16_t)w, (uint16_t)h));
+    const size_t n = g4codec_convert(gray.data(), (uint16_t)w, (uint16_t)h, &args.options, out.data(), out.size());
+    if (n == 0) {
+        fprintf(stderr, "%s: conversion failed (size/box)\n", input.c_str());
+        return false;
+    }
+    const std::string path = output_path(args, input);
+    FILE *f = fopen(path.c_str(), "wb");
+    const bool ok = f && fwrite(out.data(), 1, n, f) == n;
+    if (f) fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", path.c_str());
+        return false;
+    }
+    printf("%s -> %s (%zu bytes)\n", input.c_str(), path.c_str(), n);
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    Args args;
+    if (!parse_args(argc, argv, args)) {
+        usage();
+        return 2;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failed(0);
+    const unsigned workers = args.jobs < args.inputs.size() ? args.jobs : (unsigned)args.inputs.size();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < workers; t++) {
+        threads.emplace_back([&]() {
+            for (size_t i = next++; i < args.inputs.size(); i = next++) {
+                if (!convert_one(args, args.inputs[i])) failed++;
+            }
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+// Collage layout (src/app/collage_plan): every plan has to stay inside its
+// source and its cell with the alignment the load path needs, and the
+// streamed k x k average has to match averaging the cropped source directly.
+
+#include "collage_plan.h"
+
+#include <stdio.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+static int g_failures = 0;
+
+static void fail(const char *name, const char *what) {
+    fprintf(stderr, "FAIL %s: %s\n", name, what);
+    g_failures++;
+}
+
+static uint8_t get_px(const std::vector<uint8_t> &packed, size_t row_bytes, uint32_t x, uint32_t y) {
+    const uint8_t b = packed[y * row_bytes + x / 2];
+    return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+// Layout invariants; returns false (and reports) on the first violation.
+static bool check_plan(const char *name, const CollageCell &cell, uint16_t sw, uint16_t sh, const CollagePlan &p) {
+    if (p.k < 1 || p.k > kCollageMaxScale) return fail(name, "scale out of range"), false;
+    if (p.out_w == 0 || p.out_h == 0) return true;  // rejected by the renderer
+    if (p.out_w & 3) return fail(name, "output width off the 4-px grid"), false;
+    if (p.dst_x & 3) return fail(name, "output column off the 4-px grid"), false;
+    if (p.k == 1 && (p.src_x & 1)) return fail(name, "unscaled crop starts mid-byte"), false;
+    if ((uint32_t)p.src_x + (uint32_t)p.out_w * p.k > sw) return fail(name, "crop past source width"), false;
+    if ((uint32_t)p.src_y + (uint32_t)p.out_h * p.k > sh) return fail(name, "crop past source height"), false;
+    if (p.dst_x < cell.x || p.dst_x + p.out_w > cell.x + cell.w) return fail(name, "output outside cell (x)"), false;
+    if (p.dst_y < cell.y || p.dst_y + p.out_h > cell.y + cell.h) return fail(name, "output outside cell (y)"), false;
+    return true;
+}
+
+static void expect_plan(const char *name, const CollageCell &cell, uint16_t sw, uint16_t sh, CollageFit fit,
+                        const CollagePlan &want) {
+    CollagePlan p = {};
+    collage_plan(cell, sw, sh, fit, p);
+    if (!check_plan(name, cell, sw, sh, p)) return;
+    if (p.k != want.k || p.src_x != want.src_x || p.src_y != want.src_y || p.out_w != want.out_w ||
+        p.out_h != want.out_h || p.dst_x != want.dst_x || p.dst_y != want.dst_y) {
+        fprintf(stderr, "FAIL %s: got k=%u src=%u,%u out=%ux%u dst=%u,%u\n", name, (unsigned)p.k,
+                (unsigned)p.src_x, (unsigned)p.src_y, (unsigned)p.out_w, (unsigned)p.out_h,
+                (unsigned)p.dst_x, (unsigned)p.dst_y);
+        g_failures++;
+        return;
+    }
+    printf("ok   %s\n", name);
+}
+
+// Stream a random source through accumulate/pack like collage_load_cell and
+// compare with averaging each k x k block of the crop window.
+static void check_scaling(const char *name, uint16_t sw, uint16_t sh, const CollagePlan &p, std::mt19937 &rng) {
+    const size_t src_pw = sw / 2;
+    std::vector<uint8_t> src(src_pw * sh);
+    for (auto &b : src) b = (uint8_t)rng();
+
+    const size_t out_pw = p.out_w / 2;
+    std::vector<uint8_t> out(out_pw * p.out_h);
+    std::vector<uint16_t> sums(p.out_w, 0);
+    uint16_t out_rows = 0;
+    uint8_t summed = 0;
+    for (uint32_t y = p.src_y; y < (uint32_t)p.src_y + (uint32_t)p.out_h * p.k; y++) {
+        collage_accumulate(p, src.data() + y * src_pw, sums.data());
+        if (++summed == p.k) {
+            collage_pack_row(p, sums.data(), out.data() + out_rows * out_pw);
+            summed = 0;
+            out_rows++;
+        }
+    }
+
+    const uint32_t n = (uint32_t)p.k * p.k;
+    for (uint32_t oy = 0; oy < p.out_h; oy++) {
+        for (uint32_t ox = 0; ox < p.out_w; ox++) {
+            uint32_t sum = 0;
+            for (uint32_t dy = 0; dy < p.k; dy++) {
+                for (uint32_t dx = 0; dx < p.k; dx++) {
+                    sum += get_px(src, src_pw, p.src_x + ox * p.k + dx, p.src_y + oy * p.k + dy);
+                }
+            }
+            if (get_px(out, out_pw, ox, oy) != (sum + n / 2) / n) {
+                fprintf(stderr, "FAIL %s: pixel %u,%u\n", name, (unsigned)ox, (unsigned)oy);
+                g_failures++;
+                return;
+            }
+        }
+    }
+    for (uint16_t s : sums) {
+        if (s != 0) return fail(name, "sums not cleared");
+    }
+    printf("ok   %s\n", name);
+}
+} // namespace
+
+int main() {
+    // A 2x2 grid on the 1872x1404 panel, like image_render_service_render_collage.
+    const CollageCell quarter = {"a.g4", 936, 702, 936, 702};
+    expect_plan("full frame into a quarter, contain", quarter, 1872, 1404, CollageFit::Contain,
+                {2, 0, 0, 936, 702, 936, 702});
+    expect_plan("full frame into a quarter, auto", quarter, 1872, 1404, CollageFit::Auto,
+                {2, 0, 0, 936, 702, 936, 702});
+
+    // Portrait sub-frame into a landscape half: contain letterboxes, cover crops.
+    const CollageCell half = {"b.g4", 0, 0, 936, 1404};
+    expect_plan("portrait into half, contain", half, 1052, 1404, CollageFit::Contain,
+                {2, 2, 0, 524, 702, 204, 351});
+    expect_plan("portrait into half, cover", half, 1052, 1404, CollageFit::Cover,
+                {1, 58, 0, 936, 1404, 0, 0});
+    expect_plan("portrait into half, auto crops a little", half, 1052, 1404, CollageFit::Auto,
+                {1, 58, 0, 936, 1404, 0, 0});
+    // Cover would drop two thirds of the rows: auto falls back to contain.
+    const CollageCell strip = {"c.g4", 0, 0, 1872, 468};
+    expect_plan("wide crop, auto contains", strip, 1872, 1404, CollageFit::Auto,
+                {3, 0, 0, 624, 468, 624, 0});
+    // Large factors stop at kCollageMaxScale.
+    const CollageCell tiny = {"d.g4", 100, 100, 100, 100};
+    expect_plan("scale clamped", tiny, 1872, 1404, CollageFit::Contain,
+                {8, 536, 302, 100, 100, 100, 100});
+
+    std::mt19937 rng(20);
+    const CollageFit fits[] = {CollageFit::Contain, CollageFit::Cover, CollageFit::Auto};
+    int planned = 0;
+    for (int i = 0; i < 3000; i++) {
+        CollageCell cell = {"r.g4", 0, 0, 0, 0};
+        cell.w = (uint16_t)(4 + (rng() % 468) * 4);
+        cell.h = (uint16_t)(1 + rng() % 1404);
+        cell.x = (uint16_t)((rng() % ((1872 - cell.w) / 4 + 1)) * 4);
+        cell.y = (uint16_t)(rng() % (1404 - cell.h + 1));
+        const uint16_t sw = (uint16_t)(4 + (rng() % 468) * 4);
+        const uint16_t sh = (uint16_t)(1 + rng() % 1404);
+        CollagePlan p = {};
+        collage_plan(cell, sw, sh, fits[i % 3], p);
+        char name[48];
+        snprintf(name, sizeof(name), "random plan %d", i);
+        if (!check_plan(name, cell, sw, sh, p)) continue;
+        planned++;
+    }
+    printf("ok   %d random plans\n", planned);
+
+    for (uint8_t k = 1; k <= kCollageMaxScale; k++) {
+        const uint16_t sw = (uint16_t)(64 * k + 4 * (rng() % 8));
+        const uint16_t sh = (uint16_t)(20 * k + rng() % 7);
+        const CollageCell cell = {"s.g4", 0, 0, 64, 20};
+        CollagePlan p = {};
+        collage_plan(cell, sw, sh, CollageFit::Cover, p);
+        char name[48];
+        snprintf(name, sizeof(name), "box average k=%u (%ux%u)", (unsigned)p.k, (unsigned)sw, (unsigned)sh);
+        if (check_plan(name, cell, sw, sh, p)) check_scaling(name, sw, sh, p, rng);
+    }
+    // Odd crop origin at k > 1 reads across byte boundaries.
+    const CollagePlan odd = {3, 5, 1, 20, 4, 0, 0};
+    check_scaling("box average from an odd column", 70, 14, odd, rng);
+
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
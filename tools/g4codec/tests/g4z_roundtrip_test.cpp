@@ -0,0 +1,143 @@
+// G4Z round trip: every strip decodes back to its input, the encoded size never
+// exceeds g4z_max_encoded_size (the firmware sizes its buffers with it), and
+// encode/decode throughput of a panel frame is printed.
+
+#include "g4z_codec.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace {
+static int g_failures = 0;
+
+static bool round_trip(const char *name, const std::vector<uint8_t> &in, size_t row_bytes) {
+    const size_t cap = g4z_max_encoded_size(in.size());
+    std::vector<uint8_t> enc(cap);
+    std::vector<uint16_t> scratch(g4z_encode_scratch_entries(in.size()));
+    const size_t n = g4z_encode_strip(in.data(), in.size(), row_bytes, enc.data(), cap, scratch.data());
+    if (n == 0) {
+        fprintf(stderr, "FAIL %s: %zu bytes do not fit the %zu byte bound\n", name, in.size(), cap);
+        g_failures++;
+        return false;
+    }
+    std::vector<uint8_t> dec(in.size());
+    if (!g4z_decode_strip(enc.data(), n, dec.data(), dec.size()) || dec != in) {
+        fprintf(stderr, "FAIL %s: decode mismatch\n", name);
+        g_failures++;
+        return false;
+    }
+    printf("ok   %-22s %6zu -> %6zu bytes (bound %zu)\n", name, in.size(), n, cap);
+    return true;
+}
+
+// One fresh literal byte, then a 3-byte match of the previous "ABC": 5 encoded
+// bytes per 4 raw, the worst case the bound has to cover.
+static std::vector<uint8_t> literal_match_pattern() {
+    std::vector<uint8_t> v;
+    for (int x = 3; x < 253; x++) {
+        v.push_back((uint8_t)x);
+        v.push_back(0);
+        v.push_back(1);
+        v.push_back(2);
+    }
+    return v;
+}
+
+// Packed 4bpp rows that look like a dithered photo: a gradient with noise.
+static std::vector<uint8_t> photo_like(size_t row_bytes, size_t rows, std::mt19937 &rng) {
+    std::vector<uint8_t> v(row_bytes * rows);
+    for (size_t y = 0; y < rows; y++) {
+        for (size_t x = 0; x < row_bytes; x++) {
+            const int base = (int)((x * 16) / row_bytes);
+            const int a = base + (int)(rng() % 3) - 1;
+            const int b = base + (int)(rng() % 3) - 1;
+            const uint8_t hi = (uint8_t)(a < 0 ? 0 : (a > 15 ? 15 : a));
+            const uint8_t lo = (uint8_t)(b < 0 ? 0 : (b > 15 ? 15 : b));
+            v[y * row_bytes + x] = (uint8_t)((hi << 4) | lo);
+        }
+    }
+    return v;
+}
+
+static void throughput(size_t width, size_t height, size_t strip_rows) {
+    std::mt19937 rng(7);
+    const size_t row_bytes = width / 2;
+    const std::vector<uint8_t> frame = photo_like(row_bytes, height, rng);
+    const size_t strip_bytes = row_bytes * strip_rows;
+    std::vector<uint8_t> enc(g4z_max_encoded_size(frame.size()) + height);
+    std::vector<uint16_t> scratch(g4z_encode_scratch_entries(strip_bytes));
+    std::vector<size_t> offsets;
+    std::vector<uint8_t> dec(frame.size());
+
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    size_t op = 0;
+    for (size_t pos = 0; pos < frame.size(); pos += strip_bytes) {
+        const size_t len = frame.size() - pos < strip_bytes ? frame.size() - pos : strip_bytes;
+        const size_t n = g4z_encode_strip(frame.data() + pos, len, row_bytes, enc.data() + op,
+                                          enc.size() - op, scratch.data());
+        if (n == 0) {
+            fprintf(stderr, "FAIL throughput: strip at %zu did not encode\n", pos);
+            g_failures++;
+            return;
+        }
+        offsets.push_back(op);
+        op += n;
+    }
+    offsets.push_back(op);
+    const auto t1 = clock::now();
+    for (size_t s = 0, pos = 0; pos < frame.size(); s++, pos += strip_bytes) {
+        const size_t len = frame.size() - pos < strip_bytes ? frame.size() - pos : strip_bytes;
+        if (!g4z_decode_strip(enc.data() + offsets[s], offsets[s + 1] - offsets[s], dec.data() + pos, len)) {
+            fprintf(stderr, "FAIL throughput: strip %zu did not decode\n", s);
+            g_failures++;
+            return;
+        }
+    }
+    const auto t2 = clock::now();
+    if (dec != frame) {
+        fprintf(stderr, "FAIL throughput: frame mismatch\n");
+        g_failures++;
+        return;
+    }
+    const double mb = frame.size() / 1e6;
+    const double enc_s = std::chrono::duration<double>(t1 - t0).count();
+    const double dec_s = std::chrono::duration<double>(t2 - t1).count();
+    printf("ok   %zux%zu frame, %zu-row strips: %zu -> %zu bytes, encode %.1f MB/s, decode %.1f MB/s\n",
+           width, height, strip_rows, frame.size(), op, mb / enc_s, mb / dec_s);
+}
+} // namespace
+
+int main() {
+    std::mt19937 rng(1);
+
+    std::vector<uint8_t> random_bytes(16384);
+    for (auto &b : random_bytes) b = (uint8_t)rng();
+    round_trip("random", random_bytes, 468);
+
+    round_trip("literal+match", literal_match_pattern(), 4096);
+
+    std::vector<uint8_t> alternating;
+    for (int i = 0; i < 4000; i++) {
+        alternating.push_back((uint8_t)rng());
+        alternating.insert(alternating.end(), 3, (uint8_t)rng());
+    }
+    round_trip("literal+run", alternating, 468);
+
+    round_trip("white", std::vector<uint8_t>(7488, 0xFF), 468);
+    round_trip("photo strip", photo_like(468, 16, rng), 468);
+    round_trip("single byte", std::vector<uint8_t>(1, 0x5A), 1);
+    round_trip("two bytes", std::vector<uint8_t>{0x12, 0x34}, 2);
+
+    throughput(1872, 1404, 16);
+
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
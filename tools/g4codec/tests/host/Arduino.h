@@ -0,0 +1,93 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core the tested firmware units
+// use (tools/g4codec/tests). Not a general Arduino emulation.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define RTC_DATA_ATTR
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+unsigned long millis();
+void delay(unsigned long ms);
+void yield();
+bool psramFound();
+
+template <typename T>
+static inline T constrain(T v, T lo, T hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+class String {
+public:
+    String() = default;
+    String(const char *s) : str(s ? s : "") {}
+    String(const std::string &s) : str(s) {}
+    explicit String(int v) : str(std::to_string(v)) {}
+    explicit String(unsigned v) : str(std::to_string(v)) {}
+    explicit String(long v) : str(std::to_string(v)) {}
+    explicit String(unsigned long v) : str(std::to_string(v)) {}
+
+    const char *c_str() const { return str.c_str(); }
+    unsigned length() const { return (unsigned)str.size(); }
+    bool isEmpty() const { return str.empty(); }
+    char operator[](unsigned i) const { return str[i]; }
+
+    bool startsWith(const char *p) const { return str.compare(0, strlen(p), p) == 0; }
+    bool endsWith(const char *p) const {
+        const size_t n = strlen(p);
+        return str.size() >= n && str.compare(str.size() - n, n, p) == 0;
+    }
+    int indexOf(char c, unsigned from = 0) const {
+        const size_t p = str.find(c, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    int lastIndexOf(char c) const {
+        const size_t p = str.rfind(c);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    String substring(unsigned from) const { return String(str.substr(std::min<size_t>(from, str.size()))); }
+    String substring(unsigned from, unsigned to) const {
+        from = (unsigned)std::min<size_t>(from, str.size());
+        return String(str.substr(from, to > from ? to - from : 0));
+    }
+    void remove(unsigned index, unsigned count) { str.erase(index, count); }
+    void replace(const char *from, const char *to) {
+        const size_t n = strlen(from);
+        if (n == 0) return;
+        for (size_t p = str.find(from); p != std::string::npos; p = str.find(from, p + strlen(to))) {
+            str.replace(p, n, to);
+        }
+    }
+    int compareTo(const String &o) const { return strcmp(c_str(), o.c_str()); }
+
+    String &operator+=(const String &o) { str += o.str; return *this; }
+    String &operator+=(const char *o) { str += o; return *this; }
+    String &operator+=(char c) { str += c; return *this; }
+    bool operator==(const String &o) const { return str == o.str; }
+    bool operator==(const char *o) const { return str == o; }
+    bool operator!=(const String &o) const { return str != o.str; }
+    bool operator<(const String &o) const { return str < o.str; }
+
+    friend String operator+(const String &a, const String &b) { return String(a.str + b.str); }
+    friend String operator+(const String &a, const char *b) { return String(a.str + b); }
+    friend String operator+(const char *a, const String &b) { return String(a + b.str); }
+
+private:
+    std::string str;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+// Host stand-in for the Arduino FS File API, backed by a directory on the
+// host (host_shim.h: host_sd_mount).
+
+#include <Arduino.h>
+
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+struct HostFile;
+
+class File {
+public:
+    File() = default;
+    explicit File(std::shared_ptr<HostFile> impl) : impl(std::move(impl)) {}
+
+    explicit operator bool() const;
+    int read(uint8_t *buf, size_t len);
+    int read();
+    size_t write(const uint8_t *buf, size_t len);
+    size_t write(uint8_t b) { return write(&b, 1); }
+    bool seek(uint32_t pos);
+    size_t position() const;
+    size_t size() const;
+    int available() const;
+    void flush();
+    void close();
+    const char *name() const;
+    const char *path() const;
+    bool isDirectory() const;
+    File openNextFile();
+
+private:
+    std::shared_ptr<HostFile> impl;
+};
+
+namespace fs {
+class FS {
+public:
+    File open(const char *path, const char *mode = FILE_READ);
+    File open(const String &path, const char *mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool exists(const char *path);
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path);
+    bool remove(const String &path) { return remove(path.c_str()); }
+    bool rename(const char *from, const char *to);
+    bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char *path);
+    bool mkdir(const String &path) { return mkdir(path.c_str()); }
+    bool rmdir(const char *path);
+    bool rmdir(const String &path) { return rmdir(path.c_str()); }
+};
+} // namespace fs
+
+using fs::FS;
@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand-in for the SD library: SD is an fs::FS rooted at the directory
+// given to host_sd_mount (host_shim.h).
+
+#include <FS.h>
+
+class SDFS : public fs::FS {
+public:
+    uint64_t totalBytes() const { return 1ull << 32; }
+    uint64_t usedBytes() const { return 0; }
+};
+
+extern SDFS SD;
@@ -0,0 +1,16 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS types and macros the firmware units use.
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+// One tick per millisecond, like the ESP32 default (CONFIG_FREERTOS_HZ=1000).
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
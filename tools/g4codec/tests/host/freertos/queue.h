@@ -0,0 +1,16 @@
+#pragma once
+
+// Host stand-in for FreeRTOS queues (items copied by value, blocking with a
+// timeout in milliseconds), backed by a mutex and a condition variable.
+
+#include "freertos/FreeRTOS.h"
+
+#include <stddef.h>
+
+typedef struct HostQueue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
@@ -0,0 +1,351 @@
+// Host stand-ins for the Arduino core, SD, heap_caps, FreeRTOS queues and
+// logging, for the firmware unit tests in tools/g4codec/tests.
+
+#include "host_shim.h"
+
+#include <Arduino.h>
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <freertos/queue.h>
+
+#include "log_manager.h"
+
+#include <dirent.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stdfs = std::filesystem;
+
+SDFS SD;
+
+namespace {
+static std::string g_root;
+static std::atomic<uint32_t> g_allocations{0};
+static std::atomic<int32_t> g_live_blocks{0};
+static bool g_log = false;
+
+static std::string host_path(const char *path) {
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/') p = "/" + p;
+    return g_root + p;
+}
+} // namespace
+
+struct HostFile {
+    std::string sd_path;
+    std::string name;
+    FILE *fp = nullptr;
+    bool dir = false;
+    std::vector<std::string> entries;
+    size_t next_entry = 0;
+
+    ~HostFile() {
+        if (fp) fclose(fp);
+    }
+};
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char *dst, const char *src, size_t size) {
+    const size_t len = strlen(src);
+    if (size) {
+        const size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+unsigned long millis() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (unsigned long)duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+bool psramFound() {
+    return true;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t) {
+    void *p = malloc(size);
+    if (p) {
+        g_allocations++;
+        g_live_blocks++;
+    }
+    return p;
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t) {
+    void *p = calloc(n, size);
+    if (p) {
+        g_allocations++;
+        g_live_blocks++;
+    }
+    return p;
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t) {
+    void *p = realloc(ptr, size);
+    if (p) {
+        g_allocations++;
+        if (!ptr) g_live_blocks++;
+    }
+    return p;
+}
+
+void heap_caps_free(void *ptr) {
+    if (!ptr) return;
+    g_live_blocks--;
+    free(ptr);
+}
+
+void log_write(LogLevel level, const char *module, const char *format, ...) {
+    if (!g_log) return;
+    va_list args;
+    va_start(args, format);
+    printf("[%d][%s] ", (int)level, module);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+// --- File / fs::FS --------------------------------------------------------
+
+File::operator bool() const {
+    return impl != nullptr;
+}
+
+int File::read(uint8_t *buf, size_t len) {
+    if (!impl || !impl->fp) return -1;
+    return (int)fread(buf, 1, len, impl->fp);
+}
+
+int File::read() {
+    uint8_t b = 0;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+size_t File::write(const uint8_t *buf, size_t len) {
+    if (!impl || !impl->fp) return 0;
+    return fwrite(buf, 1, len, impl->fp);
+}
+
+bool File::seek(uint32_t pos) {
+    return impl && impl->fp && fseek(impl->fp, pos, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+    return impl && impl->fp ? (size_t)ftell(impl->fp) : 0;
+}
+
+size_t File::size() const {
+    if (!impl || !impl->fp) return 0;
+    fflush(impl->fp);
+    struct stat st;
+    return fstat(fileno(impl->fp), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+int File::available() const {
+    return (int)(size() - position());
+}
+
+void File::flush() {
+    if (impl && impl->fp) fflush(impl->fp);
+}
+
+void File::close() {
+    impl.reset();
+}
+
+const char *File::name() const {
+    return impl ? impl->name.c_str() : "";
+}
+
+const char *File::path() const {
+    return impl ? impl->sd_path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return impl && impl->dir;
+}
+
+File File::openNextFile() {
+    if (!impl || !impl->dir || impl->next_entry >= impl->entries.size()) return File();
+    const std::string child = impl->sd_path + (impl->sd_path == "/" ? "" : "/") + impl->entries[impl->next_entry++];
+    return SD.open(child.c_str(), FILE_READ);
+}
+
+File fs::FS::open(const char *path, const char *mode) {
+    auto f = std::make_shared<HostFile>();
+    f->sd_path = path;
+    const size_t slash = f->sd_path.rfind('/');
+    f->name = slash == std::string::npos ? f->sd_path : f->sd_path.substr(slash + 1);
+    const std::string hp = host_path(path);
+    std::error_code ec;
+    if (stdfs::is_directory(hp, ec)) {
+        f->dir = true;
+        for (const auto &e : stdfs::directory_iterator(hp, ec)) f->entries.push_back(e.path().filename().string());
+        std::sort(f->entries.begin(), f->entries.end());
+        return File(f);
+    }
+    const char *fmode = mode[0] == 'w' ? "w+b" : (mode[0] == 'a' ? "a+b" : "rb");
+    f->fp = fopen(hp.c_str(), fmode);
+    if (!f->fp) return File();
+    return File(f);
+}
+
+bool fs::FS::exists(const char *path) {
+    std::error_code ec;
+    return stdfs::exists(host_path(path), ec);
+}
+
+bool fs::FS::remove(const char *path) {
+    std::error_code ec;
+    return !stdfs::is_directory(host_path(path), ec) && stdfs::remove(host_path(path), ec);
+}
+
+bool fs::FS::rename(const char *from, const char *to) {
+    if (exists(to)) return false;  // FAT rename does not replace
+    std::error_code ec;
+    stdfs::rename(host_path(from), host_path(to), ec);
+    return !ec;
+}
+
+bool fs::FS::mkdir(const char *path) {
+    std::error_code ec;
+    return stdfs::create_directory(host_path(path), ec) || stdfs::is_directory(host_path(path), ec);
+}
+
+bool fs::FS::rmdir(const char *path) {
+    std::error_code ec;
+    return stdfs::is_directory(host_path(path), ec) && stdfs::remove(host_path(path), ec);
+}
+
+// --- Test controls ---------------------------------------------------------
+
+std::string host_sd_mount() {
+    host_sd_unmount();
+    char tmpl[] = "/tmp/g4codec-sd-XXXXXX";
+    const char *dir = mkdtemp(tmpl);
+    g_root = dir ? dir : "";
+    return g_root;
+}
+
+void host_sd_unmount() {
+    if (g_root.empty()) return;
+    std::error_code ec;
+    stdfs::remove_all(g_root, ec);
+    g_root.clear();
+}
+
+bool host_sd_put(const char *path, const std::string &data) {
+    const std::string hp = host_path(path);
+    std::error_code ec;
+    stdfs::create_directories(stdfs::path(hp).parent_path(), ec);
+    FILE *fp = fopen(hp.c_str(), "wb");
+    if (!fp) return false;
+    const bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+    fclose(fp);
+    return ok;
+}
+
+bool host_sd_get(const char *path, std::string *out) {
+    FILE *fp = fopen(host_path(path).c_str(), "rb");
+    if (!fp) return false;
+    out->clear();
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) out->append(buf, n);
+    fclose(fp);
+    return true;
+}
+
+void host_heap_reset_counters() {
+    g_allocations = 0;
+}
+
+uint32_t host_heap_allocations() {
+    return g_allocations;
+}
+
+int32_t host_heap_live_blocks() {
+    return g_live_blocks;
+}
+
+void host_log_enable(bool on) {
+    g_log = on;
+}
+
+// --- FreeRTOS queues ------------------------------------------------------
+
+struct HostQueue {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length = 0;
+    size_t item_size = 0;
+};
+
+namespace {
+// Wait for `ready` under the queue lock; false when `ticks` (ms) ran out.
+template <typename Ready>
+static bool queue_wait(HostQueue *q, std::unique_lock<std::mutex> &lock, TickType_t ticks, Ready ready) {
+    if (ticks == portMAX_DELAY) {
+        q->changed.wait(lock, ready);
+        return true;
+    }
+    return q->changed.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+} // namespace
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    HostQueue *q = new HostQueue();
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!queue_wait(q, lock, ticks, [q] { return q->items.size() < q->length; })) return pdFALSE;
+    const uint8_t *bytes = static_cast<const uint8_t *>(item);
+    q->items.emplace_back(bytes, bytes + q->item_size);
+    q->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!queue_wait(q, lock, ticks, [q] { return !q->items.empty(); })) return pdFALSE;
+    memcpy(item, q->items.front().data(), q->item_size);
+    q->items.pop_front();
+    q->changed.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->mutex);
+    return (UBaseType_t)q->items.size();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Test-side controls of the host stand-ins (Arduino.h, SD.h, esp_heap_caps.h,
+// freertos/queue.h).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// Root SD at a fresh temporary directory (removed by host_sd_unmount).
+// Returns the host path.
+std::string host_sd_mount();
+void host_sd_unmount();
+
+// Whole-file helpers on SD paths ("/queue-permanent/a.g4").
+bool host_sd_put(const char *path, const std::string &data);
+bool host_sd_get(const char *path, std::string *out);
+
+// heap_caps_malloc/calloc/realloc calls since the last reset, and blocks
+// still allocated.
+void host_heap_reset_counters();
+uint32_t host_heap_allocations();
+int32_t host_heap_live_blocks();
+
+// Print firmware LOG* lines (off by default).
+void host_log_enable(bool on);
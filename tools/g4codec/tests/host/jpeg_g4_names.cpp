@@ -0,0 +1,22 @@
+// jpeg_g4.cpp's name and signature helpers for the host tests; the rest needs
+// JPEGDEC. Keep in step with src/app/jpeg_g4.cpp.
+
+#include "jpeg_g4.h"
+
+bool jpeg_g4_is_jpeg_name(const char *name) {
+    if (!name) return false;
+    const size_t len = strlen(name);
+    return (len >= 4 && strcasecmp(name + len - 4, ".jpg") == 0) ||
+           (len >= 5 && strcasecmp(name + len - 5, ".jpeg") == 0);
+}
+
+String jpeg_g4_cache_path(const char *jpeg_path) {
+    String name = jpeg_path ? String(jpeg_path) : String();
+    while (name.startsWith("/")) name.remove(0, 1);
+    name.replace("/", "__");
+    return String("/jpeg-cache/") + name + ".g4";
+}
+
+bool jpeg_g4_has_signature(const uint8_t *data, size_t len) {
+    return data && len >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
@@ -0,0 +1,159 @@
+// NameList (src/app/name_list) against a std::vector<std::string> model:
+// append, insert, erase, sort, find, prefix ranges, clear and arena reuse,
+// plus the block allocations of a large listing.
+
+#include "name_list.h"
+
+#include "host_shim.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+static int g_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+static bool same(const NameList &list, const std::vector<std::string> &model) {
+    if (list.size() != model.size()) return false;
+    size_t bytes = 0;
+    for (size_t i = 0; i < model.size(); i++) {
+        if (model[i] != list[i]) return false;
+        bytes += model[i].size() + 1;
+    }
+    return list.bytes() == bytes;
+}
+
+static std::string photo_name(std::mt19937 &rng) {
+    static const char *kQueues[] = {"queue-permanent/", "queue-temporary/"};
+    char name[96];
+    snprintf(name, sizeof(name), "%s2030%02u%02uT120000Z__photo-%06u.g4", kQueues[rng() % 2],
+             1 + (unsigned)(rng() % 12), 1 + (unsigned)(rng() % 28), (unsigned)(rng() % 1000000));
+    return name;
+}
+
+static void basics() {
+    NameList list;
+    CHECK(list.empty() && list.allocations() == 0);
+    CHECK(list.push_back("b.g4") && list.push_back("queue-permanent/", "a.g4") && list.push_back("c.g4xx", 4));
+    CHECK(same(list, {"b.g4", "queue-permanent/a.g4", "c.g4"}));
+    CHECK(list.insert(0, "0.g4") && list.insert(4, "z.g4") && !list.insert(9, "x"));
+    CHECK(same(list, {"0.g4", "b.g4", "queue-permanent/a.g4", "c.g4", "z.g4"}));
+    list.erase(2);
+    list.erase(7);
+    CHECK(same(list, {"0.g4", "b.g4", "c.g4", "z.g4"}));
+    CHECK(!list.push_back(nullptr) && !list.insert(0, nullptr));
+
+    NameList copy;
+    CHECK(copy.assign(list) && same(copy, {"0.g4", "b.g4", "c.g4", "z.g4"}));
+    list.clear();
+    CHECK(list.empty() && list.bytes() == 0);
+    CHECK(same(copy, {"0.g4", "b.g4", "c.g4", "z.g4"}));
+
+    size_t index = 99;
+    CHECK(copy.find("c.g4", &index) && index == 2);
+    CHECK(!copy.find("bb.g4", &index) && index == 2);
+    CHECK(!copy.find("zz", &index) && index == 4);
+    CHECK(copy.insertSorted("bb.g4") && copy.insertSorted("bb.g4"));
+    CHECK(same(copy, {"0.g4", "b.g4", "bb.g4", "c.g4", "z.g4"}));
+    const NameList::Range r = copy.prefixRange("b");
+    CHECK(r.first == 1 && r.count == 2);
+    const NameList::Range none = copy.prefixRange("q");
+    CHECK(none.first == 4 && none.count == 0);
+    printf("ok   basics\n");
+}
+
+// Random operations against the model, growing well past the initial blocks.
+static void random_ops() {
+    std::mt19937 rng(23);
+    NameList list;
+    std::vector<std::string> model;
+    for (int step = 0; step < 20000; step++) {
+        const unsigned op = rng() % 10;
+        if (op < 5 || model.empty()) {
+            const std::string name = photo_name(rng);
+            CHECK(list.push_back(name.c_str()));
+            model.push_back(name);
+        } else if (op < 7) {
+            const size_t i = rng() % (model.size() + 1);
+            const std::string name = photo_name(rng);
+            CHECK(list.insert(i, name.c_str()));
+            model.insert(model.begin() + i, name);
+        } else {
+            const size_t i = rng() % model.size();
+            list.erase(i);
+            model.erase(model.begin() + i);
+        }
+        if (step % 997 == 0 && !same(list, model)) {
+            fprintf(stderr, "FAIL random ops: diverged at step %d\n", step);
+            g_failures++;
+            return;
+        }
+    }
+    CHECK(same(list, model));
+
+    list.sort();
+    std::sort(model.begin(), model.end());
+    CHECK(same(list, model));
+    for (size_t i = 0; i < model.size(); i += 37) {
+        size_t index = 0;
+        CHECK(list.find(model[i].c_str(), &index) && model[index] == model[i]);
+    }
+    const NameList::Range perm = list.prefixRange("queue-permanent/");
+    const size_t perm_count = (size_t)std::count_if(model.begin(), model.end(), [](const std::string &s) {
+        return s.rfind("queue-permanent/", 0) == 0;
+    });
+    CHECK(perm.first == 0 && perm.count == perm_count);
+    printf("ok   random ops (%zu names left, %u block allocations)\n", model.size(), list.allocations());
+}
+
+// A listing of 5000 names: block allocations instead of one String per name,
+// and a cleared list refills without allocating.
+static void allocations() {
+    std::mt19937 rng(33);
+    std::vector<std::string> names;
+    for (int i = 0; i < 5000; i++) names.push_back(photo_name(rng));
+
+    NameList list;
+    host_heap_reset_counters();
+    for (const std::string &n : names) CHECK(list.push_back(n.c_str()));
+    const uint32_t first = host_heap_allocations();
+    CHECK(first == list.allocations());
+    printf("ok   5000 names (%zu arena bytes): %u block allocations (std::vector<String>: one per name)\n",
+           list.bytes(), first);
+    CHECK(first <= 16);
+
+    list.clear();
+    host_heap_reset_counters();
+    for (const std::string &n : names) CHECK(list.push_back(n.c_str()));
+    CHECK(host_heap_allocations() == 0 && list.allocations() == first);
+
+    // Erasing most names and adding again compacts the arena in place.
+    for (size_t i = list.size(); i-- > 100;) list.erase(i);
+    const uint32_t before = list.allocations();
+    for (int i = 0; i < 4000; i++) CHECK(list.push_back(names[i].c_str()));
+    CHECK(list.allocations() - before <= 1);
+    printf("ok   clear and erase reuse the arena\n");
+
+    list.release();
+    CHECK(host_heap_live_blocks() == 0);
+}
+} // namespace
+
+int main() {
+    basics();
+    random_ops();
+    allocations();
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
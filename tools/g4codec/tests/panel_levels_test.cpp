@@ -0,0 +1,110 @@
+// Panel gray calibration (src/app/panel_levels): the portal/NVS text form and
+// the nibble-pair LUT the transport maps 4bpp payload through.
+
+#include "panel_levels.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+static int g_failures = 0;
+
+static void check(bool ok, const char *name) {
+    if (ok) {
+        printf("ok   %s\n", name);
+    } else {
+        fprintf(stderr, "FAIL %s\n", name);
+        g_failures++;
+    }
+}
+
+static bool parses_to(const char *text, const uint8_t *expected) {
+    uint8_t levels[kPanelLevels];
+    memset(levels, 0xAA, sizeof(levels));
+    return panel_levels_parse(text, levels) && memcmp(levels, expected, kPanelLevels) == 0;
+}
+
+static bool rejected(const char *text) {
+    uint8_t levels[kPanelLevels];
+    memset(levels, 0xAA, sizeof(levels));
+    if (panel_levels_parse(text, levels)) return false;
+    for (uint8_t v : levels) {
+        if (v != 0xAA) return false;
+    }
+    return true;
+}
+
+// Map a packed byte pixel by pixel, the way the panel should see it.
+static uint8_t map_byte(const uint8_t *levels, uint8_t b) {
+    return (uint8_t)(((levels[b >> 4] & 0x0F) << 4) | (levels[b & 0x0F] & 0x0F));
+}
+} // namespace
+
+int main() {
+    uint8_t identity[kPanelLevels];
+    panel_levels_identity(identity);
+    const uint8_t curve[kPanelLevels] = {0, 0, 1, 2, 3, 5, 6, 7, 8, 9, 10, 11, 13, 14, 15, 15};
+
+    // Text form.
+    char text[48];
+    panel_levels_format(identity, text, sizeof(text));
+    check(strcmp(text, "0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15") == 0, "format identity");
+    check(strlen(text) < sizeof(text), "format fits CONFIG_PANEL_LEVELS_STR_MAX_LEN");
+    panel_levels_format(curve, text, sizeof(text));
+    check(parses_to(text, curve), "format/parse round trip");
+    check(parses_to(" 0, 0 ,1,2,3,5,6,7,8,9,10,11,13,14,15, 15 ", curve), "parse with spaces");
+    panel_levels_format(curve, text, 8);
+    check(strlen(text) == 7 && strncmp(text, "0,0,1,2", 7) == 0, "format truncates to the buffer");
+
+    check(rejected(""), "reject empty");
+    check(rejected("0,1,2,3,4,5,6,7,8,9,10,11,12,13,14"), "reject 15 values");
+    check(rejected("0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,15"), "reject 17 values");
+    check(rejected("0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,16"), "reject level 16");
+    check(rejected("0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,-1"), "reject negative level");
+    check(rejected("0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"), "reject trailing comma");
+    check(rejected("0;1;2;3;4;5;6;7;8;9;10;11;12;13;14;15"), "reject other separators");
+    check(rejected("0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,0x0F"), "reject hex");
+    check(!panel_levels_parse(nullptr, identity), "reject null text");
+
+    // LUT: identity is inactive and maps every byte to itself.
+    uint8_t lut[256];
+    uint32_t identity_sig = 0;
+    const bool identity_active = panel_levels_build_lut(identity, lut, &identity_sig);
+    bool same = true;
+    for (int b = 0; b < 256; b++) same = same && lut[b] == b;
+    check(!identity_active && same, "identity LUT inactive and a no-op");
+
+    // A curve maps both nibbles of every byte.
+    uint32_t curve_sig = 0;
+    const bool curve_active = panel_levels_build_lut(curve, lut, &curve_sig);
+    bool mapped = true;
+    for (int b = 0; b < 256; b++) mapped = mapped && lut[b] == map_byte(curve, (uint8_t)b);
+    check(curve_active && mapped, "curve LUT maps high and low pixel");
+
+    // Levels are masked to 4 bits, like the loaded payload.
+    uint8_t wide[kPanelLevels];
+    for (uint8_t i = 0; i < kPanelLevels; i++) wide[i] = (uint8_t)(0xF0 | curve[i]);
+    uint8_t wide_lut[256];
+    uint32_t wide_sig = 0;
+    panel_levels_build_lut(wide, wide_lut, &wide_sig);
+    check(memcmp(wide_lut, lut, sizeof(lut)) == 0 && wide_sig == curve_sig, "levels masked to 4 bits");
+
+    // Signatures: never 0 (0 means "unknown" in RTC), stable, and distinct.
+    uint32_t again = 0;
+    panel_levels_build_lut(curve, lut, &again);
+    check(identity_sig != 0 && curve_sig != 0, "signature never 0");
+    check(again == curve_sig && identity_sig != curve_sig, "signature stable and curve-specific");
+    uint8_t swapped[kPanelLevels];
+    memcpy(swapped, curve, sizeof(swapped));
+    swapped[5] = curve[6];
+    swapped[6] = curve[5];
+    uint32_t swapped_sig = 0;
+    panel_levels_build_lut(swapped, lut, &swapped_sig);
+    check(swapped_sig != curve_sig, "signature depends on level order");
+
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,250 @@
+// Photo catalog (src/app/photo_catalog) on a host directory standing in for
+// the SD card. Each boot runs in its own process, so module state starts
+// fresh like after a reset while the "card" keeps its files:
+//
+//   1. first open rebuilds from a scan; put/remove keep order, counts, expiry
+//      and bump the generation once per update (timer wake, records on SD)
+//   2. SD worker: a clean catalog is reused, not rebuilt; the resident copy
+//      answers lookups without the card and is patched by put/remove; purge
+//      deletes expired photos and their JPEG caches; then a crash between
+//      begin_update and put
+//   3. the stale catalog is rebuilt and picks up the file from the crash
+//   4. a truncated catalog is rebuilt too
+
+#include "photo_catalog.h"
+
+#include "host_shim.h"
+#include "jpeg_g4.h"
+
+#include <SD.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <functional>
+#include <vector>
+
+namespace {
+static int g_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+// Temporary names: <EXPIRES_UTC>__<UPLOAD_UTC>__<slug>.
+static const char *kTempEarly = "queue-temporary/20300101T000000Z__20290101T000000Z__early.jpg";
+static const char *kTempLate = "queue-temporary/20300201T000000Z__20290101T000000Z__late.g4";
+static const uint32_t kEarlyExpiry = 1893456000;  // 2030-01-01T00:00:00Z
+static const uint32_t kLateExpiry = 1896134400;   // 2030-02-01T00:00:00Z
+
+static void put_file(const char *logical, const char *data = "photo") {
+    host_sd_put((std::string("/") + logical).c_str(), data);
+}
+
+static void delete_file(const char *logical) {
+    SD.remove((std::string("/") + logical).c_str());
+}
+
+static bool file_exists(const char *logical) {
+    std::string unused;
+    return host_sd_get((std::string("/") + logical).c_str(), &unused);
+}
+
+static std::vector<std::string> listing() {
+    NameList names;
+    std::vector<std::string> out;
+    if (!photo_catalog_list(names)) return out;
+    for (size_t i = 0; i < names.size(); i++) out.push_back(names[i]);
+    return out;
+}
+
+static uint32_t marker_on_sd() {
+    std::string data;
+    uint32_t gen = 0;
+    if (host_sd_get("/photo-catalog.gen", &data) && data.size() == sizeof(gen)) memcpy(&gen, data.data(), sizeof(gen));
+    return gen;
+}
+
+// Every name through get() and index_of(), for the records or resident path.
+static void check_lookups(const std::vector<std::string> &expected, const PhotoCatalogInfo &info) {
+    CHECK(expected.size() == info.count[0] + info.count[1]);
+    for (size_t i = 0; i < expected.size(); i++) {
+        const PhotoQueue queue = i < info.count[0] ? PhotoQueue::Permanent : PhotoQueue::Temporary;
+        const uint32_t index = (uint32_t)(i < info.count[0] ? i : i - info.count[0]);
+        String name;
+        CHECK(photo_catalog_get(queue, index, name) && expected[i] == name.c_str());
+        uint32_t found = UINT32_MAX;
+        CHECK(photo_catalog_index_of(expected[i].c_str(), &found) && found == index);
+    }
+    CHECK(!photo_catalog_index_of("queue-permanent/missing.g4", nullptr));
+}
+
+static void boot1() {
+    PhotoCatalogInfo info = {};
+    CHECK(photo_catalog_open(&info));
+    CHECK(info.generation == 1 && marker_on_sd() == 1);
+    CHECK(info.count[0] == 3 && info.count[1] == 2);
+    CHECK(info.earliest_expiry == kEarlyExpiry);
+    const std::vector<std::string> scanned = {
+        "queue-permanent/a.g4", "queue-permanent/b.jpeg", "queue-permanent/c.g4", kTempEarly, kTempLate,
+    };
+    CHECK(listing() == scanned);
+    check_lookups(scanned, info);
+
+    // Add: marker first, then the file, then the record.
+    photo_catalog_begin_update("queue-permanent/bb.g4");
+    CHECK(marker_on_sd() == 2 && photo_catalog_generation() == 1);
+    put_file("queue-permanent/bb.g4");
+    CHECK(photo_catalog_put("queue-permanent/bb.g4", 5, 0x1234));
+    CHECK(photo_catalog_generation() == 2 && marker_on_sd() == 2);
+
+    // Replace keeps one record; remove drops it.
+    photo_catalog_begin_update("queue-permanent/a.g4");
+    CHECK(photo_catalog_put("queue-permanent/a.g4", 9, 0x5678));
+    photo_catalog_begin_update("queue-permanent/c.g4");
+    delete_file("queue-permanent/c.g4");
+    CHECK(photo_catalog_remove("queue-permanent/c.g4"));
+    CHECK(photo_catalog_generation() == 4 && marker_on_sd() == 4);
+
+    // Outside the queues: refused, nothing written.
+    photo_catalog_begin_update("images/x.g4");
+    CHECK(!photo_catalog_put("images/x.g4", 1, 0));
+    CHECK(!photo_catalog_put("queue-permanent/sub/x.g4", 1, 0));
+    CHECK(photo_catalog_generation() == 4 && marker_on_sd() == 4);
+
+    CHECK(photo_catalog_open(&info));
+    CHECK(info.count[0] == 3 && info.count[1] == 2 && info.generation == 4);
+    const std::vector<std::string> updated = {
+        "queue-permanent/a.g4", "queue-permanent/b.jpeg", "queue-permanent/bb.g4", kTempEarly, kTempLate,
+    };
+    CHECK(listing() == updated);
+    check_lookups(updated, info);
+}
+
+static void boot2() {
+    photo_catalog_set_resident(true);
+    PhotoCatalogInfo info = {};
+    CHECK(photo_catalog_open(&info));
+    CHECK(info.generation == 4);  // reused, not rebuilt
+    const std::vector<std::string> expected = {
+        "queue-permanent/a.g4", "queue-permanent/b.jpeg", "queue-permanent/bb.g4", kTempEarly, kTempLate,
+    };
+    // Resident: picks and listings don't read the card.
+    CHECK(SD.rename("/photo-catalog.bin", "/photo-catalog.away"));
+    CHECK(listing() == expected);
+    check_lookups(expected, info);
+    CHECK(SD.rename("/photo-catalog.away", "/photo-catalog.bin"));
+
+    photo_catalog_begin_update("queue-permanent/0.g4");
+    put_file("queue-permanent/0.g4");
+    CHECK(photo_catalog_put("queue-permanent/0.g4", 5, 0));
+    photo_catalog_begin_update("queue-permanent/b.jpeg");
+    delete_file("queue-permanent/b.jpeg");
+    CHECK(photo_catalog_remove("queue-permanent/b.jpeg"));
+    CHECK(photo_catalog_open(&info));
+    CHECK(info.generation == 6 && info.count[0] == 3);
+    const std::vector<std::string> patched = {
+        "queue-permanent/0.g4", "queue-permanent/a.g4", "queue-permanent/bb.g4", kTempEarly, kTempLate,
+    };
+    CHECK(listing() == patched);
+    check_lookups(patched, info);
+    // The patched copy matches the records it stands for.
+    photo_catalog_set_resident(false);
+    CHECK(listing() == patched);
+    check_lookups(patched, info);
+    photo_catalog_set_resident(true);
+    CHECK(photo_catalog_open(&info));
+
+    // Purge between the two expiries: the early JPEG and its cache go.
+    const String cache = jpeg_g4_cache_path((std::string("/") + kTempEarly).c_str());
+    host_sd_put(cache.c_str(), "cache");
+    CHECK(photo_catalog_purge_expired(kEarlyExpiry - 1) == 0);
+    CHECK(photo_catalog_purge_expired(kEarlyExpiry) == 1);
+    CHECK(!file_exists(kTempEarly) && file_exists(kTempLate));
+    std::string unused;
+    CHECK(!host_sd_get(cache.c_str(), &unused));
+    CHECK(photo_catalog_open(&info));
+    CHECK(info.count[1] == 1 && info.earliest_expiry == kLateExpiry && info.generation == 7);
+    const std::vector<std::string> purged = {
+        "queue-permanent/0.g4", "queue-permanent/a.g4", "queue-permanent/bb.g4", kTempLate,
+    };
+    CHECK(listing() == purged);
+    check_lookups(purged, info);
+
+    // Crash after the file landed but before the record did.
+    photo_catalog_begin_update("queue-permanent/z.g4");
+    put_file("queue-permanent/z.g4");
+    CHECK(marker_on_sd() == 8);
+}
+
+static void boot3() {
+    PhotoCatalogInfo info = {};
+    CHECK(photo_catalog_open(&info));
+    CHECK(info.generation == 9 && marker_on_sd() == 9);  // rebuilt past the marker
+    const std::vector<std::string> rebuilt = {
+        "queue-permanent/0.g4", "queue-permanent/a.g4", "queue-permanent/bb.g4", "queue-permanent/z.g4", kTempLate,
+    };
+    CHECK(listing() == rebuilt);
+    check_lookups(rebuilt, info);
+
+    std::string data;
+    CHECK(host_sd_get("/photo-catalog.bin", &data));
+    host_sd_put("/photo-catalog.bin", data.substr(0, data.size() - 7));
+}
+
+static void boot4() {
+    PhotoCatalogInfo info = {};
+    CHECK(photo_catalog_open(&info));
+    CHECK(info.generation == 10 && info.count[0] == 4 && info.count[1] == 1);
+    photo_catalog_invalidate();
+    CHECK(photo_catalog_generation() == 0);
+    CHECK(photo_catalog_open(&info) && info.generation == 11);
+}
+
+// Run one boot in a child process; its failures become the exit status.
+static void boot(const char *name, const std::function<void()> &fn) {
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        fn();
+        fflush(stdout);
+        _exit(g_failures ? 1 : 0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "FAIL %s\n", name);
+        g_failures++;
+        return;
+    }
+    printf("ok   %s\n", name);
+}
+} // namespace
+
+int main() {
+    host_log_enable(getenv("G4CODEC_TEST_LOG") != nullptr);
+    host_sd_mount();
+    put_file("queue-permanent/c.g4");
+    put_file("queue-permanent/a.g4");
+    put_file("queue-permanent/b.jpeg");
+    put_file("queue-permanent/notes.txt");
+    put_file("queue-permanent/sub/d.g4");
+    put_file(kTempLate);
+    put_file(kTempEarly);
+    put_file("queue-temporary/undated.png");
+
+    boot("rebuild, put, remove (records)", boot1);
+    boot("reuse, resident copy, purge, crash", boot2);
+    boot("stale generation rebuilds", boot3);
+    boot("truncated catalog rebuilds", boot4);
+
+    host_sd_unmount();
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
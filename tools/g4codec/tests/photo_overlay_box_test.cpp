@@ -0,0 +1,135 @@
+// Overlay compositing (src/app/photo_overlay_box): boxes copied over packed
+// rows chunk by chunk must give the same frame as painting each box pixel by
+// pixel, for areas and chunks that cut through the boxes anywhere.
+
+#include "photo_overlay_box.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+static int g_failures = 0;
+
+static uint8_t get_px(const std::vector<uint8_t> &packed, size_t row_bytes, uint32_t x, uint32_t y) {
+    const uint8_t b = packed[y * row_bytes + x / 2];
+    return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+static void set_px(std::vector<uint8_t> &packed, size_t row_bytes, uint32_t x, uint32_t y, uint8_t v) {
+    uint8_t &b = packed[y * row_bytes + x / 2];
+    b = (x & 1) ? (uint8_t)((b & 0xF0) | v) : (uint8_t)((b & 0x0F) | (v << 4));
+}
+
+struct Case {
+    uint16_t area_x, area_y, area_w, area_h;
+    std::vector<PhotoOverlayBox> boxes;
+    std::vector<std::vector<uint8_t>> pixels;
+};
+
+static void run_case(const char *name, const Case &c, std::mt19937 &rng) {
+    const size_t row_bytes = c.area_w / 2;
+    std::vector<uint8_t> photo(row_bytes * c.area_h);
+    for (auto &b : photo) b = (uint8_t)rng();
+
+    // Reference: paint every box pixel that falls inside the area.
+    std::vector<uint8_t> expected = photo;
+    for (const PhotoOverlayBox &b : c.boxes) {
+        if (b.sig == 0) continue;
+        const std::vector<uint8_t> box(b.pixels, b.pixels + (size_t)b.h * (b.w / 2));
+        for (uint32_t by = 0; by < b.h; by++) {
+            for (uint32_t bx = 0; bx < b.w; bx++) {
+                const uint32_t px = b.x + bx;
+                const uint32_t py = b.y + by;
+                if (px < c.area_x || px >= (uint32_t)c.area_x + c.area_w) continue;
+                if (py < c.area_y || py >= (uint32_t)c.area_y + c.area_h) continue;
+                set_px(expected, row_bytes, px - c.area_x, py - c.area_y, get_px(box, b.w / 2, bx, by));
+            }
+        }
+    }
+
+    // Streamed: random chunk heights, like the renderer's loads.
+    std::vector<uint8_t> out = photo;
+    bool hit_ok = true;
+    for (uint16_t row = 0; row < c.area_h;) {
+        const uint16_t n = (uint16_t)std::min<uint32_t>(1 + rng() % 40, c.area_h - row);
+        const uint16_t y = (uint16_t)(c.area_y + row);
+        std::vector<uint8_t> chunk(out.begin() + (size_t)row * row_bytes,
+                                   out.begin() + (size_t)(row + n) * row_bytes);
+        const bool hit = photo_overlay_boxes_hit(c.boxes.data(), c.boxes.size(), c.area_x, y, c.area_w, n);
+        photo_overlay_boxes_blend(c.boxes.data(), c.boxes.size(), chunk.data(), c.area_x, c.area_w, y, n);
+        // A chunk the boxes miss is sent as is, so it must not need them.
+        if (!hit && !std::equal(chunk.begin(), chunk.end(), photo.begin() + (size_t)row * row_bytes)) hit_ok = false;
+        if (!hit && !std::equal(photo.begin() + (size_t)row * row_bytes, photo.begin() + (size_t)(row + n) * row_bytes,
+                                expected.begin() + (size_t)row * row_bytes)) {
+            hit_ok = false;
+        }
+        std::copy(chunk.begin(), chunk.end(), out.begin() + (size_t)row * row_bytes);
+        row += n;
+    }
+    if (out != expected || !hit_ok) {
+        fprintf(stderr, "FAIL %s: %s\n", name, out != expected ? "frame mismatch" : "hit test missed a box");
+        g_failures++;
+        return;
+    }
+    printf("ok   %s\n", name);
+}
+
+static PhotoOverlayBox make_box(Case &c, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t sig,
+                                std::mt19937 &rng) {
+    std::vector<uint8_t> pixels((size_t)h * (w / 2));
+    for (auto &b : pixels) b = (uint8_t)rng();
+    c.pixels.push_back(std::move(pixels));
+    return {x, y, w, h, sig, nullptr};
+}
+
+static void finish(Case &c) {
+    for (size_t i = 0; i < c.boxes.size(); i++) c.boxes[i].pixels = c.pixels[i].data();
+}
+} // namespace
+
+int main() {
+    std::mt19937 rng(19);
+
+    Case full = {0, 0, 1872, 1404, {}, {}};
+    full.boxes.push_back(make_box(full, 24, 1320, 116, 48, 11, rng));
+    full.boxes.push_back(make_box(full, 1752, 1320, 96, 48, 12, rng));
+    full.boxes.push_back(make_box(full, 700, 1320, 400, 48, 0, rng));  // hidden
+    finish(full);
+    run_case("full frame, clock + battery, hidden caption", full, rng);
+
+    Case sub = {400, 1300, 800, 104, {}, {}};
+    sub.boxes.push_back(make_box(sub, 380, 1290, 60, 40, 1, rng));    // left and top edge
+    sub.boxes.push_back(make_box(sub, 1150, 1380, 100, 48, 2, rng));  // right and bottom edge
+    sub.boxes.push_back(make_box(sub, 700, 1320, 200, 48, 3, rng));   // inside
+    sub.boxes.push_back(make_box(sub, 10, 10, 100, 48, 4, rng));      // outside
+    finish(sub);
+    run_case("sub-frame cutting through boxes", sub, rng);
+
+    for (int i = 0; i < 200; i++) {
+        Case r = {};
+        r.area_x = (uint16_t)((rng() % 400) * 4);
+        r.area_y = (uint16_t)(rng() % 1000);
+        r.area_w = (uint16_t)(4 + (rng() % 64) * 4);
+        r.area_h = (uint16_t)(1 + rng() % 200);
+        const int boxes = 1 + (int)(rng() % 3);
+        for (int b = 0; b < boxes; b++) {
+            const uint16_t x = (uint16_t)((r.area_x + (int)(rng() % 300) - 100) & ~3);
+            const int y = (int)r.area_y + (int)(rng() % 300) - 50;
+            r.boxes.push_back(make_box(r, x, (uint16_t)(y > 0 ? y : 0), (uint16_t)(4 + (rng() % 30) * 4), (uint16_t)(1 + rng() % 60),
+                                       rng() % 8 ? 1 + rng() : 0, rng));
+        }
+        finish(r);
+        char name[32];
+        snprintf(name, sizeof(name), "random %d", i);
+        run_case(name, r, rng);
+    }
+
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+// PhotoWriter (src/app/photo_writer) on a host directory standing in for the
+// SD card: uploads and blob downloads in arbitrary chunk sizes land on SD
+// byte for byte with the CRC the catalog records; truncated or foreign files
+// are refused before their first block is written; overruns, short files and
+// bad names fail with the message the job reports; nothing is left behind.
+
+#include "photo_writer.h"
+
+#include "board_config.h"
+#include "g4codec.h"
+#include "g4_file.h"
+#include "host_shim.h"
+#include "jpeg_g4.h"
+#include "photo_catalog.h"
+
+#include <SD.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+static int g_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+static std::mt19937 g_rng(24);
+
+// Reference CRC-32 (bitwise, reflected 0xEDB88320), independent of g4_file.
+static uint32_t crc32_ref(const std::string &data) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char c : data) {
+        crc ^= c;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+static std::string random_bytes(size_t len) {
+    std::string out(len, '\0');
+    for (auto &c : out) c = (char)(g_rng() & 0xFF);
+    return out;
+}
+
+// A sub-frame photo with the G4 container, as tools/jpg_to_g4.py writes it.
+static std::string g4_photo(uint16_t box_w, uint16_t box_h) {
+    std::vector<uint8_t> gray((size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    for (auto &v : gray) v = (uint8_t)(g_rng() & 0xFF);
+    G4CodecOptions opts = {};
+    opts.dither = G4CODEC_DITHER_BAYER;
+    opts.header = 1;
+    opts.box_x = 100;
+    opts.box_y = 60;
+    opts.box_w = box_w;
+    opts.box_h = box_h;
+    std::vector<uint8_t> out(g4codec_max_output_bytes(DISPLAY_WIDTH, DISPLAY_HEIGHT));
+    const size_t n = g4codec_convert(gray.data(), DISPLAY_WIDTH, DISPLAY_HEIGHT, &opts, out.data(), out.size());
+    return std::string((const char *)out.data(), n);
+}
+
+static std::string sd_path(const char *logical) {
+    return std::string("/") + logical;
+}
+
+static bool on_sd(const std::string &path) {
+    std::string unused;
+    return host_sd_get(path.c_str(), &unused);
+}
+
+// The catalog record of `logical`, read back from the card.
+static bool catalog_record(const char *logical, PhotoCatalogRecord *out) {
+    PhotoQueue queue;
+    const char *file = nullptr;
+    if (!photo_catalog_queue_of(logical, &queue, &file)) return false;
+    std::string data;
+    if (!host_sd_get("/photo-catalog.bin", &data)) return false;
+    for (size_t off = 32; off + sizeof(PhotoCatalogRecord) <= data.size(); off += sizeof(PhotoCatalogRecord)) {
+        memcpy(out, data.data() + off, sizeof(*out));
+        if (out->queue == (uint8_t)queue && strcmp(out->name, file) == 0) return true;
+    }
+    return false;
+}
+
+// begin, the data in the given chunk sizes (cycled), commit; abort always.
+static bool upload(PhotoWriter &w, const std::string &data, const std::vector<size_t> &chunks,
+                   uint32_t total_bytes) {
+    bool ok = photo_writer_begin(w, total_bytes);
+    size_t off = 0;
+    for (size_t i = 0; ok && off < data.size(); i++) {
+        const size_t n = std::min(chunks[i % chunks.size()], data.size() - off);
+        ok = photo_writer_write(w, (const uint8_t *)data.data() + off, n);
+        off += n;
+    }
+    if (ok) ok = photo_writer_commit(w);
+    photo_writer_abort(w);
+    return ok;
+}
+
+static bool upload(PhotoWriter &w, const std::string &data, const std::vector<size_t> &chunks) {
+    return upload(w, data, chunks, (uint32_t)data.size());
+}
+
+static void check_committed(const char *logical, const std::string &data, const std::vector<size_t> &chunks) {
+    PhotoWriter w = {};
+    size_t progress = 0;
+    w.name = logical;
+    w.progress = &progress;
+    CHECK(upload(w, data, chunks));
+    CHECK(w.message[0] == '\0');
+    CHECK(progress == data.size());
+    CHECK(w.crc == crc32_ref(data));
+    CHECK(w.crc == g4_file_crc32(0, (const uint8_t *)data.data(), data.size()));
+    std::string stored;
+    CHECK(host_sd_get(sd_path(logical).c_str(), &stored) && stored == data);
+    CHECK(!on_sd(sd_path(logical) + ".tmp"));
+    PhotoCatalogRecord rec;
+    CHECK(catalog_record(logical, &rec) && rec.size == data.size() && rec.hash == w.crc);
+}
+
+// Refused with `message`, before anything reached the card.
+static void check_refused(const char *logical, const std::string &data, const std::vector<size_t> &chunks,
+                          const char *message, uint32_t total_bytes) {
+    const bool existed = on_sd(sd_path(logical));
+    PhotoWriter w = {};
+    size_t progress = 0;
+    w.name = logical;
+    w.progress = &progress;
+    CHECK(!upload(w, data, chunks, total_bytes));
+    if (strcmp(w.message, message) != 0) fprintf(stderr, "  %s: got \"%s\"\n", logical, w.message);
+    CHECK(strcmp(w.message, message) == 0);
+    CHECK(progress == 0);
+    CHECK(on_sd(sd_path(logical)) == existed);
+    CHECK(!on_sd(sd_path(logical) + ".tmp"));
+    CHECK(w.stage == nullptr);
+}
+
+static void check_refused(const char *logical, const std::string &data, const std::vector<size_t> &chunks,
+                          const char *message) {
+    check_refused(logical, data, chunks, message, (uint32_t)data.size());
+}
+
+static void test_commit() {
+    const std::string photo = g4_photo(400, 300);
+    CHECK(photo.size() > 3 * kPhotoStageBytes);
+    // Staged, whole blocks straight through, and a mix straddling blocks.
+    check_committed("queue-permanent/a.g4", photo, {1, 7, 4093});
+    check_committed("queue-permanent/b.g4", photo, {kPhotoStageBytes * 2 + 5, 3});
+    check_committed("queue-temporary/20300101T000000Z__20290101T000000Z__c.g4", photo, {photo.size()});
+
+    // Headerless full frame (older converters).
+    const std::string frame = random_bytes((size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2);
+    check_committed("queue-permanent/raw.g4", frame, {65536, 1000});
+
+    // JPEGs only need the SOI marker; the renderer converts them later.
+    std::string jpeg = random_bytes(50000);
+    jpeg[0] = (char)0xFF;
+    jpeg[1] = (char)0xD8;
+    jpeg[2] = (char)0xFF;
+    check_committed("queue-permanent/p.jpg", jpeg, {1, 2, 8192});
+
+    // Replacing a JPEG drops the stale conversion.
+    const String cache = jpeg_g4_cache_path("/queue-permanent/p.jpg");
+    CHECK(host_sd_put(cache.c_str(), "old conversion"));
+    jpeg[100] ^= 0x55;
+    check_committed("queue-permanent/p.jpg", jpeg, {30000});
+    CHECK(!on_sd(cache.c_str()));
+
+    // Root-level names are written but not catalogued.
+    PhotoWriter w = {};
+    w.name = "root.g4";
+    CHECK(upload(w, photo, {9000}));
+    CHECK(on_sd("/root.g4") && !on_sd("/root.g4.tmp"));
+}
+
+static void test_refused() {
+    const std::string photo = g4_photo(400, 300);
+
+    // Truncated: the header promises more than the size announced.
+    check_refused("queue-permanent/t.g4", photo.substr(0, photo.size() - 10), {4096}, "Invalid G4: size mismatch");
+    // A sub-frame off the 4-px grid the renderer writes in host words.
+    std::string shifted = photo;
+    const uint16_t odd_x = 102;
+    memcpy(&shifted[offsetof(G4FileHeader, x)], &odd_x, sizeof(odd_x));
+    check_refused("queue-permanent/x.g4", shifted, {4096}, "Invalid G4: bad geometry");
+    // Foreign bytes under a .g4 name.
+    check_refused("queue-permanent/f.g4", random_bytes(40000), {40000}, "Invalid G4: size is not a frame");
+    // A PNG renamed to .jpg.
+    std::string png = random_bytes(20000);
+    memcpy(&png[0], "\x89PNG", 4);
+    check_refused("queue-permanent/n.jpg", png, {100}, "Invalid JPEG");
+    // A bad replacement leaves the old photo in place.
+    check_refused("queue-permanent/a.g4", random_bytes(20000), {20000}, "Invalid G4: size is not a frame");
+
+    // Less than a block: checked at commit, still before the write.
+    check_refused("queue-permanent/s.g4", random_bytes(100), {100}, "Invalid G4: size is not a frame");
+
+    // Fewer bytes than announced, and more (after some blocks went out).
+    check_refused("queue-permanent/i.g4", photo.substr(0, 5000), {1000}, "Incomplete", (uint32_t)photo.size());
+    // (A JPEG: a G4 header would already disagree with the announced size.)
+    std::string jpeg = random_bytes(50000);
+    memcpy(&jpeg[0], "\xFF\xD8\xFF", 3);
+    PhotoWriter w = {};
+    size_t progress = 0;
+    w.name = "queue-permanent/o.jpg";
+    w.progress = &progress;
+    CHECK(!upload(w, jpeg, {1000}, (uint32_t)jpeg.size() - 1));
+    CHECK(strcmp(w.message, "Too much data") == 0);
+    CHECK(progress == 2 * kPhotoStageBytes);  // the third block was never filled
+    CHECK(!on_sd("/queue-permanent/o.jpg") && !on_sd("/queue-permanent/o.jpg.tmp"));
+
+    check_refused("queue-permanent/e.g4", "", {1}, "Empty file");
+    for (const char *bad : {"../x.g4", "queue-permanent/../x.g4", "queue-permanent\\x.g4", "images/x.g4/y.g4",
+                            "queue-permanent/sub/x.g4", "images/x.g4", "x.png", "x", ""}) {
+        check_refused(bad, photo, {photo.size()}, "Invalid filename");
+    }
+    CHECK(!photo_name_valid(nullptr));
+    CHECK(!photo_name_valid(std::string(kPhotoNameMaxLen - 2, 'a').append(".g4").c_str()));
+    CHECK(photo_name_valid(std::string(kPhotoNameMaxLen - 3, 'a').append(".g4").c_str()));
+    CHECK(photo_name_valid("queue-temporary/x.jpeg"));
+}
+
+static void run(const char *name, void (*fn)()) {
+    const int before = g_failures;
+    host_heap_reset_counters();
+    fn();
+    CHECK(host_heap_live_blocks() == 0);
+    printf("%s %s\n", g_failures == before ? "ok  " : "FAIL", name);
+}
+} // namespace
+
+int main() {
+    host_log_enable(getenv("G4CODEC_TEST_LOG") != nullptr);
+    host_sd_mount();
+    PhotoCatalogInfo info = {};
+    CHECK(photo_catalog_open(&info));
+
+    run("commit: contents, CRC, catalog record, JPEG cache", test_commit);
+    run("refused: header, size, name", test_refused);
+
+    host_sd_unmount();
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+"""Native dithering (libg4codec) against the pure-Python loops in
+tools/jpg_to_g4.py.
+
+Bayer must be byte-identical. Floyd-Steinberg is fixed-point in the firmware
+and float in Python, so the error diffusion drifts apart (a fifth of the
+pixels or so): every pixel has to stay within one level and the mean level
+must match. Prints ms/MP for every mode at panel size.
+
+Run by ctest with G4CODEC_LIB pointing at the built library. PIL is not
+needed: the Python loops are taken from the tool's source and run on a
+bytes-backed stand-in for Image.
+"""
+
+import ast
+import os
+import random
+import sys
+import time
+from pathlib import Path
+
+TOOLS_DIR = Path(__file__).resolve().parents[2]
+sys.path.insert(0, str(TOOLS_DIR))
+
+import g4codec  # noqa: E402
+
+FS_MAX_LEVEL_DIFF = 1
+FS_MAX_MEAN_LEVEL_DIFF = 0.01
+
+
+class _Image:
+    """The part of PIL.Image the dither loops use."""
+
+    def __init__(self, size, data):
+        self.size = size
+        self._data = bytes(data)
+
+    def tobytes(self):
+        return self._data
+
+    @staticmethod
+    def frombytes(mode, size, data):
+        return _Image(size, data)
+
+
+class _ImageModule:
+    Image = _Image
+    frombytes = staticmethod(_Image.frombytes)
+
+
+class _NoNativeCodec:
+    @staticmethod
+    def available():
+        return False
+
+
+def load_python_reference():
+    source = (TOOLS_DIR / "jpg_to_g4.py").read_text()
+    wanted = {"apply_bayer_dither", "apply_floyd_steinberg_dither"}
+    tree = ast.parse(source)
+    body = [node for node in tree.body if isinstance(node, ast.FunctionDef) and node.name in wanted]
+    if len(body) != len(wanted):
+        raise SystemExit("dither functions not found in jpg_to_g4.py")
+    namespace = {"Image": _ImageModule, "g4codec": _NoNativeCodec}
+    exec(compile(ast.Module(body=body, type_ignores=[]), "jpg_to_g4.py", "exec"), namespace)
+    return namespace["apply_bayer_dither"], namespace["apply_floyd_steinberg_dither"]
+
+
+def test_image(width, height, seed):
+    """Gradient, flat areas, hard edges and noise: what photos throw at the dither."""
+    rng = random.Random(seed)
+    out = bytearray(width * height)
+    for y in range(height):
+        for x in range(width):
+            if y < height // 3:
+                v = x * 255 // (width - 1)
+            elif y < 2 * height // 3:
+                v = (0, 40, 128, 200, 255)[(x * 5) // width]
+            else:
+                v = x * 255 // (width - 1) + rng.randint(-40, 40)
+            out[y * width + x] = max(0, min(255, v))
+    return bytes(out)
+
+
+def levels(gray):
+    return [v // 17 for v in gray]
+
+
+def main():
+    if not g4codec.available():
+        print("libg4codec not found (set G4CODEC_LIB)", file=sys.stderr)
+        return 1
+    py_bayer, py_fs = load_python_reference()
+    failures = 0
+
+    for (w, h) in ((64, 48), (301, 97), (480, 320)):
+        gray = test_image(w, h, seed=w * h)
+        img = _Image((w, h), gray)
+
+        native = g4codec.dither(gray, w, h, g4codec.DITHER_BAYER)
+        reference = py_bayer(img).tobytes()
+        mismatches = sum(a != b for a, b in zip(native, reference))
+        status = "ok  " if mismatches == 0 else "FAIL"
+        print(f"{status} bayer {w}x{h}: {mismatches} px differ")
+        failures += mismatches != 0
+
+        native = levels(g4codec.dither(gray, w, h, g4codec.DITHER_FS))
+        reference = levels(py_fs(img).tobytes())
+        n = w * h
+        mean_diff = abs(sum(native) - sum(reference)) / n
+        max_diff = max(abs(a - b) for a, b in zip(native, reference))
+        differ = sum(a != b for a, b in zip(native, reference))
+        ok = mean_diff <= FS_MAX_MEAN_LEVEL_DIFF and max_diff <= FS_MAX_LEVEL_DIFF
+        status = "ok  " if ok else "FAIL"
+        print(f"{status} fs {w}x{h}: mean level diff {mean_diff:.4f}, "
+              f"max diff {max_diff} levels, {100.0 * differ / n:.1f}% px differ")
+        failures += not ok
+
+    w, h = 1872, 1404
+    gray = bytes((x + y) & 0xFF for y in range(h) for x in range(w))
+    for name, mode in (("none", g4codec.DITHER_NONE), ("bayer", g4codec.DITHER_BAYER),
+                       ("fs", g4codec.DITHER_FS), ("blue-noise", g4codec.DITHER_BLUE_NOISE)):
+        start = time.perf_counter()
+        g4codec.dither(gray, w, h, mode)
+        ms = (time.perf_counter() - start) * 1000
+        print(f"time {name}: {ms / (w * h / 1e6):.1f} ms/MP")
+
+    if failures:
+        print(f"{failures} failure(s)", file=sys.stderr)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,189 @@
+// UploadStream (src/app/upload_stream) with the sender and the SD worker on
+// two host threads and FreeRTOS queues standing in:
+//
+//   - bodies of any size, in request-sized pieces, arrive byte for byte in
+//     full chunks plus one last chunk holding the remainder, and every chunk
+//     is back in the free queue at the end
+//   - with all chunks in flight the sender blocks, and gives up after
+//     kUploadStallMs; one chunk handed back unblocks it
+//   - a worker that closes the stream releases a blocked sender at once
+//   - an abort only sets the flag
+
+#include "upload_stream.h"
+
+#include "host_shim.h"
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+static int g_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+static std::mt19937 g_rng(25);
+
+static std::string random_bytes(size_t len) {
+    std::string out(len, '\0');
+    for (auto &c : out) c = (char)(g_rng() & 0xFF);
+    return out;
+}
+
+static bool chunk_of(const UploadStream *stream, const UploadChunk *chunk) {
+    for (size_t i = 0; i < kUploadChunks; i++) {
+        if (chunk == &stream->chunks[i]) return chunk->data == stream->pool + i * kUploadChunkBytes;
+    }
+    return false;
+}
+
+// One upload of `size` bytes: the sender posts pieces of up to `max_piece`
+// bytes, the worker sleeps `worker_delay_us` per chunk.
+static void transfer(size_t size, size_t max_piece, unsigned worker_delay_us) {
+    const std::string body = random_bytes(size);
+    UploadStream *stream = upload_stream_alloc((uint32_t)size);
+    CHECK(stream != nullptr);
+    if (!stream) return;
+
+    std::atomic<bool> sent{false};
+    std::thread sender([&] {
+        std::mt19937 rng((uint32_t)size);
+        size_t off = 0;
+        bool ok = true;
+        while (ok && off < size) {
+            const size_t n = std::min<size_t>(1 + rng() % max_piece, size - off);
+            ok = upload_stream_write(stream, (const uint8_t *)body.data() + off, n);
+            off += n;
+        }
+        sent = ok && upload_stream_end(stream, true);
+    });
+
+    std::string received;
+    size_t chunks = 0;
+    bool last = false;
+    bool layout_ok = true;
+    bool full_ok = true;
+    while (!last) {
+        UploadChunk *chunk = upload_stream_receive(stream, 2000);
+        if (!chunk) break;
+        layout_ok = layout_ok && chunk_of(stream, chunk);
+        last = chunk->last;
+        if (!last) full_ok = full_ok && chunk->len == kUploadChunkBytes;
+        if (last) CHECK(chunk->len == size % kUploadChunkBytes);
+        received.append((const char *)chunk->data, chunk->len);
+        chunks++;
+        if (worker_delay_us) std::this_thread::sleep_for(std::chrono::microseconds(worker_delay_us));
+        upload_stream_release(stream, chunk);
+    }
+    sender.join();
+
+    CHECK(sent);
+    CHECK(last);
+    CHECK(layout_ok && full_ok);
+    CHECK(chunks == size / kUploadChunkBytes + 1);
+    CHECK(received == body);
+    // Every chunk is back: nothing posted twice, nothing lost.
+    CHECK(stream->filling == nullptr);
+    CHECK(uxQueueMessagesWaiting(stream->full_chunks) == 0);
+    CHECK(uxQueueMessagesWaiting(stream->free_chunks) == kUploadChunks);
+    upload_stream_free(stream);
+}
+
+static void test_transfer() {
+    host_heap_reset_counters();
+    for (size_t size : {(size_t)1, kUploadChunkBytes - 1, kUploadChunkBytes, kUploadChunkBytes + 1,
+                        5 * kUploadChunkBytes, (size_t)1314144 + 17}) {
+        transfer(size, 1436, 0);        // TCP segments, fast card
+        transfer(size, 20000, 200);     // large pieces, slow card
+    }
+    CHECK(host_heap_allocations() == 12);  // one pool per upload
+    CHECK(host_heap_live_blocks() == 0);
+}
+
+static uint32_t elapsed_ms(unsigned long start_ms) {
+    return (uint32_t)(millis() - start_ms);
+}
+
+static void test_backpressure() {
+    UploadStream *stream = upload_stream_alloc(1 << 20);
+    const std::string body = random_bytes(kUploadChunks * kUploadChunkBytes);
+    // Every chunk fits in flight without the worker.
+    unsigned long start_ms = millis();
+    CHECK(upload_stream_write(stream, (const uint8_t *)body.data(), body.size()));
+    CHECK(elapsed_ms(start_ms) < 100);
+    CHECK(uxQueueMessagesWaiting(stream->full_chunks) == kUploadChunks);
+
+    // One more byte needs a chunk back: the sender stalls, then gives up.
+    const uint8_t byte = 0x5A;
+    start_ms = millis();
+    CHECK(!upload_stream_write(stream, &byte, 1));
+    const uint32_t stalled_ms = elapsed_ms(start_ms);
+    CHECK(stalled_ms >= kUploadStallMs && stalled_ms < kUploadStallMs + 500);
+
+    // The worker hands one back: the sender resumes.
+    UploadChunk *chunk = upload_stream_receive(stream, 0);
+    CHECK(chunk && chunk->len == kUploadChunkBytes && memcmp(chunk->data, body.data(), kUploadChunkBytes) == 0);
+    upload_stream_release(stream, chunk);
+    start_ms = millis();
+    CHECK(upload_stream_write(stream, &byte, 1));
+    CHECK(elapsed_ms(start_ms) < 100);
+    CHECK(stream->filling && stream->filling->len == 1);
+    upload_stream_free(stream);
+}
+
+static void test_closed() {
+    UploadStream *stream = upload_stream_alloc(1 << 20);
+    const std::string body = random_bytes((kUploadChunks + 1) * kUploadChunkBytes);
+    // The worker rejects the file while the sender waits for a chunk.
+    std::thread worker([stream] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        stream->closed = true;
+    });
+    const unsigned long start_ms = millis();
+    CHECK(!upload_stream_write(stream, (const uint8_t *)body.data(), body.size()));
+    CHECK(elapsed_ms(start_ms) < 1000);
+    worker.join();
+    const uint8_t byte = 0;
+    CHECK(!upload_stream_write(stream, &byte, 1));
+    CHECK(!upload_stream_end(stream, true));
+    CHECK(!upload_stream_write(nullptr, &byte, 1) && !upload_stream_end(nullptr, true));
+    upload_stream_free(stream);
+}
+
+static void test_abort() {
+    UploadStream *stream = upload_stream_alloc(100);
+    const std::string body = random_bytes(100);
+    CHECK(upload_stream_write(stream, (const uint8_t *)body.data(), body.size()));
+    CHECK(upload_stream_end(stream, false));
+    CHECK(stream->aborted);
+    CHECK(upload_stream_receive(stream, 0) == nullptr);  // nothing posted
+    upload_stream_free(stream);
+}
+
+static void run(const char *name, void (*fn)()) {
+    const int before = g_failures;
+    fn();
+    printf("%s %s\n", g_failures == before ? "ok  " : "FAIL", name);
+}
+} // namespace
+
+int main() {
+    host_log_enable(getenv("G4CODEC_TEST_LOG") != nullptr);
+    run("transfer: bytes, chunk sizes, chunks returned", test_transfer);
+    run("backpressure: stall after kUploadStallMs, resume", test_backpressure);
+    run("worker closed: sender released", test_closed);
+    run("abort: flag only", test_abort);
+    if (g_failures) {
+        fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -3,14 +3,40 @@
 
 import argparse
 import os
+import struct
+import time
+import zlib
+from concurrent.futures import ProcessPoolExecutor
 from pathlib import Path
-from typing import Iterable
+from typing import Iterable, Optional
 
 from PIL import Image, ImageEnhance, ImageFilter, ImageOps
 
+import g4codec
+
 DEFAULT_WIDTH = 1872
 DEFAULT_HEIGHT = 1404
 
+# G4 container header (see src/app/g4_file.h), followed by the strip index
+# (G4Z only), strip CRCs and tile hashes, then the payload.
+G4_FILE_MAGIC = 0x31483447  # "G4H1"
+G4_FILE_VERSION = 1
+G4_HEADER_FORMAT = "<IBBBBHHHHHHHBBII"
+G4_ENCODING_RAW = 0
+G4_ENCODING_G4Z = 1
+G4_FLAG_STRIP_CRC = 0x01
+G4_FLAG_TILE_HASHES = 0x02
+G4_TILE_SIZE = 64
+G4_VARIANT_IDS = {"base": 0, "opt": 1, "opt-bayer": 2, "opt-fs": 3, "compare": 4}
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+
+# G4Z (see src/app/g4z_codec.h): strip-indexed, each strip decodes on its own.
+G4Z_STRIP_ROWS = 16
+G4Z_MIN_RUN = 3
+G4Z_MAX_RUN = 0x3F + G4Z_MIN_RUN
+G4Z_MAX_LITERAL = 0x80
+
 
 def iter_images(paths: Iterable[Path]) -> Iterable[Path]:
     for p in paths:
@@ -22,20 +48,34 @@ def iter_images(paths: Iterable[Path]) -> Iterable[Path]:
             yield p
 
 
-def fit_with_white_bg(img: Image.Image, width: int, height: int) -> Image.Image:
-    img = img.convert("RGB")
-    src_w, src_h = img.size
+def letterbox_box(src_size: tuple[int, int], width: int, height: int) -> tuple[int, int, int, int]:
+    """Placement (left, top, w, h) of a photo scaled to fit the canvas."""
+    src_w, src_h = src_size
     scale = min(width / src_w, height / src_h)
     new_w = max(1, int(src_w * scale))
     new_h = max(1, int(src_h * scale))
+    return (width - new_w) // 2, (height - new_h) // 2, new_w, new_h
+
+
+def fit_with_white_bg(img: Image.Image, width: int, height: int) -> Image.Image:
+    img = img.convert("RGB")
+    left, top, new_w, new_h = letterbox_box(img.size, width, height)
     resized = img.resize((new_w, new_h), Image.LANCZOS)
     canvas = Image.new("RGB", (width, height), (255, 255, 255))
-    left = (width - new_w) // 2
-    top = (height - new_h) // 2
     canvas.paste(resized, (left, top))
     return canvas
 
 
+def subframe_box(src_size: tuple[int, int], width: int, height: int) -> tuple[int, int, int, int]:
+    """Photo area of the final (flipped + mirrored) canvas, x/w widened to multiples of 4."""
+    left, top, new_w, new_h = letterbox_box(src_size, width, height)
+    x = width - (left + new_w)
+    y = height - (top + new_h)
+    x0 = x & ~3
+    x1 = min(width, (x + new_w + 3) & ~3)
+    return x0, y, x1 - x0, new_h
+
+
 def optimize_grayscale(img: Image.Image) -> Image.Image:
     img = ImageOps.autocontrast(img, cutoff=2)
     img = ImageEnhance.Contrast(img).enhance(1.10)
@@ -55,6 +95,8 @@ def add_vertical_separators(img: Image.Image, parts: int) -> Image.Image:
 
 
 def apply_bayer_dither(img: Image.Image) -> Image.Image:
+    if g4codec.available():
+        return Image.frombytes("L", img.size, g4codec.dither(img.tobytes(), *img.size, g4codec.DITHER_BAYER))
     matrix = [
         [0, 8, 2, 10],
         [12, 4, 14, 6],
@@ -83,6 +125,8 @@ def apply_bayer_dither(img: Image.Image) -> Image.Image:
 
 
 def apply_floyd_steinberg_dither(img: Image.Image) -> Image.Image:
+    if g4codec.available():
+        return Image.frombytes("L", img.size, g4codec.dither(img.tobytes(), *img.size, g4codec.DITHER_FS))
     w, h = img.size
     pixels = list(img.tobytes())
     buf = [float(p) for p in pixels]
@@ -121,6 +165,8 @@ def pack_g4(img: Image.Image) -> bytes:
     w, h = gray.size
     if w % 2 != 0:
         raise ValueError("Width must be even for packed 4bpp")
+    if g4codec.available():
+        return g4codec.pack(gray.tobytes(), w, h)
     pixels = gray.tobytes()
     out = bytearray((w * h) // 2)
     idx = 0
@@ -132,6 +178,297 @@ def pack_g4(img: Image.Image) -> bytes:
     return bytes(out)
 
 
+def _g4z_flush_literals(out: bytearray, data: bytes, start: int, end: int) -> None:
+    while start < end:
+        n = min(G4Z_MAX_LITERAL, end - start)
+        out.append(n - 1)
+        out += data[start:start + n]
+        start += n
+
+
+def _g4z_encode_strip(strip: bytes, row_bytes: int) -> bytes:
+    """Greedy encoder: byte runs, matches against the previous row and against
+    the last position of the same 3-byte prefix (window = the strip itself)."""
+    if g4codec.available():
+        return g4codec.g4z_encode_strip(strip, row_bytes)
+    out = bytearray()
+    n = len(strip)
+    last_pos = {}
+    lit_start = 0
+    i = 0
+    while i < n:
+        best_len = 0
+        best_dist = 0
+
+        b = strip[i]
+        j = i + 1
+        limit = min(n, i + G4Z_MAX_RUN)
+        while j < limit and strip[j] == b:
+            j += 1
+        run_len = j - i
+
+        key = strip[i:i + 3]
+        candidates = []
+        if i >= row_bytes:
+            candidates.append(row_bytes)
+        p = last_pos.get(key)
+        if p is not None and i - p not in candidates:
+            candidates.append(i - p)
+        for dist in candidates:
+            length = 0
+            while i + length < limit and strip[i + length] == strip[i + length - dist]:
+                length += 1
+            if length > best_len:
+                best_len = length
+                best_dist = dist
+
+        if len(key) == 3:
+            last_pos[key] = i
+
+        if run_len >= G4Z_MIN_RUN and run_len >= best_len:
+            _g4z_flush_literals(out, strip, lit_start, i)
+            out.append(0x80 | (run_len - G4Z_MIN_RUN))
+            out.append(b)
+            i += run_len
+            lit_start = i
+        elif best_len >= G4Z_MIN_RUN:
+            _g4z_flush_literals(out, strip, lit_start, i)
+            out.append(0xC0 | (best_len - G4Z_MIN_RUN))
+            out += struct.pack("<H", best_dist)
+            i += best_len
+            lit_start = i
+        else:
+            i += 1
+    _g4z_flush_literals(out, strip, lit_start, n)
+    return bytes(out)
+
+
+def _g4z_decode_strip(data: bytes, out_len: int) -> bytes:
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        t = data[i]
+        i += 1
+        if t < 0x80:
+            out += data[i:i + t + 1]
+            i += t + 1
+        elif t < 0xC0:
+            out += bytes([data[i]]) * ((t & 0x3F) + G4Z_MIN_RUN)
+            i += 1
+        else:
+            dist = data[i] | (data[i + 1] << 8)
+            i += 2
+            for _ in range((t & 0x3F) + G4Z_MIN_RUN):
+                out.append(out[-dist])
+    if len(out) != out_len:
+        raise ValueError(f"G4Z strip decoded to {len(out)} bytes, expected {out_len}")
+    return bytes(out)
+
+
+def tile_hashes(packed: bytes, width: int, height: int) -> list[int]:
+    """Per-tile FNV-1a over little-endian words, as src/app/g4_tile_map.cpp."""
+    if g4codec.available():
+        return g4codec.tile_hashes(packed, width, height)
+    row_bytes = width // 2
+    tile_bytes = G4_TILE_SIZE // 2
+    cols = (width + G4_TILE_SIZE - 1) // G4_TILE_SIZE
+    rows = (height + G4_TILE_SIZE - 1) // G4_TILE_SIZE
+    hashes = [FNV_OFFSET] * (cols * rows)
+    for y in range(height):
+        row = packed[y * row_bytes:(y + 1) * row_bytes]
+        base = (y // G4_TILE_SIZE) * cols
+        for tx in range(cols):
+            span = row[tx * tile_bytes:(tx + 1) * tile_bytes]
+            h = hashes[base + tx]
+            words = len(span) // 4
+            for (word,) in struct.iter_unpack("<I", span[:words * 4]):
+                h = ((h ^ word) * FNV_PRIME) & 0xFFFFFFFF
+            for b in span[words * 4:]:
+                h = ((h ^ b) * FNV_PRIME) & 0xFFFFFFFF
+            hashes[base + tx] = h
+    return hashes
+
+
+def encode_g4_file(packed: bytes, width: int, height: int, variant: str, use_g4z: bool,
+                   placement: tuple[int, int] = (0, 0), full_frame: bool = True) -> bytes:
+    """Container with strip CRCs and tile hashes; payload raw or G4Z.
+
+    A sub-frame (full_frame=False) is placed at `placement` on a white background
+    and carries no tile hashes (the device hashes the composed panel frame).
+    """
+    row_bytes = width // 2
+    strip_bytes = row_bytes * G4Z_STRIP_ROWS
+    raw_strips = [packed[off:off + strip_bytes] for off in range(0, len(packed), strip_bytes)]
+
+    tables = b""
+    if use_g4z:
+        strips = [_g4z_encode_strip(strip, row_bytes) for strip in raw_strips]
+        offsets = [0]
+        for s in strips:
+            offsets.append(offsets[-1] + len(s))
+        tables += struct.pack(f"<{len(offsets)}I", *offsets)
+        payload = b"".join(strips)
+    else:
+        payload = packed
+    tables += struct.pack(f"<{len(raw_strips)}I", *(zlib.crc32(strip) for strip in raw_strips))
+    flags = G4_FLAG_STRIP_CRC
+    if full_frame:
+        hashes = tile_hashes(packed, width, height)
+        tables += struct.pack(f"<{len(hashes)}I", *hashes)
+        flags |= G4_FLAG_TILE_HASHES
+
+    header_bytes = struct.calcsize(G4_HEADER_FORMAT) + len(tables)
+    header = struct.pack(
+        G4_HEADER_FORMAT,
+        G4_FILE_MAGIC,
+        G4_FILE_VERSION,
+        G4_ENCODING_G4Z if use_g4z else G4_ENCODING_RAW,
+        G4_VARIANT_IDS.get(variant, 0),
+        flags,
+        width,
+        height,
+        placement[0],
+        placement[1],
+        G4Z_STRIP_ROWS,
+        len(raw_strips),
+        G4_TILE_SIZE if full_frame else 0,
+        0x0F,  # white background level
+        0,
+        header_bytes,
+        len(payload),
+    )
+    return header + tables + payload
+
+
+def decode_g4_file(blob: bytes) -> bytes:
+    """Decode a container back to packed rows, checking strip CRCs."""
+    fields = struct.unpack_from(G4_HEADER_FORMAT, blob, 0)
+    magic, version, encoding, _variant, flags, width, height = fields[:7]
+    strip_rows, count = fields[9:11]
+    header_bytes, payload_bytes = fields[14:16]
+    if magic != G4_FILE_MAGIC or version != G4_FILE_VERSION:
+        raise ValueError("Not a G4 container")
+    if header_bytes + payload_bytes != len(blob):
+        raise ValueError("G4 size mismatch")
+    pos = struct.calcsize(G4_HEADER_FORMAT)
+    offsets = None
+    if encoding == G4_ENCODING_G4Z:
+        offsets = struct.unpack_from(f"<{count + 1}I", blob, pos)
+        pos += 4 * (count + 1)
+    crcs = None
+    if flags & G4_FLAG_STRIP_CRC:
+        crcs = struct.unpack_from(f"<{count}I", blob, pos)
+    row_bytes = width // 2
+    out = bytearray()
+    for i in range(count):
+        rows = min(strip_rows, height - i * strip_rows)
+        if offsets is not None:
+            strip = _g4z_decode_strip(blob[header_bytes + offsets[i]:header_bytes + offsets[i + 1]], rows * row_bytes)
+        else:
+            start = header_bytes + i * strip_rows * row_bytes
+            strip = blob[start:start + rows * row_bytes]
+        if crcs is not None and zlib.crc32(strip) != crcs[i]:
+            raise ValueError(f"G4 strip {i} CRC mismatch")
+        out += strip
+    return bytes(out)
+
+
+def write_g4(src: Path, path: Path, img: Image.Image, variant: str, use_header: bool, use_g4z: bool,
+             box: Optional[tuple[int, int, int, int]] = None) -> None:
+    """Write headerless packed 4bpp, or the G4 container (optionally G4Z) with a round-trip check.
+
+    With `box` (x, y, w, h) only that area of the panel image is stored, as a sub-frame.
+    """
+    full_frame = box is None or (box[2], box[3]) == img.size
+    if not full_frame:
+        x, y, w, h = box
+        img = img.crop((x, y, x + w, y + h))
+    width, height = img.size
+    packed = pack_g4(img)
+    data = packed
+    if use_header or use_g4z or not full_frame:
+        t0 = time.perf_counter()
+        placement = (box[0], box[1]) if not full_frame else (0, 0)
+        data = encode_g4_file(packed, width, height, variant, use_g4z, placement, full_frame)
+        t1 = time.perf_counter()
+        if decode_g4_file(data) != packed:
+            raise RuntimeError(f"G4 round-trip mismatch for {path}")
+        t2 = time.perf_counter()
+        mb = len(packed) / (1024 * 1024)
+        print(
+            f"  {'g4z' if use_g4z else 'raw'} {len(data)}/{len(packed)} bytes ({100.0 * len(data) / len(packed):.1f}%), "
+            f"encode {mb / (t1 - t0):.2f} MB/s, decode {mb / (t2 - t1):.2f} MB/s"
+        )
+    with open(path, "wb") as f:
+        f.write(data)
+    where = "" if full_frame else f" {width}x{height}@{box[0]},{box[1]}"
+    print(f"{src} -> {path} ({len(data)} bytes{where})")
+
+
+def convert_file(src: Path, args: argparse.Namespace, inputs: list[Path], out_dir: Optional[Path]) -> None:
+    if src.suffix.lower() not in (".jpg", ".jpeg"):
+        return
+    if out_dir:
+        base_dir = next((p for p in inputs if p.is_dir() and src.is_relative_to(p)), None)
+        rel = src.parent.relative_to(base_dir) if base_dir else Path()
+        dst_dir = out_dir / rel
+        dst_dir.mkdir(parents=True, exist_ok=True)
+    else:
+        dst_dir = src.parent
+
+    img = Image.open(src)
+    box = subframe_box(img.size, args.width, args.height) if args.subframe else None
+    img = fit_with_white_bg(img, args.width, args.height)
+    base = img.convert("L")
+
+    if args.variant == "base":
+        base = ImageOps.flip(base)
+        base = ImageOps.mirror(base)
+        base_path = dst_dir / (src.stem + "__BASE.g4")
+        write_g4(src, base_path, base, args.variant, args.header, args.g4z, box)
+    elif args.variant == "opt":
+        opt = optimize_grayscale(base.copy())
+        opt = ImageOps.flip(opt)
+        opt = ImageOps.mirror(opt)
+        opt_path = dst_dir / (src.stem + "__OPT.g4")
+        write_g4(src, opt_path, opt, args.variant, args.header, args.g4z, box)
+    elif args.variant == "opt-bayer":
+        opt = optimize_grayscale(base.copy())
+        opt = apply_bayer_dither(opt)
+        opt = ImageOps.flip(opt)
+        opt = ImageOps.mirror(opt)
+        opt_path = dst_dir / (src.stem + "__OPT_BAYER.g4")
+        write_g4(src, opt_path, opt, args.variant, args.header, args.g4z, box)
+    elif args.variant == "opt-fs":
+        opt = optimize_grayscale(base.copy())
+        opt = apply_floyd_steinberg_dither(opt)
+        opt = ImageOps.flip(opt)
+        opt = ImageOps.mirror(opt)
+        opt_path = dst_dir / (src.stem + "__OPT_FS.g4")
+        write_g4(src, opt_path, opt, args.variant, args.header, args.g4z, box)
+    else:
+        opt = optimize_grayscale(base.copy())
+        bayer = apply_bayer_dither(opt)
+        fs = apply_floyd_steinberg_dither(opt)
+
+        compare = Image.new("L", base.size, 255)
+        quarter = base.width // 4
+        x2 = quarter * 2
+        x3 = quarter * 3
+
+        compare.paste(base.crop((0, 0, quarter, base.height)), (0, 0))
+        compare.paste(opt.crop((quarter, 0, x2, base.height)), (quarter, 0))
+        compare.paste(bayer.crop((x2, 0, x3, base.height)), (x2, 0))
+        compare.paste(fs.crop((x3, 0, base.width, base.height)), (x3, 0))
+
+        compare = add_vertical_separators(compare, 4)
+        compare = ImageOps.flip(compare)
+        compare = ImageOps.mirror(compare)
+
+        compare_path = dst_dir / (src.stem + "__COMPARE.g4")
+        write_g4(src, compare_path, compare, args.variant, args.header, args.g4z)
+
+
 def main() -> int:
     parser = argparse.ArgumentParser(description="Convert JPGs to packed 4bpp .g4 files.")
     parser.add_argument("input", nargs="+", help="Input file(s) or folder(s)")
@@ -144,7 +481,30 @@ def main() -> int:
         default="opt-bayer",
         help="Which variant to generate (default: opt-bayer)",
     )
+    parser.add_argument(
+        "--header",
+        action="store_true",
+        help="Write the G4 container header (geometry, strip CRCs, tile hashes); verified by round-trip",
+    )
+    parser.add_argument(
+        "--g4z",
+        action="store_true",
+        help="Write compressed G4Z (decoded on device strip by strip); implies --header",
+    )
+    parser.add_argument(
+        "--subframe",
+        action="store_true",
+        help="Store only the photo area plus its placement (no letterbox bytes); implies --header",
+    )
+    parser.add_argument(
+        "--jobs",
+        "-j",
+        type=int,
+        default=0,
+        help="Parallel conversions (default: one per CPU)",
+    )
     args = parser.parse_args()
+    print(f"Codec: {'native g4codec' if g4codec.available() else 'pure Python (build tools/g4codec for native speed)'}")
 
     out_dir = Path(args.output).expanduser().resolve() if args.output else None
     if out_dir:
@@ -156,82 +516,14 @@ def main() -> int:
         print("No JPG files found.")
         return 1
 
-    for src in files:
-        if src.suffix.lower() not in (".jpg", ".jpeg"):
-            continue
-        if out_dir:
-            base_dir = next((p for p in inputs if p.is_dir() and src.is_relative_to(p)), None)
-            rel = src.parent.relative_to(base_dir) if base_dir else Path()
-            dst_dir = out_dir / rel
-            dst_dir.mkdir(parents=True, exist_ok=True)
-        else:
-            dst_dir = src.parent
-
-        img = Image.open(src)
-        img = fit_with_white_bg(img, args.width, args.height)
-        base = img.convert("L")
-
-        if args.variant == "base":
-            base = ImageOps.flip(base)
-            base = ImageOps.mirror(base)
-            base_path = dst_dir / (src.stem + "__BASE.g4")
-            base_data = pack_g4(base)
-            with open(base_path, "wb") as f:
-                f.write(base_data)
-            print(f"{src} -> {base_path} ({len(base_data)} bytes)")
-        elif args.variant == "opt":
-            opt = optimize_grayscale(base.copy())
-            opt = ImageOps.flip(opt)
-            opt = ImageOps.mirror(opt)
-            opt_path = dst_dir / (src.stem + "__OPT.g4")
-            opt_data = pack_g4(opt)
-            with open(opt_path, "wb") as f:
-                f.write(opt_data)
-            print(f"{src} -> {opt_path} ({len(opt_data)} bytes)")
-        elif args.variant == "opt-bayer":
-            opt = optimize_grayscale(base.copy())
-            opt = apply_bayer_dither(opt)
-            opt = ImageOps.flip(opt)
-            opt = ImageOps.mirror(opt)
-            opt_path = dst_dir / (src.stem + "__OPT_BAYER.g4")
-            opt_data = pack_g4(opt)
-            with open(opt_path, "wb") as f:
-                f.write(opt_data)
-            print(f"{src} -> {opt_path} ({len(opt_data)} bytes)")
-        elif args.variant == "opt-fs":
-            opt = optimize_grayscale(base.copy())
-            opt = apply_floyd_steinberg_dither(opt)
-            opt = ImageOps.flip(opt)
-            opt = ImageOps.mirror(opt)
-            opt_path = dst_dir / (src.stem + "__OPT_FS.g4")
-            opt_data = pack_g4(opt)
-            with open(opt_path, "wb") as f:
-                f.write(opt_data)
-            print(f"{src} -> {opt_path} ({len(opt_data)} bytes)")
-        else:
-            opt = optimize_grayscale(base.copy())
-            bayer = apply_bayer_dither(opt)
-            fs = apply_floyd_steinberg_dither(opt)
-
-            compare = Image.new("L", base.size, 255)
-            quarter = base.width // 4
-            x2 = quarter * 2
-            x3 = quarter * 3
-
-            compare.paste(base.crop((0, 0, quarter, base.height)), (0, 0))
-            compare.paste(opt.crop((quarter, 0, x2, base.height)), (quarter, 0))
-            compare.paste(bayer.crop((x2, 0, x3, base.height)), (x2, 0))
-            compare.paste(fs.crop((x3, 0, base.width, base.height)), (x3, 0))
-
-            compare = add_vertical_separators(compare, 4)
-            compare = ImageOps.flip(compare)
-            compare = ImageOps.mirror(compare)
-
-            compare_path = dst_dir / (src.stem + "__COMPARE.g4")
-            compare_data = pack_g4(compare)
-            with open(compare_path, "wb") as f:
-                f.write(compare_data)
-            print(f"{src} -> {compare_path} ({len(compare_data)} bytes)")
+    jobs = args.jobs or os.cpu_count() or 1
+    if jobs > 1 and len(files) > 1:
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            for future in [pool.submit(convert_file, src, args, inputs, out_dir) for src in files]:
+                future.result()
+    else:
+        for src in files:
+            convert_file(src, args, inputs, out_dir)
 
     return 0
 
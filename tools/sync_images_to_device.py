@@ -10,6 +10,8 @@ from urllib import request, parse, error
 
 from PIL import Image, ImageEnhance, ImageFilter, ImageOps
 
+import g4codec
+
 DEFAULT_WIDTH = 1872
 DEFAULT_HEIGHT = 1404
 
@@ -46,6 +48,8 @@ def optimize_grayscale(img: Image.Image) -> Image.Image:
 
 
 def apply_bayer_dither(img: Image.Image) -> Image.Image:
+    if g4codec.available():
+        return Image.frombytes("L", img.size, g4codec.dither(img.tobytes(), *img.size, g4codec.DITHER_BAYER))
     matrix = [
         [0, 8, 2, 10],
         [12, 4, 14, 6],
@@ -74,6 +78,8 @@ def apply_bayer_dither(img: Image.Image) -> Image.Image:
 
 
 def apply_floyd_steinberg_dither(img: Image.Image) -> Image.Image:
+    if g4codec.available():
+        return Image.frombytes("L", img.size, g4codec.dither(img.tobytes(), *img.size, g4codec.DITHER_FS))
     w, h = img.size
     pixels = list(img.tobytes())
     buf = [float(p) for p in pixels]
@@ -112,6 +118,8 @@ def pack_g4(img: Image.Image) -> bytes:
     w, h = gray.size
     if w % 2 != 0:
         raise ValueError("Width must be even for packed 4bpp")
+    if g4codec.available():
+        return g4codec.pack(gray.tobytes(), w, h)
     pixels = gray.tobytes()
     out = bytearray((w * h) // 2)
     idx = 0
@@ -13,8 +13,17 @@ from fastapi.responses import HTMLResponse, JSONResponse, Response
 from fastapi.templating import Jinja2Templates
 from PIL import Image, ImageEnhance, ImageFilter, ImageOps
 
+import sys
 import xml.etree.ElementTree as ET
 
+# Native codec (tools/g4codec) when the repo's tools folder is next to this app;
+# otherwise the pure-Python loops below are used.
+sys.path.append(str(Path(__file__).resolve().parent.parent / "tools"))
+try:
+    import g4codec
+except ImportError:
+    g4codec = None
+
 DEFAULT_WIDTH = 1872
 DEFAULT_HEIGHT = 1404
 DEFAULT_VARIANT = "opt-bayer"
@@ -73,6 +82,8 @@ def optimize_grayscale(img: Image.Image) -> Image.Image:
 
 
 def apply_bayer_dither(img: Image.Image) -> Image.Image:
+    if g4codec is not None and g4codec.available():
+        return Image.frombytes("L", img.size, g4codec.dither(img.tobytes(), *img.size, g4codec.DITHER_BAYER))
     matrix = [
         [0, 8, 2, 10],
         [12, 4, 14, 6],
@@ -101,6 +112,8 @@ def apply_bayer_dither(img: Image.Image) -> Image.Image:
 
 
 def apply_floyd_steinberg_dither(img: Image.Image) -> Image.Image:
+    if g4codec is not None and g4codec.available():
+        return Image.frombytes("L", img.size, g4codec.dither(img.tobytes(), *img.size, g4codec.DITHER_FS))
     w, h = img.size
     pixels = list(img.tobytes())
     buf = [float(p) for p in pixels]
@@ -139,6 +152,8 @@ def pack_g4(img: Image.Image) -> bytes:
     w, h = gray.size
     if w % 2 != 0:
         raise ValueError("Width must be even for packed 4bpp")
+    if g4codec is not None and g4codec.available():
+        return g4codec.pack(gray.tobytes(), w, h)
     pixels = gray.tobytes()
     out = bytearray((w * h) // 2)
     idx = 0